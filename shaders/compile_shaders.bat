@@ -8,11 +8,24 @@ REM
 if not exist "%OUTPUT_DIR%" mkdir "%OUTPUT_DIR%"
 
 REM
-for %%f in (*.vert *.frag) do (
+set VALIDATE=0
+where spirv-val.exe >nul 2>nul && set VALIDATE=1
+if !VALIDATE!==0 echo [WARNING] spirv-val.exe not found, compiled shaders are not validated
+
+REM
+for %%f in (*.vert *.frag *.comp) do (
     echo Compiling %%f...
     glslangValidator.exe -V %%f -o "%OUTPUT_DIR%/%%~nxf.spv"
     if errorlevel 1 (
         echo [ERROR] Failed to compile %%f
+    ) else if !VALIDATE!==1 (
+        spirv-val.exe "%OUTPUT_DIR%/%%~nxf.spv"
+        if errorlevel 1 (
+            echo [ERROR] %%f compiled to an invalid module, removing it
+            del "%OUTPUT_DIR%\%%~nxf.spv"
+        ) else (
+            echo [SUCCESS] Compiled and validated %%f to %OUTPUT_DIR%/%%~nxf.spv
+        )
     ) else (
         echo [SUCCESS] Compiled %%f to %OUTPUT_DIR%/%%~nxf.spv
     )
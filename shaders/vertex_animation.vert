@@ -0,0 +1,51 @@
+#version 450
+
+layout(location = 0) in vec3 vert_position;
+layout(location = 1) in vec3 vert_color;
+layout(location = 2) in vec2 vert_texture;
+
+layout(location = 5) in mat4 instance_model;
+layout(location = 9) in vec4 instance_animation;
+
+layout(location = 0) out vec3 frag_color;
+layout(location = 1) out vec2 frag_texture;
+
+layout(set = 0, binding = 0) uniform ViewProjection {
+    mat4 view;
+    mat4 projection;
+} view_projection;
+
+layout(set = 2, binding = 0) uniform sampler2D vertex_animation_texture;
+
+layout(push_constant) uniform VertexAnimation {
+    mat4 model;
+    float time;
+    float frames_per_second;
+    uint vertex_offset;
+    uint vertex_count;
+    uint texture_width;
+} vertex_animation_pc;
+
+vec3 fetch_position(uint frame, uint vertex) {
+    uint texel = frame * vertex_animation_pc.vertex_count + vertex_animation_pc.vertex_offset + vertex;
+    ivec2 coordinate = ivec2(texel % vertex_animation_pc.texture_width, texel / vertex_animation_pc.texture_width);
+    return texelFetch(vertex_animation_texture, coordinate, 0).xyz;
+}
+
+void main() {
+    float frame_count = max(instance_animation.w, 1.0);
+    float frame = mod((vertex_animation_pc.time + instance_animation.x) * instance_animation.y * vertex_animation_pc.frames_per_second, frame_count);
+
+    uint current_frame = uint(floor(frame));
+    uint next_frame = uint(mod(float(current_frame + 1), frame_count));
+    uint first_frame = uint(instance_animation.z);
+
+    vec3 position = mix(
+        fetch_position(first_frame + current_frame, uint(gl_VertexIndex)),
+        fetch_position(first_frame + next_frame, uint(gl_VertexIndex)),
+        fract(frame));
+
+    gl_Position = view_projection.projection * view_projection.view * vertex_animation_pc.model * instance_model * vec4(position, 1.0);
+    frag_color = vert_color;
+    frag_texture = vert_texture;
+}
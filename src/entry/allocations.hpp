@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+
+namespace MarkoEngine
+{
+	[[nodiscard]] size_t allocation_count();
+}
\ No newline at end of file
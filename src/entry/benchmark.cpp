@@ -0,0 +1,858 @@
+#include "pch.h"
+#include "benchmark.hpp"
+#include "../managers/registry.hpp"
+#include "../managers/spatial.hpp"
+#include "../managers/scene_file.hpp"
+#include "../managers/mapped_file.hpp"
+#include "../managers/blob_store.hpp"
+#include "../managers/compression.hpp"
+#include "../managers/journal.hpp"
+#include "../managers/jobs.hpp"
+#include "../managers/cooked_mesh.hpp"
+#include "../managers/asset_database.hpp"
+#include "../managers/mesh_import.hpp"
+#include "../game_objects/components.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+namespace
+{
+	constexpr int BENCHMARK_PASSES = 10;
+	constexpr size_t GROUP_SIZE = 10;
+
+	// Mirrors the layout game objects had before the registry: one heap node per object, reached by string key.
+	struct Legacy_Game_Object
+	{
+		virtual ~Legacy_Game_Object() = default;
+
+		bool is_visible = true;
+		std::string parent;
+		std::vector<std::string> children;
+		std::string script;
+		game_object_type type = game_object_type::EMPTY;
+		transform local_transform;
+		transform world_transform;
+	};
+
+	template <typename Function>
+	double measure(Function&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+		{
+			function();
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_PASSES;
+	}
+
+	double legacy_pass(size_t count, float& checksum)
+	{
+		std::unordered_map<std::string, std::unique_ptr<Legacy_Game_Object>> objects;
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto object = std::make_unique<Legacy_Game_Object>();
+			object->type = game_object_type::MESH;
+			object->parent = "object_" + std::to_string(i - i % GROUP_SIZE);
+			object->local_transform.position = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+			objects["object_" + std::to_string(i)] = std::move(object);
+		}
+
+		return measure([&]()
+			{
+				for (auto& object : objects)
+				{
+					if (!object.second->is_visible)
+						continue;
+
+					auto parent = objects.find(object.second->parent);
+					object.second->world_transform = parent != objects.end() && parent->second.get() != object.second.get()
+						? parent->second->world_transform + object.second->local_transform
+						: object.second->local_transform;
+					checksum += object.second->world_transform.position.x;
+				}
+			});
+	}
+
+	double registry_pass(size_t count, float& checksum)
+	{
+		MarkoEngine::Registry& registry = MarkoEngine::Registry::get();
+		registry.initialize();
+		registry.reserve(count);
+		registry.pool<Transform_Component>().reserve(count);
+
+		MarkoEngine::Entity group_root;
+		for (size_t i = 0; i < count; ++i)
+		{
+			MarkoEngine::Entity entity = registry.create();
+			Transform_Component& component = registry.emplace<Transform_Component>(entity);
+			component.local.position = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+			if (i % GROUP_SIZE == 0)
+				group_root = entity;
+			else
+				component.parent = group_root;
+		}
+
+		const double milliseconds = measure([&]()
+			{
+				for (Transform_Component& component : registry.pool<Transform_Component>().components())
+				{
+					if (!component.visible)
+						continue;
+
+					Transform_Component* parent = registry.try_get<Transform_Component>(component.parent);
+					component.world = parent ? parent->world + component.local : component.local;
+					checksum += component.world.position.x;
+				}
+			});
+
+		registry.cleanup();
+		return milliseconds;
+	}
+
+	template <typename Function>
+	double measure_once(Function&& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	MarkoEngine::Aabb random_box(std::mt19937& random, float world_size)
+	{
+		std::uniform_real_distribution<float> position(-world_size, world_size);
+		std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+		const glm::vec3 min(position(random), position(random) * 0.1f, position(random));
+		return { min, min + glm::vec3(size(random), size(random), size(random)) };
+	}
+
+	// Writes the string-table format that predates the chunked layout, field by field like the old saver did.
+	void write_legacy_scene(const std::string& filename, const MarkoEngine::Scene_Data& scene)
+	{
+		std::ofstream ofs(filename, std::ios::binary);
+		const uint64_t magic = 0x31454E4543534B4Dull;
+		ofs.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+
+		const uint32_t string_count = static_cast<uint32_t>(scene.strings.size());
+		ofs.write(reinterpret_cast<const char*>(&string_count), sizeof(string_count));
+		for (const std::string& string : scene.strings)
+		{
+			const uint32_t string_size = static_cast<uint32_t>(string.size());
+			ofs.write(reinterpret_cast<const char*>(&string_size), sizeof(string_size));
+			ofs.write(string.data(), string_size);
+		}
+
+		const size_t object_count = scene.objects.size();
+		ofs.write(reinterpret_cast<const char*>(&object_count), sizeof(object_count));
+		for (const MarkoEngine::Scene_Object_Record& record : scene.objects)
+		{
+			const game_object_type type = static_cast<game_object_type>(record.type);
+			ofs.write(reinterpret_cast<const char*>(&type), sizeof(type));
+			ofs.write(reinterpret_cast<const char*>(&record.id), sizeof(uint32_t));
+			ofs.write(reinterpret_cast<const char*>(&record.script), sizeof(uint32_t));
+			ofs.write(reinterpret_cast<const char*>(&record.parent), sizeof(uint32_t));
+
+			const size_t child_count = record.child_count;
+			ofs.write(reinterpret_cast<const char*>(&child_count), sizeof(child_count));
+			ofs.write(reinterpret_cast<const char*>(&scene.children[record.first_child]), sizeof(uint32_t) * child_count);
+
+			ofs.write(reinterpret_cast<const char*>(&record.local), sizeof(transform));
+			ofs.write(reinterpret_cast<const char*>(&record.local), sizeof(transform));
+			if (type == game_object_type::CAMERA)
+				ofs.write(reinterpret_cast<const char*>(&record.vector_a), sizeof(glm::vec3));
+			else if (type == game_object_type::MODEL)
+				ofs.write(reinterpret_cast<const char*>(&record.asset), sizeof(uint32_t));
+		}
+	}
+
+	MarkoEngine::Scene_Data make_scene(size_t count)
+	{
+		MarkoEngine::Scene_Data scene;
+		scene.objects.reserve(count);
+
+		const uint32_t model = scene.add_string("dependencies/crate/Crate1.obj");
+		for (size_t i = 0; i < count; ++i)
+		{
+			MarkoEngine::Scene_Object_Record record{};
+			record.type = i % 3 == 0 ? game_object_type::MODEL : game_object_type::CAMERA;
+			record.id = scene.add_string("object_" + std::to_string(i));
+			record.parent = i % GROUP_SIZE == 0 ? scene.add_string("Root") : scene.add_string("object_" + std::to_string(i - i % GROUP_SIZE));
+			record.asset = record.type == game_object_type::MODEL ? model : 0;
+			record.flags = MarkoEngine::SCENE_OBJECT_VISIBLE;
+			record.local.position = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+			record.vector_a = glm::vec3(0.0f, 1.0f, 0.0f);
+			record.mesh = MarkoEngine::SCENE_NO_INDEX;
+			record.first_child = static_cast<uint32_t>(scene.children.size());
+			if (i % GROUP_SIZE == 0)
+			{
+				for (size_t child = i + 1; child < std::min(count, i + GROUP_SIZE); ++child)
+					scene.children.push_back(scene.add_string("object_" + std::to_string(child)));
+			}
+			record.child_count = static_cast<uint32_t>(scene.children.size()) - record.first_child;
+			scene.objects.push_back(record);
+		}
+		return scene;
+	}
+
+	// A heightfield grid; flat colors and zero skinning data compress the way imported meshes do.
+	void make_grid_mesh(size_t side, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		for (size_t z = 0; z < side; ++z)
+		{
+			for (size_t x = 0; x < side; ++x)
+			{
+				Vertex vertex{};
+				vertex.position = glm::vec3(static_cast<float>(x), std::sin(static_cast<float>(x * z) * 0.01f), static_cast<float>(z));
+				vertex.color = glm::vec3(1.0f);
+				vertex.texture = glm::vec2(static_cast<float>(x) / side, static_cast<float>(z) / side);
+				vertices.push_back(vertex);
+			}
+		}
+
+		for (size_t z = 0; z + 1 < side; ++z)
+		{
+			for (size_t x = 0; x + 1 < side; ++x)
+			{
+				const uint32_t corner = static_cast<uint32_t>(z * side + x);
+				const uint32_t side_count = static_cast<uint32_t>(side);
+				indices.insert(indices.end(), { corner, corner + side_count, corner + 1, corner + 1, corner + side_count, corner + side_count + 1 });
+			}
+		}
+	}
+
+	size_t directory_size(const std::string& directory)
+	{
+		size_t size = 0;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+		{
+			if (entry.is_regular_file())
+				size += entry.file_size();
+		}
+		return size;
+	}
+
+	// One OBJ with its own material and TGA texture, so every asset costs a full import and a decode.
+	void write_benchmark_asset(const std::string& directory, size_t index, size_t side, uint32_t texture_size)
+	{
+		const std::string name = "asset_" + std::to_string(index);
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		make_grid_mesh(side, vertices, indices);
+
+		std::ofstream obj(directory + "/" + name + ".obj");
+		obj << "mtllib " << name << ".mtl\nusemtl " << name << "\n";
+		for (const Vertex& vertex : vertices)
+			obj << "v " << vertex.position.x << " " << vertex.position.y + static_cast<float>(index) << " " << vertex.position.z << "\n";
+		for (const Vertex& vertex : vertices)
+			obj << "vt " << vertex.texture.x << " " << vertex.texture.y << "\n";
+		for (size_t i = 0; i < indices.size(); i += 3)
+			obj << "f " << indices[i] + 1 << "/" << indices[i] + 1 << " " << indices[i + 1] + 1 << "/" << indices[i + 1] + 1 << " "
+			<< indices[i + 2] + 1 << "/" << indices[i + 2] + 1 << "\n";
+
+		std::ofstream mtl(directory + "/" + name + ".mtl");
+		mtl << "newmtl " << name << "\nmap_Kd " << name << ".tga\n";
+
+		// Uncompressed 32-bit TGA, top-left origin.
+		uint8_t header[18] = {};
+		header[2] = 2;
+		header[12] = static_cast<uint8_t>(texture_size & 0xFF);
+		header[13] = static_cast<uint8_t>(texture_size >> 8);
+		header[14] = header[12];
+		header[15] = header[13];
+		header[16] = 32;
+		header[17] = 0x28;
+
+		std::vector<uint8_t> pixels(static_cast<size_t>(texture_size) * texture_size * 4);
+		for (size_t i = 0; i < pixels.size(); ++i)
+			pixels[i] = static_cast<uint8_t>(i * 7 + index * 13);
+
+		std::ofstream tga(directory + "/" + name + ".tga", std::ios::binary);
+		tga.write(reinterpret_cast<const char*>(header), sizeof(header));
+		tga.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+	}
+
+	// A grid as Assimp hands it over after triangulation, with bone_count bones whose influences all cover every
+	// vertex at different strengths, so skinned imports have more than four to choose from.
+	std::unique_ptr<aiMesh> make_imported_mesh(size_t side, unsigned int bone_count)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		make_grid_mesh(side, vertices, indices);
+
+		auto mesh = std::make_unique<aiMesh>();
+		mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		mesh->mNumVertices = static_cast<unsigned int>(vertices.size());
+		mesh->mVertices = new aiVector3D[vertices.size()];
+		mesh->mTextureCoords[0] = new aiVector3D[vertices.size()];
+		mesh->mNumUVComponents[0] = 2;
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			mesh->mVertices[i] = aiVector3D(vertices[i].position.x, vertices[i].position.y, vertices[i].position.z);
+			mesh->mTextureCoords[0][i] = aiVector3D(vertices[i].texture.x, vertices[i].texture.y, 0.0f);
+		}
+
+		mesh->mNumFaces = static_cast<unsigned int>(indices.size() / 3);
+		mesh->mFaces = new aiFace[mesh->mNumFaces];
+		for (size_t i = 0; i < mesh->mNumFaces; ++i)
+		{
+			mesh->mFaces[i].mNumIndices = 3;
+			mesh->mFaces[i].mIndices = new unsigned int[3]{ indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2] };
+		}
+
+		mesh->mNumBones = bone_count;
+		mesh->mBones = bone_count > 0 ? new aiBone*[bone_count] : nullptr;
+		for (unsigned int b = 0; b < bone_count; ++b)
+		{
+			aiBone* bone = new aiBone();
+			bone->mNumWeights = mesh->mNumVertices;
+			bone->mWeights = new aiVertexWeight[mesh->mNumVertices];
+			for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+				bone->mWeights[v] = aiVertexWeight(v, static_cast<float>((v + b * 7) % 11 + 1));
+			mesh->mBones[b] = bone;
+		}
+		return mesh;
+	}
+
+	// Mirrors the conversion create_model and create_animation did before it was done in bulk: one vertex at a
+	// time, indices pushed one by one, and each weight put in the first empty slot.
+	void legacy_convert(const aiMesh* mesh, const std::vector<int>* bone_ids, Imported_Mesh& result, MarkoEngine::Aabb& bounds, MarkoEngine::Triangle_Mesh& triangles)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+
+		vertices.resize(mesh->mNumVertices);
+		for (size_t j = 0; j < mesh->mNumVertices; j++) {
+			vertices[j].position = { mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z };
+			bounds.extend(vertices[j].position);
+
+			if (mesh->mTextureCoords[0]) {
+				vertices[j].texture = { mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y };
+			}
+			else {
+				vertices[j].texture = { 0.0f, 0.0f };
+			}
+
+			vertices[j].color = { 1.0f, 1.0f, 1.0f };
+		}
+
+		for (size_t j = 0; j < mesh->mNumFaces; j++) {
+			aiFace face = mesh->mFaces[j];
+			for (size_t k = 0; k < face.mNumIndices; k++) {
+				indices.push_back(face.mIndices[k]);
+			}
+		}
+
+		if (bone_ids != nullptr) {
+			for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+				const aiBone* bone = mesh->mBones[b];
+				for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+					Vertex& vertex = vertices[bone->mWeights[w].mVertexId];
+					for (int slot = 0; slot < 4; slot++) {
+						if (vertex.weights[slot] == 0.0f) {
+							vertex.bone_ids[slot] = (*bone_ids)[b];
+							vertex.weights[slot] = bone->mWeights[w].mWeight;
+							break;
+						}
+					}
+				}
+			}
+		}
+		else {
+			const uint32_t first_position = static_cast<uint32_t>(triangles.positions.size());
+			for (const Vertex& vertex : vertices)
+				triangles.positions.push_back(vertex.position);
+			for (uint32_t index : indices)
+				triangles.indices.push_back(first_position + index);
+		}
+
+		result = { "", std::move(vertices), std::move(indices) };
+	}
+
+	double triangles_per_second(size_t triangles, double milliseconds)
+	{
+		return static_cast<double>(triangles) / milliseconds / 1000.0;
+	}
+
+	size_t run_queries(const MarkoEngine::Aabb_Tree& tree, const std::vector<MarkoEngine::Aabb>& queries)
+	{
+		size_t hits = 0;
+		for (const MarkoEngine::Aabb& query : queries)
+			tree.query([&query](const MarkoEngine::Aabb& node) { return node.overlaps(query); }, [&hits](MarkoEngine::Entity) { ++hits; });
+		return hits;
+	}
+}
+
+void MarkoEngine::run_entity_benchmarks()
+{
+	std::cout << std::fixed << std::setprecision(3);
+
+	for (size_t count : { size_t(10'000), size_t(100'000), size_t(1'000'000) })
+	{
+		float checksum = 0.0f;
+		const double legacy = legacy_pass(count, checksum);
+		const double dense = registry_pass(count, checksum);
+
+		std::cout << count << " entities: legacy map " << legacy << " ms, registry " << dense << " ms ("
+			<< legacy / dense << "x, checksum " << checksum << ")" << std::endl;
+	}
+}
+
+void MarkoEngine::run_spatial_benchmarks()
+{
+	constexpr size_t COUNT = 100'000;
+	constexpr size_t QUERY_COUNT = 10'000;
+	constexpr float WORLD_SIZE = 1000.0f;
+
+	std::mt19937 random(42);
+	std::vector<Aabb> boxes(COUNT);
+	for (Aabb& box : boxes)
+		box = random_box(random, WORLD_SIZE);
+
+	std::vector<Aabb> queries(QUERY_COUNT);
+	for (Aabb& query : queries)
+	{
+		query = random_box(random, WORLD_SIZE);
+		query.max += glm::vec3(20.0f);
+	}
+
+	Aabb_Tree tree;
+	std::vector<int32_t> proxies(COUNT);
+	const double insert = measure_once([&]()
+		{
+			for (size_t i = 0; i < COUNT; ++i)
+				proxies[i] = tree.insert(boxes[i], { static_cast<uint32_t>(i), 0 });
+		});
+
+	std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+	size_t reinserted = 0;
+	const double move = measure_once([&]()
+		{
+			for (size_t i = 0; i < COUNT; ++i)
+			{
+				const glm::vec3 offset(jitter(random), 0.0f, jitter(random));
+				boxes[i].min += offset;
+				boxes[i].max += offset;
+				reinserted += tree.move(proxies[i], boxes[i]) ? 1 : 0;
+			}
+		});
+
+	size_t hits = 0;
+	const double incremental_query = measure_once([&]() { hits = run_queries(tree, queries); });
+	const int32_t incremental_height = tree.height();
+
+	const double rebuild = measure_once([&]() { tree.rebuild(); });
+	const double rebuilt_query = measure_once([&]() { hits = run_queries(tree, queries); });
+
+	size_t brute_hits = 0;
+	const double brute_force = measure_once([&]()
+		{
+			for (size_t q = 0; q < QUERY_COUNT / 100; ++q)
+			{
+				for (const Aabb& box : boxes)
+					brute_hits += box.overlaps(queries[q]) ? 1 : 0;
+			}
+		}) * 100.0;
+
+	std::cout << COUNT << " proxies: insert " << insert << " ms, move " << move << " ms (" << reinserted << " reinserted), height "
+		<< incremental_height << " -> " << tree.height() << " after SAH rebuild (" << rebuild << " ms)" << std::endl;
+	std::cout << QUERY_COUNT << " box queries: incremental tree " << QUERY_COUNT / incremental_query * 1000.0 << " /s, rebuilt tree "
+		<< QUERY_COUNT / rebuilt_query * 1000.0 << " /s, linear scan " << QUERY_COUNT / brute_force * 1000.0 << " /s ("
+		<< hits << " fat hits, " << brute_hits << " sampled exact hits)" << std::endl;
+}
+
+void MarkoEngine::run_scene_benchmarks()
+{
+	constexpr size_t COUNT = 100'000;
+	const std::string legacy_file = "benchmark_scene_legacy.bin";
+	const std::string chunked_file = "benchmark_scene.bin";
+
+	const Scene_Data scene = make_scene(COUNT);
+	const double legacy_write = measure_once([&]() { write_legacy_scene(legacy_file, scene); });
+	const double chunked_write = measure_once([&]() { write_scene(chunked_file, scene); });
+
+	float checksum = 0.0f;
+	const double legacy_load = measure([&]()
+		{
+			Scene_Data loaded;
+			read_legacy_scene(legacy_file, loaded);
+			for (const Scene_Object_Record& record : loaded.objects)
+				checksum += record.local.position.x + static_cast<float>(loaded.strings[record.id].size() + record.child_count);
+		});
+
+	const double chunked_load = measure([&]()
+		{
+			Mapped_File file(chunked_file);
+			Scene_View view;
+			if (!view.open(file.data(), file.size()))
+				return;
+
+			const auto& records = view.objects();
+			for (size_t i = 0; i < records.size(); ++i)
+				checksum += records[i].local.position.x + static_cast<float>(view.string(records[i].id).size() + records[i].child_count);
+		});
+
+	std::cout << COUNT << " scene objects: write legacy " << legacy_write << " ms, chunked " << chunked_write << " ms; load legacy "
+		<< legacy_load << " ms, mapped chunked " << chunked_load << " ms (" << legacy_load / chunked_load << "x, "
+		<< std::filesystem::file_size(legacy_file) / 1024 << " KB vs " << std::filesystem::file_size(chunked_file) / 1024
+		<< " KB, checksum " << checksum << ")" << std::endl;
+
+	std::filesystem::remove(legacy_file);
+	std::filesystem::remove(chunked_file);
+}
+
+void MarkoEngine::run_blob_benchmarks()
+{
+	constexpr size_t COPIES = 100;
+	const std::string inline_file = "benchmark_mesh_inline.bin";
+	const std::string blob_file = "benchmark_mesh_blobs.bin";
+	const std::string blob_root = "benchmark_blobs";
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	make_grid_mesh(64, vertices, indices);
+
+	const uint8_t* raw = reinterpret_cast<const uint8_t*>(vertices.data());
+	const size_t raw_size = vertices.size() * sizeof(Vertex);
+	std::vector<uint8_t> compressed;
+	const double compress = measure([&]() { compressed = compress_lz(raw, raw_size); });
+
+	std::vector<uint8_t> restored(raw_size);
+	bool round_trip = false;
+	const double decompress = measure([&]() { round_trip = decompress_lz(compressed.data(), compressed.size(), restored.data(), restored.size()); });
+	round_trip = round_trip && std::memcmp(raw, restored.data(), raw_size) == 0;
+
+	Scene_Data inline_scene;
+	Scene_Data blob_scene;
+	for (size_t i = 0; i < COPIES; ++i)
+	{
+		Scene_Object_Record record{};
+		record.type = game_object_type::MESH;
+		record.id = inline_scene.add_string("mesh_" + std::to_string(i));
+		record.flags = SCENE_OBJECT_VISIBLE;
+		record.mesh = static_cast<uint32_t>(inline_scene.meshes.size());
+		inline_scene.meshes.push_back({ inline_scene.vertices.size(), vertices.size(), inline_scene.indices.size(), indices.size() });
+		inline_scene.vertices.insert(inline_scene.vertices.end(), vertices.begin(), vertices.end());
+		inline_scene.indices.insert(inline_scene.indices.end(), indices.begin(), indices.end());
+		inline_scene.objects.push_back(record);
+	}
+
+	std::filesystem::remove_all(blob_root);
+	Blob_Store::get().initialize(blob_root);
+
+	const double inline_save = measure_once([&]() { write_scene(inline_file, inline_scene); });
+	const double blob_save = measure_once([&]()
+		{
+			// Same per-object path as saving MESH objects without a cached hash: hash, find the blob, reference it.
+			blob_scene = Scene_Data{};
+			for (size_t i = 0; i < COPIES; ++i)
+			{
+				Scene_Object_Record record{};
+				record.type = game_object_type::MESH;
+				record.id = blob_scene.add_string("mesh_" + std::to_string(i));
+				record.flags = SCENE_OBJECT_VISIBLE | SCENE_OBJECT_MESH_BLOB;
+				record.mesh = static_cast<uint32_t>(blob_scene.mesh_blobs.size());
+				blob_scene.mesh_blobs.push_back(store_mesh_blob(vertices, indices));
+				blob_scene.objects.push_back(record);
+			}
+			write_scene(blob_file, blob_scene);
+		});
+
+	std::vector<Vertex> loaded_vertices;
+	std::vector<uint32_t> loaded_indices;
+	const bool blob_loaded = load_mesh_blob(blob_scene.mesh_blobs.front(), loaded_vertices, loaded_indices)
+		&& loaded_vertices.size() == vertices.size() && loaded_indices == indices;
+
+	const size_t inline_size = std::filesystem::file_size(inline_file);
+	const size_t blob_size = std::filesystem::file_size(blob_file) + directory_size(blob_root);
+
+	std::cout << "lz: " << raw_size / 1024 << " KB of vertices -> " << compressed.size() / 1024 << " KB ("
+		<< static_cast<double>(raw_size) / compressed.size() << "x), compress " << compress << " ms, decompress " << decompress
+		<< " ms, round trip " << (round_trip ? "ok" : "FAILED") << std::endl;
+	std::cout << COPIES << " copies of one mesh: save inline " << inline_save << " ms, " << inline_size / 1024 << " KB; blob store "
+		<< blob_save << " ms, " << blob_size / 1024 << " KB (" << static_cast<double>(inline_size) / blob_size << "x smaller, load "
+		<< (blob_loaded ? "ok" : "FAILED") << ")" << std::endl;
+
+	std::filesystem::remove(inline_file);
+	std::filesystem::remove(blob_file);
+	std::filesystem::remove_all(blob_root);
+	Blob_Store::get().initialize("backups/blobs");
+}
+
+void MarkoEngine::run_journal_benchmarks()
+{
+	constexpr size_t COUNT = 10'000;
+	constexpr size_t SAVES = 50;
+	constexpr size_t CHANGED = 10;
+	const std::string journal_directory = "benchmark_journal";
+	const std::string full_file = "benchmark_full_save.bin";
+
+	Scene_Data scene = make_scene(COUNT);
+
+	std::filesystem::remove_all(journal_directory);
+	Journal& journal = Journal::get();
+	journal.initialize(journal_directory);
+	journal.save(scene);
+
+	size_t journal_bytes = 0;
+	double journal_time = 0.0;
+	double full_time = 0.0;
+	for (size_t save = 0; save < SAVES; ++save)
+	{
+		for (size_t i = 0; i < CHANGED; ++i)
+			scene.objects[(save * CHANGED + i) * 7 % COUNT].local.position.y += 1.0f;
+
+		journal_time += measure_once([&]() { journal.save(scene); });
+		journal_bytes += journal.last_write_size();
+		full_time += measure_once([&]() { write_scene(full_file, scene); });
+	}
+
+	Scene_Data restored;
+	const double restore = measure_once([&]() { journal.restore(journal.entries().back().sequence, restored); });
+	const size_t entries = journal.entries().size();
+
+	// With background saving the frame only pays for the snapshot; the journal write moves to the backup thread.
+	size_t snapshot_objects = 0;
+	const double snapshot = measure([&]()
+		{
+			Scene_Data copy = scene;
+			snapshot_objects += copy.objects.size();
+		});
+
+	// Saving on the frame, as before the backup thread: the same snapshot and journal write, timed together.
+	double synchronous = 0.0;
+	for (size_t save = 0; save < SAVES; ++save)
+	{
+		for (size_t i = 0; i < CHANGED; ++i)
+			scene.objects[(save * CHANGED + i) * 11 % COUNT].local.position.y += 1.0f;
+
+		synchronous += measure_once([&]()
+			{
+				Scene_Data copy = scene;
+				journal.save(copy);
+			});
+	}
+
+	std::cout << SAVES << " saves of " << COUNT << " objects with " << CHANGED << " changed: journal " << journal_time / SAVES << " ms, "
+		<< journal_bytes / SAVES << " B per save; full rewrite " << full_time / SAVES << " ms, " << std::filesystem::file_size(full_file)
+		<< " B per save; restore newest " << restore << " ms (" << restored.objects.size() << " objects, " << entries
+		<< " entries)" << std::endl;
+	std::cout << "save frame stall: synchronous " << synchronous / SAVES << " ms, background " << snapshot
+		<< " ms (snapshot of " << snapshot_objects / BENCHMARK_PASSES << " objects)" << std::endl;
+
+	std::filesystem::remove_all(journal_directory);
+	std::filesystem::remove(full_file);
+	journal.initialize("backups/journal");
+}
+
+void MarkoEngine::run_load_benchmarks()
+{
+	constexpr size_t ASSETS = 300;
+	constexpr size_t INSTANCES = 4;
+	const std::string directory = "benchmark_assets";
+	const std::string cooked_directory = (std::filesystem::path(COOKED_MESH_DIRECTORY) / directory).string();
+
+	std::filesystem::remove_all(directory);
+	std::filesystem::remove_all(cooked_directory);
+	std::filesystem::create_directories(directory);
+	for (size_t i = 0; i < ASSETS; ++i)
+		write_benchmark_asset(directory, i, 48, 128);
+
+	// The scene references every asset several times, the way props are placed around a level.
+	std::vector<std::string> objects;
+	for (size_t instance = 0; instance < INSTANCES; ++instance)
+	{
+		for (size_t i = 0; i < ASSETS; ++i)
+			objects.push_back(directory + "/asset_" + std::to_string(i) + ".obj");
+	}
+
+	// What constructing the objects one by one did on the CPU: a full import and texture decode per object.
+	size_t per_object_meshes = 0;
+	const double per_object = measure_once([&]()
+		{
+			for (const std::string& filename : objects)
+			{
+				Imported_Model model = Renderer::import_model_source(filename);
+				for (const Imported_Mesh& mesh : model.meshes)
+					per_object_meshes += Renderer::decode_texture_source(mesh.texture_filename).pixels != nullptr;
+			}
+		});
+
+	// Both staged runs start without cooked files, so they import through Assimp and cook.
+	Jobs::get().cleanup();
+	Imported_Assets serial_assets;
+	const double serial = measure_once([&]() { serial_assets = Renderer::import_assets(objects, {}); });
+
+	std::filesystem::remove_all(cooked_directory);
+	Jobs::get().initialize();
+	Imported_Assets parallel_assets;
+	const double parallel = measure_once([&]() { parallel_assets = Renderer::import_assets(objects, {}); });
+
+	size_t decoded = 0;
+	for (const auto& [filename, texture] : parallel_assets.textures)
+		decoded += texture.pixels != nullptr;
+
+	std::cout << "cold load of " << objects.size() << " objects over " << ASSETS << " unique models: per object " << per_object
+		<< " ms (" << per_object_meshes << " textures decoded); staged serial " << serial << " ms; staged on " << Jobs::get().thread_count()
+		<< " threads " << parallel << " ms (" << per_object / parallel << "x, " << parallel_assets.models.size() << " models, " << decoded
+		<< " textures)" << std::endl;
+
+	Imported_Assets cooked_assets;
+	const double cooked = measure_once([&]() { cooked_assets = Renderer::import_assets(objects, {}); });
+
+	Jobs::get().cleanup();
+	double source_import = 0.0;
+	double cooked_import = 0.0;
+	bool same = true;
+	for (size_t i = 0; i < ASSETS; ++i)
+	{
+		Imported_Model from_source;
+		Imported_Model from_cooked;
+		source_import += measure_once([&]() { from_source = Renderer::import_model_source(objects[i]); });
+		cooked_import += measure_once([&]() { load_cooked_model(objects[i], from_cooked); });
+		same = same && from_source.meshes.size() == from_cooked.meshes.size() && from_source.meshes.front().indices == from_cooked.meshes.front().indices &&
+			std::memcmp(from_source.meshes.front().vertices.data(), from_cooked.meshes.front().vertices.data(), from_source.meshes.front().vertices.size() * sizeof(Vertex)) == 0;
+	}
+	Jobs::get().initialize();
+
+	std::cout << "cooked meshes: " << ASSETS << " models through Assimp " << source_import << " ms, from .mmesh " << cooked_import << " ms ("
+		<< source_import / cooked_import << "x, " << directory_size(cooked_directory) / 1024 << " KB cooked, " << (same ? "identical" : "MISMATCH")
+		<< "); warm staged load " << cooked << " ms" << std::endl;
+
+	std::filesystem::remove_all(directory);
+	std::filesystem::remove_all(cooked_directory);
+}
+
+void MarkoEngine::run_cook_benchmarks()
+{
+	constexpr size_t ASSETS = 300;
+	const std::string directory = "benchmark_cook";
+	const std::string cooked_directory = (std::filesystem::path(COOKED_MESH_DIRECTORY) / directory).string();
+	const std::string database = (std::filesystem::path(COOKED_MESH_DIRECTORY) / "benchmark_cook.db").string();
+
+	std::filesystem::remove_all(directory);
+	std::filesystem::remove_all(cooked_directory);
+	std::filesystem::remove(database);
+	std::filesystem::create_directories(directory);
+	for (size_t i = 0; i < ASSETS; ++i)
+		write_benchmark_asset(directory, i, 48, 128);
+
+	Asset_Database& assets = Asset_Database::get();
+	assets.initialize(database);
+	const Cook_Result cold = assets.cook({ directory });
+
+	// Reloaded from disk, the way the next editor session or build starts.
+	assets.initialize(database);
+	const Cook_Result unchanged = assets.cook({ directory });
+
+	const std::string texture = directory + "/asset_0.tga";
+	std::filesystem::last_write_time(texture, std::filesystem::last_write_time(texture) + std::chrono::seconds(1));
+	const Cook_Result touched = assets.cook({ directory });
+
+	{
+		std::fstream file(texture, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(18);
+		file.put(static_cast<char>(0x7F));
+	}
+	const size_t dependents = assets.dependents(texture).size();
+	const Cook_Result edited = assets.cook({ directory });
+
+	std::cout << "asset cook of " << cold.scanned << " sources: cold " << cold.milliseconds << " ms (" << cold.cooked << " cooked, "
+		<< cold.failed << " failed); no change " << unchanged.milliseconds << " ms (" << unchanged.cooked << " cooked); touched texture "
+		<< touched.milliseconds << " ms (" << touched.cooked << " cooked); edited texture " << edited.milliseconds << " ms (" << edited.cooked
+		<< " cooked, " << dependents << " dependents)" << std::endl;
+
+	std::filesystem::remove_all(directory);
+	std::filesystem::remove_all(cooked_directory);
+	std::filesystem::remove(database);
+	assets.initialize();
+}
+
+void MarkoEngine::run_import_benchmarks()
+{
+	constexpr size_t MESHES = 16;
+	constexpr size_t SIDE = 256;
+	constexpr unsigned int BONES = 6;
+
+	std::vector<std::unique_ptr<aiMesh>> owned_meshes;
+	std::vector<const aiMesh*> meshes;
+	size_t triangles = 0;
+	for (size_t i = 0; i < MESHES; ++i)
+	{
+		owned_meshes.push_back(make_imported_mesh(SIDE, BONES));
+		meshes.push_back(owned_meshes.back().get());
+		triangles += owned_meshes.back()->mNumFaces;
+	}
+
+	const std::vector<std::string> texture_filenames = { "" };
+	std::vector<int> mesh_bone_ids(BONES);
+	for (unsigned int b = 0; b < BONES; ++b)
+		mesh_bone_ids[b] = static_cast<int>(b);
+	const std::vector<std::vector<int>> bone_ids(MESHES, mesh_bone_ids);
+
+	std::vector<Imported_Mesh> legacy_meshes(MESHES);
+	const double legacy = measure([&]()
+		{
+			Aabb bounds;
+			Triangle_Mesh picking;
+			for (size_t i = 0; i < MESHES; ++i)
+				legacy_convert(meshes[i], nullptr, legacy_meshes[i], bounds, picking);
+		});
+
+	Jobs::get().cleanup();
+	std::vector<Imported_Mesh> bulk_meshes;
+	std::shared_ptr<Triangle_Mesh> picking;
+	const double serial = measure([&]()
+		{
+			Aabb bounds;
+			convert_meshes(meshes, texture_filenames, nullptr, bulk_meshes, bounds);
+			picking = build_triangle_mesh(bulk_meshes);
+		});
+
+	Jobs::get().initialize();
+	const double parallel = measure([&]()
+		{
+			Aabb bounds;
+			convert_meshes(meshes, texture_filenames, nullptr, bulk_meshes, bounds);
+			picking = build_triangle_mesh(bulk_meshes);
+		});
+
+	bool same = picking->indices.size() == triangles * 3;
+	for (size_t i = 0; i < MESHES; ++i)
+	{
+		same = same && bulk_meshes[i].indices == legacy_meshes[i].indices && bulk_meshes[i].vertices.size() == legacy_meshes[i].vertices.size() &&
+			std::memcmp(bulk_meshes[i].vertices.data(), legacy_meshes[i].vertices.data(), bulk_meshes[i].vertices.size() * sizeof(Vertex)) == 0;
+	}
+
+	const double skinned_legacy = measure([&]()
+		{
+			Aabb bounds;
+			Triangle_Mesh unused;
+			for (size_t i = 0; i < MESHES; ++i)
+				legacy_convert(meshes[i], &bone_ids[i], legacy_meshes[i], bounds, unused);
+		});
+	const double skinned = measure([&]()
+		{
+			Aabb bounds;
+			convert_meshes(meshes, texture_filenames, &bone_ids, bulk_meshes, bounds);
+		});
+
+	// Every vertex has six influences; the bulk path keeps the strongest four and makes them sum to one.
+	bool normalized = true;
+	for (const Imported_Mesh& mesh : bulk_meshes)
+	{
+		for (const Vertex& vertex : mesh.vertices)
+			normalized = normalized && std::abs(vertex.weights.x + vertex.weights.y + vertex.weights.z + vertex.weights.w - 1.0f) < 1e-4f;
+	}
+
+	std::cout << "mesh import of " << triangles << " triangles in " << MESHES << " meshes: per vertex " << legacy << " ms ("
+		<< triangles_per_second(triangles, legacy) << " M triangles/s); bulk serial " << serial << " ms (" << triangles_per_second(triangles, serial)
+		<< " M triangles/s); bulk on " << Jobs::get().thread_count() << " threads " << parallel << " ms (" << triangles_per_second(triangles, parallel)
+		<< " M triangles/s, " << legacy / parallel << "x, " << (same ? "identical" : "MISMATCH") << ")" << std::endl;
+	std::cout << "skinned import with " << BONES << " influences per vertex: first four slots " << skinned_legacy << " ms ("
+		<< triangles_per_second(triangles, skinned_legacy) << " M triangles/s); strongest four " << skinned << " ms ("
+		<< triangles_per_second(triangles, skinned) << " M triangles/s, " << skinned_legacy / skinned << "x, weights "
+		<< (normalized ? "normalized" : "NOT NORMALIZED") << ")" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace MarkoEngine
+{
+	void run_entity_benchmarks();
+	void run_spatial_benchmarks();
+	void run_scene_benchmarks();
+	void run_blob_benchmarks();
+	void run_journal_benchmarks();
+	void run_load_benchmarks();
+	void run_cook_benchmarks();
+	void run_import_benchmarks();
+}
\ No newline at end of file
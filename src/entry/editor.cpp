@@ -4,24 +4,44 @@
 #include "../managers/gui.hpp"
 #include "../managers/script.hpp"
 #include "../managers/backup.hpp"
+#include "../managers/registry.hpp"
+#include "../managers/spatial.hpp"
+#include "../managers/jobs.hpp"
+#include "../managers/asset_database.hpp"
+#include "../managers/file_system.hpp"
+#include "../managers/asset_loader.hpp"
+#include "../managers/texture_streaming.hpp"
+#include "../managers/hot_reload.hpp"
 
 #include "../game_objects/camera_game_object.hpp"
 
 #include "../game_objects/model_game_object.hpp"
 #include "../game_objects/mesh_game_object.hpp"
 #include "../game_objects/animated_game_object.hpp"
+#include "../game_objects/components.hpp"
 
 #include <iostream>
 
 Editor::Editor() : editor_camera(nullptr)
 {
+	MarkoEngine::Registry::get().initialize();
+	MarkoEngine::Jobs::get().initialize();
+	#ifdef EXPORT
+	MarkoEngine::File_System::get().initialize(MarkoEngine::ARCHIVE_FILENAME, false);
+	#else
+	MarkoEngine::File_System::get().initialize(MarkoEngine::ARCHIVE_FILENAME, true);
+	#endif
+	MarkoEngine::Asset_Database::get().initialize();
 	MarkoEngine::Window::get().initialize();
 	Renderer::get().initialize();
+	MarkoEngine::Texture_Streaming::get().initialize();
+	MarkoEngine::Asset_Loader::get().initialize();
 	MarkoEngine::Script::get().initialize();
 	MarkoEngine::Gui::get().initialize();
 	marko_engine::Backup::get().initialize();
 
 	#ifndef EXPORT
+	MarkoEngine::Hot_Reload::get().initialize();
 	editor_camera = new CAMERA_GAME_OBJECT();
     transform t = editor_camera->get_local_transform();
     t.position.y = 1;
@@ -32,11 +52,20 @@ Editor::Editor() : editor_camera(nullptr)
 Editor::~Editor()
 {
 	delete editor_camera;
+	I_GAME_OBJECT::game_objects.clear();
     marko_engine::Backup::get().cleanup();
+	MarkoEngine::Hot_Reload::get().cleanup();
+	MarkoEngine::Asset_Loader::get().cleanup();
+	MarkoEngine::Texture_Streaming::get().cleanup();
 	MarkoEngine::Gui::get().cleanup();
 	MarkoEngine::Script::get().cleanup();
 	Renderer::get().cleanup();
 	MarkoEngine::Window::get().cleanup();
+	MarkoEngine::Spatial::get().cleanup();
+	MarkoEngine::Asset_Database::get().cleanup();
+	MarkoEngine::File_System::get().cleanup();
+	MarkoEngine::Jobs::get().cleanup();
+	MarkoEngine::Registry::get().cleanup();
 }
 
 void Editor::run()
@@ -48,14 +77,17 @@ void Editor::run()
 
     while (!MarkoEngine::Window::get().should_close())
     {
+        MarkoEngine::Window::get().update();
 
         if (MarkoEngine::Window::get().key_pressed(GLFW_KEY_S) && MarkoEngine::Window::get().key_pressed(GLFW_KEY_LEFT_CONTROL) ||
             MarkoEngine::Window::get().key_held(GLFW_KEY_S) && MarkoEngine::Window::get().key_pressed(GLFW_KEY_LEFT_CONTROL) ||
             MarkoEngine::Window::get().key_pressed(GLFW_KEY_S) && MarkoEngine::Window::get().key_held(GLFW_KEY_LEFT_CONTROL))
         {
             marko_engine::Backup::get().save_object_state();
-            std::cout << "save completed!" << std::endl;
         }
+        marko_engine::Backup::get().update();
+        MarkoEngine::Hot_Reload::get().update();
+        MarkoEngine::Asset_Loader::get().update();
 
 
         if ((MarkoEngine::Gui::get().playing() != MarkoEngine::Gui::get().prev_playing()) && MarkoEngine::Gui::get().playing())
@@ -122,14 +154,12 @@ void Editor::run()
 
         if (MarkoEngine::Gui::get().playing())
         {
-            for (const auto& object : I_GAME_OBJECT::game_objects)
-            {
-                if (object.second->get_type() == game_object_type::CAMERA)
+            MarkoEngine::Registry::get().each<Camera_Component, Transform_Component>(
+                [this](MarkoEngine::Entity entity, Camera_Component& camera, Transform_Component& transform)
                 {
-                    auto* camera = dynamic_cast<CAMERA_GAME_OBJECT*>(object.second.get());
-                    Renderer::get().set_view_matrix(camera->get_view_matrix());
-                }
-            }
+                    if (editor_camera == nullptr || entity != editor_camera->get_entity())
+                        Renderer::get().set_view_matrix(CAMERA_GAME_OBJECT::view_matrix(transform.local, camera));
+                });
             MarkoEngine::Script::get().call_update();
         }
 
@@ -140,7 +170,6 @@ void Editor::run()
         }
 
 
-        MarkoEngine::Window::get().update();
         Renderer::get().update();
         MarkoEngine::Script::get().update();
     }
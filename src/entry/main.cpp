@@ -1,10 +1,49 @@
 #include "pch.h"
 #include "editor.hpp"
+#include "benchmark.hpp"
+#include "../managers/scene_file.hpp"
+#include "../managers/asset_database.hpp"
 
-int main()
+int main(int argc, char* argv[])
 {
     try 
     {
+        if (argc > 1 && std::string(argv[1]) == "--benchmark")
+        {
+            MarkoEngine::run_entity_benchmarks();
+            MarkoEngine::run_spatial_benchmarks();
+            MarkoEngine::run_scene_benchmarks();
+            MarkoEngine::run_blob_benchmarks();
+            MarkoEngine::run_journal_benchmarks();
+            MarkoEngine::run_load_benchmarks();
+            MarkoEngine::run_cook_benchmarks();
+            MarkoEngine::run_import_benchmarks();
+            return EXIT_SUCCESS;
+        }
+
+        if (argc > 1 && std::string(argv[1]) == "--cook-assets")
+        {
+            std::vector<std::string> directories(argv + 2, argv + argc);
+            if (directories.empty())
+                directories = { "content", "dependencies" };
+
+            MarkoEngine::Jobs::get().initialize();
+            MarkoEngine::Asset_Database::get().initialize();
+            MarkoEngine::Cook_Result result = MarkoEngine::Asset_Database::get().cook(directories);
+            MarkoEngine::Asset_Database::get().cleanup();
+            std::cout << result.cooked << " of " << result.scanned << " assets cooked, " << result.failed << " failed, in "
+                << result.milliseconds << " ms" << std::endl;
+            return result.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        if (argc > 1 && std::string(argv[1]) == "--convert-scenes")
+        {
+            size_t converted = MarkoEngine::convert_scenes(argc > 2 ? argv[2] : "backups");
+            std::cout << converted << " scene files converted" << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+
         Editor editor;
         editor.run();
     }
@@ -1,6 +1,7 @@
 #include "pch.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include "animated_game_object.hpp"
+#include "components.hpp"
 #include <glm/gtx/quaternion.hpp>
 #include <stb/stb_image.h>
 #include <vulkan/vulkan.h>
@@ -12,18 +13,70 @@ ANIMATED_GAME_OBJECT::ANIMATED_GAME_OBJECT(const std::string& model) : I_GAME_OB
 {
 
     renderer_animation = Renderer::get().create_animation(model);
+    renderer_animation.skinning = Renderer::get().create_skinning(renderer_animation);
     this->model = model;
 
-    renderer_animation.final_bone_matrices.resize(100, glm::mat4(1.0f));
+    MarkoEngine::Registry::get().emplace<Mesh_Renderer_Component>(entity, game_object_type::ANIMATED, this);
+    MarkoEngine::Registry::get().emplace<Animator_Component>(entity, this);
+    update_bounds();
+}
+
+void ANIMATED_GAME_OBJECT::Animate()
+{
+    Renderer::get().animate(renderer_animation);
 }
 
 void ANIMATED_GAME_OBJECT::Draw()
 {
-    renderer_animation.t = get_world_transform();
+    renderer_animation.model = get_local_to_world();
     Renderer::get().draw_animation(renderer_animation);
 }
 
 void ANIMATED_GAME_OBJECT::reload()
 {
+    Renderer::get().retire_skinning(renderer_animation.skinning);
     renderer_animation = Renderer::get().create_animation(model);
+    renderer_animation.skinning = Renderer::get().create_skinning(renderer_animation);
+    update_bounds();
+}
+
+// Skinned vertices are posed under the root correction and drawn with it again, so both orientations of the
+// bind pose are covered, padded for limbs that swing outside it.
+void ANIMATED_GAME_OBJECT::update_bounds()
+{
+    if (!renderer_animation.asset || !renderer_animation.asset->bounds.valid())
+    {
+        set_local_bounds(MarkoEngine::Aabb());
+        return;
+    }
+
+    const MarkoEngine::Aabb& bind_pose = renderer_animation.asset->bounds;
+    MarkoEngine::Aabb bounds = MarkoEngine::Aabb::merge(bind_pose, bind_pose.transformed(Renderer::animation_correction()));
+
+    const glm::vec3 extent = bounds.extent();
+    const float padding = 0.5f * std::max(extent.x, std::max(extent.y, extent.z));
+    bounds.min -= glm::vec3(padding);
+    bounds.max += glm::vec3(padding);
+
+    set_local_bounds(bounds, Renderer::animation_correction());
+}
+
+bool ANIMATED_GAME_OBJECT::play(std::string_view clip, float fade_duration, uint32_t layer, bool loop)
+{
+    return Renderer::get().play_animation(renderer_animation, clip, fade_duration, layer, loop);
+}
+
+void ANIMATED_GAME_OBJECT::stop(uint32_t layer)
+{
+    Renderer::get().stop_animation(renderer_animation, layer);
+}
+
+void ANIMATED_GAME_OBJECT::set_layer(uint32_t layer, float weight, bool additive)
+{
+    Renderer::get().set_animation_layer(renderer_animation, layer, weight, additive);
+}
+
+void ANIMATED_GAME_OBJECT::set_speed(float speed, uint32_t layer)
+{
+    Renderer::get().set_animation_speed(renderer_animation, speed, layer);
 }
\ No newline at end of file
@@ -9,9 +9,18 @@ class ANIMATED_GAME_OBJECT : public I_GAME_OBJECT
 {
 public:
     ANIMATED_GAME_OBJECT(const std::string& model);
+    void Animate();
     void Draw();
     void reload();
+    bool play(std::string_view clip, float fade_duration = 0.0f, uint32_t layer = 0, bool loop = true);
+    void stop(uint32_t layer = 0);
+    void set_layer(uint32_t layer, float weight, bool additive);
+    void set_speed(float speed, uint32_t layer = 0);
+    const std::vector<Animation_Layer>& get_layers() const { return renderer_animation.layers; }
+    void set_layers(const std::vector<Animation_Layer>& layers) { renderer_animation.layers = layers; }
     std::string model;
 private:
+    void update_bounds();
+
     Renderer_Animation renderer_animation;
 };
\ No newline at end of file
@@ -2,4 +2,15 @@
 #include "box_collider_game_object.hpp"
 
 
-BOX_COLLIDER_GAME_OBJECT::BOX_COLLIDER_GAME_OBJECT(const glm::vec3& min, const glm::vec3& max) : I_GAME_OBJECT(game_object_type::BOX_COLLIDER), min(min), max(max) {}
\ No newline at end of file
+BOX_COLLIDER_GAME_OBJECT::BOX_COLLIDER_GAME_OBJECT() : BOX_COLLIDER_GAME_OBJECT(glm::vec3(0.0f), glm::vec3(0.0f)) {}
+
+BOX_COLLIDER_GAME_OBJECT::BOX_COLLIDER_GAME_OBJECT(const glm::vec3& min, const glm::vec3& max) : I_GAME_OBJECT(game_object_type::BOX_COLLIDER)
+{
+	MarkoEngine::Registry::get().emplace<Box_Collider_Component>(entity, min, max);
+	set_local_bounds({ glm::min(min, max), glm::max(min, max) });
+}
+
+Box_Collider_Component& BOX_COLLIDER_GAME_OBJECT::collider() const
+{
+	return MarkoEngine::Registry::get().get<Box_Collider_Component>(entity);
+}
\ No newline at end of file
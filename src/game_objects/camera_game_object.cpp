@@ -1,26 +1,41 @@
 #include "pch.h"
 #include "camera_game_object.hpp"
+#include "../managers/transforms.hpp"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 
 
-CAMERA_GAME_OBJECT::CAMERA_GAME_OBJECT() : I_GAME_OBJECT(game_object_type::CAMERA), world_up(0.0f, 1.0f, 0.0f) {}
+CAMERA_GAME_OBJECT::CAMERA_GAME_OBJECT() : I_GAME_OBJECT(game_object_type::CAMERA)
+{
+    MarkoEngine::Registry::get().emplace<Camera_Component>(entity);
+}
+
+Camera_Component& CAMERA_GAME_OBJECT::camera() const
+{
+    return MarkoEngine::Registry::get().get<Camera_Component>(entity);
+}
 
 void CAMERA_GAME_OBJECT::rotate(glm::vec2 mouse_delta, float sensitivity)
 {
     float delta_x = -mouse_delta.x * sensitivity;
     float delta_y = -mouse_delta.y * sensitivity;
+    transform& local_transform = transform_component().local;
 
     local_transform.rotation.x += delta_y;
     local_transform.rotation.y += delta_x;
 
     if (local_transform.rotation.x > 89.0f) local_transform.rotation.x = 89.0f;
     if (local_transform.rotation.x < -89.0f) local_transform.rotation.x = -89.0f;
+
+    MarkoEngine::Transforms::get().mark_dirty(entity);
 }
 
 void CAMERA_GAME_OBJECT::translate(glm::vec3 direction, float speed)
 {
+    const transform& local_transform = transform_component().local;
+    const glm::vec3 world_up = camera().world_up;
+
     glm::vec3 front;
     front.x = cos(-glm::radians(local_transform.rotation.y)) * cos(glm::radians(local_transform.rotation.x));
     front.y = sin(glm::radians(local_transform.rotation.x));
@@ -38,6 +53,13 @@ void CAMERA_GAME_OBJECT::translate(glm::vec3 direction, float speed)
 
 glm::mat4 CAMERA_GAME_OBJECT::get_view_matrix() const
 {
+    return view_matrix(transform_component().local, camera());
+}
+
+glm::mat4 CAMERA_GAME_OBJECT::view_matrix(const transform& local_transform, const Camera_Component& camera)
+{
+    const glm::vec3 world_up = camera.world_up;
+
     glm::vec3 front;
     front.x = cos(glm::radians(-local_transform.rotation.y)) * cos(glm::radians(local_transform.rotation.x));
     front.y = sin(glm::radians(local_transform.rotation.x));
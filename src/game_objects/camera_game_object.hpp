@@ -1,5 +1,6 @@
 #pragma once
 #include "i_game_object.hpp"
+#include "components.hpp"
 
 class CAMERA_GAME_OBJECT : public I_GAME_OBJECT
 {
@@ -8,5 +9,6 @@ public:
     void rotate(glm::vec2 mouse_delta, float sensitivity);
     void translate(glm::vec3 direction, float speed);
     glm::mat4 get_view_matrix() const;
-    glm::vec3 world_up;
+    static glm::mat4 view_matrix(const transform& local_transform, const Camera_Component& camera);
+    Camera_Component& camera() const;
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include "i_game_object.hpp"
+#include "../managers/spatial.hpp"
+
+class ANIMATED_GAME_OBJECT;
+
+struct Transform_Component
+{
+	transform local;
+	transform world;
+	glm::mat4 local_to_world{ 1.0f };
+	MarkoEngine::Entity parent;
+	bool visible = true;
+	bool dirty = true;
+	bool changed = false;
+};
+
+struct Mesh_Renderer_Component
+{
+	game_object_type type;
+	I_GAME_OBJECT* object;
+};
+
+struct Camera_Component
+{
+	glm::vec3 world_up{ 0.0f, 1.0f, 0.0f };
+};
+
+struct Box_Collider_Component
+{
+	glm::vec3 min{ 0.0f };
+	glm::vec3 max{ 0.0f };
+};
+
+struct Animator_Component
+{
+	ANIMATED_GAME_OBJECT* object;
+};
+
+struct Script_Component
+{
+	MarkoEngine::Name script;
+};
+
+struct Bounds_Component
+{
+	MarkoEngine::Aabb local;
+	MarkoEngine::Aabb world;
+	glm::mat4 world_correction{ 1.0f };
+	int32_t proxy = MarkoEngine::Aabb_Tree::null_node;
+	bool dirty = true;
+};
+
+struct Pick_Mesh_Component
+{
+	std::shared_ptr<const MarkoEngine::Triangle_Mesh> mesh;
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "crowd_game_object.hpp"
+#include "components.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+CROWD_GAME_OBJECT::CROWD_GAME_OBJECT(const std::string& model, size_t instance_count, float spacing) : I_GAME_OBJECT(game_object_type::CROWD)
+{
+    this->model = model;
+    this->instance_count = instance_count;
+    this->spacing = spacing;
+
+    reload();
+
+    MarkoEngine::Registry::get().emplace<Mesh_Renderer_Component>(entity, game_object_type::CROWD, this);
+}
+
+void CROWD_GAME_OBJECT::Draw()
+{
+    Renderer::get().draw_vertex_animation(renderer_vertex_animation, renderer_crowd, get_local_to_world());
+}
+
+void CROWD_GAME_OBJECT::reload()
+{
+    Renderer::get().retire_vertex_animation(renderer_vertex_animation);
+    renderer_vertex_animation = Renderer::get().create_vertex_animation(model);
+    rebuild_instances();
+}
+
+void CROWD_GAME_OBJECT::rebuild_instances()
+{
+    Renderer::get().retire_crowd(renderer_crowd);
+    renderer_crowd = Renderer_Crowd{};
+
+    if (renderer_vertex_animation.clips.empty() || instance_count == 0)
+    {
+        set_local_bounds(MarkoEngine::Aabb());
+        return;
+    }
+
+    size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(instance_count))));
+
+    std::vector<Vertex_Animation_Instance> instances(instance_count);
+    MarkoEngine::Aabb bounds;
+    for (size_t i = 0; i < instance_count; i++)
+    {
+        uint32_t hash = static_cast<uint32_t>(i) * 2654435761u;
+        float random = static_cast<float>(hash >> 8) / static_cast<float>(1u << 24);
+
+        float x = (static_cast<float>(i % columns) - columns * 0.5f) * spacing;
+        float z = (static_cast<float>(i / columns) - columns * 0.5f) * spacing;
+
+        const Vertex_Animation_Clip& clip = renderer_vertex_animation.clips[i % renderer_vertex_animation.clips.size()];
+
+        instances[i].model = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, z)), glm::radians(random * 360.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        instances[i].animation = glm::vec4(random * 10.0f, 0.8f + random * 0.4f, static_cast<float>(clip.first_frame), static_cast<float>(clip.frame_count));
+        bounds = MarkoEngine::Aabb::merge(bounds, renderer_vertex_animation.bounds.transformed(instances[i].model));
+    }
+
+    set_local_bounds(bounds, Renderer::animation_correction());
+
+    renderer_crowd = Renderer::get().create_crowd(instances);
+}
\ No newline at end of file
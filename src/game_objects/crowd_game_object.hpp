@@ -0,0 +1,19 @@
+#pragma once
+#include "i_game_object.hpp"
+#include "../managers/renderer.hpp"
+
+class CROWD_GAME_OBJECT : public I_GAME_OBJECT
+{
+public:
+    CROWD_GAME_OBJECT(const std::string& model, size_t instance_count = 100, float spacing = 2.0f);
+    void Draw();
+    // Re-bakes the model; changing only instance_count or spacing needs just rebuild_instances.
+    void reload();
+    void rebuild_instances();
+    std::string model;
+    size_t instance_count;
+    float spacing;
+private:
+    Renderer_Vertex_Animation renderer_vertex_animation;
+    Renderer_Crowd renderer_crowd;
+};
\ No newline at end of file
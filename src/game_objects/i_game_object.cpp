@@ -1,40 +1,73 @@
 #include "pch.h"
 #include "i_game_object.hpp"
+#include "components.hpp"
+#include "../managers/transforms.hpp"
+#include "../managers/scene_file.hpp"
+#include "../managers/file_system.hpp"
 
 #include "game_objects/camera_game_object.hpp"
 #include "game_objects/mesh_game_object.hpp"
 #include "game_objects/model_game_object.hpp"
 #include "game_objects/box_collider_game_object.hpp"
 #include "game_objects/animated_game_object.hpp"
+#include "game_objects/crowd_game_object.hpp"
 
-std::unordered_map<std::string, std::unique_ptr<I_GAME_OBJECT>> I_GAME_OBJECT::game_objects;
+std::unordered_map<MarkoEngine::Name, std::unique_ptr<I_GAME_OBJECT>> I_GAME_OBJECT::game_objects;
 
-I_GAME_OBJECT::I_GAME_OBJECT(): type(game_object_type::EMPTY), parent("Root"), children(), local_transform(), script() {}
+I_GAME_OBJECT::I_GAME_OBJECT() : I_GAME_OBJECT(game_object_type::EMPTY) {}
 
-I_GAME_OBJECT::I_GAME_OBJECT(const game_object_type& type) : type(type), parent("Root"), children(), local_transform(), script() {}
+I_GAME_OBJECT::I_GAME_OBJECT(const game_object_type& type) : parent(), children(), type(type), entity(MarkoEngine::Registry::get().create())
+{
+	MarkoEngine::Registry::get().emplace<Transform_Component>(entity);
+	MarkoEngine::Transforms::get().mark_dirty(entity);
+	set_parent("Root");
+}
 
-I_GAME_OBJECT::~I_GAME_OBJECT() {}
+I_GAME_OBJECT::~I_GAME_OBJECT()
+{
+	MarkoEngine::Spatial::get().remove(entity);
+	MarkoEngine::Registry::get().destroy(entity);
+	MarkoEngine::Transforms::get().mark_hierarchy_dirty();
+}
 
-void I_GAME_OBJECT::set_parent(const std::string& parent_id)
+void I_GAME_OBJECT::set_parent(MarkoEngine::Name parent_id)
 {
 	parent = parent_id;
+
+	auto it = game_objects.find(parent_id);
+	transform_component().parent = it != game_objects.end() ? it->second->entity : MarkoEngine::null_entity;
+	MarkoEngine::Transforms::get().mark_hierarchy_dirty();
+}
+
+MarkoEngine::Name I_GAME_OBJECT::find_id(MarkoEngine::Entity entity)
+{
+	for (const auto& [id, object] : game_objects)
+	{
+		if (object->entity == entity)
+			return id;
+	}
+	return MarkoEngine::Name();
 }
 
-void I_GAME_OBJECT::set_child(const std::string& child_id)
+void I_GAME_OBJECT::set_child(MarkoEngine::Name child_id)
 {
 	children.push_back(child_id);
 }
 
-void I_GAME_OBJECT::set_script(const std::string& script)
+void I_GAME_OBJECT::set_script(MarkoEngine::Name script)
 {
-	this->script = script;
+	if (script.empty())
+		MarkoEngine::Registry::get().remove<Script_Component>(entity);
+	else
+		MarkoEngine::Registry::get().emplace<Script_Component>(entity, script);
 }
 
 void I_GAME_OBJECT::translate_local_transform(glm::vec3 axis, float factor)
 {
 	if (glm::length(axis) > 0.0f)
 	{
-		local_transform.position += glm::normalize(axis) * factor;
+		transform_component().local.position += glm::normalize(axis) * factor;
+		MarkoEngine::Transforms::get().mark_dirty(entity);
 	}
 }
 
@@ -42,7 +75,8 @@ void I_GAME_OBJECT::rotate_local_transform(glm::vec3 axis, float factor)
 {
 	if (glm::length(axis) > 0.0f)
 	{
-		local_transform.rotation += glm::normalize(axis) * factor;
+		transform_component().local.rotation += glm::normalize(axis) * factor;
+		MarkoEngine::Transforms::get().mark_dirty(entity);
 	}
 }
 
@@ -50,18 +84,25 @@ void I_GAME_OBJECT::scale_local_transform(glm::vec3 axis, float factor)
 {
 	if (glm::length(axis) > 0.0f)
 	{
-		local_transform.scale *= (1.0f + glm::normalize(axis) * factor);
+		transform_component().local.scale *= (1.0f + glm::normalize(axis) * factor);
+		MarkoEngine::Transforms::get().mark_dirty(entity);
 	}
 }
 
 void I_GAME_OBJECT::set_local_transform(const transform new_local_transform)
 {
-	local_transform = new_local_transform;
+	transform_component().local = new_local_transform;
+	MarkoEngine::Transforms::get().mark_dirty(entity);
 }
 
 void I_GAME_OBJECT::set_world_transform(const transform new_world_transform)
 {
-	world_transform = new_world_transform;
+	transform_component().world = new_world_transform;
+}
+
+void I_GAME_OBJECT::set_visible(bool visible)
+{
+	transform_component().visible = visible;
 }
 
 game_object_type I_GAME_OBJECT::get_type() const
@@ -69,259 +110,284 @@ game_object_type I_GAME_OBJECT::get_type() const
 	return type;
 }
 
-std::string I_GAME_OBJECT::get_script() const
+MarkoEngine::Name I_GAME_OBJECT::get_script() const
 {
-	return script;
+	Script_Component* component = MarkoEngine::Registry::get().try_get<Script_Component>(entity);
+	return component ? component->script : MarkoEngine::Name();
 }
 
-std::string I_GAME_OBJECT::get_parent() const
+MarkoEngine::Name I_GAME_OBJECT::get_parent() const
 {
 	return parent;
 }
 
 transform I_GAME_OBJECT::get_local_transform() const
 {
-	return local_transform;
+	return transform_component().local;
 }
 
 transform I_GAME_OBJECT::get_world_transform() const
 {
-	return world_transform;
+	return transform_component().world;
 }
 
-std::vector<std::string>& I_GAME_OBJECT::get_children()
+std::vector<MarkoEngine::Name>& I_GAME_OBJECT::get_children()
 {
 	return children;
 }
 
-void I_GAME_OBJECT::save_to_binary(const std::string& filename) {
-    std::ofstream ofs(filename, std::ios::binary);
-    if (!ofs) {
-        std::cerr << "Failed to open file for saving: " << filename << std::endl;
-        return;
-    }
-
-    size_t game_objects_size = game_objects.size();
-    ofs.write(reinterpret_cast<const char*>(&game_objects_size), sizeof(game_objects_size));
-
-    for (const auto& obj_pair : game_objects) {
-        I_GAME_OBJECT* obj = obj_pair.second.get();
+MarkoEngine::Entity I_GAME_OBJECT::get_entity() const
+{
+	return entity;
+}
 
-        game_object_type type = obj->type;
-        ofs.write(reinterpret_cast<const char*>(&type), sizeof(type));
+glm::mat4 I_GAME_OBJECT::get_local_to_world() const
+{
+	return transform_component().local_to_world;
+}
 
+bool I_GAME_OBJECT::is_visible() const
+{
+	return transform_component().visible;
+}
 
-        size_t id_size = obj_pair.first.size();
-        ofs.write(reinterpret_cast<const char*>(&id_size), sizeof(id_size));
-        ofs.write(obj_pair.first.c_str(), id_size);
+Transform_Component& I_GAME_OBJECT::transform_component() const
+{
+	return MarkoEngine::Registry::get().get<Transform_Component>(entity);
+}
 
+void I_GAME_OBJECT::set_local_bounds(const MarkoEngine::Aabb& bounds, const glm::mat4& world_correction)
+{
+	Bounds_Component* component = MarkoEngine::Registry::get().try_get<Bounds_Component>(entity);
+	if (!component)
+		component = &MarkoEngine::Registry::get().emplace<Bounds_Component>(entity);
 
-        size_t script_size = obj->get_script().size();
-        ofs.write(reinterpret_cast<const char*>(&script_size), sizeof(script_size));
-        ofs.write(obj->get_script().c_str(), script_size);
+	component->local = bounds;
+	component->world_correction = world_correction;
+	component->dirty = true;
+}
 
+void I_GAME_OBJECT::save_to_binary(const std::string& filename) {
+    MarkoEngine::Scene_Data scene;
+    build_scene(scene);
+    MarkoEngine::write_scene(filename, scene);
+}
 
-        size_t parent_size = obj->get_parent().size();
-        ofs.write(reinterpret_cast<const char*>(&parent_size), sizeof(parent_size));
-        ofs.write(obj->get_parent().c_str(), parent_size);
+void I_GAME_OBJECT::build_scene(MarkoEngine::Scene_Data& scene, std::vector<std::shared_ptr<MarkoEngine::Mesh_Geometry>>* meshes) {
+    scene.objects.reserve(scene.objects.size() + game_objects.size());
 
+    for (const auto& obj_pair : game_objects) {
+        I_GAME_OBJECT* obj = obj_pair.second.get();
 
-        size_t children_size = obj->get_children().size();
-        ofs.write(reinterpret_cast<const char*>(&children_size), sizeof(children_size));
+        MarkoEngine::Scene_Object_Record record{};
+        record.type = static_cast<uint32_t>(obj->type);
+        record.id = scene.add_string(obj_pair.first.str());
+        record.script = scene.add_string(obj->get_script().str());
+        record.parent = scene.add_string(obj->get_parent().str());
+        record.flags = obj->is_visible() ? MarkoEngine::SCENE_OBJECT_VISIBLE : 0u;
+        record.local = obj->get_local_transform();
+        record.mesh = MarkoEngine::SCENE_NO_INDEX;
+
+        record.first_child = static_cast<uint32_t>(scene.children.size());
+        record.child_count = static_cast<uint32_t>(obj->get_children().size());
         for (const auto& child_id : obj->get_children()) {
-            size_t child_id_size = child_id.size();
-            ofs.write(reinterpret_cast<const char*>(&child_id_size), sizeof(child_id_size));
-            ofs.write(child_id.c_str(), child_id_size);
+            scene.children.push_back(scene.add_string(child_id.str()));
         }
 
-
-        ofs.write(reinterpret_cast<const char*>(&obj->world_transform), sizeof(transform));
-        ofs.write(reinterpret_cast<const char*>(&obj->world_transform), sizeof(transform));
-
-
-        switch (type) {
+        switch (obj->type) {
         case MESH: {
             MESH_GAME_OBJECT* mesh_obj = static_cast<MESH_GAME_OBJECT*>(obj);
-
-
-            const std::string& modelPath = mesh_obj->get_mesh_filename();
-            size_t modelPathLength = modelPath.size();
-            ofs.write(reinterpret_cast<const char*>(&modelPathLength), sizeof(modelPathLength));
-            ofs.write(modelPath.c_str(), modelPathLength);
-
-
-            const std::vector<Vertex>& vertices = mesh_obj->get_vertices();
-            size_t vertexCount = vertices.size();
-            ofs.write(reinterpret_cast<const char*>(&vertexCount), sizeof(vertexCount));
-            ofs.write(reinterpret_cast<const char*>(vertices.data()), vertexCount * sizeof(Vertex));
-
-
-            const std::vector<uint32_t>& indices = mesh_obj->get_indices();
-            size_t indexCount = indices.size();
-            ofs.write(reinterpret_cast<const char*>(&indexCount), sizeof(indexCount));
-            ofs.write(reinterpret_cast<const char*>(indices.data()), indexCount * sizeof(uint32_t));
-
+            record.asset = scene.add_string(mesh_obj->get_mesh_filename());
+            record.mesh = static_cast<uint32_t>(scene.mesh_blobs.size());
+            record.flags |= MarkoEngine::SCENE_OBJECT_MESH_BLOB;
+            if (meshes != nullptr) {
+                scene.mesh_blobs.emplace_back();
+                meshes->push_back(mesh_obj->get_geometry());
+            }
+            else {
+                scene.mesh_blobs.push_back(mesh_obj->get_mesh_blob());
+            }
             break;
         }
         case MODEL: {
-            MODEL_GAME_OBJECT* model_obj = static_cast<MODEL_GAME_OBJECT*>(obj);
-            size_t modelPathLength = model_obj->model.size();
-            ofs.write(reinterpret_cast<const char*>(&modelPathLength), sizeof(modelPathLength));
-            ofs.write(model_obj->model.c_str(), modelPathLength);
+            record.asset = scene.add_string(static_cast<MODEL_GAME_OBJECT*>(obj)->model);
+            break;
+        }
+        case ANIMATED: {
+            record.asset = scene.add_string(static_cast<ANIMATED_GAME_OBJECT*>(obj)->model);
+            break;
+        }
+        case CROWD: {
+            CROWD_GAME_OBJECT* crowd_obj = static_cast<CROWD_GAME_OBJECT*>(obj);
+            record.asset = scene.add_string(crowd_obj->model);
+            record.instance_count = static_cast<uint32_t>(crowd_obj->instance_count);
+            record.spacing = crowd_obj->spacing;
             break;
         }
         case CAMERA: {
-            CAMERA_GAME_OBJECT* camera_obj = static_cast<CAMERA_GAME_OBJECT*>(obj);
-            ofs.write(reinterpret_cast<const char*>(&camera_obj->world_up), sizeof(camera_obj->world_up));
+            record.vector_a = static_cast<CAMERA_GAME_OBJECT*>(obj)->camera().world_up;
             break;
         }
         case BOX_COLLIDER: {
             BOX_COLLIDER_GAME_OBJECT* box_obj = static_cast<BOX_COLLIDER_GAME_OBJECT*>(obj);
-            ofs.write(reinterpret_cast<const char*>(&box_obj->min), sizeof(box_obj->min));
-            ofs.write(reinterpret_cast<const char*>(&box_obj->max), sizeof(box_obj->max));
-            break;
-        }
-        case ANIMATED: {
-            ANIMATED_GAME_OBJECT* model_obj = static_cast<ANIMATED_GAME_OBJECT*>(obj);
-            size_t modelPathLength = model_obj->model.size();
-            ofs.write(reinterpret_cast<const char*>(&modelPathLength), sizeof(modelPathLength));
-            ofs.write(model_obj->model.c_str(), modelPathLength);
+            record.vector_a = box_obj->collider().min;
+            record.vector_b = box_obj->collider().max;
             break;
         }
         default:
             break;
         }
-    }
 
-    ofs.close();
+        scene.objects.push_back(record);
+    }
 }
 
-void I_GAME_OBJECT::load_from_binary(const std::string& filename) {
-    std::ifstream ifs(filename, std::ios::binary);
-    if (!ifs) {
+void I_GAME_OBJECT::load_from_binary(const std::string& filename, const MarkoEngine::Load_Progress& progress) {
+    const MarkoEngine::File_Data file = MarkoEngine::File_System::get().open(filename);
+    if (!file.is_open()) {
         std::cerr << "Failed to open file for loading: " << filename << std::endl;
         return;
     }
 
-    size_t game_objects_size;
-    ifs.read(reinterpret_cast<char*>(&game_objects_size), sizeof(game_objects_size));
-
-    for (size_t i = 0; i < game_objects_size; ++i) {
-        game_object_type type;
-        ifs.read(reinterpret_cast<char*>(&type), sizeof(type));
-
-        size_t id_size;
-        ifs.read(reinterpret_cast<char*>(&id_size), sizeof(id_size));
-        std::string id(id_size, '\0');
-        ifs.read(&id[0], id_size);
-
-
-        size_t script_size;
-        ifs.read(reinterpret_cast<char*>(&script_size), sizeof(script_size));
-        std::string script(script_size, '\0');
-        ifs.read(&script[0], script_size);
-
-
-        size_t parent_size;
-        ifs.read(reinterpret_cast<char*>(&parent_size), sizeof(parent_size));
-        std::string parent(parent_size, '\0');
-        ifs.read(&parent[0], parent_size);
-
-
-        size_t children_size;
-        ifs.read(reinterpret_cast<char*>(&children_size), sizeof(children_size));
-        std::vector<std::string> children(children_size);
-        for (size_t j = 0; j < children_size; ++j) {
-            size_t child_id_size;
-            ifs.read(reinterpret_cast<char*>(&child_id_size), sizeof(child_id_size));
-            std::string child_id(child_id_size, '\0');
-            ifs.read(&child_id[0], child_id_size);
-            children[j] = child_id;
+    // Older files are converted in memory so there is a single loading path over the chunked layout.
+    std::vector<uint8_t> converted;
+    MarkoEngine::Scene_View scene;
+    if (MarkoEngine::is_scene_file(file.data(), file.size())) {
+        if (!scene.open(file.data(), file.size())) {
+            std::cerr << "Corrupt scene file: " << filename << std::endl;
+            return;
         }
+    }
+    else {
+        MarkoEngine::Scene_Data legacy;
+        if (!MarkoEngine::read_legacy_scene(filename, legacy))
+            return;
 
+        converted = MarkoEngine::serialize_scene(legacy);
+        scene.open(converted.data(), converted.size());
+    }
 
-        transform local_transform;
-        transform world_transform;
-        ifs.read(reinterpret_cast<char*>(&local_transform), sizeof(local_transform));
-        ifs.read(reinterpret_cast<char*>(&world_transform), sizeof(world_transform));
-
-        I_GAME_OBJECT* obj = nullptr;
-        switch (type) {
-        case MESH: {
-            
-
-            size_t modelPathLength;
-            ifs.read(reinterpret_cast<char*>(&modelPathLength), sizeof(modelPathLength));
-
-            std::string modelPath(modelPathLength, '\0');
-            ifs.read(&modelPath[0], modelPathLength);
-
-
-            size_t vertexCount;
-            ifs.read(reinterpret_cast<char*>(&vertexCount), sizeof(vertexCount));
-
-            std::vector<Vertex> vertices(vertexCount);
-            ifs.read(reinterpret_cast<char*>(vertices.data()), vertexCount * sizeof(Vertex));
+    load_scene(scene, progress);
+}
 
+void I_GAME_OBJECT::load_scene(const MarkoEngine::Scene_View& scene, const MarkoEngine::Load_Progress& progress) {
+    const auto& records = scene.objects();
 
-            size_t indexCount;
-            ifs.read(reinterpret_cast<char*>(&indexCount), sizeof(indexCount));
+    std::vector<std::string> models;
+    std::vector<std::string> animations;
+    for (size_t i = 0; i < records.size(); ++i) {
+        switch (static_cast<game_object_type>(records[i].type)) {
+        case MODEL:
+            models.emplace_back(scene.string(records[i].asset));
+            break;
+        case ANIMATED:
+            animations.emplace_back(scene.string(records[i].asset));
+            break;
+        default:
+            break;
+        }
+        if (progress)
+            progress("parse", i + 1, records.size());
+    }
 
-            std::vector<uint32_t> indices(indexCount);
-            ifs.read(reinterpret_cast<char*>(indices.data()), indexCount * sizeof(uint32_t));
+    Renderer::get().preload_assets(models, animations, progress);
 
+    game_objects.reserve(game_objects.size() + records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        std::unique_ptr<I_GAME_OBJECT> obj = create_from_scene(scene, records[i]);
+        if (obj) {
+            game_objects[scene.string(records[i].id)] = std::move(obj);
+        }
+        if (progress)
+            progress("instantiate", i + 1, records.size());
+    }
 
-            MESH_GAME_OBJECT* mesh_obj = new MESH_GAME_OBJECT(vertices, indices, modelPath);
+    for (auto& [id, obj] : game_objects)
+    {
+        obj->set_parent(obj->get_parent());
+    }
+}
 
-            obj = mesh_obj;
-            
+std::unique_ptr<I_GAME_OBJECT> I_GAME_OBJECT::create_from_scene(const MarkoEngine::Scene_View& scene, const MarkoEngine::Scene_Object_Record& record,
+    const std::vector<std::shared_ptr<MarkoEngine::Mesh_Geometry>>* meshes) {
+    I_GAME_OBJECT* obj = nullptr;
+    switch (static_cast<game_object_type>(record.type)) {
+    case MESH: {
+        if (meshes != nullptr) {
+            if (record.mesh < meshes->size())
+                obj = new MESH_GAME_OBJECT((*meshes)[record.mesh], std::string(scene.string(record.asset)));
             break;
         }
-        case MODEL: {
 
-            size_t modelPathLength;
-            ifs.read(reinterpret_cast<char*>(&modelPathLength), sizeof(modelPathLength));
-            std::string modelPath(modelPathLength, '\0');
-            ifs.read(&modelPath[0], modelPathLength);
-            obj = new MODEL_GAME_OBJECT(modelPath);
-            break;
-        }
-        case ANIMATED: {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
 
-            size_t modelPathLength;
-            ifs.read(reinterpret_cast<char*>(&modelPathLength), sizeof(modelPathLength));
-            std::string modelPath(modelPathLength, '\0');
-            ifs.read(&modelPath[0], modelPathLength);
-            obj = new ANIMATED_GAME_OBJECT(modelPath);
-            break;
-        }
-        case CAMERA: {
-            obj = new CAMERA_GAME_OBJECT();
-            CAMERA_GAME_OBJECT* camera_obj = static_cast<CAMERA_GAME_OBJECT*>(obj);
-            ifs.read(reinterpret_cast<char*>(&camera_obj->world_up), sizeof(camera_obj->world_up));
-            break;
+        if ((record.flags & MarkoEngine::SCENE_OBJECT_MESH_BLOB) != 0) {
+            if (record.mesh >= scene.mesh_blobs().size() || !MarkoEngine::load_mesh_blob(scene.mesh_blobs()[record.mesh], vertices, indices))
+                break;
         }
-        case BOX_COLLIDER: {
-            obj = new BOX_COLLIDER_GAME_OBJECT();
-            BOX_COLLIDER_GAME_OBJECT* box_obj = static_cast<BOX_COLLIDER_GAME_OBJECT*>(obj);
-            ifs.read(reinterpret_cast<char*>(&box_obj->min), sizeof(box_obj->min));
-            ifs.read(reinterpret_cast<char*>(&box_obj->max), sizeof(box_obj->max));
-            break;
-        }
-        default:
-            break;
+        else {
+            if (record.mesh >= scene.meshes().size())
+                break;
+
+            const MarkoEngine::Scene_Mesh_Record& mesh = scene.meshes()[record.mesh];
+            vertices.resize(mesh.vertex_count);
+            for (size_t v = 0; v < mesh.vertex_count; ++v)
+                vertices[v] = scene.vertices()[mesh.first_vertex + v];
+
+            indices.resize(mesh.index_count);
+            for (size_t j = 0; j < mesh.index_count; ++j)
+                indices[j] = scene.indices()[mesh.first_index + j];
         }
 
-        if (obj) {
-            obj->set_parent(parent);
-            obj->set_script(script);
-            obj->children = children;
-            obj->set_local_transform(local_transform);
-            obj->set_world_transform(world_transform);
-            obj->type = type;
-            game_objects[id] = std::unique_ptr<I_GAME_OBJECT>(obj);
-        }
+        MESH_GAME_OBJECT* mesh_obj = new MESH_GAME_OBJECT(vertices, indices, std::string(scene.string(record.asset)));
+        if ((record.flags & MarkoEngine::SCENE_OBJECT_MESH_BLOB) != 0)
+            mesh_obj->set_mesh_blob(scene.mesh_blobs()[record.mesh]);
+        obj = mesh_obj;
+        break;
+    }
+    case MODEL: {
+        obj = new MODEL_GAME_OBJECT(std::string(scene.string(record.asset)));
+        break;
+    }
+    case ANIMATED: {
+        obj = new ANIMATED_GAME_OBJECT(std::string(scene.string(record.asset)));
+        break;
+    }
+    case CROWD: {
+        obj = new CROWD_GAME_OBJECT(std::string(scene.string(record.asset)), record.instance_count, record.spacing);
+        break;
+    }
+    case CAMERA: {
+        obj = new CAMERA_GAME_OBJECT();
+        break;
+    }
+    case BOX_COLLIDER: {
+        obj = new BOX_COLLIDER_GAME_OBJECT(record.vector_a, record.vector_b);
+        break;
+    }
+    default:
+        break;
     }
 
-    ifs.close();
+    if (obj) {
+        obj->type = static_cast<game_object_type>(record.type);
+        obj->apply_scene_record(scene, record);
+    }
+    return std::unique_ptr<I_GAME_OBJECT>(obj);
 }
+
+void I_GAME_OBJECT::apply_scene_record(const MarkoEngine::Scene_View& scene, const MarkoEngine::Scene_Object_Record& record) {
+    set_parent(scene.string(record.parent));
+    set_script(scene.string(record.script));
+    children.resize(record.child_count);
+    for (uint32_t j = 0; j < record.child_count && record.first_child + j < scene.children().size(); ++j) {
+        children[j] = scene.string(scene.children()[record.first_child + j]);
+    }
+    set_local_transform(record.local);
+    set_visible((record.flags & MarkoEngine::SCENE_OBJECT_VISIBLE) != 0);
+
+    if (type == CAMERA) {
+        static_cast<CAMERA_GAME_OBJECT*>(this)->camera().world_up = record.vector_a;
+    }
+}
\ No newline at end of file
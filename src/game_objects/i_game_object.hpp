@@ -5,6 +5,11 @@
 
 #include <glm/glm.hpp>
 
+#include "../managers/jobs.hpp"
+#include "../managers/names.hpp"
+#include "../managers/registry.hpp"
+#include "../managers/spatial.hpp"
+
 struct transform
 {
 	transform() : position(0.0f), rotation(0.0f), scale(1.0f) {}
@@ -26,43 +31,70 @@ enum game_object_type
 	MODEL,
 	CAMERA,
 	BOX_COLLIDER,
-	ANIMATED
+	ANIMATED,
+	CROWD
 };
 
+struct Transform_Component;
+
+namespace MarkoEngine
+{
+	struct Scene_Data;
+	struct Scene_Object_Record;
+	class Scene_View;
+	class Mesh_Geometry;
+}
+
 class I_GAME_OBJECT
 {
 public:
 	I_GAME_OBJECT();
 	I_GAME_OBJECT(const game_object_type& type);
+	I_GAME_OBJECT(const I_GAME_OBJECT&) = delete;
+	I_GAME_OBJECT& operator=(const I_GAME_OBJECT&) = delete;
 	virtual ~I_GAME_OBJECT();
 public:
 	void translate_local_transform(glm::vec3 axis, float factor);
 	void rotate_local_transform(glm::vec3 axis, float factor);
 	void scale_local_transform(glm::vec3 axis, float factor);
 public:
-	void set_parent(const std::string& parent_id);
-	void set_child(const std::string& child_id);
-	void set_script(const std::string& script);
+	void set_parent(MarkoEngine::Name parent_id);
+	void set_child(MarkoEngine::Name child_id);
+	void set_script(MarkoEngine::Name script);
 	void set_local_transform(const transform new_local_transform);
 	void set_world_transform(const transform new_world_transform);
+	void set_visible(bool visible);
 public:
-	std::string get_script() const;
-	std::string get_parent() const;
+	MarkoEngine::Name get_script() const;
+	MarkoEngine::Name get_parent() const;
 	game_object_type get_type() const;
 	transform get_local_transform() const;
 	transform get_world_transform() const;
-	std::vector<std::string>& get_children();
-	bool is_visible = true;
-	std::string parent;
-	std::vector<std::string> children;
+	glm::mat4 get_local_to_world() const;
+	std::vector<MarkoEngine::Name>& get_children();
+	MarkoEngine::Entity get_entity() const;
+	bool is_visible() const;
+	MarkoEngine::Name parent;
+	std::vector<MarkoEngine::Name> children;
 protected:
-	std::string	script;
+	Transform_Component& transform_component() const;
+	void set_local_bounds(const MarkoEngine::Aabb& bounds, const glm::mat4& world_correction = glm::mat4(1.0f));
 
 	game_object_type type;
-	transform local_transform;
-	transform world_transform;
+	MarkoEngine::Entity entity;
 public:
-	static std::unordered_map<std::string, std::unique_ptr<I_GAME_OBJECT>> game_objects;
+	static std::unordered_map<MarkoEngine::Name, std::unique_ptr<I_GAME_OBJECT>> game_objects;
 	static void save_to_binary(const std::string& filename);
-	static void load_from_binary(const std::string& filename);
+	static void load_from_binary(const std::string& filename, const MarkoEngine::Load_Progress& progress = {});
+	// With meshes given, mesh blob records are left empty and the geometry behind each one is handed back in the same
+	// order, so hashing and writing the blobs can happen off the calling thread.
+	static void build_scene(MarkoEngine::Scene_Data& scene, std::vector<std::shared_ptr<MarkoEngine::Mesh_Geometry>>* meshes = nullptr);
+	// Imports and uploads every asset the scene needs up front, then constructs the objects against the renderer caches.
+	static void load_scene(const MarkoEngine::Scene_View& scene, const MarkoEngine::Load_Progress& progress = {});
+	// With meshes given, a MESH record's mesh index refers to them, as handed back by build_scene.
+	static std::unique_ptr<I_GAME_OBJECT> create_from_scene(const MarkoEngine::Scene_View& scene, const MarkoEngine::Scene_Object_Record& record,
+		const std::vector<std::shared_ptr<MarkoEngine::Mesh_Geometry>>* meshes = nullptr);
+	// Sets everything a scene record holds that does not need the object to be constructed again.
+	void apply_scene_record(const MarkoEngine::Scene_View& scene, const MarkoEngine::Scene_Object_Record& record);
+	static MarkoEngine::Name find_id(MarkoEngine::Entity entity);
 };
\ No newline at end of file
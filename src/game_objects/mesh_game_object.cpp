@@ -1,10 +1,28 @@
 #include "pch.h"
 #include "mesh_game_object.hpp"
+#include "components.hpp"
 
 
-MESH_GAME_OBJECT::MESH_GAME_OBJECT(std::vector<Vertex> vertices, std::vector<uint32_t> indices, const std::string& texture) : I_GAME_OBJECT(game_object_type::MESH), mesh_filename(texture), vertices(vertices), indices(indices)
+MESH_GAME_OBJECT::MESH_GAME_OBJECT(std::vector<Vertex> vertices, std::vector<uint32_t> indices, const std::string& texture) : MESH_GAME_OBJECT(std::make_shared<MarkoEngine::Mesh_Geometry>(std::move(vertices), std::move(indices)), texture)
 {
-	renderer_mesh = Renderer::get().create_mesh(texture, vertices, indices);
+}
+
+MESH_GAME_OBJECT::MESH_GAME_OBJECT(std::shared_ptr<MarkoEngine::Mesh_Geometry> geometry, const std::string& texture) : I_GAME_OBJECT(game_object_type::MESH), mesh_filename(texture), geometry(std::move(geometry))
+{
+	renderer_mesh = Renderer::get().create_mesh(texture, this->geometry->vertices, this->geometry->indices);
+	MarkoEngine::Registry::get().emplace<Mesh_Renderer_Component>(entity, game_object_type::MESH, this);
+
+	auto triangles = std::make_shared<MarkoEngine::Triangle_Mesh>();
+	triangles->indices = this->geometry->indices;
+
+	MarkoEngine::Aabb bounds;
+	for (const Vertex& vertex : this->geometry->vertices)
+	{
+		bounds.extend(vertex.position);
+		triangles->positions.push_back(vertex.position);
+	}
+	set_local_bounds(bounds);
+	MarkoEngine::Registry::get().emplace<Pick_Mesh_Component>(entity, std::move(triangles));
 }
 
 void MESH_GAME_OBJECT::Draw()
@@ -14,5 +32,5 @@ void MESH_GAME_OBJECT::Draw()
 
 void MESH_GAME_OBJECT::reload()
 {
-	renderer_mesh = Renderer::get().create_mesh(mesh_filename, vertices, indices);
-}
+	renderer_mesh = Renderer::get().create_mesh(mesh_filename, geometry->vertices, geometry->indices);
+}
\ No newline at end of file
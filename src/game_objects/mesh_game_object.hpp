@@ -1,12 +1,14 @@
 #pragma once
 #include "i_game_object.hpp"
 #include "../managers/renderer.hpp"
+#include "../managers/scene_file.hpp"
 
 class MESH_GAME_OBJECT : public I_GAME_OBJECT
 {
 public:
 	MESH_GAME_OBJECT() {}
 	MESH_GAME_OBJECT(std::vector<Vertex> vertices, std::vector<uint32_t> indices, const std::string& texture);
+	MESH_GAME_OBJECT(std::shared_ptr<MarkoEngine::Mesh_Geometry> geometry, const std::string& texture);
 	void Draw();
 
 	void reload();
@@ -14,13 +16,16 @@ public:
 	void set_mesh_filename(std::string new_mesh_filename) { mesh_filename = new_mesh_filename; }
 	std::string get_mesh_filename() { return mesh_filename; }
 
-	std::vector<Vertex> get_vertices() { return vertices; }
+	std::vector<Vertex> get_vertices() { return geometry->vertices; }
 
-	std::vector<uint32_t> get_indices() { return indices; }
+	std::vector<uint32_t> get_indices() { return geometry->indices; }
+
+	const std::shared_ptr<MarkoEngine::Mesh_Geometry>& get_geometry() const { return geometry; }
+	MarkoEngine::Scene_Mesh_Blob_Record get_mesh_blob() { return geometry->blob(); }
+	void set_mesh_blob(const MarkoEngine::Scene_Mesh_Blob_Record& blob) { geometry->set_blob(blob); }
 private:
 	std::string mesh_filename;
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	std::shared_ptr<MarkoEngine::Mesh_Geometry> geometry = std::make_shared<MarkoEngine::Mesh_Geometry>();
 
 	Renderer_Mesh renderer_mesh;
 };
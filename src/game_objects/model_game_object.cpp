@@ -1,11 +1,15 @@
 #include "pch.h"
 #include "model_game_object.hpp"
+#include "components.hpp"
 #include "../managers/renderer.hpp"
 
 
 MODEL_GAME_OBJECT::MODEL_GAME_OBJECT(const std::string& model) : I_GAME_OBJECT(game_object_type::MODEL), model(model)
 {
 	renderer_model = Renderer::get().create_model(model);
+	MarkoEngine::Registry::get().emplace<Mesh_Renderer_Component>(entity, game_object_type::MODEL, this);
+	set_local_bounds(renderer_model.bounds);
+	MarkoEngine::Registry::get().emplace<Pick_Mesh_Component>(entity, renderer_model.triangles);
 }
 
 void MODEL_GAME_OBJECT::Draw() 
@@ -16,6 +20,8 @@ void MODEL_GAME_OBJECT::Draw()
 void MODEL_GAME_OBJECT::reload()
 {
     renderer_model = Renderer::get().create_model(model);
+    set_local_bounds(renderer_model.bounds);
+    MarkoEngine::Registry::get().emplace<Pick_Mesh_Component>(entity, renderer_model.triangles);
 }
 
 
@@ -0,0 +1,489 @@
+#include "pch.h"
+#include "asset_database.hpp"
+#include "cooked_mesh.hpp"
+#include "file_system.hpp"
+#include "jobs.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+    // "MKASSET1"
+    constexpr uint64_t ASSET_DATABASE_MAGIC = 0x3154455353414B4Dull;
+    constexpr uint32_t ASSET_DATABASE_VERSION = 1;
+
+    MarkoEngine::Blob_Hash hash_string(std::string_view string)
+    {
+        return MarkoEngine::hash_blob(reinterpret_cast<const uint8_t*>(string.data()), string.size());
+    }
+
+    bool read_file(const std::string& path, std::vector<uint8_t>& data)
+    {
+        std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+        if (!ifs)
+            return false;
+
+        data.resize(static_cast<size_t>(ifs.tellg()));
+        ifs.seekg(0);
+        ifs.read(reinterpret_cast<char*>(data.data()), data.size());
+        return static_cast<bool>(ifs);
+    }
+
+    std::string lowercase_extension(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+        return extension;
+    }
+
+    // The references an .obj or .mtl names in plain text: material libraries and texture maps. They resolve the
+    // way the importer resolves them, by file name next to the referencing file.
+    std::vector<std::string> scan_references(const std::string& path, const std::vector<uint8_t>& data)
+    {
+        const std::string extension = lowercase_extension(path);
+        const bool obj = extension == ".obj";
+        if (!obj && extension != ".mtl")
+            return {};
+
+        const std::string directory = std::filesystem::path(path).parent_path().string();
+        std::vector<std::string> references;
+        std::istringstream lines(std::string(data.begin(), data.end()));
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            std::istringstream tokens(line);
+            std::string keyword;
+            tokens >> keyword;
+            if (obj ? keyword != "mtllib" : keyword.rfind("map_", 0) != 0 && keyword != "bump")
+                continue;
+
+            std::string reference;
+            for (std::string token; tokens >> token;)
+                reference = token;
+            if (reference.empty())
+                continue;
+
+            const size_t separator = reference.rfind('\\');
+            if (separator != std::string::npos)
+                reference = reference.substr(separator + 1);
+            references.push_back(MarkoEngine::Asset_Database::normalize(directory + "/" + reference));
+        }
+        return references;
+    }
+
+    template <typename T>
+    void write_value(std::vector<uint8_t>& buffer, const T& value)
+    {
+        const size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(T));
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    void write_string(std::vector<uint8_t>& buffer, const std::string& string)
+    {
+        write_value(buffer, static_cast<uint32_t>(string.size()));
+        buffer.insert(buffer.end(), string.begin(), string.end());
+    }
+
+    struct Reader
+    {
+        const std::vector<uint8_t>& data;
+        size_t offset = 0;
+
+        template <typename T>
+        bool read(T& value)
+        {
+            if (data.size() - offset < sizeof(T))
+                return false;
+
+            std::memcpy(&value, data.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+
+        bool read(std::string& string)
+        {
+            uint32_t size = 0;
+            if (!read(size) || data.size() - offset < size)
+                return false;
+
+            string.assign(reinterpret_cast<const char*>(data.data()) + offset, size);
+            offset += size;
+            return true;
+        }
+    };
+}
+
+MarkoEngine::Asset_Database& MarkoEngine::Asset_Database::get()
+{
+    static Asset_Database instance;
+    return instance;
+}
+
+void MarkoEngine::Asset_Database::initialize(const std::string& filename)
+{
+    std::lock_guard lock(m_mutex);
+    m_filename = filename;
+    m_records.clear();
+    m_dirty = false;
+
+    std::vector<uint8_t> data;
+    if (!read_file(m_filename, data))
+        return;
+
+    Reader reader{ data };
+    uint64_t magic = 0;
+    uint32_t version = 0;
+    uint32_t count = 0;
+    bool valid = reader.read(magic) && reader.read(version) && reader.read(count) &&
+        magic == ASSET_DATABASE_MAGIC && version == ASSET_DATABASE_VERSION;
+    for (uint32_t i = 0; valid && i < count; ++i)
+    {
+        std::string source;
+        Asset_Record record;
+        uint32_t dependency_count = 0;
+        valid = reader.read(source) && reader.read(record.size) && reader.read(record.time) && reader.read(record.content) &&
+            reader.read(dependency_count);
+        for (uint32_t j = 0; valid && j < dependency_count; ++j)
+            valid = reader.read(record.dependencies.emplace_back());
+
+        uint32_t cooked_count = 0;
+        valid = valid && reader.read(cooked_count);
+        for (uint32_t j = 0; valid && j < cooked_count; ++j)
+        {
+            Blob_Hash settings;
+            Blob_Hash input;
+            valid = reader.read(settings) && reader.read(input);
+            record.cooked[settings] = input;
+        }
+
+        if (valid)
+            m_records[source] = std::move(record);
+    }
+
+    // Losing the database only costs a full cook, so a damaged one is dropped rather than trusted in part.
+    if (!valid)
+    {
+        std::cerr << "Asset database is corrupt, everything will be cooked again: " << m_filename << std::endl;
+        m_records.clear();
+        m_dirty = true;
+    }
+}
+
+void MarkoEngine::Asset_Database::cleanup()
+{
+    save();
+
+    std::lock_guard lock(m_mutex);
+    m_records.clear();
+    m_dirty = false;
+}
+
+bool MarkoEngine::Asset_Database::save()
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_dirty)
+        return true;
+
+    std::vector<uint8_t> buffer;
+    write_value(buffer, ASSET_DATABASE_MAGIC);
+    write_value(buffer, ASSET_DATABASE_VERSION);
+    write_value(buffer, static_cast<uint32_t>(m_records.size()));
+    for (const auto& [source, record] : m_records)
+    {
+        write_string(buffer, source);
+        write_value(buffer, record.size);
+        write_value(buffer, record.time);
+        write_value(buffer, record.content);
+        write_value(buffer, static_cast<uint32_t>(record.dependencies.size()));
+        for (const std::string& dependency : record.dependencies)
+            write_string(buffer, dependency);
+        write_value(buffer, static_cast<uint32_t>(record.cooked.size()));
+        for (const auto& [settings, input] : record.cooked)
+        {
+            write_value(buffer, settings);
+            write_value(buffer, input);
+        }
+    }
+
+    const std::filesystem::path path = m_filename;
+    const std::filesystem::path temporary = m_filename + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    {
+        std::ofstream ofs(temporary, std::ios::binary);
+        if (!ofs) {
+            std::cerr << "Failed to open file for saving: " << temporary.string() << std::endl;
+            return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        if (!ofs)
+            return false;
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        return false;
+
+    m_dirty = false;
+    return true;
+}
+
+MarkoEngine::Blob_Hash MarkoEngine::Asset_Database::content_hash(const std::string& source)
+{
+    const std::string key = normalize(source);
+    refresh(key);
+
+    std::lock_guard lock(m_mutex);
+    auto record = m_records.find(key);
+    return record != m_records.end() ? record->second.content : Blob_Hash();
+}
+
+MarkoEngine::Blob_Hash MarkoEngine::Asset_Database::input_hash(const std::string& source, std::string_view settings)
+{
+    std::unordered_set<std::string> visiting;
+    const Blob_Hash dependencies = dependency_hash(normalize(source), visiting);
+    if (dependencies.empty())
+        return Blob_Hash();
+
+    const Blob_Hash settings_hash = hash_string(settings);
+    const Blob_Hash parts[2] = { settings_hash, dependencies };
+    return hash_blob(reinterpret_cast<const uint8_t*>(parts), sizeof(parts));
+}
+
+void MarkoEngine::Asset_Database::add_dependencies(const std::string& source, const std::vector<std::string>& dependencies)
+{
+    std::lock_guard lock(m_mutex);
+    Asset_Record& record = m_records[normalize(source)];
+    for (const std::string& dependency : dependencies)
+    {
+        const std::string key = normalize(dependency);
+        if (std::find(record.dependencies.begin(), record.dependencies.end(), key) == record.dependencies.end())
+        {
+            record.dependencies.push_back(key);
+            m_dirty = true;
+        }
+    }
+}
+
+void MarkoEngine::Asset_Database::mark_cooked(const std::string& source, std::string_view settings, const Blob_Hash& input)
+{
+    std::lock_guard lock(m_mutex);
+    m_records[normalize(source)].cooked[hash_string(settings)] = input;
+    m_dirty = true;
+}
+
+bool MarkoEngine::Asset_Database::is_current(const std::string& source, std::string_view settings, const Blob_Hash& input) const
+{
+    std::lock_guard lock(m_mutex);
+    auto record = m_records.find(normalize(source));
+    if (record == m_records.end())
+        return false;
+
+    auto cooked = record->second.cooked.find(hash_string(settings));
+    return cooked != record->second.cooked.end() && cooked->second == input;
+}
+
+std::vector<std::string> MarkoEngine::Asset_Database::dependents(const std::string& source) const
+{
+    std::lock_guard lock(m_mutex);
+    std::vector<std::string> result;
+    std::unordered_set<std::string> found = { normalize(source) };
+    std::vector<std::string> pending = { normalize(source) };
+    while (!pending.empty())
+    {
+        const std::string dependency = std::move(pending.back());
+        pending.pop_back();
+        for (const auto& [path, record] : m_records)
+        {
+            if (std::find(record.dependencies.begin(), record.dependencies.end(), dependency) != record.dependencies.end() &&
+                found.insert(path).second)
+            {
+                result.push_back(path);
+                pending.push_back(path);
+            }
+        }
+    }
+    return result;
+}
+
+MarkoEngine::Cook_Result MarkoEngine::Asset_Database::cook(const std::vector<std::string>& directories)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    Cook_Result result;
+
+    std::vector<std::string> models;
+    std::vector<std::string> textures;
+    std::vector<std::string> sources;
+    for (const std::string& directory : directories)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(directory, error))
+            continue;
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+        {
+            if (!entry.is_regular_file())
+                continue;
+
+            const std::string path = normalize(entry.path().string());
+            if (is_cookable_mesh(path))
+                models.push_back(path);
+            else if (is_cookable_texture(path))
+                textures.push_back(path);
+            else if (lowercase_extension(path) != ".mtl")
+                continue;
+            sources.push_back(path);
+        }
+    }
+    result.scanned = sources.size();
+
+    // Stat and, where the stamp moved, hash everything up front on the pool; the checks below then only hash hashes.
+    Jobs::get().parallel_for(sources.size(), [&](size_t i) { refresh(sources[i]); });
+
+    enum class Cook_Kind { model, animation, texture };
+    struct Cook_Task
+    {
+        std::string source;
+        Cook_Kind kind;
+    };
+
+    auto is_stale = [&](const std::string& source, std::string_view settings, const std::string& cooked_path)
+        {
+            std::error_code error;
+            return !is_current(source, settings, input_hash(source, settings)) || !std::filesystem::exists(cooked_path, error);
+        };
+
+    std::vector<Cook_Task> tasks;
+    for (const std::string& texture : textures)
+    {
+        if (is_stale(texture, TEXTURE_IMPORT_SETTINGS, cooked_texture_path(texture)))
+            tasks.push_back({ texture, Cook_Kind::texture });
+    }
+    for (const std::string& model : models)
+    {
+        if (is_stale(model, MODEL_IMPORT_SETTINGS, cooked_mesh_path(model, false)))
+            tasks.push_back({ model, Cook_Kind::model });
+
+        // Only sources something already loaded as an animation get a skinned cook.
+        bool skinned = false;
+        {
+            std::lock_guard lock(m_mutex);
+            auto record = m_records.find(model);
+            skinned = record != m_records.end() && record->second.cooked.contains(hash_string(SKINNED_IMPORT_SETTINGS));
+        }
+        if (skinned && is_stale(model, SKINNED_IMPORT_SETTINGS, cooked_mesh_path(model, true)))
+            tasks.push_back({ model, Cook_Kind::animation });
+    }
+
+    std::atomic<size_t> cooked = 0;
+    std::atomic<size_t> failed = 0;
+    Jobs::get().parallel_for(tasks.size(), [&](size_t i)
+        {
+            const Cook_Task& task = tasks[i];
+            bool success = false;
+            if (task.kind == Cook_Kind::texture)
+            {
+                const Decoded_Texture texture = Renderer::decode_texture_source(task.source);
+                success = texture.pixels && cook_texture(task.source, texture);
+            }
+            else if (task.kind == Cook_Kind::model)
+            {
+                const Imported_Model model = Renderer::import_model_source(task.source);
+                success = model.triangles && cook_model(task.source, model);
+            }
+            else
+            {
+                const Imported_Animation animation = Renderer::import_animation_source(task.source);
+                success = animation.asset && cook_animation(task.source, animation);
+            }
+            ++(success ? cooked : failed);
+        });
+
+    save();
+
+    result.cooked = cooked;
+    result.failed = failed;
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return result;
+}
+
+std::string MarkoEngine::Asset_Database::normalize(const std::string& path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+void MarkoEngine::Asset_Database::refresh(const std::string& path)
+{
+    uint64_t size = 0;
+    int64_t time = 0;
+    // Sources may be packed in a shipped build; they are hashed and cooked the same way as loose ones.
+    const bool exists = File_System::get().stamp(path, size, time);
+    {
+        std::lock_guard lock(m_mutex);
+        auto record = m_records.find(path);
+        if (record != m_records.end() && record->second.size == size && record->second.time == time &&
+            record->second.content.empty() != exists)
+            return;
+
+        if (!exists)
+        {
+            Asset_Record& missing = m_records[path];
+            missing.size = 0;
+            missing.time = 0;
+            missing.content = Blob_Hash();
+            m_dirty = true;
+            return;
+        }
+    }
+
+    const File_Data file = File_System::get().open(path);
+    if (!file.is_open())
+        return;
+
+    const std::vector<uint8_t> data(file.data(), file.data() + file.size());
+    uint8_t empty = 0;
+    const Blob_Hash content = hash_blob(data.empty() ? &empty : data.data(), data.size());
+    std::vector<std::string> references = scan_references(path, data);
+
+    std::lock_guard lock(m_mutex);
+    Asset_Record& record = m_records[path];
+    // Touched but unchanged files keep their dependencies; the ones the importer found come back on the next cook.
+    if (!(record.content == content))
+        record.dependencies = std::move(references);
+    record.size = size;
+    record.time = time;
+    record.content = content;
+    m_dirty = true;
+}
+
+MarkoEngine::Blob_Hash MarkoEngine::Asset_Database::dependency_hash(const std::string& path, std::unordered_set<std::string>& visiting)
+{
+    if (!visiting.insert(path).second)
+        return Blob_Hash();
+
+    refresh(path);
+
+    std::vector<Blob_Hash> parts;
+    std::vector<std::string> dependencies;
+    {
+        std::lock_guard lock(m_mutex);
+        auto record = m_records.find(path);
+        if (record == m_records.end() || record->second.content.empty())
+        {
+            visiting.erase(path);
+            return Blob_Hash();
+        }
+        parts.push_back(record->second.content);
+        dependencies = record->second.dependencies;
+    }
+
+    // A missing dependency contributes an empty hash, so creating it later makes the source stale.
+    for (const std::string& dependency : dependencies)
+        parts.push_back(dependency_hash(dependency, visiting));
+
+    visiting.erase(path);
+    return hash_blob(reinterpret_cast<const uint8_t*>(parts.data()), sizeof(Blob_Hash) * parts.size());
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "blob_store.hpp"
+
+namespace MarkoEngine
+{
+    // Importer settings are part of every cooked output's input hash, so changing one re-cooks what it produced.
+    inline constexpr std::string_view MODEL_IMPORT_SETTINGS = "model: assimp triangulate flip_uvs join_identical_vertices";
+    inline constexpr std::string_view SKINNED_IMPORT_SETTINGS = "skinned: assimp triangulate flip_uvs join_identical_vertices bone_weights top4_normalized";
+    inline constexpr std::string_view TEXTURE_IMPORT_SETTINGS = "texture: stb rgba8 lz";
+
+    struct Asset_Record
+    {
+        // Write time and size of the source when it was hashed; while they match the hash is trusted without reading.
+        uint64_t size = 0;
+        int64_t time = 0;
+        Blob_Hash content{};
+        std::vector<std::string> dependencies;
+        // Input hash of the last successful cook, per importer settings hash.
+        std::unordered_map<Blob_Hash, Blob_Hash> cooked;
+    };
+
+    struct Cook_Result
+    {
+        size_t scanned = 0;
+        size_t cooked = 0;
+        size_t failed = 0;
+        double milliseconds = 0.0;
+    };
+
+    // What every source under content/ and dependencies/ was last cooked from: its content hash and what it
+    // depends on (.obj -> .mtl -> textures). A cooked output is current while the hash of its settings, its source
+    // and, recursively, its dependencies matches the one it was written with, so editing a texture re-cooks the
+    // models using it and touching a file without changing it re-cooks nothing. Import jobs call in from worker
+    // threads, so every public call takes the lock; files are read and hashed outside it.
+    class Asset_Database
+    {
+    public:
+        Asset_Database(const Asset_Database&) = delete;
+        Asset_Database(Asset_Database&&) = delete;
+        Asset_Database& operator=(const Asset_Database&) = delete;
+        Asset_Database& operator=(Asset_Database&&) = delete;
+
+    private:
+        Asset_Database() = default;
+
+    public:
+        static Asset_Database& get();
+
+        void initialize(const std::string& filename = "cooked/assets.db");
+        void cleanup();
+        bool save();
+
+        Blob_Hash content_hash(const std::string& source);
+        Blob_Hash input_hash(const std::string& source, std::string_view settings);
+
+        // Recorded when a cook finds references the source format does not expose without importing it.
+        void add_dependencies(const std::string& source, const std::vector<std::string>& dependencies);
+        void mark_cooked(const std::string& source, std::string_view settings, const Blob_Hash& input);
+        bool is_current(const std::string& source, std::string_view settings, const Blob_Hash& input) const;
+
+        // Sources that depend on this one, directly or through others.
+        std::vector<std::string> dependents(const std::string& source) const;
+
+        // Cooks every asset under the directories whose output is missing or out of date, on the job pool.
+        Cook_Result cook(const std::vector<std::string>& directories);
+
+        static std::string normalize(const std::string& path);
+
+    private:
+        void refresh(const std::string& path);
+        Blob_Hash dependency_hash(const std::string& path, std::unordered_set<std::string>& visiting);
+
+    private:
+        mutable std::mutex m_mutex;
+        std::string m_filename = "cooked/assets.db";
+        std::unordered_map<std::string, Asset_Record> m_records;
+        bool m_dirty = false;
+    };
+}
\ No newline at end of file
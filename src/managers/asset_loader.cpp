@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "asset_loader.hpp"
+#include "renderer.hpp"
+#include "jobs.hpp"
+#include "texture_streaming.hpp"
+#include "../game_objects/model_game_object.hpp"
+#include "../game_objects/animated_game_object.hpp"
+
+#include <chrono>
+
+namespace MarkoEngine
+{
+    struct Load_Batch
+    {
+        std::vector<std::string> models;
+        std::vector<std::string> animations;
+        std::vector<std::string> textures;
+
+        Imported_Assets assets;
+        std::unordered_map<std::string, Decoded_Texture> decoded_textures;
+        size_t bytes = 0;
+        double milliseconds = 0.0;
+    };
+}
+
+namespace
+{
+    // Assets the worker takes from the queue at once; a batch is uploaded in one go, so this bounds the spikes.
+    constexpr size_t MAX_BATCH_ASSETS = 8;
+    // Bytes uploaded per frame before the rest waits for the next one; one batch always goes through.
+    constexpr size_t FRAME_UPLOAD_BYTES = 16ull << 20;
+
+    size_t mesh_bytes(const std::vector<Imported_Mesh>& meshes)
+    {
+        size_t bytes = 0;
+        for (const Imported_Mesh& mesh : meshes)
+            bytes += sizeof(Vertex) * mesh.vertices.size() + sizeof(uint32_t) * mesh.indices.size();
+        return bytes;
+    }
+
+    size_t texture_bytes(const Decoded_Texture& texture)
+    {
+        return MarkoEngine::mip_chain_size(texture.width, texture.height, texture.mip_levels);
+    }
+}
+
+MarkoEngine::Asset_Loader::Asset_Loader() = default;
+
+MarkoEngine::Asset_Loader::~Asset_Loader()
+{
+    cleanup();
+}
+
+MarkoEngine::Asset_Loader& MarkoEngine::Asset_Loader::get()
+{
+    static Asset_Loader instance;
+    return instance;
+}
+
+void MarkoEngine::Asset_Loader::initialize()
+{
+    cleanup();
+
+    m_stopping = false;
+    m_worker = std::thread(&Asset_Loader::run_imports, this);
+}
+
+void MarkoEngine::Asset_Loader::cleanup()
+{
+    // A batch in flight is finished, but nothing is uploaded after this; the handles left report failure.
+    if (m_worker.joinable())
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_condition.notify_one();
+        m_worker.join();
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.clear();
+        m_finished.clear();
+    }
+
+    for (auto& [key, request] : m_requests)
+        request.state->store(Asset_State::failed);
+    m_requests.clear();
+}
+
+MarkoEngine::Asset_Handle MarkoEngine::Asset_Loader::request(Asset_Kind kind, const std::string& filename, bool changed)
+{
+    auto key = std::make_pair(kind, filename);
+
+    std::lock_guard lock(m_mutex);
+    auto [request, inserted] = m_requests.try_emplace(key);
+    if (inserted)
+        request->second.state = std::make_shared<std::atomic<Asset_State>>(Asset_State::loading);
+    else if (!changed || std::find(m_queue.begin(), m_queue.end(), key) != m_queue.end())
+        return Asset_Handle(request->second.state);
+
+    m_queue.push_back(std::move(key));
+    ++request->second.outstanding;
+    m_condition.notify_one();
+    return Asset_Handle(request->second.state);
+}
+
+void MarkoEngine::Asset_Loader::update()
+{
+    std::vector<std::unique_ptr<Load_Batch>> finished;
+    {
+        std::lock_guard lock(m_mutex);
+        finished.swap(m_finished);
+    }
+
+    size_t uploaded = 0;
+    size_t applied = 0;
+    for (; applied < finished.size() && (applied == 0 || uploaded + finished[applied]->bytes <= FRAME_UPLOAD_BYTES); ++applied)
+    {
+        apply(*finished[applied]);
+        uploaded += finished[applied]->bytes;
+    }
+
+    if (applied < finished.size())
+    {
+        // What did not fit goes back in front of anything the worker finished meanwhile.
+        std::lock_guard lock(m_mutex);
+        m_finished.insert(m_finished.begin(), std::make_move_iterator(finished.begin() + applied), std::make_move_iterator(finished.end()));
+    }
+}
+
+void MarkoEngine::Asset_Loader::apply(Load_Batch& batch)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    Renderer::get().replace_assets(batch.assets, batch.decoded_textures);
+
+    std::unordered_set<std::string> models;
+    for (size_t i = 0; i < batch.assets.models.size(); ++i)
+    {
+        const bool loaded = batch.assets.models[i].triangles != nullptr;
+        if (loaded)
+            models.insert(batch.assets.model_filenames[i]);
+        finish(Asset_Kind::model, batch.assets.model_filenames[i], loaded);
+    }
+    std::unordered_set<std::string> animations;
+    for (size_t i = 0; i < batch.assets.animations.size(); ++i)
+    {
+        const bool loaded = batch.assets.animations[i].asset != nullptr;
+        if (loaded)
+            animations.insert(batch.assets.animation_filenames[i]);
+        finish(Asset_Kind::animation, batch.assets.animation_filenames[i], loaded);
+    }
+    for (const std::string& filename : batch.textures)
+        finish(Asset_Kind::texture, filename, batch.decoded_textures[filename].pixels != nullptr);
+
+    // Meshes refer to texture slots, so only objects holding a model or an animation need to pick up the new one.
+    size_t objects = 0;
+    for (const auto& [name, object] : I_GAME_OBJECT::game_objects)
+    {
+        if (object->get_type() == game_object_type::MODEL)
+        {
+            MODEL_GAME_OBJECT* model = static_cast<MODEL_GAME_OBJECT*>(object.get());
+            if (models.contains(model->model))
+            {
+                model->reload();
+                ++objects;
+            }
+        }
+        else if (object->get_type() == game_object_type::ANIMATED)
+        {
+            ANIMATED_GAME_OBJECT* animated = static_cast<ANIMATED_GAME_OBJECT*>(object.get());
+            if (animations.contains(animated->model))
+            {
+                animated->reload();
+                ++objects;
+            }
+        }
+    }
+
+    const double upload = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "asset loader: " << models.size() << " models, " << animations.size() << " animations, " << batch.textures.size()
+        << " textures, " << objects << " objects (import " << batch.milliseconds << " ms in the background, upload " << upload << " ms)" << std::endl;
+}
+
+void MarkoEngine::Asset_Loader::finish(Asset_Kind kind, const std::string& filename, bool loaded)
+{
+    auto request = m_requests.find(std::make_pair(kind, filename));
+    if (request == m_requests.end())
+        return;
+
+    // A request made while this one was importing has its own load still to come.
+    if (--request->second.outstanding > 0)
+        return;
+
+    request->second.state->store(loaded ? Asset_State::ready : Asset_State::failed);
+    m_requests.erase(request);
+}
+
+void MarkoEngine::Asset_Loader::run_imports()
+{
+    std::unique_lock lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+        if (m_stopping)
+            break;
+
+        auto batch = std::make_unique<Load_Batch>();
+        for (size_t i = 0; i < MAX_BATCH_ASSETS && !m_queue.empty(); ++i)
+        {
+            auto [kind, filename] = std::move(m_queue.front());
+            m_queue.pop_front();
+            if (kind == Asset_Kind::model)
+                batch->models.push_back(std::move(filename));
+            else if (kind == Asset_Kind::animation)
+                batch->animations.push_back(std::move(filename));
+            else
+                batch->textures.push_back(std::move(filename));
+        }
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        batch->assets = Renderer::import_assets(batch->models, batch->animations);
+
+        std::vector<Decoded_Texture> textures(batch->textures.size());
+        Jobs::get().parallel_for(textures.size(), [&](size_t i)
+            {
+                textures[i] = Texture_Streaming::get().prepare(batch->textures[i], Renderer::decode_texture(batch->textures[i]));
+            });
+        for (size_t i = 0; i < textures.size(); ++i)
+            batch->decoded_textures.emplace(batch->textures[i], std::move(textures[i]));
+        batch->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (const Imported_Model& model : batch->assets.models)
+            batch->bytes += mesh_bytes(model.meshes);
+        for (const Imported_Animation& animation : batch->assets.animations)
+            batch->bytes += mesh_bytes(animation.meshes);
+        for (const auto& [filename, texture] : batch->assets.textures)
+            batch->bytes += texture_bytes(texture);
+        for (const auto& [filename, texture] : batch->decoded_textures)
+            batch->bytes += texture_bytes(texture);
+
+        lock.lock();
+        m_finished.push_back(std::move(batch));
+    }
+}
\ No newline at end of file
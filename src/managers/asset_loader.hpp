@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace MarkoEngine
+{
+    struct Load_Batch;
+
+    enum class Asset_State
+    {
+        loading,
+        ready,
+        failed
+    };
+
+    enum class Asset_Kind
+    {
+        model,
+        animation,
+        texture
+    };
+
+    // Shared with the loader; reports where a requested asset is without blocking.
+    class Asset_Handle
+    {
+    public:
+        Asset_Handle() = default;
+
+        bool valid() const { return m_state != nullptr; }
+        Asset_State state() const { return m_state ? m_state->load() : Asset_State::failed; }
+        bool ready() const { return state() == Asset_State::ready; }
+        bool failed() const { return state() == Asset_State::failed; }
+
+    private:
+        friend class Asset_Loader;
+        explicit Asset_Handle(std::shared_ptr<std::atomic<Asset_State>> state) : m_state(std::move(state)) {}
+
+    private:
+        std::shared_ptr<std::atomic<Asset_State>> m_state;
+    };
+
+    // Imports models and animations and decodes textures on a thread of its own while the renderer hands out
+    // placeholders: an empty model, an animation without an asset, a white texture in the slot the real one will
+    // take. update() uploads what has finished between frames, a bounded amount per frame, and reloads the objects
+    // that were created with the placeholders.
+    class Asset_Loader
+    {
+    public:
+        Asset_Loader(const Asset_Loader&) = delete;
+        Asset_Loader(Asset_Loader&&) = delete;
+        Asset_Loader& operator=(const Asset_Loader&) = delete;
+        Asset_Loader& operator=(Asset_Loader&&) = delete;
+
+    private:
+        Asset_Loader();
+        ~Asset_Loader();
+
+    public:
+        static Asset_Loader& get();
+
+        void initialize();
+        void cleanup();
+
+        // While the loader is not running the renderer loads everything on the calling thread, as before.
+        bool running() const { return m_worker.joinable(); }
+
+        // Main thread only. Asking again for an asset that is still loading returns the same handle; a file that
+        // changed on disk since its import started is loaded once more, which is how hot reload sees every edit.
+        Asset_Handle request(Asset_Kind kind, const std::string& filename, bool changed = false);
+        size_t pending() const { return m_requests.size(); }
+
+        // Called once per frame before anything is drawn.
+        void update();
+
+    private:
+        struct Request
+        {
+            std::shared_ptr<std::atomic<Asset_State>> state;
+            size_t outstanding = 0;
+        };
+
+        void apply(Load_Batch& batch);
+        void finish(Asset_Kind kind, const std::string& filename, bool loaded);
+        void run_imports();
+
+    private:
+        std::thread m_worker;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::deque<std::pair<Asset_Kind, std::string>> m_queue;
+        std::vector<std::unique_ptr<Load_Batch>> m_finished;
+        bool m_stopping = false;
+        // Main thread only.
+        std::map<std::pair<Asset_Kind, std::string>, Request> m_requests;
+    };
+}
\ No newline at end of file
@@ -2,10 +2,40 @@
 #include "backup.hpp"
 #include "window.hpp"
 #include "../game_objects/i_game_object.hpp"
+#include "jobs.hpp"
+#include "journal.hpp"
+#include "play_snapshot.hpp"
+#include "script.hpp"
+
+#include <chrono>
+
+namespace
+{
+    // Loading runs before the first frame, so the console is where its progress shows.
+    void print_load_progress(std::string_view stage, size_t done, size_t total)
+    {
+        if (done == total)
+            std::cout << "scene load: " << stage << " " << done << "/" << total << std::endl;
+    }
+}
 
 namespace marko_engine
 {
 
+    struct Backup::Save_Request
+    {
+        MarkoEngine::Scene_Data scene;
+        // Geometry behind each entry of scene.mesh_blobs, whose records are filled in on the backup thread.
+        std::vector<std::shared_ptr<MarkoEngine::Mesh_Geometry>> meshes;
+    };
+
+    Backup::Backup() = default;
+
+    Backup::~Backup()
+    {
+        cleanup();
+    }
+
     Backup& Backup::get()
     {
         static Backup instance;
@@ -18,90 +48,191 @@ namespace marko_engine
         {
             std::filesystem::create_directory("backups");
         }
+
+        MarkoEngine::Blob_Store::get().initialize("backups/blobs");
+        MarkoEngine::Journal::get().initialize("backups/journal");
+        collect_garbage();
+
+        m_stopping = false;
+        m_worker = std::thread(&Backup::run_saves, this);
     }
 
-    void Backup::cleanup()
+    size_t Backup::collect_garbage()
     {
-        std::filesystem::remove("backups/temp_object_state.bin");
+        std::unordered_set<MarkoEngine::Blob_Hash> live;
+        MarkoEngine::Journal::get().collect_blobs(live);
+        MarkoEngine::collect_scene_blobs("backups", live);
+        return MarkoEngine::Blob_Store::get().collect_garbage(live);
     }
 
-    void Backup::save_object_state()
+    void Backup::cleanup()
     {
-        std::vector<std::string> backup_folders;
-        for (const auto& entry : std::filesystem::directory_iterator("backups"))
+        // A save still in flight is finished before the editor goes away.
+        if (m_worker.joinable())
         {
-            if (entry.is_directory())
             {
-                std::string name = entry.path().filename().string();
-                if (std::regex_match(name, std::regex("backup[0-9]+")))
-                {
-                    backup_folders.push_back(name);
-                }
+                std::lock_guard lock(m_mutex);
+                m_stopping = true;
             }
+            m_condition.notify_one();
+            m_worker.join();
         }
 
-        std::sort(backup_folders.begin(), backup_folders.end(), [](const std::string& a, const std::string& b) {
-            int num_a = std::stoi(a.substr(6));
-            int num_b = std::stoi(b.substr(6));
-            return num_a > num_b;
-            });
+    }
 
-        for (const auto& folder : backup_folders)
+    void Backup::save_object_state()
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        auto request = std::make_unique<Save_Request>();
+        I_GAME_OBJECT::build_scene(request->scene, &request->meshes);
         {
-            int num = std::stoi(folder.substr(6));
-            std::string new_name = "backups/backup" + std::to_string(num + 1);
-            std::filesystem::rename("backups/" + folder, new_name);
+            std::lock_guard lock(m_mutex);
+            m_pending = std::move(request);
         }
+        m_condition.notify_one();
 
-        std::filesystem::create_directory("backups/backup1");
+        m_last_stall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
 
-        if (std::filesystem::exists("backups/backup1/game_objects.bin"))
+    void Backup::run_saves()
+    {
+        std::unique_lock lock(m_mutex);
+        while (true)
         {
-            std::filesystem::rename("backups/backup1/game_objects.bin", "backups/backup1/game_objects.bin.bak");
+            m_condition.wait(lock, [this]() { return m_pending != nullptr || m_stopping; });
+            if (m_pending == nullptr)
+                break;
+
+            std::unique_ptr<Save_Request> request = std::move(m_pending);
+            m_writing = true;
+            lock.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+
+            // Blob writes are durable, directory included, before the journal entry that references them is appended.
+            bool saved = true;
+            for (size_t i = 0; i < request->meshes.size() && saved; ++i)
+            {
+                request->scene.mesh_blobs[i] = request->meshes[i]->blob();
+                saved = !request->scene.mesh_blobs[i].hash.empty();
+            }
+            saved = saved && MarkoEngine::Journal::get().save(request->scene);
+
+            const double duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            request.reset();
+
+            lock.lock();
+            m_writing = false;
+            m_last_duration = duration;
+            saved ? ++m_completed : ++m_failed;
         }
-        I_GAME_OBJECT::save_to_binary("backups/backup1/game_objects.bin");
     }
 
-    void Backup::load_object_state()
+    void Backup::update()
     {
-        I_GAME_OBJECT::load_from_binary("backups/backup1/game_objects.bin");
+        size_t completed = 0;
+        size_t failed = 0;
+        {
+            std::lock_guard lock(m_mutex);
+            std::swap(completed, m_completed);
+            std::swap(failed, m_failed);
+        }
+
+        if (completed > 0)
+        {
+            std::cout << "save completed! (" << MarkoEngine::Journal::get().last_write_size() << " bytes, " << m_last_stall
+                << " ms on the main thread, " << last_save_duration() << " ms in the background)" << std::endl;
+        }
+        if (failed > 0)
+        {
+            std::cerr << "save failed!" << std::endl;
+        }
     }
 
-    void Backup::save_temp_object_state()
+    bool Backup::saving()
     {
-        std::filesystem::remove("backups/temp_object_state.bin");
+        std::lock_guard lock(m_mutex);
+        return m_writing || m_pending != nullptr;
+    }
+
+    double Backup::last_save_duration()
+    {
+        std::lock_guard lock(m_mutex);
+        return m_last_duration;
+    }
 
-        std::ofstream datao("backups/temp_object_state.bin", std::ios::binary | std::ios::app);
-        if (datao.is_open())
+    void Backup::load_object_state()
+    {
+        // Saves from before the journal stay in the backupN folders; the newest one seeds the first checkpoint.
+        const auto start = std::chrono::steady_clock::now();
+
+        if (MarkoEngine::Journal::get().empty())
         {
-            std::cout << "SAVE!";
-            for (auto& game_object : I_GAME_OBJECT::game_objects)
-            {
-                transform t = game_object.second->get_local_transform();
-                datao.write(reinterpret_cast<const char*>(&t.position), sizeof(glm::vec3));
-                datao.write(reinterpret_cast<const char*>(&t.rotation), sizeof(glm::vec3));
-                datao.write(reinterpret_cast<const char*>(&t.scale), sizeof(glm::vec3));
-            }
-            datao.close();
+            I_GAME_OBJECT::load_from_binary("backups/backup1/game_objects.bin", print_load_progress);
+        }
+        else
+        {
+            MarkoEngine::Scene_Data scene;
+            MarkoEngine::Journal::get().restore_latest(scene);
+            load_scene(scene);
         }
+
+        std::cout << "scene loaded in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+            << " ms on " << MarkoEngine::Jobs::get().thread_count() << " threads" << std::endl;
     }
 
-    void Backup::load_temp_object_state()
+    bool Backup::restore_object_state(uint64_t sequence)
     {
-        std::ifstream datai("backups/temp_object_state.bin", std::ios::binary);
-        if (datai.is_open())
+        MarkoEngine::Scene_Data scene;
+        if (!MarkoEngine::Journal::get().restore(sequence, scene))
         {
-            std::cout << "LOAD!";
-            glm::vec3 position, rotation, scale;
-            for (auto& game_object : I_GAME_OBJECT::game_objects)
-            {
-                datai.read(reinterpret_cast<char*>(&position), sizeof(glm::vec3));
-                datai.read(reinterpret_cast<char*>(&rotation), sizeof(glm::vec3));
-                datai.read(reinterpret_cast<char*>(&scale), sizeof(glm::vec3));
-                game_object.second->set_local_transform(transform(position, rotation, scale));
-            }
-            datai.close();
+            std::cerr << "No backup to restore at entry " << sequence << std::endl;
+            return false;
+        }
+
+        I_GAME_OBJECT::game_objects.clear();
+        load_scene(scene);
+        return true;
+    }
+
+    void Backup::load_scene(const MarkoEngine::Scene_Data& scene)
+    {
+        const std::vector<uint8_t> buffer = MarkoEngine::serialize_scene(scene);
+        MarkoEngine::Scene_View view;
+        if (view.open(buffer.data(), buffer.size()))
+        {
+            I_GAME_OBJECT::load_scene(view, print_load_progress);
         }
     }
 
+    void Backup::save_temp_object_state()
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        m_play_snapshot = std::make_unique<MarkoEngine::Play_Snapshot>();
+        m_play_snapshot->capture();
+
+        m_last_play_toggle = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "play snapshot of " << m_play_snapshot->object_count() << " objects in " << m_last_play_toggle << " ms" << std::endl;
+    }
+
+    void Backup::load_temp_object_state()
+    {
+        if (!m_play_snapshot)
+            return;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        const size_t restored = m_play_snapshot->restore();
+        m_play_snapshot.reset();
+
+        // Script globals are whatever play left behind; a fresh state is what the next play expects.
+        MarkoEngine::Script::get().cleanup();
+        MarkoEngine::Script::get().initialize();
+
+        m_last_play_toggle = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "restored " << restored << " changed objects in " << m_last_play_toggle << " ms" << std::endl;
+    }
+
 }
\ No newline at end of file
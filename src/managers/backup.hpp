@@ -1,4 +1,16 @@
 #pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace MarkoEngine
+{
+	struct Scene_Data;
+	class Play_Snapshot;
+}
 
 namespace marko_engine
 {
@@ -12,7 +24,8 @@ namespace marko_engine
 		Backup& operator=(Backup&&) = delete;
 
 	private:
-		Backup() = default;
+		Backup();
+		~Backup();
 
 	public:
 		void initialize();
@@ -20,10 +33,48 @@ namespace marko_engine
 
 		static Backup& get();
 
+		// Snapshots the scene on the calling thread and leaves mesh blobs, serialization and the durable write to the
+		// backup thread.
 		void save_object_state();
+		// Reports saves the backup thread finished since the last call; called once per frame.
+		void update();
+		bool saving();
+		double last_save_stall() const { return m_last_stall; }
+		double last_save_duration();
+
 		void load_object_state();
+		// Replaces the scene with the state saved at the given journal entry.
+		bool restore_object_state(uint64_t sequence);
+		// Play mode: the scene is kept in memory when play starts and put back when it stops.
 		void save_temp_object_state();
 		void load_temp_object_state();
+		double last_play_toggle() const { return m_last_play_toggle; }
+
+		// Removes blobs no longer referenced by any saved scene.
+		size_t collect_garbage();
+
+	private:
+		void load_scene(const MarkoEngine::Scene_Data& scene);
+		void run_saves();
+
+	private:
+		struct Save_Request;
+
+		std::thread m_worker;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		// Only the newest snapshot is kept, so saves requested while one is being written collapse into one.
+		std::unique_ptr<Save_Request> m_pending;
+		bool m_writing = false;
+		bool m_stopping = false;
+		size_t m_completed = 0;
+		size_t m_failed = 0;
+
+		double m_last_stall = 0.0;
+		double m_last_duration = 0.0;
+
+		std::unique_ptr<MarkoEngine::Play_Snapshot> m_play_snapshot;
+		double m_last_play_toggle = 0.0;
 	};
 
 } 
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "pch.h"
+#include "blob_store.hpp"
+#include "compression.hpp"
+#include "mapped_file.hpp"
+
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    // "MKBL"
+    constexpr uint32_t BLOB_MAGIC = 0x4C424B4Du;
+    constexpr uint32_t BLOB_COMPRESSED = 1u << 0;
+
+    struct Blob_Header
+    {
+        uint32_t magic;
+        uint32_t flags;
+        uint64_t size;
+        uint64_t stored_size;
+    };
+
+    uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    uint64_t rotate_left(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+}
+
+std::string MarkoEngine::Blob_Hash::hex() const
+{
+    static constexpr char digits[] = "0123456789abcdef";
+
+    std::string result(32, '0');
+    for (int i = 0; i < 16; ++i)
+    {
+        result[15 - i] = digits[(high >> (i * 4)) & 0xF];
+        result[31 - i] = digits[(low >> (i * 4)) & 0xF];
+    }
+    return result;
+}
+
+MarkoEngine::Blob_Hash MarkoEngine::hash_blob(const uint8_t* data, size_t size)
+{
+    uint64_t first = 0x9E3779B97F4A7C15ull ^ size;
+    uint64_t second = 0xC2B2AE3D27D4EB4Full + size;
+
+    size_t offset = 0;
+    for (; offset + 8 <= size; offset += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + offset, sizeof(word));
+        first = rotate_left(first ^ mix(word), 27) * 0x87C37B91114253D5ull + 0x52DCE729;
+        second = rotate_left(second + mix(word ^ 0x4CF5AD432745937Full), 31) * 0x4CF5AD432745937Full + 0x38495AB5;
+    }
+
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + offset, size - offset);
+    first = mix(first ^ mix(tail));
+    second = mix(second + mix(tail ^ first));
+
+    return { first, second };
+}
+
+MarkoEngine::Blob_Store& MarkoEngine::Blob_Store::get()
+{
+    static Blob_Store instance;
+    return instance;
+}
+
+void MarkoEngine::Blob_Store::initialize(const std::string& root)
+{
+    m_root = root;
+    std::filesystem::create_directories(m_root);
+}
+
+std::string MarkoEngine::Blob_Store::path(const Blob_Hash& hash) const
+{
+    const std::string name = hash.hex();
+    return m_root + "/" + name.substr(0, 2) + "/" + name + ".blob";
+}
+
+bool MarkoEngine::Blob_Store::contains(const Blob_Hash& hash) const
+{
+    return std::filesystem::exists(path(hash));
+}
+
+MarkoEngine::Blob_Hash MarkoEngine::Blob_Store::put(const uint8_t* data, size_t size)
+{
+    const Blob_Hash hash = hash_blob(data, size);
+    const std::string blob_path = path(hash);
+    if (std::filesystem::exists(blob_path))
+        return hash;
+
+    std::vector<uint8_t> compressed = compress_lz(data, size);
+    const bool use_compressed = compressed.size() < size;
+
+    Blob_Header header{ BLOB_MAGIC, use_compressed ? BLOB_COMPRESSED : 0u, size, use_compressed ? compressed.size() : size };
+
+    std::vector<uint8_t> file(sizeof(header) + header.stored_size);
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + sizeof(header), use_compressed ? compressed.data() : data, header.stored_size);
+
+    // Written durably under a temporary name and renamed, so neither a crash nor a full disk leaves a truncated blob
+    // behind its hash, which would never be written again.
+    const std::filesystem::path directory = std::filesystem::path(blob_path).parent_path();
+    std::error_code error;
+    if (std::filesystem::create_directories(directory, error))
+        sync_directory(m_root);
+
+    // Saves put blobs from the backup thread while the editor may put the same one, so each thread has its own name.
+    const std::string temporary_path = blob_path + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    if (!write_durable(temporary_path, file.data(), file.size(), false) || !rename_durable(temporary_path, blob_path)) {
+        std::cerr << "Failed to write blob: " << blob_path << std::endl;
+        std::filesystem::remove(temporary_path, error);
+        return {};
+    }
+
+    return hash;
+}
+
+bool MarkoEngine::Blob_Store::get(const Blob_Hash& hash, std::vector<uint8_t>& data) const
+{
+    const std::string blob_path = path(hash);
+    std::ifstream ifs(blob_path, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "Missing blob: " << blob_path << std::endl;
+        return false;
+    }
+
+    Blob_Header header{};
+    ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!ifs || header.magic != BLOB_MAGIC) {
+        std::cerr << "Corrupt blob: " << blob_path << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> stored(header.stored_size);
+    ifs.read(reinterpret_cast<char*>(stored.data()), stored.size());
+    if (!ifs) {
+        std::cerr << "Truncated blob: " << blob_path << std::endl;
+        return false;
+    }
+
+    if ((header.flags & BLOB_COMPRESSED) == 0)
+    {
+        data = std::move(stored);
+    }
+    else
+    {
+        data.resize(header.size);
+        if (!decompress_lz(stored.data(), stored.size(), data.data(), data.size())) {
+            std::cerr << "Corrupt blob: " << blob_path << std::endl;
+            return false;
+        }
+    }
+
+    return hash_blob(data.data(), data.size()) == hash;
+}
+
+size_t MarkoEngine::Blob_Store::collect_garbage(const std::unordered_set<Blob_Hash>& live)
+{
+    if (!std::filesystem::exists(m_root))
+        return 0;
+
+    std::unordered_set<std::string> live_names;
+    for (const Blob_Hash& hash : live)
+        live_names.insert(hash.hex() + ".blob");
+
+    std::vector<std::filesystem::path> dead;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(m_root))
+    {
+        if (entry.is_regular_file() && !live_names.contains(entry.path().filename().string()))
+            dead.push_back(entry.path());
+    }
+
+    for (const auto& path : dead)
+        std::filesystem::remove(path);
+
+    return dead.size();
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace MarkoEngine
+{
+    // 128-bit content hash; not cryptographic, but wide enough that distinct payloads never share a blob in practice.
+    struct Blob_Hash
+    {
+        uint64_t high = 0;
+        uint64_t low = 0;
+
+        bool empty() const { return high == 0 && low == 0; }
+        bool operator==(const Blob_Hash& other) const = default;
+
+        std::string hex() const;
+    };
+
+    Blob_Hash hash_blob(const uint8_t* data, size_t size);
+}
+
+template <>
+struct std::hash<MarkoEngine::Blob_Hash>
+{
+    size_t operator()(const MarkoEngine::Blob_Hash& hash) const noexcept
+    {
+        return static_cast<size_t>(hash.low ^ (hash.high * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+namespace MarkoEngine
+{
+    // Immutable payloads stored once under their hash and LZ-compressed, so every scene and backup that uses the
+    // same data shares one file.
+    class Blob_Store
+    {
+    public:
+        Blob_Store(const Blob_Store&) = delete;
+        Blob_Store(Blob_Store&&) = delete;
+        Blob_Store& operator=(const Blob_Store&) = delete;
+        Blob_Store& operator=(Blob_Store&&) = delete;
+
+    private:
+        Blob_Store() = default;
+
+    public:
+        static Blob_Store& get();
+
+        void initialize(const std::string& root);
+
+        Blob_Hash put(const uint8_t* data, size_t size);
+        bool get(const Blob_Hash& hash, std::vector<uint8_t>& data) const;
+        bool contains(const Blob_Hash& hash) const;
+
+        // Deletes every blob not in the live set and returns how many were removed.
+        size_t collect_garbage(const std::unordered_set<Blob_Hash>& live);
+
+        std::string path(const Blob_Hash& hash) const;
+        const std::string& root() const { return m_root; }
+
+    private:
+        std::string m_root = "backups/blobs";
+    };
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "compression.hpp"
+
+#include <cstring>
+
+namespace
+{
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr size_t HASH_BITS = 14;
+    constexpr size_t LAST_LITERALS = 5;
+
+    uint32_t read_u32(const uint8_t* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash_sequence(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void write_length(std::vector<uint8_t>& output, size_t length)
+    {
+        while (length >= 255)
+        {
+            output.push_back(255);
+            length -= 255;
+        }
+        output.push_back(static_cast<uint8_t>(length));
+    }
+
+    void write_sequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t literal_length, size_t match_length, size_t offset)
+    {
+        const size_t match_code = match_length ? match_length - MIN_MATCH : 0;
+        output.push_back(static_cast<uint8_t>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15)));
+        if (literal_length >= 15)
+            write_length(output, literal_length - 15);
+
+        output.insert(output.end(), literals, literals + literal_length);
+        if (match_length == 0)
+            return;
+
+        output.push_back(static_cast<uint8_t>(offset & 0xFF));
+        output.push_back(static_cast<uint8_t>(offset >> 8));
+        if (match_code >= 15)
+            write_length(output, match_code - 15);
+    }
+
+    bool read_length(const uint8_t*& input, const uint8_t* end, size_t& length)
+    {
+        uint8_t byte;
+        do
+        {
+            if (input >= end)
+                return false;
+            byte = *input++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+}
+
+std::vector<uint8_t> MarkoEngine::compress_lz(const uint8_t* data, size_t size)
+{
+    std::vector<uint8_t> output;
+    output.reserve(size / 2 + 16);
+
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t position = 0;
+
+    if (size > MIN_MATCH + LAST_LITERALS)
+    {
+        const size_t match_limit = size - LAST_LITERALS;
+        while (position + MIN_MATCH <= match_limit)
+        {
+            const uint32_t sequence = read_u32(data + position);
+            const uint32_t hash = hash_sequence(sequence);
+            const size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(position);
+
+            if (candidate >= position || position - candidate > MAX_OFFSET || read_u32(data + candidate) != sequence)
+            {
+                ++position;
+                continue;
+            }
+
+            size_t match_length = MIN_MATCH;
+            while (position + match_length < match_limit && data[candidate + match_length] == data[position + match_length])
+                ++match_length;
+
+            write_sequence(output, data + anchor, position - anchor, match_length, position - candidate);
+            position += match_length;
+            anchor = position;
+        }
+    }
+
+    write_sequence(output, data + anchor, size - anchor, 0, 0);
+    return output;
+}
+
+bool MarkoEngine::decompress_lz(const uint8_t* data, size_t size, uint8_t* output, size_t output_size)
+{
+    const uint8_t* input = data;
+    const uint8_t* input_end = data + size;
+    size_t written = 0;
+
+    while (input < input_end)
+    {
+        const uint8_t token = *input++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(input, input_end, literal_length))
+            return false;
+
+        if (literal_length > static_cast<size_t>(input_end - input) || literal_length > output_size - written)
+            return false;
+
+        std::memcpy(output + written, input, literal_length);
+        input += literal_length;
+        written += literal_length;
+
+        if (input == input_end)
+            break;
+
+        if (input_end - input < 2)
+            return false;
+
+        const size_t offset = input[0] | static_cast<size_t>(input[1]) << 8;
+        input += 2;
+
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !read_length(input, input_end, match_length))
+            return false;
+        match_length += MIN_MATCH;
+
+        if (offset == 0 || offset > written || match_length > output_size - written)
+            return false;
+
+        // Byte by byte because matches may overlap their own output.
+        const uint8_t* source = output + written - offset;
+        for (size_t i = 0; i < match_length; ++i)
+            output[written + i] = source[i];
+        written += match_length;
+    }
+
+    return written == output_size;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MarkoEngine
+{
+    // Byte-oriented LZ77 in the style of LZ4 blocks: cheap to decode, worthwhile on repetitive vertex data.
+    std::vector<uint8_t> compress_lz(const uint8_t* data, size_t size);
+
+    // Returns false when the input is malformed or does not expand to exactly output_size bytes.
+    bool decompress_lz(const uint8_t* data, size_t size, uint8_t* output, size_t output_size);
+}
\ No newline at end of file
@@ -0,0 +1,570 @@
+#include "pch.h"
+#include "cooked_mesh.hpp"
+#include "asset_database.hpp"
+#include "compression.hpp"
+#include "file_system.hpp"
+
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    size_t align_up(size_t value)
+    {
+        return (value + MarkoEngine::SCENE_CHUNK_ALIGNMENT - 1) & ~(MarkoEngine::SCENE_CHUNK_ALIGNMENT - 1);
+    }
+
+    template <typename T>
+    void append(std::vector<uint8_t>& buffer, const T* data, size_t count)
+    {
+        const size_t bytes = sizeof(T) * count;
+        if (bytes == 0)
+            return;
+
+        const size_t offset = buffer.size();
+        buffer.resize(offset + bytes);
+        std::memcpy(buffer.data() + offset, data, bytes);
+    }
+
+    std::string_view mesh_settings(bool skinned)
+    {
+        return skinned ? MarkoEngine::SKINNED_IMPORT_SETTINGS : MarkoEngine::MODEL_IMPORT_SETTINGS;
+    }
+
+    // An exported package ships cooked files without their sources, so a packed one has nothing to be stale against.
+    bool is_current(const MarkoEngine::File_Data& file, const std::string& source, std::string_view settings, const MarkoEngine::Blob_Hash& input_hash)
+    {
+        if (file.packed() && !MarkoEngine::File_System::get().exists(source))
+            return true;
+        return input_hash == MarkoEngine::Asset_Database::get().input_hash(source, settings);
+    }
+
+    // Written aside and renamed so a reader never maps a half-written file. The model and skinned cooks of one source
+    // run on the job pool together and both write its embedded textures, so each thread has its own temporary name.
+    bool write_file(const std::string& filename, const std::vector<uint8_t>& header, const uint8_t* data, size_t size)
+    {
+        const std::filesystem::path path = filename;
+        const std::filesystem::path temporary = filename + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        {
+            std::ofstream ofs(temporary, std::ios::binary);
+            if (!ofs) {
+                std::cerr << "Failed to open file for saving: " << temporary.string() << std::endl;
+                return false;
+            }
+            ofs.write(reinterpret_cast<const char*>(header.data()), header.size());
+            ofs.write(reinterpret_cast<const char*>(data), size);
+            ofs.close();
+            if (!ofs)
+            {
+                std::filesystem::remove(temporary, error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        if (!error)
+            return true;
+
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    void add_texture_dependencies(const std::string& source, const std::vector<Imported_Mesh>& meshes)
+    {
+        std::vector<std::string> textures;
+        for (const Imported_Mesh& mesh : meshes)
+        {
+            // Embedded textures are part of the source itself.
+            if (!mesh.texture_filename.empty() && MarkoEngine::embedded_texture_source(mesh.texture_filename).empty())
+                textures.push_back(mesh.texture_filename);
+        }
+        MarkoEngine::Asset_Database::get().add_dependencies(source, textures);
+    }
+
+    struct Cooked_Data
+    {
+        MarkoEngine::Scene_Data strings;
+        std::vector<MarkoEngine::Cooked_Submesh_Record> submeshes;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<MarkoEngine::Cooked_Node_Record> nodes;
+        std::vector<MarkoEngine::Cooked_Bone_Record> bones;
+        std::vector<MarkoEngine::Cooked_Clip_Record> clips;
+        std::vector<MarkoEngine::Cooked_Channel_Record> channels;
+        std::vector<Keyframe> keyframes;
+    };
+
+    void add_meshes(Cooked_Data& data, const std::vector<Imported_Mesh>& meshes)
+    {
+        for (const Imported_Mesh& mesh : meshes)
+        {
+            data.submeshes.push_back({ data.strings.add_string(mesh.texture_filename), 0, data.vertices.size(), mesh.vertices.size(),
+                data.indices.size(), mesh.indices.size() });
+            data.vertices.insert(data.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+            data.indices.insert(data.indices.end(), mesh.indices.begin(), mesh.indices.end());
+        }
+    }
+
+    // Same chunk table as scene files, behind a header that carries the input hash.
+    bool write_cooked(const std::string& source, bool skinned, const Cooked_Data& data, const MarkoEngine::Aabb& bounds, const glm::mat4& global_inverse_transform)
+    {
+        MarkoEngine::Cooked_Mesh_Header header{};
+        header.input_hash = MarkoEngine::Asset_Database::get().input_hash(source, mesh_settings(skinned));
+        if (header.input_hash.empty())
+            return false;
+
+        std::vector<uint8_t> strings;
+        {
+            std::vector<uint32_t> offsets;
+            uint32_t offset = 0;
+            for (const std::string& string : data.strings.strings)
+            {
+                offsets.push_back(offset);
+                offset += static_cast<uint32_t>(string.size() + 1);
+            }
+            offsets.push_back(offset);
+
+            const uint32_t count = static_cast<uint32_t>(data.strings.strings.size());
+            append(strings, &count, 1);
+            append(strings, offsets.data(), offsets.size());
+            for (const std::string& string : data.strings.strings)
+                append(strings, string.c_str(), string.size() + 1);
+        }
+
+        struct Chunk_Source
+        {
+            uint32_t id;
+            uint32_t stride;
+            size_t count;
+            const void* data;
+            size_t size;
+        };
+
+        const std::array<Chunk_Source, 9> sources = { {
+            { MarkoEngine::COOKED_CHUNK_STRINGS, 1, strings.size(), strings.data(), strings.size() },
+            { MarkoEngine::COOKED_CHUNK_SUBMESHES, sizeof(MarkoEngine::Cooked_Submesh_Record), data.submeshes.size(), data.submeshes.data(), data.submeshes.size() * sizeof(MarkoEngine::Cooked_Submesh_Record) },
+            { MarkoEngine::COOKED_CHUNK_VERTICES, sizeof(Vertex), data.vertices.size(), data.vertices.data(), data.vertices.size() * sizeof(Vertex) },
+            { MarkoEngine::COOKED_CHUNK_INDICES, sizeof(uint32_t), data.indices.size(), data.indices.data(), data.indices.size() * sizeof(uint32_t) },
+            { MarkoEngine::COOKED_CHUNK_NODES, sizeof(MarkoEngine::Cooked_Node_Record), data.nodes.size(), data.nodes.data(), data.nodes.size() * sizeof(MarkoEngine::Cooked_Node_Record) },
+            { MarkoEngine::COOKED_CHUNK_BONES, sizeof(MarkoEngine::Cooked_Bone_Record), data.bones.size(), data.bones.data(), data.bones.size() * sizeof(MarkoEngine::Cooked_Bone_Record) },
+            { MarkoEngine::COOKED_CHUNK_CLIPS, sizeof(MarkoEngine::Cooked_Clip_Record), data.clips.size(), data.clips.data(), data.clips.size() * sizeof(MarkoEngine::Cooked_Clip_Record) },
+            { MarkoEngine::COOKED_CHUNK_CHANNELS, sizeof(MarkoEngine::Cooked_Channel_Record), data.channels.size(), data.channels.data(), data.channels.size() * sizeof(MarkoEngine::Cooked_Channel_Record) },
+            { MarkoEngine::COOKED_CHUNK_KEYFRAMES, sizeof(Keyframe), data.keyframes.size(), data.keyframes.data(), data.keyframes.size() * sizeof(Keyframe) }
+        } };
+
+        header.magic = MarkoEngine::COOKED_MESH_MAGIC;
+        header.version = MarkoEngine::COOKED_MESH_VERSION;
+        header.chunk_count = static_cast<uint32_t>(sources.size());
+        header.bounds = bounds;
+        header.flags = skinned ? MarkoEngine::COOKED_MESH_SKINNED : 0u;
+        header.global_inverse_transform = global_inverse_transform;
+
+        std::vector<MarkoEngine::Scene_Chunk_Entry> entries(sources.size());
+        size_t offset = align_up(sizeof(MarkoEngine::Cooked_Mesh_Header) + sizeof(MarkoEngine::Scene_Chunk_Entry) * entries.size());
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            entries[i] = { sources[i].id, 1, sources[i].stride, static_cast<uint32_t>(sources[i].count), offset, sources[i].size };
+            offset = align_up(offset + sources[i].size);
+        }
+
+        std::vector<uint8_t> buffer;
+        buffer.reserve(offset);
+        append(buffer, &header, 1);
+        append(buffer, entries.data(), entries.size());
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            buffer.resize(entries[i].offset, 0);
+            append(buffer, static_cast<const uint8_t*>(sources[i].data), sources[i].size);
+        }
+        buffer.resize(offset, 0);
+
+        if (!write_file(MarkoEngine::cooked_mesh_path(source, skinned), buffer, nullptr, 0))
+            return false;
+
+        MarkoEngine::Asset_Database::get().mark_cooked(source, mesh_settings(skinned), header.input_hash);
+        return true;
+    }
+
+    // Validates a mapped cooked file against its source and reads chunks out of it.
+    class Cooked_View
+    {
+    public:
+        bool open(const std::string& source, bool skinned)
+        {
+            m_file = MarkoEngine::File_System::get().open(MarkoEngine::cooked_mesh_path(source, skinned));
+            if (!m_file.is_open() || m_file.size() < sizeof(MarkoEngine::Cooked_Mesh_Header))
+                return false;
+
+            std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+            if (m_header.magic != MarkoEngine::COOKED_MESH_MAGIC || m_header.version != MarkoEngine::COOKED_MESH_VERSION ||
+                ((m_header.flags & MarkoEngine::COOKED_MESH_SKINNED) != 0) != skinned ||
+                !is_current(m_file, source, mesh_settings(skinned), m_header.input_hash))
+                return false;
+
+            const size_t size = m_file.size();
+            if (size < sizeof(MarkoEngine::Cooked_Mesh_Header) + sizeof(MarkoEngine::Scene_Chunk_Entry) * static_cast<size_t>(m_header.chunk_count))
+                return false;
+
+            m_chunks = reinterpret_cast<const MarkoEngine::Scene_Chunk_Entry*>(m_file.data() + sizeof(MarkoEngine::Cooked_Mesh_Header));
+            for (uint32_t i = 0; i < m_header.chunk_count; ++i)
+            {
+                const MarkoEngine::Scene_Chunk_Entry& chunk = m_chunks[i];
+                if (chunk.offset > size || chunk.size > size - chunk.offset || chunk.offset % MarkoEngine::SCENE_CHUNK_ALIGNMENT != 0)
+                    return false;
+            }
+
+            const MarkoEngine::Scene_Chunk_Entry* strings = find_chunk(MarkoEngine::COOKED_CHUNK_STRINGS);
+            if (strings == nullptr || strings->size < sizeof(uint32_t))
+                return false;
+
+            const uint8_t* string_chunk = m_file.data() + strings->offset;
+            std::memcpy(&m_string_count, string_chunk, sizeof(uint32_t));
+            const size_t table_size = sizeof(uint32_t) * (static_cast<size_t>(m_string_count) + 2);
+            if (table_size > strings->size)
+                return false;
+
+            m_string_offsets = reinterpret_cast<const uint32_t*>(string_chunk + sizeof(uint32_t));
+            m_string_data = reinterpret_cast<const char*>(string_chunk + table_size);
+            return m_string_offsets[m_string_count] <= strings->size - table_size;
+        }
+
+        const MarkoEngine::Cooked_Mesh_Header& header() const { return m_header; }
+
+        std::string_view string(uint32_t index) const
+        {
+            if (index >= m_string_count)
+                return {};
+
+            const uint32_t begin = m_string_offsets[index];
+            const uint32_t end = m_string_offsets[index + 1];
+            return end > begin ? std::string_view(m_string_data + begin, end - begin - 1) : std::string_view();
+        }
+
+        template <typename T>
+        bool array(uint32_t id, MarkoEngine::Scene_Array<T>& result) const
+        {
+            const MarkoEngine::Scene_Chunk_Entry* chunk = find_chunk(id);
+            if (chunk == nullptr)
+            {
+                result = MarkoEngine::Scene_Array<T>();
+                return true;
+            }
+
+            if (chunk->stride < sizeof(T) || static_cast<uint64_t>(chunk->stride) * chunk->count > chunk->size)
+                return false;
+
+            result = MarkoEngine::Scene_Array<T>(m_file.data() + chunk->offset, chunk->count, chunk->stride);
+            return true;
+        }
+
+        bool meshes(std::vector<Imported_Mesh>& meshes) const
+        {
+            MarkoEngine::Scene_Array<MarkoEngine::Cooked_Submesh_Record> submeshes;
+            MarkoEngine::Scene_Array<Vertex> vertices;
+            MarkoEngine::Scene_Array<uint32_t> indices;
+            if (!array(MarkoEngine::COOKED_CHUNK_SUBMESHES, submeshes) || !array(MarkoEngine::COOKED_CHUNK_VERTICES, vertices) ||
+                !array(MarkoEngine::COOKED_CHUNK_INDICES, indices))
+                return false;
+
+            meshes.resize(submeshes.size());
+            for (size_t i = 0; i < submeshes.size(); ++i)
+            {
+                const MarkoEngine::Cooked_Submesh_Record& submesh = submeshes[i];
+                if (submesh.first_vertex + submesh.vertex_count > vertices.size() || submesh.first_index + submesh.index_count > indices.size())
+                    return false;
+
+                Imported_Mesh& mesh = meshes[i];
+                mesh.texture_filename = string(submesh.texture);
+                mesh.vertices.resize(submesh.vertex_count);
+                mesh.indices.resize(submesh.index_count);
+                if (vertices.contiguous() != nullptr)
+                {
+                    std::memcpy(mesh.vertices.data(), vertices.contiguous() + submesh.first_vertex, sizeof(Vertex) * submesh.vertex_count);
+                }
+                else
+                {
+                    for (size_t v = 0; v < submesh.vertex_count; ++v)
+                        mesh.vertices[v] = vertices[submesh.first_vertex + v];
+                }
+                for (size_t j = 0; j < submesh.index_count; ++j)
+                {
+                    mesh.indices[j] = indices[submesh.first_index + j];
+                    if (mesh.indices[j] >= submesh.vertex_count)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        const MarkoEngine::Scene_Chunk_Entry* find_chunk(uint32_t id) const
+        {
+            for (uint32_t i = 0; i < m_header.chunk_count; ++i)
+            {
+                if (m_chunks[i].id == id)
+                    return &m_chunks[i];
+            }
+            return nullptr;
+        }
+
+    private:
+        MarkoEngine::File_Data m_file;
+        MarkoEngine::Cooked_Mesh_Header m_header{};
+        const MarkoEngine::Scene_Chunk_Entry* m_chunks = nullptr;
+        const uint32_t* m_string_offsets = nullptr;
+        const char* m_string_data = nullptr;
+        uint32_t m_string_count = 0;
+    };
+}
+
+std::string MarkoEngine::cooked_mesh_path(const std::string& source, bool skinned)
+{
+    std::filesystem::path path = std::filesystem::path(COOKED_MESH_DIRECTORY) / std::filesystem::path(source).relative_path();
+    path += skinned ? ".skinned.mmesh" : ".mmesh";
+    return path.string();
+}
+
+std::string MarkoEngine::cooked_texture_path(const std::string& source)
+{
+    std::filesystem::path path = std::filesystem::path(COOKED_MESH_DIRECTORY) / std::filesystem::path(source).relative_path();
+    path += ".mtex";
+    return path.string();
+}
+
+std::string MarkoEngine::embedded_texture_name(const std::string& source, int index)
+{
+    return source + "#" + std::to_string(index);
+}
+
+std::string MarkoEngine::embedded_texture_source(const std::string& texture)
+{
+    const size_t separator = texture.rfind('#');
+    if (separator == std::string::npos || separator + 1 == texture.size() ||
+        !std::all_of(texture.begin() + separator + 1, texture.end(), [](unsigned char character) { return std::isdigit(character) != 0; }))
+        return std::string();
+    return texture.substr(0, separator);
+}
+
+bool MarkoEngine::load_cooked_model(const std::string& source, Imported_Model& model)
+{
+    Cooked_View view;
+    if (!view.open(source, false))
+        return false;
+
+    Imported_Model result;
+    if (!view.meshes(result.meshes))
+        return false;
+
+    result.bounds = view.header().bounds;
+    result.triangles = std::make_shared<Triangle_Mesh>();
+    for (const Imported_Mesh& mesh : result.meshes)
+    {
+        const uint32_t first_position = static_cast<uint32_t>(result.triangles->positions.size());
+        for (const Vertex& vertex : mesh.vertices)
+            result.triangles->positions.push_back(vertex.position);
+        for (uint32_t index : mesh.indices)
+            result.triangles->indices.push_back(first_position + index);
+    }
+
+    model = std::move(result);
+    return true;
+}
+
+bool MarkoEngine::load_cooked_animation(const std::string& source, Imported_Animation& animation)
+{
+    Cooked_View view;
+    if (!view.open(source, true))
+        return false;
+
+    Scene_Array<Cooked_Node_Record> nodes;
+    Scene_Array<Cooked_Bone_Record> bones;
+    Scene_Array<Cooked_Clip_Record> clips;
+    Scene_Array<Cooked_Channel_Record> channels;
+    Scene_Array<Keyframe> keyframes;
+    if (!view.array(COOKED_CHUNK_NODES, nodes) || !view.array(COOKED_CHUNK_BONES, bones) || !view.array(COOKED_CHUNK_CLIPS, clips) ||
+        !view.array(COOKED_CHUNK_CHANNELS, channels) || !view.array(COOKED_CHUNK_KEYFRAMES, keyframes))
+        return false;
+
+    Imported_Animation result;
+    if (!view.meshes(result.meshes))
+        return false;
+
+    result.asset = std::make_shared<Renderer_Animation_Asset>();
+    Renderer_Animation_Asset& asset = *result.asset;
+    asset.bounds = view.header().bounds;
+
+    Renderer_Skeleton& skeleton = asset.skeleton;
+    skeleton.global_inverse_transform = view.header().global_inverse_transform;
+    for (size_t i = 0; i < nodes.size(); ++i)
+        skeleton.nodes.push_back({ Name(view.string(nodes[i].name)), nodes[i].parent, nodes[i].bone_index, nodes[i].bind_pose });
+    for (size_t i = 0; i < bones.size(); ++i)
+    {
+        skeleton.bone_mapping.emplace(Name(view.string(bones[i].name)), static_cast<int>(i));
+        skeleton.bone_offset_matrices.push_back(bones[i].offset);
+    }
+
+    for (size_t i = 0; i < clips.size(); ++i)
+    {
+        const Cooked_Clip_Record& clip = clips[i];
+        if (static_cast<uint64_t>(clip.first_channel) + clip.channel_count > channels.size())
+            return false;
+
+        Animation animation_clip;
+        animation_clip.name = view.string(clip.name);
+        animation_clip.duration = clip.duration;
+        animation_clip.ticksPerSecond = clip.ticks_per_second;
+        for (uint32_t c = 0; c < clip.channel_count; ++c)
+        {
+            const Cooked_Channel_Record& channel = channels[clip.first_channel + c];
+            if (channel.first_keyframe + channel.keyframe_count > keyframes.size())
+                return false;
+
+            BoneAnimation bone_animation;
+            bone_animation.boneName = view.string(channel.name);
+            bone_animation.node_index = channel.node_index;
+            bone_animation.keyframes.resize(channel.keyframe_count);
+            for (size_t k = 0; k < channel.keyframe_count; ++k)
+                bone_animation.keyframes[k] = keyframes[channel.first_keyframe + k];
+            animation_clip.boneAnimations.push_back(std::move(bone_animation));
+        }
+        asset.animations.push_back(std::move(animation_clip));
+    }
+
+    animation = std::move(result);
+    return true;
+}
+
+bool MarkoEngine::load_cooked_texture(const std::string& source, Decoded_Texture& texture)
+{
+    const File_Data file = File_System::get().open(cooked_texture_path(source));
+    if (!file.is_open() || file.size() < sizeof(Cooked_Texture_Header))
+        return false;
+
+    Cooked_Texture_Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    const size_t pixel_size = static_cast<size_t>(header.width) * header.height * 4;
+    const std::string embedded = embedded_texture_source(source);
+    if (header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION || header.stored_size > file.size() - sizeof(header) ||
+        pixel_size == 0 || !is_current(file, embedded.empty() ? source : embedded, TEXTURE_IMPORT_SETTINGS, header.input_hash))
+        return false;
+
+    std::shared_ptr<uint8_t[]> pixels(new uint8_t[pixel_size]);
+    const uint8_t* stored = file.data() + sizeof(header);
+    if ((header.flags & COOKED_TEXTURE_COMPRESSED) != 0)
+    {
+        if (!decompress_lz(stored, static_cast<size_t>(header.stored_size), pixels.get(), pixel_size))
+            return false;
+    }
+    else
+    {
+        if (header.stored_size != pixel_size)
+            return false;
+        std::memcpy(pixels.get(), stored, pixel_size);
+    }
+
+    texture = { header.width, header.height, std::shared_ptr<const uint8_t>(pixels, pixels.get()) };
+    return true;
+}
+
+bool MarkoEngine::cook_texture(const std::string& source, const Decoded_Texture& texture)
+{
+    if (!texture.pixels)
+        return false;
+
+    const std::string embedded = embedded_texture_source(source);
+    const std::string& hashed = embedded.empty() ? source : embedded;
+    Cooked_Texture_Header header{ COOKED_TEXTURE_MAGIC, COOKED_TEXTURE_VERSION, 0, Asset_Database::get().input_hash(hashed, TEXTURE_IMPORT_SETTINGS),
+        texture.width, texture.height, 0 };
+    if (header.input_hash.empty())
+        return false;
+
+    const size_t pixel_size = static_cast<size_t>(texture.width) * texture.height * 4;
+    std::vector<uint8_t> compressed = compress_lz(texture.pixels.get(), pixel_size);
+    // Photographs barely compress and would only pay for decompression on every load.
+    const bool use_compressed = compressed.size() < pixel_size - pixel_size / 8;
+    header.flags = use_compressed ? COOKED_TEXTURE_COMPRESSED : 0;
+    header.stored_size = use_compressed ? compressed.size() : pixel_size;
+
+    std::vector<uint8_t> header_bytes;
+    append(header_bytes, &header, 1);
+    if (!write_file(cooked_texture_path(source), header_bytes, use_compressed ? compressed.data() : texture.pixels.get(), static_cast<size_t>(header.stored_size)))
+        return false;
+
+    Asset_Database::get().mark_cooked(hashed, TEXTURE_IMPORT_SETTINGS, header.input_hash);
+    return true;
+}
+
+bool MarkoEngine::cook_model(const std::string& source, const Imported_Model& model)
+{
+    add_texture_dependencies(source, model.meshes);
+    for (const auto& [name, texture] : model.embedded_textures)
+        cook_texture(name, texture);
+
+    Cooked_Data data;
+    add_meshes(data, model.meshes);
+    return write_cooked(source, false, data, model.bounds, glm::mat4(1.0f));
+}
+
+bool MarkoEngine::cook_animation(const std::string& source, const Imported_Animation& animation)
+{
+    if (!animation.asset)
+        return false;
+
+    const Renderer_Animation_Asset& asset = *animation.asset;
+    const Renderer_Skeleton& skeleton = asset.skeleton;
+    add_texture_dependencies(source, animation.meshes);
+    for (const auto& [name, texture] : animation.embedded_textures)
+        cook_texture(name, texture);
+
+    Cooked_Data data;
+    add_meshes(data, animation.meshes);
+
+    for (const Skeleton_Node& node : skeleton.nodes)
+        data.nodes.push_back({ data.strings.add_string(node.name.str()), node.parent, node.bone_index, 0, node.bind_pose });
+
+    data.bones.resize(skeleton.bone_offset_matrices.size());
+    for (size_t i = 0; i < data.bones.size(); ++i)
+        data.bones[i].offset = skeleton.bone_offset_matrices[i];
+    for (const auto& [name, id] : skeleton.bone_mapping)
+    {
+        if (id >= 0 && static_cast<size_t>(id) < data.bones.size())
+            data.bones[id].name = data.strings.add_string(name.str());
+    }
+
+    for (const Animation& clip : asset.animations)
+    {
+        data.clips.push_back({ data.strings.add_string(clip.name.str()), clip.duration, clip.ticksPerSecond,
+            static_cast<uint32_t>(data.channels.size()), static_cast<uint32_t>(clip.boneAnimations.size()), 0 });
+        for (const BoneAnimation& channel : clip.boneAnimations)
+        {
+            data.channels.push_back({ data.strings.add_string(channel.boneName.str()), channel.node_index, data.keyframes.size(), channel.keyframes.size() });
+            data.keyframes.insert(data.keyframes.end(), channel.keyframes.begin(), channel.keyframes.end());
+        }
+    }
+
+    return write_cooked(source, true, data, asset.bounds, skeleton.global_inverse_transform);
+}
+
+namespace
+{
+    std::string lowercase_extension(const std::string& filename)
+    {
+        std::string extension = std::filesystem::path(filename).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+        return extension;
+    }
+}
+
+bool MarkoEngine::is_cookable_mesh(const std::string& filename)
+{
+    const std::string extension = lowercase_extension(filename);
+    return extension == ".obj" || extension == ".fbx" || extension == ".3ds" || extension == ".dae" || extension == ".gltf" || extension == ".glb";
+}
+
+bool MarkoEngine::is_cookable_texture(const std::string& filename)
+{
+    const std::string extension = lowercase_extension(filename);
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "blob_store.hpp"
+#include "renderer.hpp"
+#include "scene_file.hpp"
+
+namespace MarkoEngine
+{
+    // "MKMESH01"
+    inline constexpr uint64_t COOKED_MESH_MAGIC = 0x31304853454D4B4Dull;
+    // Bumped whenever the importer output changes, so files cooked by an older build are cooked again.
+    inline constexpr uint32_t COOKED_MESH_VERSION = 4;
+    inline constexpr const char* COOKED_MESH_DIRECTORY = "cooked";
+
+    inline constexpr uint32_t COOKED_CHUNK_STRINGS = make_chunk_id("STRS");
+    inline constexpr uint32_t COOKED_CHUNK_SUBMESHES = make_chunk_id("SUBM");
+    inline constexpr uint32_t COOKED_CHUNK_VERTICES = make_chunk_id("VERT");
+    inline constexpr uint32_t COOKED_CHUNK_INDICES = make_chunk_id("INDX");
+    inline constexpr uint32_t COOKED_CHUNK_NODES = make_chunk_id("NODE");
+    inline constexpr uint32_t COOKED_CHUNK_BONES = make_chunk_id("BONE");
+    inline constexpr uint32_t COOKED_CHUNK_CLIPS = make_chunk_id("CLIP");
+    inline constexpr uint32_t COOKED_CHUNK_CHANNELS = make_chunk_id("CHAN");
+    inline constexpr uint32_t COOKED_CHUNK_KEYFRAMES = make_chunk_id("KEYS");
+
+    enum Cooked_Mesh_Flags : uint32_t
+    {
+        // Written by the animation importer: vertices carry bone weights and the skeleton chunks are present.
+        COOKED_MESH_SKINNED = 1u << 0
+    };
+
+    // The input hash from the asset database decides whether the cooked file is stale.
+    struct Cooked_Mesh_Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t chunk_count;
+        Blob_Hash input_hash;
+        Aabb bounds;
+        uint32_t flags;
+        uint32_t reserved;
+        glm::mat4 global_inverse_transform;
+    };
+
+    // Strings are indices into the string table.
+    struct Cooked_Submesh_Record
+    {
+        uint32_t texture;
+        uint32_t reserved;
+        uint64_t first_vertex;
+        uint64_t vertex_count;
+        uint64_t first_index;
+        uint64_t index_count;
+    };
+
+    struct Cooked_Node_Record
+    {
+        uint32_t name;
+        int32_t parent;
+        int32_t bone_index;
+        uint32_t reserved;
+        Joint_Pose bind_pose;
+    };
+
+    // In bone id order.
+    struct Cooked_Bone_Record
+    {
+        uint32_t name;
+        uint32_t reserved[3];
+        glm::mat4 offset;
+    };
+
+    struct Cooked_Clip_Record
+    {
+        uint32_t name;
+        float duration;
+        float ticks_per_second;
+        uint32_t first_channel;
+        uint32_t channel_count;
+        uint32_t reserved;
+    };
+
+    struct Cooked_Channel_Record
+    {
+        uint32_t name;
+        int32_t node_index;
+        uint64_t first_keyframe;
+        uint64_t keyframe_count;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Cooked_Mesh_Header> && sizeof(Cooked_Mesh_Header) == 128);
+    static_assert(std::is_trivially_copyable_v<Cooked_Submesh_Record> && sizeof(Cooked_Submesh_Record) == 40);
+    static_assert(std::is_trivially_copyable_v<Cooked_Node_Record> && sizeof(Cooked_Node_Record) == 56);
+    static_assert(std::is_trivially_copyable_v<Cooked_Bone_Record> && sizeof(Cooked_Bone_Record) == 80);
+    static_assert(std::is_trivially_copyable_v<Cooked_Clip_Record> && sizeof(Cooked_Clip_Record) == 24);
+    static_assert(std::is_trivially_copyable_v<Cooked_Channel_Record> && sizeof(Cooked_Channel_Record) == 24);
+    static_assert(std::is_trivially_copyable_v<Keyframe> && sizeof(Keyframe) == 44);
+
+    // "MKTEX001"; decoded RGBA8 pixels, LZ-compressed when that pays off.
+    inline constexpr uint64_t COOKED_TEXTURE_MAGIC = 0x3130305845544B4Dull;
+    inline constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+    inline constexpr uint32_t COOKED_TEXTURE_COMPRESSED = 1u << 0;
+
+    struct Cooked_Texture_Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t flags;
+        Blob_Hash input_hash;
+        uint32_t width;
+        uint32_t height;
+        uint64_t stored_size;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Cooked_Texture_Header> && sizeof(Cooked_Texture_Header) == 48);
+
+    // Cooked files mirror the source path under the cooked directory; skinned imports get their own file because
+    // the animation importer lays vertices out differently from the model importer.
+    std::string cooked_mesh_path(const std::string& source, bool skinned);
+    std::string cooked_texture_path(const std::string& source);
+
+    // Textures embedded in a model are named "<model>#<index>". They are cooked like texture files, under the
+    // model's input hash, so editing the model cooks them again.
+    std::string embedded_texture_name(const std::string& source, int index);
+    // The model an embedded texture name points into, or an empty string for a texture file.
+    std::string embedded_texture_source(const std::string& texture);
+
+    // These return false when the cooked file is missing, stale or corrupt; the caller imports the source instead.
+    bool load_cooked_model(const std::string& source, Imported_Model& model);
+    bool load_cooked_animation(const std::string& source, Imported_Animation& animation);
+    bool load_cooked_texture(const std::string& source, Decoded_Texture& texture);
+
+    // Cooking records the references the import found as dependencies of the source.
+    bool cook_model(const std::string& source, const Imported_Model& model);
+    bool cook_animation(const std::string& source, const Imported_Animation& animation);
+    bool cook_texture(const std::string& source, const Decoded_Texture& texture);
+
+    bool is_cookable_mesh(const std::string& filename);
+    bool is_cookable_texture(const std::string& filename);
+}
\ No newline at end of file
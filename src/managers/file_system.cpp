@@ -0,0 +1,272 @@
+#include "pch.h"
+#include "file_system.hpp"
+#include "compression.hpp"
+
+#include <cstring>
+
+namespace
+{
+    // Stored files this large start on a page so reading one touches no page of its neighbours; the rest only
+    // need their fields aligned.
+    constexpr uint64_t PAGE_ALIGNMENT = 4096;
+    constexpr uint64_t FIELD_ALIGNMENT = 16;
+    constexpr uint64_t PAGE_ALIGNED_SIZE = 64ull << 10;
+
+    MarkoEngine::Blob_Hash hash_path(const std::string& path)
+    {
+        const std::string key = MarkoEngine::File_System::normalize(path);
+        return MarkoEngine::hash_blob(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    }
+
+    bool hash_less(const MarkoEngine::Blob_Hash& a, const MarkoEngine::Blob_Hash& b)
+    {
+        return a.high != b.high ? a.high < b.high : a.low < b.low;
+    }
+
+    bool loose_stamp(const std::string& path, uint64_t& size, int64_t& time)
+    {
+        std::error_code error;
+        size = std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+
+        time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+        return !error;
+    }
+
+    void write_padding(std::ofstream& ofs, uint64_t& offset, uint64_t alignment)
+    {
+        static const char zeros[PAGE_ALIGNMENT] = {};
+        const uint64_t padding = (alignment - offset % alignment) % alignment;
+        ofs.write(zeros, static_cast<std::streamsize>(padding));
+        offset += padding;
+    }
+}
+
+bool MarkoEngine::write_archive(const std::string& filename, std::vector<Archive_File>& files)
+{
+    const std::string temporary = filename + ".tmp";
+    std::vector<Archive_Entry> entries;
+    uint64_t offset = 0;
+    {
+        std::ofstream ofs(temporary, std::ios::binary);
+        if (!ofs) {
+            std::cerr << "Failed to open file for saving: " << temporary << std::endl;
+            return false;
+        }
+        // Nothing half written is left next to the archive.
+        auto discard = [&]()
+            {
+                ofs.close();
+                std::error_code error;
+                std::filesystem::remove(temporary, error);
+                return false;
+            };
+
+        Archive_Header header{ ARCHIVE_MAGIC, ARCHIVE_VERSION, 0, 0, 0 };
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        offset = sizeof(header);
+
+        for (Archive_File& file : files)
+        {
+            // Mapped_File refuses empty files, which are packed as empty entries.
+            Mapped_File source;
+            std::error_code error;
+            if (!file.source.empty() && !source.open(file.source) && std::filesystem::file_size(file.source, error) != 0)
+            {
+                std::cerr << "Failed to read file for packing: " << file.source << std::endl;
+                return discard();
+            }
+
+            const uint8_t* data = file.source.empty() ? file.data.data() : source.data();
+            const size_t size = file.source.empty() ? file.data.size() : source.size();
+            std::vector<uint8_t> compressed = size > 0 ? compress_lz(data, size) : std::vector<uint8_t>();
+            // Images and audio that are compressed already stay as they are rather than pay for decompression.
+            const bool use_compressed = size > 0 && compressed.size() < size - size / 8;
+            const uint8_t* stored = use_compressed ? compressed.data() : data;
+            file.size = size;
+            file.stored_size = use_compressed ? compressed.size() : size;
+
+            write_padding(ofs, offset, !use_compressed && size >= PAGE_ALIGNED_SIZE ? PAGE_ALIGNMENT : FIELD_ALIGNMENT);
+            entries.push_back({ hash_path(file.path), offset, file.stored_size, size, use_compressed ? ARCHIVE_ENTRY_COMPRESSED : 0u, 0 });
+            ofs.write(reinterpret_cast<const char*>(stored), static_cast<std::streamsize>(file.stored_size));
+            offset += file.stored_size;
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Archive_Entry& a, const Archive_Entry& b) { return hash_less(a.path_hash, b.path_hash); });
+        for (size_t i = 1; i < entries.size(); ++i)
+        {
+            if (entries[i].path_hash == entries[i - 1].path_hash)
+            {
+                std::cerr << "Two packed paths hash the same, the archive is not written: " << filename << std::endl;
+                return discard();
+            }
+        }
+
+        write_padding(ofs, offset, FIELD_ALIGNMENT);
+        header.entry_count = static_cast<uint32_t>(entries.size());
+        header.toc_offset = offset;
+        ofs.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Archive_Entry)));
+        offset += entries.size() * sizeof(Archive_Entry);
+
+        ofs.seekp(0);
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!ofs)
+            return discard();
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    std::cout << "packed " << entries.size() << " files into " << filename << " (" << (offset >> 20) << " MB)" << std::endl;
+    return true;
+}
+
+MarkoEngine::File_System& MarkoEngine::File_System::get()
+{
+    static File_System instance;
+    return instance;
+}
+
+void MarkoEngine::File_System::initialize(const std::string& archive, bool loose_override)
+{
+    cleanup();
+    m_loose_override = loose_override;
+
+    if (!std::filesystem::exists(archive))
+        return;
+
+    Archive_Header header{};
+    if (!m_archive.open(archive) || m_archive.size() < sizeof(header))
+    {
+        std::cerr << "Failed to open archive: " << archive << std::endl;
+        m_archive.close();
+        return;
+    }
+
+    std::memcpy(&header, m_archive.data(), sizeof(header));
+    if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION || header.toc_offset > m_archive.size() ||
+        header.toc_offset % alignof(Archive_Entry) != 0 || header.entry_count > (m_archive.size() - header.toc_offset) / sizeof(Archive_Entry))
+    {
+        std::cerr << "Corrupt archive, assets are read from disk: " << archive << std::endl;
+        m_archive.close();
+        return;
+    }
+
+    m_entries = reinterpret_cast<const Archive_Entry*>(m_archive.data() + header.toc_offset);
+    m_entry_count = header.entry_count;
+
+    std::error_code error;
+    m_archive_time = static_cast<int64_t>(std::filesystem::last_write_time(archive, error).time_since_epoch().count());
+}
+
+void MarkoEngine::File_System::cleanup()
+{
+    m_entries = nullptr;
+    m_entry_count = 0;
+    m_archive_time = 0;
+    m_archive.close();
+}
+
+MarkoEngine::File_Data MarkoEngine::File_System::open(const std::string& path) const
+{
+    File_Data file;
+    if (m_loose_override && open_loose(path, file))
+        return file;
+
+    if (const Archive_Entry* entry = find(path))
+    {
+        if (!open_packed(*entry, file))
+            std::cerr << "Corrupt archive entry: " << path << std::endl;
+        return file;
+    }
+
+    if (!m_loose_override)
+        open_loose(path, file);
+    return file;
+}
+
+bool MarkoEngine::File_System::exists(const std::string& path) const
+{
+    std::error_code error;
+    return find(path) != nullptr || std::filesystem::is_regular_file(path, error);
+}
+
+bool MarkoEngine::File_System::stamp(const std::string& path, uint64_t& size, int64_t& time) const
+{
+    const Archive_Entry* entry = find(path);
+    if ((m_loose_override || !entry) && loose_stamp(path, size, time))
+        return true;
+    if (!entry)
+        return false;
+
+    size = entry->size;
+    time = m_archive_time;
+    return true;
+}
+
+std::string MarkoEngine::File_System::normalize(const std::string& path)
+{
+    std::string key = path;
+    std::replace(key.begin(), key.end(), '\\', '/');
+    key = std::filesystem::path(key).lexically_normal().generic_string();
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+    return key;
+}
+
+const MarkoEngine::Archive_Entry* MarkoEngine::File_System::find(const std::string& path) const
+{
+    if (m_entry_count == 0)
+        return nullptr;
+
+    const Blob_Hash hash = hash_path(path);
+    const Archive_Entry* end = m_entries + m_entry_count;
+    const Archive_Entry* entry = std::lower_bound(m_entries, end, hash, [](const Archive_Entry& entry, const Blob_Hash& hash) { return hash_less(entry.path_hash, hash); });
+    return entry != end && entry->path_hash == hash ? entry : nullptr;
+}
+
+bool MarkoEngine::File_System::open_loose(const std::string& path, File_Data& file) const
+{
+    if (file.m_file.open(path))
+    {
+        file.m_data = file.m_file.data();
+        file.m_size = file.m_file.size();
+        file.m_open = true;
+        return true;
+    }
+
+    std::error_code error;
+    file.m_open = std::filesystem::is_regular_file(path, error) && std::filesystem::file_size(path, error) == 0 && !error;
+    return file.m_open;
+}
+
+bool MarkoEngine::File_System::open_packed(const Archive_Entry& entry, File_Data& file) const
+{
+    if (entry.offset > m_archive.size() || entry.stored_size > m_archive.size() - entry.offset)
+        return false;
+
+    const uint8_t* stored = m_archive.data() + entry.offset;
+    if ((entry.flags & ARCHIVE_ENTRY_COMPRESSED) == 0)
+    {
+        if (entry.stored_size != entry.size)
+            return false;
+        file.m_data = stored;
+    }
+    else
+    {
+        file.m_buffer.resize(static_cast<size_t>(entry.size));
+        if (!decompress_lz(stored, static_cast<size_t>(entry.stored_size), file.m_buffer.data(), file.m_buffer.size()))
+            return false;
+        file.m_data = file.m_buffer.data();
+    }
+
+    file.m_size = static_cast<size_t>(entry.size);
+    file.m_open = true;
+    file.m_packed = true;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "blob_store.hpp"
+#include "mapped_file.hpp"
+
+namespace MarkoEngine
+{
+    // "MKPACK01"
+    inline constexpr uint64_t ARCHIVE_MAGIC = 0x31304B4341504B4Dull;
+    inline constexpr uint32_t ARCHIVE_VERSION = 1;
+    // Next to the executable; export_package writes it with what the saved scene reaches.
+    inline constexpr const char* ARCHIVE_FILENAME = "assets.pak";
+
+    enum Archive_Entry_Flags : uint32_t
+    {
+        ARCHIVE_ENTRY_COMPRESSED = 1u << 0
+    };
+
+    // The table of contents sits at toc_offset, after the file data.
+    struct Archive_Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t entry_count;
+        uint64_t toc_offset;
+        uint64_t reserved;
+    };
+
+    // Sorted by path hash, so a lookup is a binary search over the mapped table and no path is stored.
+    struct Archive_Entry
+    {
+        Blob_Hash path_hash;
+        uint64_t offset;
+        uint64_t stored_size;
+        uint64_t size;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    // One file to pack under the relative path the engine opens it by, read from source on disk or, when source is
+    // empty, taken from data.
+    struct Archive_File
+    {
+        std::string path;
+        std::string source;
+        std::vector<uint8_t> data;
+        // Filled in by write_archive.
+        uint64_t size = 0;
+        uint64_t stored_size = 0;
+    };
+
+    // Files are LZ-compressed where that pays off; large stored ones start on a page boundary.
+    bool write_archive(const std::string& filename, std::vector<Archive_File>& files);
+
+    // The contents of one file: a view into the archive mapping, a loose file mapped on its own, or the decompressed
+    // copy of a packed one. Views into the archive stay valid until the file system is cleaned up.
+    class File_Data
+    {
+    public:
+        bool is_open() const { return m_open; }
+        bool packed() const { return m_packed; }
+        const uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        friend class File_System;
+
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        bool m_open = false;
+        bool m_packed = false;
+        Mapped_File m_file;
+        std::vector<uint8_t> m_buffer;
+    };
+
+    // Every asset the engine reads goes through here: shaders, textures, models, scenes and scripts. With loose
+    // override on, a file on disk wins over the packed one, so an edited asset shows up without repacking;
+    // otherwise the archive is looked at first and the disk only for what it does not hold. Thread safe after
+    // initialize().
+    class File_System
+    {
+    public:
+        File_System(const File_System&) = delete;
+        File_System(File_System&&) = delete;
+        File_System& operator=(const File_System&) = delete;
+        File_System& operator=(File_System&&) = delete;
+
+    private:
+        File_System() = default;
+
+    public:
+        static File_System& get();
+
+        // Without the archive everything is read from disk, as before.
+        void initialize(const std::string& archive, bool loose_override);
+        void cleanup();
+
+        bool mounted() const { return m_archive.is_open(); }
+
+        File_Data open(const std::string& path) const;
+        bool exists(const std::string& path) const;
+        // Size and write time; packed files carry the archive's write time.
+        bool stamp(const std::string& path, uint64_t& size, int64_t& time) const;
+
+        // Lowercase, '/'-separated and lexically normal, so the editor's paths and the packed ones hash the same.
+        static std::string normalize(const std::string& path);
+
+    private:
+        const Archive_Entry* find(const std::string& path) const;
+        bool open_loose(const std::string& path, File_Data& file) const;
+        bool open_packed(const Archive_Entry& entry, File_Data& file) const;
+
+    private:
+        Mapped_File m_archive;
+        const Archive_Entry* m_entries = nullptr;
+        uint32_t m_entry_count = 0;
+        int64_t m_archive_time = 0;
+        bool m_loose_override = true;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "pch.h"
+#include "file_watcher.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // How often the watcher thread wakes up to check whether it should stop.
+    constexpr int WAKE_INTERVAL_MS = 100;
+    constexpr size_t EVENT_BUFFER_SIZE = 64 * 1024;
+}
+
+MarkoEngine::File_Watcher::~File_Watcher()
+{
+    stop();
+}
+
+bool MarkoEngine::File_Watcher::start(const std::vector<std::string>& directories, std::chrono::milliseconds debounce)
+{
+    stop();
+
+    m_debounce = debounce;
+    m_stopping = false;
+
+#ifdef _WIN32
+    for (const std::string& directory : directories)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(directory, error))
+            continue;
+
+        HANDLE handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+            OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            continue;
+
+        m_directories.push_back(handle);
+        m_roots.push_back(directory);
+    }
+
+    if (m_directories.empty())
+        return false;
+#else
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0)
+        return false;
+
+    for (const std::string& directory : directories)
+    {
+        std::error_code error;
+        if (std::filesystem::is_directory(directory, error))
+            add_watches(directory);
+    }
+
+    if (m_watches.empty())
+    {
+        ::close(m_inotify);
+        m_inotify = -1;
+        return false;
+    }
+#endif
+
+    m_thread = std::thread(&File_Watcher::run, this);
+    return true;
+}
+
+void MarkoEngine::File_Watcher::stop()
+{
+    if (m_thread.joinable())
+    {
+        m_stopping = true;
+        m_thread.join();
+    }
+
+#ifdef _WIN32
+    for (void* handle : m_directories)
+        CloseHandle(handle);
+    m_directories.clear();
+    m_roots.clear();
+#else
+    if (m_inotify >= 0)
+        ::close(m_inotify);
+    m_inotify = -1;
+    m_watches.clear();
+#endif
+
+    std::lock_guard lock(m_mutex);
+    m_changes.clear();
+}
+
+std::vector<std::string> MarkoEngine::File_Watcher::poll()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    std::vector<std::string> changed;
+    std::lock_guard lock(m_mutex);
+    for (auto change = m_changes.begin(); change != m_changes.end();)
+    {
+        if (now - change->second >= m_debounce)
+        {
+            changed.push_back(change->first);
+            change = m_changes.erase(change);
+        }
+        else
+        {
+            ++change;
+        }
+    }
+    return changed;
+}
+
+void MarkoEngine::File_Watcher::record(const std::string& path)
+{
+    const std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard lock(m_mutex);
+    m_changes[normalized] = now;
+}
+
+#ifdef _WIN32
+void MarkoEngine::File_Watcher::run()
+{
+    struct Watch
+    {
+        OVERLAPPED overlapped{};
+        std::vector<DWORD> buffer = std::vector<DWORD>(EVENT_BUFFER_SIZE / sizeof(DWORD));
+    };
+
+    std::vector<Watch> watches(m_directories.size());
+    std::vector<HANDLE> events;
+    auto issue = [&](size_t i)
+        {
+            ReadDirectoryChangesW(m_directories[i], watches[i].buffer.data(), static_cast<DWORD>(watches[i].buffer.size() * sizeof(DWORD)), TRUE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr, &watches[i].overlapped, nullptr);
+        };
+
+    for (size_t i = 0; i < watches.size(); ++i)
+    {
+        watches[i].overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        events.push_back(watches[i].overlapped.hEvent);
+        issue(i);
+    }
+
+    while (!m_stopping)
+    {
+        const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, WAKE_INTERVAL_MS);
+        if (result < WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + events.size())
+            continue;
+
+        const size_t i = result - WAIT_OBJECT_0;
+        DWORD bytes = 0;
+        // No bytes means the buffer overflowed and this batch of changes was lost; later ones still come through.
+        if (GetOverlappedResult(m_directories[i], &watches[i].overlapped, &bytes, FALSE) && bytes > 0)
+        {
+            const uint8_t* buffer = reinterpret_cast<const uint8_t*>(watches[i].buffer.data());
+            for (size_t offset = 0;;)
+            {
+                const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+                if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+                {
+                    const std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                    record((std::filesystem::path(m_roots[i]) / name).string());
+                }
+                if (info->NextEntryOffset == 0)
+                    break;
+                offset += info->NextEntryOffset;
+            }
+        }
+
+        ResetEvent(events[i]);
+        issue(i);
+    }
+
+    for (size_t i = 0; i < watches.size(); ++i)
+    {
+        DWORD bytes = 0;
+        CancelIoEx(m_directories[i], &watches[i].overlapped);
+        GetOverlappedResult(m_directories[i], &watches[i].overlapped, &bytes, TRUE);
+        CloseHandle(events[i]);
+    }
+}
+#else
+void MarkoEngine::File_Watcher::add_watches(const std::string& directory)
+{
+    constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+    const int root = inotify_add_watch(m_inotify, directory.c_str(), WATCH_MASK);
+    if (root >= 0)
+        m_watches[root] = directory;
+
+    // inotify is not recursive, so every directory below gets its own watch.
+    std::error_code error;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+    {
+        if (!entry.is_directory())
+            continue;
+
+        const std::string path = entry.path().string();
+        const int watch = inotify_add_watch(m_inotify, path.c_str(), WATCH_MASK);
+        if (watch >= 0)
+            m_watches[watch] = path;
+    }
+}
+
+void MarkoEngine::File_Watcher::run()
+{
+    std::vector<uint8_t> buffer(EVENT_BUFFER_SIZE);
+    while (!m_stopping)
+    {
+        pollfd descriptor{ m_inotify, POLLIN, 0 };
+        if (::poll(&descriptor, 1, WAKE_INTERVAL_MS) <= 0)
+            continue;
+
+        const ssize_t length = ::read(m_inotify, buffer.data(), buffer.size());
+        for (ssize_t offset = 0; offset < length;)
+        {
+            inotify_event event;
+            std::memcpy(&event, buffer.data() + offset, sizeof(event));
+            const char* name = reinterpret_cast<const char*>(buffer.data() + offset + sizeof(event));
+            offset += sizeof(event) + event.len;
+
+            if (event.mask & IN_IGNORED)
+            {
+                m_watches.erase(event.wd);
+                continue;
+            }
+
+            auto watch = m_watches.find(event.wd);
+            if (watch == m_watches.end() || event.len == 0)
+                continue;
+
+            const std::string path = watch->second + "/" + name;
+            if (event.mask & IN_ISDIR)
+            {
+                // A directory created or moved in may already hold files by the time its watch is added.
+                add_watches(path);
+                std::error_code error;
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(path, error))
+                {
+                    if (entry.is_regular_file())
+                        record(entry.path().string());
+                }
+                continue;
+            }
+
+            record(path);
+        }
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace MarkoEngine
+{
+    // Watches directory trees on a thread of its own (ReadDirectoryChangesW on Windows, inotify on Linux) and reports
+    // each changed file once it has been quiet for the debounce interval, so an editor saving a file in several
+    // writes, or a tool rewriting a whole folder, comes through as one change per file.
+    class File_Watcher
+    {
+    public:
+        File_Watcher() = default;
+        ~File_Watcher();
+
+        File_Watcher(const File_Watcher&) = delete;
+        File_Watcher& operator=(const File_Watcher&) = delete;
+
+        // Directories that do not exist are skipped; returns false when none could be watched.
+        bool start(const std::vector<std::string>& directories, std::chrono::milliseconds debounce = std::chrono::milliseconds(200));
+        void stop();
+
+        bool watching() const { return m_thread.joinable(); }
+
+        // Files whose last change is older than the debounce interval, each once, with generic separators.
+        std::vector<std::string> poll();
+
+    private:
+        void run();
+        void record(const std::string& path);
+#ifndef _WIN32
+        void add_watches(const std::string& directory);
+#endif
+
+    private:
+        std::thread m_thread;
+        std::atomic<bool> m_stopping = false;
+        std::chrono::milliseconds m_debounce{ 200 };
+        std::mutex m_mutex;
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_changes;
+#ifdef _WIN32
+        std::vector<void*> m_directories;
+        std::vector<std::string> m_roots;
+#else
+        int m_inotify = -1;
+        std::unordered_map<int, std::string> m_watches;
+#endif
+    };
+}
\ No newline at end of file
@@ -3,6 +3,12 @@
 #include "gui.hpp"
 #include "window.hpp"
 #include "renderer.hpp"
+#include "transforms.hpp"
+#include "picking.hpp"
+#include "journal.hpp"
+#include "texture_streaming.hpp"
+#include "file_system.hpp"
+#include "package.hpp"
 
 #include "../game_objects/i_game_object.hpp"
 #include "../game_objects/camera_game_object.hpp"
@@ -11,7 +17,9 @@
 #include "../game_objects/mesh_game_object.hpp"
 
 #include <shlobj.h> 
+#include <iomanip>
 #include "../game_objects/animated_game_object.hpp"
+#include "../game_objects/crowd_game_object.hpp"
 #include "../managers/backup.hpp"
 
 MarkoEngine::Gui& MarkoEngine::Gui::get()
@@ -101,8 +109,7 @@ void MarkoEngine::Gui::initialize()
     is_playing = false;
 #ifdef EXPORT
     is_playing = true;
-#endif
-
+#else
     folder_tex = Renderer::get().create_gui_texture("dependencies/gui_icons/folder.png");
 
     file_tex = Renderer::get().create_gui_texture("dependencies/gui_icons/file.png");
@@ -117,6 +124,7 @@ void MarkoEngine::Gui::initialize()
     cuboid_tex = Renderer::get().create_gui_texture("dependencies/gui_icons/codepen.png");
     visible_tex = Renderer::get().create_gui_texture("dependencies/gui_icons/eye.png");
     hidden_tex = Renderer::get().create_gui_texture("dependencies/gui_icons/eye-off.png");
+#endif
 
     I_GAME_OBJECT::game_objects["Root"] = std::make_unique<I_GAME_OBJECT>();
 }
@@ -139,9 +147,78 @@ void MarkoEngine::Gui::update()
         draw_hierarchy();
         draw_content();
         draw_top_bar();
+        update_viewport_selection();
 
 }
 
+void MarkoEngine::Gui::update_viewport_selection()
+{
+    MarkoEngine::Window& window = MarkoEngine::Window::get();
+    const glm::dvec2 viewport_min(window.scale_x(21), window.scale_y(5));
+    const glm::dvec2 viewport_max(window.scale_x(79), window.scale_y(60));
+    const glm::dvec2 cursor = glm::clamp(window.mouse_position(), viewport_min, viewport_max);
+
+    if (window.mouse_pressed(GLFW_MOUSE_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse && cursor == window.mouse_position())
+    {
+        is_selecting = true;
+        selection_start = cursor;
+    }
+
+    if (!is_selecting)
+        return;
+
+    const bool is_rectangle = glm::length(cursor - selection_start) > 4.0;
+    if (window.mouse_held(GLFW_MOUSE_BUTTON_LEFT))
+    {
+        if (is_rectangle)
+        {
+            ImDrawList* draw_list = ImGui::GetForegroundDrawList();
+            ImVec2 a(static_cast<float>(selection_start.x), static_cast<float>(selection_start.y));
+            ImVec2 b(static_cast<float>(cursor.x), static_cast<float>(cursor.y));
+            draw_list->AddRectFilled(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)), ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), IM_COL32(90, 120, 200, 40));
+            draw_list->AddRect(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)), ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), IM_COL32(90, 120, 200, 255));
+        }
+        return;
+    }
+
+    is_selecting = false;
+
+    if (!window.key_held(GLFW_KEY_LEFT_SHIFT))
+    {
+        selected_game_objects.clear();
+        selected_game_object = "";
+    }
+
+    if (!is_rectangle)
+    {
+        MarkoEngine::Entity entity = MarkoEngine::Picking::get().pick(cursor);
+        if (entity == MarkoEngine::null_entity)
+            return;
+
+        selected_game_object = I_GAME_OBJECT::find_id(entity);
+        selected_game_objects.insert(selected_game_object);
+        return;
+    }
+
+    std::vector<MarkoEngine::Entity> entities = MarkoEngine::Picking::get().pick_rectangle(selection_start, cursor);
+    if (entities.empty())
+        return;
+
+    std::unordered_set<uint32_t> picked;
+    for (MarkoEngine::Entity entity : entities)
+        picked.insert(entity.index);
+
+    for (const auto& [id, object] : I_GAME_OBJECT::game_objects)
+    {
+        if (!picked.contains(object->get_entity().index))
+            continue;
+
+        selected_game_objects.insert(id);
+        if (selected_game_object.empty())
+            selected_game_object = id;
+    }
+}
+
 void MarkoEngine::Gui::draw_inspector()
 {
     if (MarkoEngine::Window::get().key_pressed(GLFW_KEY_DELETE))
@@ -155,6 +232,7 @@ void MarkoEngine::Gui::draw_inspector()
             else
             {
                 I_GAME_OBJECT::game_objects.erase(Gui::get().selected_game_object);
+                Gui::get().selected_game_objects.erase(Gui::get().selected_game_object);
                 Gui::get().selected_game_object = "";
             }
         }
@@ -230,6 +308,8 @@ void MarkoEngine::Gui::draw_inspector()
                             I_GAME_OBJECT::game_objects[new_key] = std::move(it->second);
                             I_GAME_OBJECT::game_objects.erase(it);
 
+                            selected_game_objects.erase(selected_game_object);
+                            selected_game_objects.insert(new_key);
                             selected_game_object = new_key;
                         }
                     }
@@ -338,11 +418,11 @@ void MarkoEngine::Gui::draw_inspector()
                 float checkbox_x = window_center_x - (checkboxSize * 0.5f);
                 ImGui::SetCursorPosX(checkbox_x - position.x);
 
-                bool visibility = I_GAME_OBJECT::game_objects[selected_game_object]->is_visible;
+                bool visibility = I_GAME_OBJECT::game_objects[selected_game_object]->is_visible();
                 if (ImGui::Checkbox("##visibility", &visibility))
                 {
    
-                    I_GAME_OBJECT::game_objects[selected_game_object]->is_visible = visibility;
+                    I_GAME_OBJECT::game_objects[selected_game_object]->set_visible(visibility);
                 }
             }
 
@@ -510,6 +590,52 @@ void MarkoEngine::Gui::draw_inspector()
                 ImGui::Separator();
                 ImGui::PopStyleColor();
             }
+
+            if (I_GAME_OBJECT::game_objects[selected_game_object]->get_type() == game_object_type::CROWD)
+            {
+                CenterText("crowd");
+                {
+                    CROWD_GAME_OBJECT* crowd = dynamic_cast<CROWD_GAME_OBJECT*>(I_GAME_OBJECT::game_objects[selected_game_object].get());
+                    strncpy_s(buffer, crowd->model.c_str(), sizeof(buffer) - 1);
+                    buffer[sizeof(buffer) - 1] = '\0';
+
+                    float input_width = button_size.x - 100;
+                    float window_center_x = position.x + (size.x * 0.5f);
+                    float group_x = window_center_x - (input_width * 0.5f);
+                    ImGui::SetCursorPosX(group_x - position.x);
+
+                    ImGui::BeginGroup();
+                    ImGui::SetNextItemWidth(input_width);
+
+                    // Baking reads the whole model, so it waits until the path is committed instead of running per keystroke.
+                    if (ImGui::InputText("##crowd", buffer, IM_ARRAYSIZE(buffer)))
+                    {
+                        crowd->model = buffer;
+                    }
+                    if (ImGui::IsItemDeactivatedAfterEdit())
+                    {
+                        crowd->reload();
+                    }
+
+                    int instance_count = static_cast<int>(crowd->instance_count);
+                    ImGui::SetNextItemWidth(input_width);
+                    if (ImGui::InputInt("##instances", &instance_count) && instance_count >= 0)
+                    {
+                        crowd->instance_count = static_cast<size_t>(instance_count);
+                        crowd->rebuild_instances();
+                    }
+
+                    ImGui::SetNextItemWidth(input_width);
+                    if (ImGui::DragFloat("##spacing", &crowd->spacing, 0.1f, 0.1f, 100.0f))
+                    {
+                        crowd->rebuild_instances();
+                    }
+                    ImGui::EndGroup();
+                }
+                ImGui::PushStyleColor(ImGuiCol_Separator, ImVec4(1, 1, 1, 1));
+                ImGui::Separator();
+                ImGui::PopStyleColor();
+            }
         }
         else
         {
@@ -576,6 +702,11 @@ void MarkoEngine::Gui::draw_inspector()
                 I_GAME_OBJECT::game_objects["new_animation"] = std::make_unique<ANIMATED_GAME_OBJECT>("");
             }
 
+            if (ImGui::Button("create crowd", button_size))
+            {
+                I_GAME_OBJECT::game_objects["new_crowd"] = std::make_unique<CROWD_GAME_OBJECT>("");
+            }
+
         }
         ImGui::End();
     }
@@ -602,8 +733,8 @@ void MarkoEngine::Gui::draw_hierarchy()
         }
 
 
-        std::function<void(const std::string&, const std::unique_ptr<I_GAME_OBJECT>&, int)> drawObject;
-        drawObject = [&](const std::string& id, const std::unique_ptr<I_GAME_OBJECT>& object, int indent_level)
+        std::function<void(const MarkoEngine::Name&, const std::unique_ptr<I_GAME_OBJECT>&, int)> drawObject;
+        drawObject = [&](const MarkoEngine::Name& id, const std::unique_ptr<I_GAME_OBJECT>& object, int indent_level)
             {
 
                 if (id == dragged_object_id)
@@ -612,23 +743,27 @@ void MarkoEngine::Gui::draw_hierarchy()
                 ImGui::Indent(indent_level * 20);
 
 
-                std::string label = id;
+                std::string label = id.str();
                 if (!object->get_script().empty())
                 {
-                    label += " -> [" + object->get_script() + "]";
+                    label += " -> [" + object->get_script().str() + "]";
                 }
 
 
-                bool is_selected = (selected_game_object == id);
+                bool is_selected = (selected_game_object == id) || selected_game_objects.contains(id);
                 if (ImGui::Selectable(label.c_str(), is_selected))
                 {
-                    selected_game_object = (is_selected ? "" : id);
+                    selected_game_object = (selected_game_object == id ? MarkoEngine::Name() : id);
+                    selected_game_objects.clear();
+                    if (!selected_game_object.empty())
+                        selected_game_objects.insert(selected_game_object);
                 }
 
 
                 if (id != "Root" && ImGui::BeginDragDropSource(ImGuiDragDropFlags_SourceNoPreviewTooltip))
                 {
-                    ImGui::SetDragDropPayload("GAME_OBJECT", id.c_str(), id.size() + 1);
+                    const uint64_t hash = id.hash();
+                    ImGui::SetDragDropPayload("GAME_OBJECT", &hash, sizeof(hash));
                     ImGui::Text("Dragging: %s", id.c_str());
                     ImGui::EndDragDropSource();
                 }
@@ -638,7 +773,7 @@ void MarkoEngine::Gui::draw_hierarchy()
                 {
                     if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("GAME_OBJECT"))
                     {
-                        std::string dragged_id(static_cast<const char*>(payload->Data));
+                        MarkoEngine::Name dragged_id = MarkoEngine::Name::from_hash(*static_cast<const uint64_t*>(payload->Data));
                         if (I_GAME_OBJECT::game_objects.find(dragged_id) == I_GAME_OBJECT::game_objects.end())
                         {
                             ImGui::EndDragDropTarget();
@@ -647,7 +782,7 @@ void MarkoEngine::Gui::draw_hierarchy()
                         }
 
                         bool is_valid_target = true;
-                        std::string current_id = id;
+                        MarkoEngine::Name current_id = id;
                         while (!current_id.empty() && current_id != "Root")
                         {
                             if (current_id == dragged_id)
@@ -661,7 +796,7 @@ void MarkoEngine::Gui::draw_hierarchy()
                         if (is_valid_target)
                         {
                             auto& dragged_obj = I_GAME_OBJECT::game_objects[dragged_id];
-                            std::string old_parent_id = dragged_obj->get_parent();
+                            MarkoEngine::Name old_parent_id = dragged_obj->get_parent();
                             if (!old_parent_id.empty() &&
                                 I_GAME_OBJECT::game_objects.find(old_parent_id) != I_GAME_OBJECT::game_objects.end())
                             {
@@ -814,22 +949,6 @@ void MarkoEngine::Gui::draw_content()
     ImGui::End();
 }
 
-void copy_directory_recursively(const std::wstring& source, const std::wstring& destination) {
-    std::filesystem::create_directory(destination);
-
-    for (const auto& entry : std::filesystem::directory_iterator(source)) {
-        const auto& path = entry.path();
-        if (entry.is_directory()) {
-
-            copy_directory_recursively(path.wstring(), destination + L"\\" + path.filename().wstring());
-        }
-        else if (entry.is_regular_file()) {
-
-            std::filesystem::copy(path, destination + L"\\" + path.filename().wstring(), std::filesystem::copy_options::overwrite_existing);
-        }
-    }
-}
-
 void MarkoEngine::Gui::draw_top_bar()
 {
     ImVec2 position(MarkoEngine::Window::get().scale_x(0), MarkoEngine::Window::get().scale_y(0));
@@ -865,6 +984,13 @@ void MarkoEngine::Gui::draw_top_bar()
         else
         {
             marko_engine::Backup::get().load_temp_object_state();
+
+            // Objects spawned during play are gone again.
+            std::erase_if(selected_game_objects, [](const MarkoEngine::Name& id) { return !I_GAME_OBJECT::game_objects.contains(id); });
+            if (!I_GAME_OBJECT::game_objects.contains(selected_game_object))
+            {
+                selected_game_object = "";
+            }
         }
     }
 
@@ -939,26 +1065,97 @@ void MarkoEngine::Gui::draw_top_bar()
                 }
 
 
-                std::wstring source_shaders = L"shaders";
-                std::wstring destination_shaders = build_path + L"\\shaders";
-                copy_directory_recursively(source_shaders, destination_shaders);
+                // The saved scene and what it reaches go into one archive; the game writes its own saves next to it.
+                MarkoEngine::export_package(str + "\\" + MarkoEngine::ARCHIVE_FILENAME);
+            }
+        }
+    }
+
+
+    ImGui::SetCursorPos(ImVec2(button_size.x * 3, button_size.y / 4));
+
+    bool compute_skinning = Renderer::get().skinning_mode == Skinning_Mode::COMPUTE;
+    if (ImGui::Checkbox("compute skinning", &compute_skinning))
+    {
+        Renderer::get().skinning_mode = compute_skinning ? Skinning_Mode::COMPUTE : Skinning_Mode::VERTEX_SHADER;
+    }
+
+    ImGui::SameLine();
+    int benchmark_passes = static_cast<int>(Renderer::get().benchmark_passes);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::InputInt("extra passes", &benchmark_passes) && benchmark_passes >= 0)
+    {
+        Renderer::get().benchmark_passes = static_cast<uint32_t>(benchmark_passes);
+    }
+
+    ImGui::SameLine();
+    ImGui::Text("gpu %.3f ms", Renderer::get().gpu_frame_time);
+
+    ImGui::SameLine();
+    ImGui::Text("animation allocations %zu", Renderer::get().animation_allocations);
+
+    ImGui::SameLine();
+    ImGui::Text("poll to present %.2f ms", MarkoEngine::Window::get().poll_to_present_latency());
+
+    ImGui::SameLine();
+    ImGui::Text("transforms updated %zu", MarkoEngine::Transforms::get().updated_count());
 
+    ImGui::SameLine();
+    ImGui::Checkbox("frustum culling", &Renderer::get().frustum_culling);
 
-                std::wstring source_saves = L"backups";
-                std::wstring destination_saves = build_path + L"\\backups";
-                copy_directory_recursively(source_saves, destination_saves);
+    ImGui::SameLine();
+    ImGui::Text("drawn %zu", Renderer::get().drawn_objects);
 
+    ImGui::SameLine();
+    ImGui::Text("textures %zu MB", MarkoEngine::Texture_Streaming::get().resident_bytes() >> 20);
 
-                std::wstring source_dependencies = L"dependencies";
-                std::wstring destination_dependencies = build_path + L"\\dependencies";
-                copy_directory_recursively(source_dependencies, destination_dependencies);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    int texture_budget = static_cast<int>(MarkoEngine::Texture_Streaming::get().budget() >> 20);
+    if (ImGui::DragInt("budget MB", &texture_budget, 1.0f, 16, 8192))
+        MarkoEngine::Texture_Streaming::get().set_budget(static_cast<size_t>(texture_budget) << 20);
 
+    ImGui::SameLine();
+    ImGui::Text("pick %.3f ms", MarkoEngine::Picking::get().last_pick_time());
 
-                std::wstring source_content = L"content";
-                std::wstring destination_content = build_path + L"\\content";
-                copy_directory_recursively(source_content, destination_content);
+    ImGui::SameLine();
+    ImGui::Text("play toggle %.2f ms", marko_engine::Backup::get().last_play_toggle());
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(150);
+    if (ImGui::BeginCombo("history", "restore save"))
+    {
+        const std::vector<MarkoEngine::Journal_Entry> entries = MarkoEngine::Journal::get().entries();
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+        {
+            std::time_t time = static_cast<std::time_t>(it->timestamp);
+            std::tm buf;
+            localtime_s(&buf, &time);
+
+            std::ostringstream label;
+            label << "#" << it->sequence << "  " << std::put_time(&buf, "%Y-%m-%d %H:%M:%S") << "  "
+                << (it->kind == MarkoEngine::Journal_Entry_Kind::CHECKPOINT ? "checkpoint, " : "changed ") << it->object_count
+                << (it->kind == MarkoEngine::Journal_Entry_Kind::CHECKPOINT ? " objects" : "");
+
+            if (ImGui::Selectable(label.str().c_str()) && !is_playing)
+            {
+                selected_game_object = "";
+                selected_game_objects.clear();
+                marko_engine::Backup::get().restore_object_state(it->sequence);
             }
         }
+        ImGui::EndCombo();
+    }
+
+    ImGui::SameLine();
+    if (marko_engine::Backup::get().saving())
+    {
+        ImGui::Text("saving...");
+    }
+    else
+    {
+        ImGui::Text("last save %zu B, stall %.2f ms, write %.2f ms", MarkoEngine::Journal::get().last_write_size(),
+            marko_engine::Backup::get().last_save_stall(), marko_engine::Backup::get().last_save_duration());
     }
 
     ImGui::End();
@@ -1,5 +1,10 @@
 #pragma once
 #include <string>
+#include <unordered_set>
+
+#include <glm/glm.hpp>
+
+#include "names.hpp"
 
 namespace MarkoEngine
 {
@@ -29,6 +34,7 @@ namespace MarkoEngine
 		void draw_hierarchy();
 		void draw_content();
 		void draw_top_bar();
+		void update_viewport_selection();
 
 	private: 
 		unsigned long long folder_tex = -1, file_tex = -1, alert_tex = -1,
@@ -39,9 +45,12 @@ namespace MarkoEngine
 		bool is_playing;
 		bool prev_is_playing;
 		std::string object_to_rename;
-		std::string selected_game_object;
+		MarkoEngine::Name selected_game_object;
+		std::unordered_set<MarkoEngine::Name> selected_game_objects;
+		bool is_selecting = false;
+		glm::dvec2 selection_start{ 0.0 };
 		std::string curr_folder;
-		std::string dragged_object_id;
+		MarkoEngine::Name dragged_object_id;
 		std::string file_to_rename;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "hot_reload.hpp"
+#include "asset_database.hpp"
+#include "asset_loader.hpp"
+#include "cooked_mesh.hpp"
+#include "renderer.hpp"
+
+MarkoEngine::Hot_Reload::Hot_Reload() = default;
+
+MarkoEngine::Hot_Reload::~Hot_Reload()
+{
+    cleanup();
+}
+
+MarkoEngine::Hot_Reload& MarkoEngine::Hot_Reload::get()
+{
+    static Hot_Reload instance;
+    return instance;
+}
+
+void MarkoEngine::Hot_Reload::initialize(const std::vector<std::string>& directories)
+{
+    cleanup();
+
+    if (!m_watcher.start(directories))
+        std::cerr << "hot reload is disabled, none of the asset directories could be watched" << std::endl;
+}
+
+void MarkoEngine::Hot_Reload::cleanup()
+{
+    m_watcher.stop();
+}
+
+void MarkoEngine::Hot_Reload::update()
+{
+    const std::vector<std::string> changed = m_watcher.poll();
+    if (!changed.empty())
+        queue_reloads(changed);
+}
+
+void MarkoEngine::Hot_Reload::queue_reloads(const std::vector<std::string>& changed)
+{
+    bool shaders = false;
+    std::unordered_set<std::string> textures;
+    std::unordered_set<std::string> sources;
+    for (const std::string& path : changed)
+    {
+        if (path.ends_with(".spv"))
+        {
+            shaders = true;
+        }
+        else if (is_cookable_texture(path))
+        {
+            // Meshes refer to texture slots, so swapping the texture is enough for every model that uses it.
+            textures.insert(path);
+        }
+        else
+        {
+            // A changed .mtl reaches the models that use it through the dependency graph.
+            sources.insert(path);
+            for (const std::string& dependent : Asset_Database::get().dependents(path))
+                sources.insert(dependent);
+        }
+    }
+
+    if (shaders && Renderer::get().reload_shaders())
+        std::cout << "hot reload: shaders rebuilt" << std::endl;
+
+    // Assets that were never loaded have nothing to replace; the loader picks up the edit when they are requested.
+    for (const std::string& filename : Renderer::get().loaded_models())
+    {
+        if (sources.contains(Asset_Database::normalize(filename)))
+            Asset_Loader::get().request(Asset_Kind::model, filename, true);
+    }
+    for (const std::string& filename : Renderer::get().loaded_animations())
+    {
+        if (sources.contains(Asset_Database::normalize(filename)))
+            Asset_Loader::get().request(Asset_Kind::animation, filename, true);
+    }
+    for (const std::string& filename : Renderer::get().loaded_textures())
+    {
+        if (textures.contains(Asset_Database::normalize(filename)))
+            Asset_Loader::get().request(Asset_Kind::texture, filename, true);
+    }
+}
\ No newline at end of file
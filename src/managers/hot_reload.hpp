@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "file_watcher.hpp"
+
+namespace MarkoEngine
+{
+    // Watches the asset and shader directories while the editor runs. Loaded models, animations and textures that
+    // change on disk are re-imported by the Asset_Loader and swapped in between frames, for every object using
+    // them at once and without reloading the scene. Shaders are rebuilt on the spot; scripts need nothing, since
+    // every call reads them again.
+    class Hot_Reload
+    {
+    public:
+        Hot_Reload(const Hot_Reload&) = delete;
+        Hot_Reload(Hot_Reload&&) = delete;
+        Hot_Reload& operator=(const Hot_Reload&) = delete;
+        Hot_Reload& operator=(Hot_Reload&&) = delete;
+
+    private:
+        Hot_Reload();
+        ~Hot_Reload();
+
+    public:
+        static Hot_Reload& get();
+
+        void initialize(const std::vector<std::string>& directories = { "content", "dependencies", "shaders/bin" });
+        void cleanup();
+
+        // Called once per frame before anything is drawn.
+        void update();
+
+    private:
+        void queue_reloads(const std::vector<std::string>& changed);
+
+    private:
+        File_Watcher m_watcher;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "jobs.hpp"
+
+namespace
+{
+    thread_local bool inside_job = false;
+}
+
+MarkoEngine::Jobs::~Jobs()
+{
+    cleanup();
+}
+
+MarkoEngine::Jobs& MarkoEngine::Jobs::get()
+{
+    static Jobs instance;
+    return instance;
+}
+
+void MarkoEngine::Jobs::initialize(size_t worker_count)
+{
+    cleanup();
+
+    if (worker_count == 0)
+    {
+        const size_t hardware = std::thread::hardware_concurrency();
+        worker_count = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    m_stopping = false;
+    m_workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i)
+        m_workers.emplace_back(&Jobs::run_worker, this);
+}
+
+void MarkoEngine::Jobs::cleanup()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+}
+
+void MarkoEngine::Jobs::parallel_for(size_t count, const std::function<void(size_t)>& job)
+{
+    if (count == 0)
+        return;
+
+    if (m_workers.empty() || count == 1 || inside_job)
+    {
+        for (size_t i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    std::lock_guard submit(m_submit_mutex);
+    {
+        std::lock_guard lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_next = 0;
+        m_error = nullptr;
+        ++m_generation;
+    }
+    m_condition.notify_all();
+
+    run_batch();
+
+    std::exception_ptr error;
+    {
+        // Workers that picked the batch up still hold the job; it has to outlive them.
+        std::unique_lock lock(m_mutex);
+        m_finished.wait(lock, [this]() { return m_active == 0; });
+        m_job = nullptr;
+        error = m_error;
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void MarkoEngine::Jobs::run_worker()
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [&]() { return m_stopping || (m_job != nullptr && m_generation != seen); });
+            if (m_stopping)
+                return;
+
+            seen = m_generation;
+            ++m_active;
+        }
+
+        run_batch();
+
+        {
+            std::lock_guard lock(m_mutex);
+            --m_active;
+        }
+        m_finished.notify_all();
+    }
+}
+
+void MarkoEngine::Jobs::run_batch()
+{
+    inside_job = true;
+    for (size_t i = m_next++; i < m_count; i = m_next++)
+    {
+        try
+        {
+            (*m_job)(i);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_error)
+                m_error = std::current_exception();
+        }
+    }
+    inside_job = false;
+}
\ No newline at end of file
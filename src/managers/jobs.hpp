@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace MarkoEngine
+{
+    // Reports a staged load: stage name, items finished and items in the stage. Stages running on the job pool
+    // call it from worker threads, one call at a time.
+    using Load_Progress = std::function<void(std::string_view stage, size_t done, size_t total)>;
+
+    // Worker threads for loading work. parallel_for hands indices out from a shared counter and the calling thread
+    // takes part, so it returns once every index ran. Without workers, or when called from inside a job, it runs
+    // inline on the calling thread.
+    class Jobs
+    {
+    public:
+        Jobs(const Jobs&) = delete;
+        Jobs(Jobs&&) = delete;
+        Jobs& operator=(const Jobs&) = delete;
+        Jobs& operator=(Jobs&&) = delete;
+
+    private:
+        Jobs() = default;
+        ~Jobs();
+
+    public:
+        static Jobs& get();
+
+        // 0 uses one worker per hardware thread besides the caller.
+        void initialize(size_t worker_count = 0);
+        void cleanup();
+
+        size_t thread_count() const { return m_workers.size() + 1; }
+
+        // Rethrows the first exception a job threw once every index finished.
+        void parallel_for(size_t count, const std::function<void(size_t)>& job);
+
+    private:
+        void run_worker();
+        void run_batch();
+
+    private:
+        std::vector<std::thread> m_workers;
+        std::mutex m_submit_mutex;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::condition_variable m_finished;
+
+        const std::function<void(size_t)>* m_job = nullptr;
+        size_t m_count = 0;
+        std::atomic<size_t> m_next = 0;
+        uint64_t m_generation = 0;
+        size_t m_active = 0;
+        std::exception_ptr m_error;
+        bool m_stopping = false;
+    };
+}
\ No newline at end of file
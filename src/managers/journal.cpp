@@ -0,0 +1,526 @@
+#include "pch.h"
+#include "journal.hpp"
+#include "mapped_file.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+
+namespace
+{
+    // "MKJE"
+    constexpr uint32_t JOURNAL_ENTRY_MAGIC = 0x454A4B4Du;
+    constexpr size_t JOURNAL_ALIGNMENT = 16;
+
+    struct Journal_Entry_Header
+    {
+        uint32_t magic;
+        uint32_t kind;
+        uint64_t sequence;
+        int64_t timestamp;
+        uint64_t size;
+        uint64_t checksum;
+        uint32_t object_count;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Journal_Entry_Header) % JOURNAL_ALIGNMENT == 0);
+
+    size_t align_entry(size_t value)
+    {
+        return (value + JOURNAL_ALIGNMENT - 1) & ~(JOURNAL_ALIGNMENT - 1);
+    }
+
+    // Walks the entries of a mapped segment and stops at the first one that is torn or corrupt.
+    template <typename Function>
+    size_t for_each_entry(const uint8_t* data, size_t size, Function&& function)
+    {
+        size_t offset = 0;
+        while (size - offset >= sizeof(Journal_Entry_Header))
+        {
+            Journal_Entry_Header header;
+            std::memcpy(&header, data + offset, sizeof(header));
+            if (header.magic != JOURNAL_ENTRY_MAGIC || header.size > size - offset - sizeof(header))
+                break;
+
+            const uint8_t* payload = data + offset + sizeof(header);
+            if (MarkoEngine::hash_blob(payload, header.size).low != header.checksum)
+                break;
+
+            if (!function(header, payload))
+                break;
+            offset += align_entry(sizeof(header) + header.size);
+        }
+        return std::min(offset, size);
+    }
+
+    MarkoEngine::Journal_Object make_object(const MarkoEngine::Scene_Object_Record& record)
+    {
+        MarkoEngine::Journal_Object object;
+        object.record = record;
+        object.record.id = 0;
+        object.record.script = 0;
+        object.record.parent = 0;
+        object.record.asset = 0;
+        object.record.first_child = 0;
+        object.record.child_count = 0;
+        object.record.mesh = 0;
+        return object;
+    }
+
+    void apply_scene(const MarkoEngine::Scene_View& view, MarkoEngine::Journal_State& state)
+    {
+        const auto& records = view.objects();
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            const MarkoEngine::Scene_Object_Record& record = records[i];
+            std::string id(view.string(record.id));
+            if ((record.flags & MarkoEngine::SCENE_OBJECT_REMOVED) != 0)
+            {
+                state.erase(id);
+                continue;
+            }
+
+            MarkoEngine::Journal_Object object = make_object(record);
+            object.script = view.string(record.script);
+            object.parent = view.string(record.parent);
+            object.asset = view.string(record.asset);
+            for (uint32_t j = 0; j < record.child_count && record.first_child + j < view.children().size(); ++j)
+                object.children.emplace_back(view.string(view.children()[record.first_child + j]));
+
+            if ((record.flags & MarkoEngine::SCENE_OBJECT_MESH_BLOB) != 0 && record.mesh < view.mesh_blobs().size())
+                object.mesh_blob = view.mesh_blobs()[record.mesh];
+            else
+                object.record.flags &= ~MarkoEngine::SCENE_OBJECT_MESH_BLOB;
+
+            state[std::move(id)] = std::move(object);
+        }
+    }
+
+    void add_object(MarkoEngine::Scene_Data& scene, const std::string& id, const MarkoEngine::Journal_Object& object)
+    {
+        MarkoEngine::Scene_Object_Record record = object.record;
+        record.id = scene.add_string(id);
+        record.script = scene.add_string(object.script);
+        record.parent = scene.add_string(object.parent);
+        record.asset = scene.add_string(object.asset);
+        record.mesh = MarkoEngine::SCENE_NO_INDEX;
+
+        record.first_child = static_cast<uint32_t>(scene.children.size());
+        record.child_count = static_cast<uint32_t>(object.children.size());
+        for (const std::string& child : object.children)
+            scene.children.push_back(scene.add_string(child));
+
+        if ((record.flags & MarkoEngine::SCENE_OBJECT_MESH_BLOB) != 0)
+        {
+            record.mesh = static_cast<uint32_t>(scene.mesh_blobs.size());
+            scene.mesh_blobs.push_back(object.mesh_blob);
+        }
+
+        scene.objects.push_back(record);
+    }
+
+    // Same as add_object for a record that is still in its source scene.
+    void copy_object(const MarkoEngine::Scene_Data& from, const MarkoEngine::Scene_Object_Record& source, MarkoEngine::Scene_Data& scene)
+    {
+        MarkoEngine::Scene_Object_Record record = source;
+        record.id = scene.add_string(from.strings[source.id]);
+        record.script = scene.add_string(from.strings[source.script]);
+        record.parent = scene.add_string(from.strings[source.parent]);
+        record.asset = scene.add_string(from.strings[source.asset]);
+        record.mesh = MarkoEngine::SCENE_NO_INDEX;
+
+        record.first_child = static_cast<uint32_t>(scene.children.size());
+        for (uint32_t i = 0; i < source.child_count; ++i)
+            scene.children.push_back(scene.add_string(from.strings[from.children[source.first_child + i]]));
+
+        if ((source.flags & MarkoEngine::SCENE_OBJECT_MESH_BLOB) != 0)
+        {
+            record.mesh = static_cast<uint32_t>(scene.mesh_blobs.size());
+            scene.mesh_blobs.push_back(from.mesh_blobs[source.mesh]);
+        }
+        else
+        {
+            record.flags &= ~MarkoEngine::SCENE_OBJECT_MESH_BLOB;
+        }
+
+        scene.objects.push_back(record);
+    }
+
+    // Hash of everything a save records about an object, independent of where its strings sit in the table.
+    MarkoEngine::Blob_Hash fingerprint(const MarkoEngine::Scene_Data& scene, const MarkoEngine::Scene_Object_Record& record)
+    {
+        thread_local std::vector<uint8_t> buffer;
+        buffer.clear();
+
+        const auto write = [](const void* data, size_t size)
+            {
+                const uint8_t* bytes = static_cast<const uint8_t*>(data);
+                buffer.insert(buffer.end(), bytes, bytes + size);
+            };
+        const auto write_string = [&write](const std::string& string) { write(string.c_str(), string.size() + 1); };
+
+        const MarkoEngine::Journal_Object canonical = make_object(record);
+        write(&canonical.record, sizeof(canonical.record));
+        write_string(scene.strings[record.script]);
+        write_string(scene.strings[record.parent]);
+        write_string(scene.strings[record.asset]);
+        for (uint32_t i = 0; i < record.child_count; ++i)
+            write_string(scene.strings[scene.children[record.first_child + i]]);
+        if ((record.flags & MarkoEngine::SCENE_OBJECT_MESH_BLOB) != 0)
+            write(&scene.mesh_blobs[record.mesh].hash, sizeof(MarkoEngine::Blob_Hash));
+
+        return MarkoEngine::hash_blob(buffer.data(), buffer.size());
+    }
+
+    void add_removed(MarkoEngine::Scene_Data& scene, const std::string& id)
+    {
+        MarkoEngine::Scene_Object_Record record{};
+        record.type = game_object_type::EMPTY;
+        record.id = scene.add_string(id);
+        record.flags = MarkoEngine::SCENE_OBJECT_REMOVED;
+        record.mesh = MarkoEngine::SCENE_NO_INDEX;
+        scene.objects.push_back(record);
+    }
+
+    std::string segment_name(uint64_t sequence)
+    {
+        std::ostringstream name;
+        name << "segment_" << std::setw(10) << std::setfill('0') << sequence << ".mkj";
+        return name.str();
+    }
+}
+
+MarkoEngine::Journal& MarkoEngine::Journal::get()
+{
+    static Journal instance;
+    return instance;
+}
+
+void MarkoEngine::Journal::initialize(const std::string& directory, const Journal_Retention& retention)
+{
+    std::lock_guard lock(m_mutex);
+    m_directory = directory;
+    m_retention = retention;
+    m_segments.clear();
+    m_entries.clear();
+    m_fingerprints.clear();
+
+    std::filesystem::create_directories(m_directory);
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory))
+    {
+        const std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file() || entry.path().extension() != ".mkj" || name.rfind("segment_", 0) != 0)
+            continue;
+
+        m_segments.push_back({ std::stoull(name.substr(8)), entry.path().string(), 0, 0, 0 });
+    }
+
+    std::sort(m_segments.begin(), m_segments.end(), [](const Segment& a, const Segment& b) { return a.first_sequence < b.first_sequence; });
+
+    // Only the newest segment is ever appended to, so only it can end in a torn write.
+    for (size_t i = 0; i < m_segments.size(); ++i)
+        scan_segment(m_segments[i], i + 1 == m_segments.size());
+
+    m_segments.erase(std::remove_if(m_segments.begin(), m_segments.end(), [](const Segment& segment) { return segment.size == 0; }), m_segments.end());
+
+    Scene_Data latest;
+    if (!m_entries.empty() && restore_entry(m_entries.back().sequence, latest))
+    {
+        for (const Scene_Object_Record& record : latest.objects)
+            m_fingerprints[latest.strings[record.id]] = fingerprint(latest, record);
+    }
+}
+
+void MarkoEngine::Journal::scan_segment(Segment& segment, bool repair)
+{
+    size_t valid = 0;
+    size_t file_size = 0;
+    {
+        Mapped_File file(segment.path);
+        if (file.is_open())
+        {
+            file_size = file.size();
+            bool first = true;
+            valid = for_each_entry(file.data(), file.size(), [&](const Journal_Entry_Header& header, const uint8_t*)
+                {
+                    const Journal_Entry_Kind kind = static_cast<Journal_Entry_Kind>(header.kind);
+                    if (first != (kind == Journal_Entry_Kind::CHECKPOINT))
+                        return false;
+
+                    if (first)
+                        segment.checkpoint_size = header.size;
+                    else
+                        ++segment.delta_count;
+
+                    first = false;
+                    m_entries.push_back({ header.sequence, header.timestamp, kind, header.object_count, header.size });
+                    return true;
+                });
+        }
+    }
+
+    segment.size = valid;
+    if (repair && valid < file_size)
+    {
+        std::cerr << "Discarding " << file_size - valid << " bytes of incomplete backup journal in " << segment.path << std::endl;
+        std::filesystem::resize_file(segment.path, valid);
+    }
+}
+
+bool MarkoEngine::Journal::replay(const Segment& segment, uint64_t last_sequence, Journal_State& state) const
+{
+    Mapped_File file(segment.path);
+    if (!file.is_open())
+        return false;
+
+    bool replayed = false;
+    for_each_entry(file.data(), std::min<size_t>(file.size(), segment.size), [&](const Journal_Entry_Header& header, const uint8_t* payload)
+        {
+            if (header.sequence > last_sequence)
+                return false;
+
+            Scene_View view;
+            if (!view.open(payload, header.size))
+                return false;
+
+            if (static_cast<Journal_Entry_Kind>(header.kind) == Journal_Entry_Kind::CHECKPOINT)
+                state.clear();
+
+            apply_scene(view, state);
+            replayed = true;
+            return true;
+        });
+
+    return replayed;
+}
+
+bool MarkoEngine::Journal::append(const Segment& segment, Journal_Entry_Kind kind, uint64_t sequence, uint32_t object_count, const std::vector<uint8_t>& payload)
+{
+    Journal_Entry_Header header{};
+    header.magic = JOURNAL_ENTRY_MAGIC;
+    header.kind = static_cast<uint32_t>(kind);
+    header.sequence = sequence;
+    header.timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    header.size = payload.size();
+    header.checksum = hash_blob(payload.data(), payload.size()).low;
+    header.object_count = object_count;
+
+    std::vector<uint8_t> entry(align_entry(sizeof(header) + payload.size()), 0);
+    std::memcpy(entry.data(), &header, sizeof(header));
+    std::memcpy(entry.data() + sizeof(header), payload.data(), payload.size());
+
+    // A new segment is written under a temporary name first, so a crash never leaves a segment without its checkpoint.
+    bool written = false;
+    if (kind == Journal_Entry_Kind::CHECKPOINT)
+    {
+        const std::string temporary_path = segment.path + ".tmp";
+        written = MarkoEngine::write_durable(temporary_path, entry.data(), entry.size(), false) &&
+            MarkoEngine::rename_durable(temporary_path, segment.path);
+    }
+    else
+    {
+        written = MarkoEngine::write_durable(segment.path, entry.data(), entry.size(), true);
+    }
+
+    if (!written) {
+        std::cerr << "Failed to write backup journal: " << segment.path << std::endl;
+        return false;
+    }
+
+    m_entries.push_back({ sequence, header.timestamp, kind, object_count, header.size });
+    m_last_write_size = entry.size();
+    return true;
+}
+
+bool MarkoEngine::Journal::save(const Scene_Data& scene)
+{
+    std::lock_guard lock(m_mutex);
+    // Objects are compared by fingerprint against the newest entry, so unchanged objects are never copied.
+    Scene_Data delta;
+    uint32_t changed = 0;
+    std::unordered_set<std::string_view> current;
+    current.reserve(scene.objects.size());
+
+    std::vector<std::pair<const std::string*, Blob_Hash>> updated;
+    size_t kept = 0;
+    for (const Scene_Object_Record& record : scene.objects)
+    {
+        const std::string& id = scene.strings[record.id];
+        current.insert(id);
+
+        const Blob_Hash print = fingerprint(scene, record);
+        auto it = m_fingerprints.find(id);
+        kept += it != m_fingerprints.end() ? 1 : 0;
+        if (it == m_fingerprints.end() || !(it->second == print))
+        {
+            copy_object(scene, record, delta);
+            updated.emplace_back(&id, print);
+            ++changed;
+        }
+    }
+
+    std::vector<std::string> removed;
+    if (kept < m_fingerprints.size())
+    {
+        for (const auto& [id, print] : m_fingerprints)
+        {
+            if (!current.contains(id))
+            {
+                add_removed(delta, id);
+                removed.push_back(id);
+                ++changed;
+            }
+        }
+    }
+
+    m_last_write_size = 0;
+    if (changed == 0 && !m_segments.empty())
+        return true;
+
+    const uint64_t sequence = m_entries.empty() ? 1 : m_entries.back().sequence + 1;
+    const std::vector<uint8_t> delta_payload = serialize_scene(delta);
+
+    bool checkpoint = m_segments.empty();
+    if (!checkpoint)
+    {
+        const Segment& segment = m_segments.back();
+        checkpoint = segment.delta_count >= m_retention.deltas_per_checkpoint ||
+            segment.size - segment.checkpoint_size + delta_payload.size() > segment.checkpoint_size;
+    }
+
+    if (checkpoint)
+    {
+        const std::vector<uint8_t> payload = serialize_scene(scene);
+        Segment segment{ sequence, (std::filesystem::path(m_directory) / segment_name(sequence)).string(), 0, payload.size(), 0 };
+        if (!append(segment, Journal_Entry_Kind::CHECKPOINT, sequence, static_cast<uint32_t>(scene.objects.size()), payload))
+            return false;
+
+        segment.size = m_last_write_size;
+        m_segments.push_back(segment);
+    }
+    else
+    {
+        Segment& segment = m_segments.back();
+        if (!append(segment, Journal_Entry_Kind::DELTA, sequence, changed, delta_payload))
+            return false;
+
+        segment.size += m_last_write_size;
+        ++segment.delta_count;
+    }
+
+    for (const auto& [id, print] : updated)
+        m_fingerprints[*id] = print;
+    for (const std::string& id : removed)
+        m_fingerprints.erase(id);
+
+    apply_retention();
+    return true;
+}
+
+void MarkoEngine::Journal::apply_retention()
+{
+    while (m_segments.size() > 1 && (m_segments.size() > m_retention.max_checkpoints || segments_size() > m_retention.max_bytes))
+    {
+        const Segment& oldest = m_segments.front();
+        const uint64_t next_sequence = m_segments[1].first_sequence;
+
+        std::error_code error;
+        std::filesystem::remove(oldest.path, error);
+        m_entries.erase(m_entries.begin(), std::find_if(m_entries.begin(), m_entries.end(), [next_sequence](const Journal_Entry& entry) { return entry.sequence >= next_sequence; }));
+        m_segments.erase(m_segments.begin());
+    }
+}
+
+bool MarkoEngine::Journal::restore(uint64_t sequence, Scene_Data& scene) const
+{
+    std::lock_guard lock(m_mutex);
+    return restore_entry(sequence, scene);
+}
+
+bool MarkoEngine::Journal::restore_entry(uint64_t sequence, Scene_Data& scene) const
+{
+    auto segment = std::upper_bound(m_segments.begin(), m_segments.end(), sequence, [](uint64_t value, const Segment& segment) { return value < segment.first_sequence; });
+    if (segment == m_segments.begin())
+        return false;
+    --segment;
+
+    Journal_State state;
+    if (!replay(*segment, sequence, state))
+        return false;
+
+    for (const auto& [id, object] : state)
+        add_object(scene, id, object);
+    return true;
+}
+
+bool MarkoEngine::Journal::restore_latest(Scene_Data& scene) const
+{
+    std::lock_guard lock(m_mutex);
+    return !m_entries.empty() && restore_entry(m_entries.back().sequence, scene);
+}
+
+uint64_t MarkoEngine::Journal::sequence_at(int64_t timestamp) const
+{
+    std::lock_guard lock(m_mutex);
+    for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it)
+    {
+        if (it->timestamp <= timestamp)
+            return it->sequence;
+    }
+    return 0;
+}
+
+uint64_t MarkoEngine::Journal::disk_size() const
+{
+    std::lock_guard lock(m_mutex);
+    return segments_size();
+}
+
+uint64_t MarkoEngine::Journal::segments_size() const
+{
+    uint64_t size = 0;
+    for (const Segment& segment : m_segments)
+        size += segment.size;
+    return size;
+}
+
+void MarkoEngine::Journal::collect_blobs(std::unordered_set<Blob_Hash>& live) const
+{
+    std::lock_guard lock(m_mutex);
+    for (const Segment& segment : m_segments)
+    {
+        Mapped_File file(segment.path);
+        if (!file.is_open())
+            continue;
+
+        for_each_entry(file.data(), std::min<size_t>(file.size(), segment.size), [&live](const Journal_Entry_Header& header, const uint8_t* payload)
+            {
+                Scene_View view;
+                if (view.open(payload, header.size))
+                {
+                    for (size_t i = 0; i < view.mesh_blobs().size(); ++i)
+                        live.insert(view.mesh_blobs()[i].hash);
+                }
+                return true;
+            });
+    }
+}
+
+std::vector<MarkoEngine::Journal_Entry> MarkoEngine::Journal::entries() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_entries;
+}
+
+bool MarkoEngine::Journal::empty() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_entries.empty();
+}
+
+size_t MarkoEngine::Journal::last_write_size() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_last_write_size;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "scene_file.hpp"
+
+namespace MarkoEngine
+{
+    // One object as a save records it, with strings resolved so entries with different string tables can be merged.
+    struct Journal_Object
+    {
+        // Type, flags, transform and per-type values; the string, child and mesh indices are cleared.
+        Scene_Object_Record record{};
+        std::string script;
+        std::string parent;
+        std::string asset;
+        std::vector<std::string> children;
+        Scene_Mesh_Blob_Record mesh_blob{};
+    };
+
+    using Journal_State = std::map<std::string, Journal_Object>;
+
+    enum class Journal_Entry_Kind : uint32_t
+    {
+        CHECKPOINT,
+        DELTA
+    };
+
+    struct Journal_Entry
+    {
+        uint64_t sequence;
+        int64_t timestamp;
+        Journal_Entry_Kind kind;
+        uint32_t object_count;
+        uint64_t size;
+    };
+
+    struct Journal_Retention
+    {
+        size_t max_checkpoints = 16;
+        uint64_t max_bytes = 512ull << 20;
+        // A new checkpoint is taken after this many deltas, or earlier once the deltas outweigh the last checkpoint.
+        size_t deltas_per_checkpoint = 64;
+    };
+
+    // Append-only save history. Each segment file starts with a full checkpoint followed by deltas holding only
+    // the objects that changed, so a save costs what changed and any entry can be restored by replaying its segment.
+    // Saves run on the backup thread while the editor reads the history, so every public call takes the lock.
+    class Journal
+    {
+    public:
+        Journal(const Journal&) = delete;
+        Journal(Journal&&) = delete;
+        Journal& operator=(const Journal&) = delete;
+        Journal& operator=(Journal&&) = delete;
+
+    private:
+        Journal() = default;
+
+    public:
+        static Journal& get();
+
+        void initialize(const std::string& directory, const Journal_Retention& retention = {});
+
+        // Appends the objects that differ from the newest entry; nothing is written when the scene is unchanged.
+        bool save(const Scene_Data& scene);
+
+        bool restore(uint64_t sequence, Scene_Data& scene) const;
+        bool restore_latest(Scene_Data& scene) const;
+
+        // Newest entry written at or before the given time, or 0 when there is none.
+        uint64_t sequence_at(int64_t timestamp) const;
+
+        std::vector<Journal_Entry> entries() const;
+        bool empty() const;
+        uint64_t disk_size() const;
+        size_t last_write_size() const;
+
+        void collect_blobs(std::unordered_set<Blob_Hash>& live) const;
+
+    private:
+        struct Segment
+        {
+            uint64_t first_sequence;
+            std::string path;
+            uint64_t size;
+            uint64_t checkpoint_size;
+            size_t delta_count;
+        };
+
+        void scan_segment(Segment& segment, bool repair);
+        bool replay(const Segment& segment, uint64_t last_sequence, Journal_State& state) const;
+        bool restore_entry(uint64_t sequence, Scene_Data& scene) const;
+        uint64_t segments_size() const;
+        bool append(const Segment& segment, Journal_Entry_Kind kind, uint64_t sequence, uint32_t object_count, const std::vector<uint8_t>& payload);
+        void apply_retention();
+
+    private:
+        mutable std::mutex m_mutex;
+        std::string m_directory = "backups/journal";
+        Journal_Retention m_retention{};
+        std::vector<Segment> m_segments;
+        std::vector<Journal_Entry> m_entries;
+
+        // Per-object fingerprints as of the newest entry; the next delta is taken against them.
+        std::unordered_map<std::string, Blob_Hash> m_fingerprints;
+        size_t m_last_write_size = 0;
+    };
+}
\ No newline at end of file
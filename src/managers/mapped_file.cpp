@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MarkoEngine::Mapped_File::Mapped_File(const std::string& filename)
+{
+    open(filename);
+}
+
+MarkoEngine::Mapped_File::~Mapped_File()
+{
+    close();
+}
+
+MarkoEngine::Mapped_File::Mapped_File(Mapped_File&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MarkoEngine::Mapped_File& MarkoEngine::Mapped_File::operator=(Mapped_File&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+#ifdef _WIN32
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+#endif
+    }
+    return *this;
+}
+
+bool MarkoEngine::Mapped_File::open(const std::string& filename)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (view == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(file_stat.st_size);
+#endif
+    return true;
+}
+
+void MarkoEngine::Mapped_File::close()
+{
+    if (m_data == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool MarkoEngine::write_durable(const std::string& filename, const uint8_t* data, size_t size, bool append)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), append ? FILE_APPEND_DATA : GENERIC_WRITE, 0, nullptr, append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD written = 0;
+    const bool result = WriteFile(file, data, static_cast<DWORD>(size), &written, nullptr) && written == size && FlushFileBuffers(file);
+    CloseHandle(file);
+    return result;
+#else
+    const int file = ::open(filename.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    if (file < 0)
+        return false;
+
+    size_t offset = 0;
+    while (offset < size)
+    {
+        const ssize_t written = ::write(file, data + offset, size - offset);
+        if (written <= 0)
+            break;
+        offset += static_cast<size_t>(written);
+    }
+
+    const bool result = offset == size && ::fsync(file) == 0;
+    ::close(file);
+    return result;
+#endif
+}
+
+bool MarkoEngine::rename_durable(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (::rename(from.c_str(), to.c_str()) != 0)
+        return false;
+
+    const std::string directory = std::filesystem::path(to).parent_path().string();
+    return sync_directory(directory.empty() ? "." : directory);
+#endif
+}
+
+bool MarkoEngine::sync_directory(const std::string& directory)
+{
+#ifdef _WIN32
+    (void)directory;
+    return true;
+#else
+    const int file = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (file < 0)
+        return false;
+
+    const bool result = ::fsync(file) == 0;
+    ::close(file);
+    return result;
+#endif
+}
\ No newline at end of file
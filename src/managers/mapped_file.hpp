@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace MarkoEngine
+{
+    // Read-only view of a whole file mapped into the address space; the mapping lives as long as the object.
+    class Mapped_File
+    {
+    public:
+        Mapped_File() = default;
+        explicit Mapped_File(const std::string& filename);
+        ~Mapped_File();
+
+        Mapped_File(const Mapped_File&) = delete;
+        Mapped_File& operator=(const Mapped_File&) = delete;
+        Mapped_File(Mapped_File&& other) noexcept;
+        Mapped_File& operator=(Mapped_File&& other) noexcept;
+
+        bool open(const std::string& filename);
+        void close();
+
+        bool is_open() const { return m_data != nullptr; }
+        const uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+#ifdef _WIN32
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+    };
+
+    // Return only once the bytes, or the new name, have reached the device, so a file reported as written survives
+    // a crash.
+    bool write_durable(const std::string& filename, const uint8_t* data, size_t size, bool append);
+    bool rename_durable(const std::string& from, const std::string& to);
+    // Makes files created or renamed in the directory durable; NTFS already journals that, so a no-op on Windows.
+    bool sync_directory(const std::string& directory);
+}
\ No newline at end of file
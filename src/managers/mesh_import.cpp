@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "mesh_import.hpp"
+#include "jobs.hpp"
+
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+    static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "vertices are read from Assimp's arrays as packed floats");
+    static_assert(offsetof(Vertex, color) == 12 && offsetof(Vertex, texture) == 24 && offsetof(Vertex, bone_ids) == 32);
+
+    void collect_node_meshes(const aiScene& scene, const aiNode& node, std::vector<const aiMesh*>& meshes)
+    {
+        for (unsigned int i = 0; i < node.mNumMeshes; ++i)
+            meshes.push_back(scene.mMeshes[node.mMeshes[i]]);
+        for (unsigned int i = 0; i < node.mNumChildren; ++i)
+            collect_node_meshes(scene, *node.mChildren[i], meshes);
+    }
+
+    // The first 32 bytes of a vertex as two stores: x y z and the colour's red, then green, blue, u and v. The bones
+    // after them stay as the vertex was constructed.
+    inline void store_vertex(Vertex& vertex, __m128 position, __m128 texture, __m128 ones)
+    {
+        float* out = reinterpret_cast<float*>(&vertex);
+        const __m128 z_one = _mm_shuffle_ps(position, ones, _MM_SHUFFLE(0, 0, 2, 2));
+        _mm_storeu_ps(out, _mm_shuffle_ps(position, z_one, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(out + 4, _mm_shuffle_ps(ones, texture, _MM_SHUFFLE(1, 0, 0, 0)));
+    }
+
+    inline __m128 load_texture(const aiVector3D& texture)
+    {
+        // u and v as one 8-byte load; Assimp's arrays only guarantee float alignment.
+        double uv;
+        std::memcpy(&uv, &texture.x, sizeof(uv));
+        return _mm_castpd_ps(_mm_set_sd(uv));
+    }
+}
+
+std::vector<const aiMesh*> MarkoEngine::collect_meshes(const aiScene& scene)
+{
+    std::vector<const aiMesh*> meshes;
+    if (scene.mRootNode != nullptr)
+        collect_node_meshes(scene, *scene.mRootNode, meshes);
+    return meshes;
+}
+
+void MarkoEngine::convert_vertices(const aiMesh& mesh, std::vector<Vertex>& vertices, Aabb& bounds)
+{
+    const size_t count = mesh.mNumVertices;
+    vertices.assign(count, Vertex());
+    if (count == 0)
+        return;
+
+    // Without UVs every vertex reads the same zero.
+    const aiVector3D no_texture(0.0f, 0.0f, 0.0f);
+    const aiVector3D* textures = mesh.mTextureCoords[0] != nullptr ? mesh.mTextureCoords[0] : &no_texture;
+    const size_t texture_stride = mesh.mTextureCoords[0] != nullptr ? 1 : 0;
+
+    const aiVector3D* positions = mesh.mVertices;
+    const __m128 ones = _mm_set1_ps(1.0f);
+    __m128 low = _mm_set1_ps(FLT_MAX);
+    __m128 high = _mm_set1_ps(-FLT_MAX);
+
+    // A position load takes four floats, the fourth being the next vertex's x, so the last one is loaded on its own.
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        const __m128 position = _mm_loadu_ps(&positions[i].x);
+        store_vertex(vertices[i], position, load_texture(textures[i * texture_stride]), ones);
+        low = _mm_min_ps(low, position);
+        high = _mm_max_ps(high, position);
+    }
+
+    const aiVector3D& last = positions[count - 1];
+    const __m128 position = _mm_setr_ps(last.x, last.y, last.z, 0.0f);
+    store_vertex(vertices[count - 1], position, load_texture(textures[(count - 1) * texture_stride]), ones);
+    low = _mm_min_ps(low, position);
+    high = _mm_max_ps(high, position);
+
+    float min[4];
+    float max[4];
+    _mm_storeu_ps(min, low);
+    _mm_storeu_ps(max, high);
+    bounds.extend(glm::vec3(min[0], min[1], min[2]));
+    bounds.extend(glm::vec3(max[0], max[1], max[2]));
+}
+
+void MarkoEngine::convert_indices(const aiMesh& mesh, std::vector<uint32_t>& indices)
+{
+    if (mesh.mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+    {
+        indices.resize(static_cast<size_t>(mesh.mNumFaces) * 3);
+        uint32_t* out = indices.data();
+        for (unsigned int i = 0; i < mesh.mNumFaces; ++i, out += 3)
+        {
+            const unsigned int* face = mesh.mFaces[i].mIndices;
+            out[0] = face[0];
+            out[1] = face[1];
+            out[2] = face[2];
+        }
+        return;
+    }
+
+    size_t count = 0;
+    for (unsigned int i = 0; i < mesh.mNumFaces; ++i)
+        count += mesh.mFaces[i].mNumIndices;
+
+    indices.resize(count);
+    uint32_t* out = indices.data();
+    for (unsigned int i = 0; i < mesh.mNumFaces; ++i)
+        out = std::copy_n(mesh.mFaces[i].mIndices, mesh.mFaces[i].mNumIndices, out);
+}
+
+void MarkoEngine::convert_bone_weights(const aiMesh& mesh, const std::vector<int>& bone_ids, std::vector<Vertex>& vertices)
+{
+    for (unsigned int b = 0; b < mesh.mNumBones; ++b)
+    {
+        const aiBone& bone = *mesh.mBones[b];
+        const int bone_id = bone_ids[b];
+        for (unsigned int w = 0; w < bone.mNumWeights; ++w)
+        {
+            const aiVertexWeight& influence = bone.mWeights[w];
+            if (influence.mVertexId >= vertices.size())
+                continue;
+
+            // An influence takes the weakest of the four slots if it is stronger; empty slots weigh nothing.
+            Vertex& vertex = vertices[influence.mVertexId];
+            int weakest = 0;
+            for (int slot = 1; slot < 4; ++slot)
+            {
+                if (vertex.weights[slot] < vertex.weights[weakest])
+                    weakest = slot;
+            }
+            if (influence.mWeight > vertex.weights[weakest])
+            {
+                vertex.bone_ids[weakest] = bone_id;
+                vertex.weights[weakest] = influence.mWeight;
+            }
+        }
+    }
+
+    for (Vertex& vertex : vertices)
+    {
+        const float sum = vertex.weights.x + vertex.weights.y + vertex.weights.z + vertex.weights.w;
+        if (sum > 0.0f)
+            vertex.weights /= sum;
+    }
+}
+
+void MarkoEngine::convert_meshes(const std::vector<const aiMesh*>& meshes, const std::vector<std::string>& texture_filenames,
+    const std::vector<std::vector<int>>* bone_ids, std::vector<Imported_Mesh>& result, Aabb& bounds)
+{
+    result.clear();
+    result.resize(meshes.size());
+    std::vector<Aabb> mesh_bounds(meshes.size());
+
+    Jobs::get().parallel_for(meshes.size(), [&](size_t i)
+        {
+            const aiMesh& mesh = *meshes[i];
+            Imported_Mesh& imported = result[i];
+            imported.texture_filename = texture_filenames[mesh.mMaterialIndex];
+            convert_vertices(mesh, imported.vertices, mesh_bounds[i]);
+            convert_indices(mesh, imported.indices);
+            if (bone_ids != nullptr && mesh.HasBones())
+                convert_bone_weights(mesh, (*bone_ids)[i], imported.vertices);
+        });
+
+    for (const Aabb& mesh_bound : mesh_bounds)
+    {
+        if (!mesh_bound.valid())
+            continue;
+        bounds.extend(mesh_bound.min);
+        bounds.extend(mesh_bound.max);
+    }
+}
+
+std::shared_ptr<MarkoEngine::Triangle_Mesh> MarkoEngine::build_triangle_mesh(const std::vector<Imported_Mesh>& meshes)
+{
+    std::vector<size_t> first_vertex(meshes.size() + 1, 0);
+    std::vector<size_t> first_index(meshes.size() + 1, 0);
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        first_vertex[i + 1] = first_vertex[i] + meshes[i].vertices.size();
+        first_index[i + 1] = first_index[i] + meshes[i].indices.size();
+    }
+
+    std::shared_ptr<Triangle_Mesh> triangles = std::make_shared<Triangle_Mesh>();
+    triangles->positions.resize(first_vertex.back());
+    triangles->indices.resize(first_index.back());
+
+    Jobs::get().parallel_for(meshes.size(), [&](size_t i)
+        {
+            const Imported_Mesh& mesh = meshes[i];
+            glm::vec3* positions = triangles->positions.data() + first_vertex[i];
+            for (size_t v = 0; v < mesh.vertices.size(); ++v)
+                positions[v] = mesh.vertices[v].position;
+
+            const uint32_t offset = static_cast<uint32_t>(first_vertex[i]);
+            uint32_t* indices = triangles->indices.data() + first_index[i];
+            for (size_t j = 0; j < mesh.indices.size(); ++j)
+                indices[j] = mesh.indices[j] + offset;
+        });
+
+    return triangles;
+}
\ No newline at end of file
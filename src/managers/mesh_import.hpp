@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "renderer.hpp"
+#include "spatial.hpp"
+
+namespace MarkoEngine
+{
+    // Meshes in the order a depth-first walk of the node tree reaches them; a mesh under several nodes is listed
+    // once per node.
+    std::vector<const aiMesh*> collect_meshes(const aiScene& scene);
+
+    // Positions and the first UV set, colour white and no bones, written four lanes at a time into vertices sized
+    // to the mesh. Extends bounds by every position.
+    void convert_vertices(const aiMesh& mesh, std::vector<Vertex>& vertices, Aabb& bounds);
+    // Three indices per triangle into a list sized once; faces of any other size keep all their indices.
+    void convert_indices(const aiMesh& mesh, std::vector<uint32_t>& indices);
+    // bone_ids holds the skeleton's id of each of the mesh's bones. Every vertex keeps its four strongest influences,
+    // chosen as the weights are read and normalized to sum to one.
+    void convert_bone_weights(const aiMesh& mesh, const std::vector<int>& bone_ids, std::vector<Vertex>& vertices);
+
+    // Converts the meshes on the job pool, one job per mesh. texture_filenames is indexed by material; bone_ids,
+    // when given, by mesh.
+    void convert_meshes(const std::vector<const aiMesh*>& meshes, const std::vector<std::string>& texture_filenames,
+        const std::vector<std::vector<int>>* bone_ids, std::vector<Imported_Mesh>& result, Aabb& bounds);
+    // Every mesh's positions and indices in one list for picking, the indices offset past the meshes before it.
+    std::shared_ptr<Triangle_Mesh> build_triangle_mesh(const std::vector<Imported_Mesh>& meshes);
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "names.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace
+{
+    struct Name_Table
+    {
+        std::shared_mutex mutex;
+        std::unordered_map<uint64_t, std::string> strings;
+    };
+
+    Name_Table& name_table()
+    {
+        static Name_Table table;
+        return table;
+    }
+
+    uint64_t intern(std::string_view string)
+    {
+        const uint64_t hash = MarkoEngine::hash_name(string);
+        if (hash == 0)
+            return hash;
+
+        Name_Table& table = name_table();
+        {
+            std::shared_lock lock(table.mutex);
+            auto it = table.strings.find(hash);
+            if (it != table.strings.end())
+            {
+#ifdef _DEBUG
+                if (it->second != string)
+                    throw std::runtime_error("Name hash collision between '" + it->second + "' and '" + std::string(string) + "'");
+#endif
+                return hash;
+            }
+        }
+
+        std::unique_lock lock(table.mutex);
+        table.strings.try_emplace(hash, string);
+        return hash;
+    }
+}
+
+MarkoEngine::Name::Name(const char* string) : m_hash(intern(string ? std::string_view(string) : std::string_view())) {}
+
+MarkoEngine::Name::Name(const std::string& string) : m_hash(intern(string)) {}
+
+MarkoEngine::Name::Name(std::string_view string) : m_hash(intern(string)) {}
+
+MarkoEngine::Name MarkoEngine::Name::from_hash(uint64_t hash)
+{
+    Name name;
+    name.m_hash = hash;
+    return name;
+}
+
+MarkoEngine::Name MarkoEngine::Name::find(std::string_view string)
+{
+    const uint64_t hash = hash_name(string);
+    if (hash == 0)
+        return Name();
+
+    Name_Table& table = name_table();
+    std::shared_lock lock(table.mutex);
+    return table.strings.contains(hash) ? from_hash(hash) : Name();
+}
+
+const std::string& MarkoEngine::Name::str() const
+{
+    static const std::string empty_string;
+    if (m_hash == 0)
+        return empty_string;
+
+    Name_Table& table = name_table();
+    std::shared_lock lock(table.mutex);
+    auto it = table.strings.find(m_hash);
+    return it != table.strings.end() ? it->second : empty_string;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace MarkoEngine
+{
+    // FNV-1a; the empty string maps to 0 so a default Name compares equal to "".
+    constexpr uint64_t hash_name(std::string_view string)
+    {
+        if (string.empty())
+            return 0;
+
+        uint64_t hash = 14695981039346656037ull;
+        for (char character : string)
+        {
+            hash ^= static_cast<uint8_t>(character);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    class Name
+    {
+    public:
+        Name() = default;
+        Name(const char* string);
+        Name(const std::string& string);
+        Name(std::string_view string);
+
+        static Name from_hash(uint64_t hash);
+        // The interned name for a lookup key, or the empty Name if nothing interned the string; unlike the constructors
+        // it never adds to the table, so misses and made-up keys cost nothing.
+        static Name find(std::string_view string);
+
+        uint64_t hash() const { return m_hash; }
+        const std::string& str() const;
+        const char* c_str() const { return str().c_str(); }
+        bool empty() const { return m_hash == 0; }
+
+        bool operator==(const Name& other) const { return m_hash == other.m_hash; }
+
+    private:
+        uint64_t m_hash = 0;
+    };
+
+    inline std::ostream& operator<<(std::ostream& stream, const Name& name)
+    {
+        return stream << name.str();
+    }
+}
+
+template <>
+struct std::hash<MarkoEngine::Name>
+{
+    size_t operator()(const MarkoEngine::Name& name) const noexcept
+    {
+        return static_cast<size_t>(name.hash());
+    }
+};
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "package.hpp"
+#include "cooked_mesh.hpp"
+#include "file_system.hpp"
+#include "jobs.hpp"
+#include "journal.hpp"
+#include "renderer.hpp"
+#include "scene_file.hpp"
+#include "../game_objects/i_game_object.hpp"
+
+#include <iomanip>
+#include <set>
+
+namespace
+{
+    // Where Backup::load_object_state reads the scene when there is no journal, as in a shipped game.
+    constexpr const char* PACKED_SCENE_PATH = "backups/backup1/game_objects.bin";
+    constexpr const char* SHADER_DIRECTORY = "shaders/bin";
+
+    enum Package_Group : size_t
+    {
+        PACKAGE_SCENE,
+        PACKAGE_MODELS,
+        PACKAGE_ANIMATIONS,
+        PACKAGE_TEXTURES,
+        PACKAGE_SCRIPTS,
+        PACKAGE_SHADERS,
+        PACKAGE_GROUP_COUNT
+    };
+
+    constexpr const char* GROUP_NAMES[PACKAGE_GROUP_COUNT] = { "scene", "models", "animations", "textures", "scripts", "shaders" };
+
+    // What a packed file stands for in the content folders; empty for the scene, which is written from memory.
+    struct Packed_Asset
+    {
+        Package_Group group;
+        std::string source;
+    };
+
+    struct Package_Report
+    {
+        size_t files = 0;
+        uint64_t source_bytes = 0;
+        uint64_t packed_bytes = 0;
+    };
+
+    // Zero for an embedded texture, whose bytes are counted with its model.
+    uint64_t source_size(const std::string& path)
+    {
+        std::error_code error;
+        const uint64_t size = std::filesystem::file_size(path, error);
+        return error ? 0 : size;
+    }
+
+    // The cooked file is packed under its own path, where the import looks first; an asset that never cooked ships
+    // as its source.
+    void add_cooked(std::vector<MarkoEngine::Archive_File>& files, std::vector<Packed_Asset>& assets, Package_Group group, const std::string& source, const std::string& cooked)
+    {
+        const std::string path = std::filesystem::exists(cooked) ? cooked : source;
+        if (path == source)
+            std::cerr << "export: no cooked file for " << source << ", its source is packed instead" << std::endl;
+
+        files.push_back({ path, path, {} });
+        assets.push_back({ group, source });
+    }
+
+    // Cooked textures are RGBA8 and barely compress when they come from photographs, so they can be ten times the
+    // JPEG they were decoded from. The smaller of the two is packed; the game decodes the source when that one ships.
+    void add_texture(std::vector<MarkoEngine::Archive_File>& files, std::vector<Packed_Asset>& assets, const std::string& source)
+    {
+        const std::string cooked = MarkoEngine::cooked_texture_path(source);
+        const uint64_t source_bytes = source_size(source);
+        if (source_bytes > 0 && std::filesystem::exists(cooked) && source_bytes < source_size(cooked))
+        {
+            files.push_back({ source, source, {} });
+            assets.push_back({ PACKAGE_TEXTURES, source });
+            return;
+        }
+
+        add_cooked(files, assets, PACKAGE_TEXTURES, source, cooked);
+    }
+
+    double megabytes(uint64_t bytes)
+    {
+        return static_cast<double>(bytes) / (1 << 20);
+    }
+}
+
+bool MarkoEngine::export_package(const std::string& archive_filename)
+{
+    // The journal is not shipped, so the newest save goes in as a plain scene with its meshes taken out of the blob
+    // store. Without a journal the scene is still the one loaded from the backup folder.
+    Scene_Data scene;
+    if (!Journal::get().empty())
+    {
+        if (!Journal::get().restore_latest(scene))
+        {
+            std::cerr << "export: the latest save could not be restored" << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        I_GAME_OBJECT::build_scene(scene);
+    }
+
+    if (!move_meshes_inline(scene))
+    {
+        std::cerr << "export: a mesh of the scene is missing from the blob store" << std::endl;
+        return false;
+    }
+
+    std::set<std::string> models;
+    std::set<std::string> animations;
+    std::set<std::string> textures{ "dependencies/bela.png" };
+    std::set<std::string> scripts;
+    for (const Scene_Object_Record& record : scene.objects)
+    {
+        const std::string& asset = scene.strings[record.asset];
+        switch (static_cast<game_object_type>(record.type))
+        {
+        case MESH:
+            textures.insert(asset);
+            break;
+        case MODEL:
+            models.insert(asset);
+            break;
+        case ANIMATED:
+        case CROWD:
+            animations.insert(asset);
+            break;
+        default:
+            break;
+        }
+
+        if (!scene.strings[record.script].empty())
+            scripts.insert(scene.strings[record.script]);
+    }
+    textures.erase("");
+
+    // Importing cooks whatever is missing or stale, textures the models use included.
+    const Imported_Assets imported = Renderer::import_assets({ models.begin(), models.end() }, { animations.begin(), animations.end() });
+    for (const auto& [filename, texture] : imported.textures)
+        textures.insert(filename);
+
+    const std::vector<std::string> texture_filenames(textures.begin(), textures.end());
+    Jobs::get().parallel_for(texture_filenames.size(), [&](size_t i)
+        {
+            (void)Renderer::decode_texture(texture_filenames[i]);
+        });
+
+    std::vector<Archive_File> files;
+    std::vector<Packed_Asset> assets;
+    files.push_back({ PACKED_SCENE_PATH, "", serialize_scene(scene) });
+    assets.push_back({ PACKAGE_SCENE, "" });
+
+    for (const std::string& model : models)
+        add_cooked(files, assets, PACKAGE_MODELS, model, cooked_mesh_path(model, false));
+    for (const std::string& animation : animations)
+        add_cooked(files, assets, PACKAGE_ANIMATIONS, animation, cooked_mesh_path(animation, true));
+    for (const std::string& texture : texture_filenames)
+    {
+        // Embedded textures live inside their model; there is no source to fall back to.
+        if (!embedded_texture_source(texture).empty() && !std::filesystem::exists(cooked_texture_path(texture)))
+            continue;
+        add_texture(files, assets, texture);
+    }
+    for (const std::string& script : scripts)
+    {
+        files.push_back({ script, script, {} });
+        assets.push_back({ PACKAGE_SCRIPTS, script });
+    }
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(SHADER_DIRECTORY, error))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".spv")
+        {
+            const std::string path = entry.path().generic_string();
+            files.push_back({ path, path, {} });
+            assets.push_back({ PACKAGE_SHADERS, path });
+        }
+    }
+
+    if (!write_archive(archive_filename, files))
+        return false;
+
+    Package_Report reports[PACKAGE_GROUP_COUNT];
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        Package_Report& report = reports[assets[i].group];
+        ++report.files;
+        report.source_bytes += assets[i].source.empty() ? files[i].size : source_size(assets[i].source);
+        report.packed_bytes += files[i].stored_size;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (size_t group = 0; group < PACKAGE_GROUP_COUNT; ++group)
+    {
+        const Package_Report& report = reports[group];
+        std::cout << "export: " << GROUP_NAMES[group] << " " << report.files << " files, " << megabytes(report.source_bytes)
+            << " MB source, " << megabytes(report.packed_bytes) << " MB packed" << std::endl;
+    }
+    std::cout << std::defaultfloat;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+
+namespace MarkoEngine
+{
+    // Packs only what the saved scene reaches into the archive: the scene itself with its meshes inlined, the
+    // cooked models, animations and textures its objects refer to, their scripts, and the compiled shaders. Assets
+    // are cooked first where they are not already; one that cannot be is packed as its source. Prints what each kind
+    // of asset takes before and after packing.
+    bool export_package(const std::string& archive_filename);
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "picking.hpp"
+#include "window.hpp"
+#include "renderer.hpp"
+#include "../game_objects/components.hpp"
+
+#include <chrono>
+
+namespace
+{
+    glm::vec2 to_ndc(const glm::dvec2& cursor)
+    {
+        const glm::vec2 size = glm::vec2(MarkoEngine::Window::get().size());
+        return glm::vec2(cursor) / size * 2.0f - 1.0f;
+    }
+
+    double elapsed_milliseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+MarkoEngine::Picking& MarkoEngine::Picking::get()
+{
+    static Picking instance;
+    return instance;
+}
+
+MarkoEngine::Ray MarkoEngine::Picking::screen_ray(const glm::dvec2& cursor) const
+{
+    const glm::mat4 inverse = glm::inverse(Renderer::get().get_projection_matrix() * Renderer::get().get_view_matrix());
+    const glm::vec2 ndc = to_ndc(cursor);
+
+    glm::vec4 near_point = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 far_point = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+    near_point /= near_point.w;
+    far_point /= far_point.w;
+
+    Ray ray;
+    ray.origin = glm::vec3(near_point);
+    ray.direction = glm::normalize(glm::vec3(far_point - near_point));
+    return ray;
+}
+
+MarkoEngine::Entity MarkoEngine::Picking::pick(const glm::dvec2& cursor, float* distance)
+{
+    return raycast(screen_ray(cursor), distance);
+}
+
+MarkoEngine::Entity MarkoEngine::Picking::raycast(const Ray& ray, float* distance)
+{
+    const auto start = std::chrono::steady_clock::now();
+    Registry& registry = Registry::get();
+
+    // The ray is moved into object space with an unnormalised direction, so hit distances stay in world units.
+    Entity hit = null_entity;
+    const float closest = Spatial::get().tree().raycast(ray, [&](Entity entity, const Ray& clipped)
+        {
+            Bounds_Component* bounds = registry.try_get<Bounds_Component>(entity);
+            Transform_Component* transform = registry.try_get<Transform_Component>(entity);
+            if (!bounds || !transform || !transform->visible || clipped.intersect(bounds->world) < 0.0f)
+                return -1.0f;
+
+            float t = -1.0f;
+            Pick_Mesh_Component* pick_mesh = registry.try_get<Pick_Mesh_Component>(entity);
+            if (pick_mesh && pick_mesh->mesh)
+            {
+                const glm::mat4 to_object = glm::inverse(bounds->world_correction * transform->local_to_world);
+
+                Ray object_ray = clipped;
+                object_ray.origin = glm::vec3(to_object * glm::vec4(clipped.origin, 1.0f));
+                object_ray.direction = glm::vec3(to_object * glm::vec4(clipped.direction, 0.0f));
+                t = pick_mesh->mesh->intersect(object_ray);
+            }
+            else
+            {
+                t = clipped.intersect(bounds->world);
+            }
+
+            if (t >= 0.0f)
+                hit = entity;
+            return t;
+        });
+
+    if (distance)
+        *distance = closest;
+
+    m_last_pick_time = elapsed_milliseconds(start);
+    return hit;
+}
+
+std::vector<MarkoEngine::Entity> MarkoEngine::Picking::pick_rectangle(const glm::dvec2& corner_a, const glm::dvec2& corner_b)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Entity> result;
+
+    const glm::vec2 min = glm::min(to_ndc(corner_a), to_ndc(corner_b));
+    const glm::vec2 max = glm::max(to_ndc(corner_a), to_ndc(corner_b));
+    if (max.x - min.x <= 0.0f || max.y - min.y <= 0.0f)
+        return result;
+
+    // Rescales the selected part of clip space to the full [-1, 1] range so its frustum planes can be extracted.
+    glm::mat4 region(1.0f);
+    region[0][0] = 2.0f / (max.x - min.x);
+    region[1][1] = 2.0f / (max.y - min.y);
+    region[3][0] = -(max.x + min.x) / (max.x - min.x);
+    region[3][1] = -(max.y + min.y) / (max.y - min.y);
+
+    const Frustum frustum = Frustum::from_matrix(region * Renderer::get().get_projection_matrix() * Renderer::get().get_view_matrix());
+
+    Registry& registry = Registry::get();
+    Spatial::get().query_frustum(frustum, [&](Entity entity)
+        {
+            Bounds_Component* bounds = registry.try_get<Bounds_Component>(entity);
+            Transform_Component* transform = registry.try_get<Transform_Component>(entity);
+            if (bounds && transform && transform->visible && frustum.overlaps(bounds->world))
+                result.push_back(entity);
+        });
+
+    m_last_pick_time = elapsed_milliseconds(start);
+    return result;
+}
+
+double MarkoEngine::Picking::last_pick_time() const
+{
+    return m_last_pick_time;
+}
\ No newline at end of file
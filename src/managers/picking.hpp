@@ -0,0 +1,37 @@
+#pragma once
+#include "spatial.hpp"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace MarkoEngine
+{
+    // Viewport selection on the CPU: the spatial tree narrows a click down to a few candidates, which are then
+    // tested against their triangles, so nothing waits on the GPU.
+    class Picking
+    {
+    public:
+        Picking(const Picking&) = delete;
+        Picking(Picking&&) = delete;
+        Picking& operator=(const Picking&) = delete;
+        Picking& operator=(Picking&&) = delete;
+
+    private:
+        Picking() = default;
+
+    public:
+        static Picking& get();
+
+        Ray screen_ray(const glm::dvec2& cursor) const;
+
+        Entity pick(const glm::dvec2& cursor, float* distance = nullptr);
+        Entity raycast(const Ray& ray, float* distance = nullptr);
+        std::vector<Entity> pick_rectangle(const glm::dvec2& corner_a, const glm::dvec2& corner_b);
+
+        double last_pick_time() const;
+
+    private:
+        double m_last_pick_time = 0.0;
+    };
+}
\ No newline at end of file
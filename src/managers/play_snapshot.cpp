@@ -0,0 +1,162 @@
+#include "pch.h"
+#include "play_snapshot.hpp"
+#include "../game_objects/animated_game_object.hpp"
+
+#include <cstring>
+#include <unordered_set>
+
+namespace
+{
+    MarkoEngine::Scene_Object_Record without_indices(const MarkoEngine::Scene_Object_Record& record)
+    {
+        MarkoEngine::Scene_Object_Record result = record;
+        result.id = 0;
+        result.script = 0;
+        result.parent = 0;
+        result.asset = 0;
+        result.first_child = 0;
+        result.child_count = 0;
+        result.mesh = 0;
+        return result;
+    }
+
+    using Mesh_List = std::vector<std::shared_ptr<MarkoEngine::Mesh_Geometry>>;
+
+    // Geometry is immutable and shared, so the same pointer means the same mesh.
+    const MarkoEngine::Mesh_Geometry* mesh_geometry(const MarkoEngine::Scene_Object_Record& record, const Mesh_List& meshes)
+    {
+        return (record.flags & MarkoEngine::SCENE_OBJECT_MESH_BLOB) != 0 && record.mesh < meshes.size() ? meshes[record.mesh].get() : nullptr;
+    }
+
+    // Whether the live object can be patched with apply_scene_record instead of being constructed again.
+    bool same_construction(const MarkoEngine::Scene_Data& current, const Mesh_List& current_meshes, const MarkoEngine::Scene_Object_Record& live,
+        const MarkoEngine::Scene_View& saved_scene, const Mesh_List& saved_meshes, const MarkoEngine::Scene_Object_Record& saved)
+    {
+        if (live.type != saved.type || current.strings[live.asset] != saved_scene.string(saved.asset) ||
+            mesh_geometry(live, current_meshes) != mesh_geometry(saved, saved_meshes))
+            return false;
+
+        switch (static_cast<game_object_type>(live.type))
+        {
+        case BOX_COLLIDER:
+            return live.vector_a == saved.vector_a && live.vector_b == saved.vector_b;
+        case CROWD:
+            return live.instance_count == saved.instance_count && live.spacing == saved.spacing;
+        default:
+            return true;
+        }
+    }
+
+    bool same_state(const MarkoEngine::Scene_Data& current, const Mesh_List& current_meshes, const MarkoEngine::Scene_Object_Record& live,
+        const MarkoEngine::Scene_View& saved_scene, const Mesh_List& saved_meshes, const MarkoEngine::Scene_Object_Record& saved)
+    {
+        const MarkoEngine::Scene_Object_Record a = without_indices(live);
+        const MarkoEngine::Scene_Object_Record b = without_indices(saved);
+        if (std::memcmp(&a, &b, sizeof(a)) != 0 || live.child_count != saved.child_count || !same_construction(current, current_meshes, live, saved_scene, saved_meshes, saved) ||
+            current.strings[live.script] != saved_scene.string(saved.script) || current.strings[live.parent] != saved_scene.string(saved.parent))
+            return false;
+
+        for (uint32_t i = 0; i < live.child_count; ++i)
+        {
+            if (current.strings[current.children[live.first_child + i]] != saved_scene.string(saved_scene.children()[saved.first_child + i]))
+                return false;
+        }
+        return true;
+    }
+}
+
+void MarkoEngine::Play_Snapshot::capture()
+{
+    // Meshes are kept by reference, so starting play neither copies geometry nor writes blobs.
+    Scene_Data scene;
+    m_meshes.clear();
+    I_GAME_OBJECT::build_scene(scene, &m_meshes);
+
+    m_buffer = serialize_scene(scene);
+    m_scene.open(m_buffer.data(), m_buffer.size());
+
+    m_index.clear();
+    m_index.reserve(m_scene.objects().size());
+    for (size_t i = 0; i < m_scene.objects().size(); ++i)
+        m_index.emplace(m_scene.string(m_scene.objects()[i].id), static_cast<uint32_t>(i));
+
+    m_animation_layers.clear();
+    for (const auto& [id, object] : I_GAME_OBJECT::game_objects)
+    {
+        if (object->get_type() == ANIMATED)
+            m_animation_layers.emplace(id.str(), static_cast<ANIMATED_GAME_OBJECT*>(object.get())->get_layers());
+    }
+}
+
+size_t MarkoEngine::Play_Snapshot::restore()
+{
+    if (empty())
+        return 0;
+
+    Scene_Data current;
+    std::vector<std::shared_ptr<Mesh_Geometry>> current_meshes;
+    I_GAME_OBJECT::build_scene(current, &current_meshes);
+
+    size_t changed = 0;
+    bool rebuilt = false;
+    std::unordered_set<std::string_view> seen;
+    seen.reserve(current.objects.size());
+
+    for (const Scene_Object_Record& live : current.objects)
+    {
+        const std::string& id = current.strings[live.id];
+        auto it = m_index.find(id);
+        if (it == m_index.end())
+        {
+            I_GAME_OBJECT::game_objects.erase(id);
+            ++changed;
+            continue;
+        }
+
+        seen.insert(it->first);
+        const Scene_Object_Record& saved = m_scene.objects()[it->second];
+        if (same_state(current, current_meshes, live, m_scene, m_meshes, saved))
+            continue;
+
+        ++changed;
+        if (same_construction(current, current_meshes, live, m_scene, m_meshes, saved))
+        {
+            I_GAME_OBJECT::game_objects[id]->apply_scene_record(m_scene, saved);
+        }
+        else if (std::unique_ptr<I_GAME_OBJECT> object = I_GAME_OBJECT::create_from_scene(m_scene, saved, &m_meshes))
+        {
+            I_GAME_OBJECT::game_objects[id] = std::move(object);
+            rebuilt = true;
+        }
+    }
+
+    // Objects deleted during play.
+    for (const auto& [id, index] : m_index)
+    {
+        if (seen.contains(id))
+            continue;
+
+        if (std::unique_ptr<I_GAME_OBJECT> object = I_GAME_OBJECT::create_from_scene(m_scene, m_scene.objects()[index], &m_meshes))
+        {
+            I_GAME_OBJECT::game_objects[id] = std::move(object);
+            rebuilt = true;
+            ++changed;
+        }
+    }
+
+    // Children of a rebuilt object still point at the entity it replaced.
+    if (rebuilt)
+    {
+        for (auto& [id, object] : I_GAME_OBJECT::game_objects)
+            object->set_parent(object->get_parent());
+    }
+
+    for (const auto& [id, layers] : m_animation_layers)
+    {
+        auto it = I_GAME_OBJECT::game_objects.find(id);
+        if (it != I_GAME_OBJECT::game_objects.end() && it->second->get_type() == ANIMATED)
+            static_cast<ANIMATED_GAME_OBJECT*>(it->second.get())->set_layers(layers);
+    }
+
+    return changed;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "scene_file.hpp"
+
+namespace MarkoEngine
+{
+    // In-memory copy of the scene taken when play starts. Stopping compares every object against it and only touches
+    // the ones that differ: patched in place when they can be, rebuilt when their construction data changed,
+    // removed when they were spawned during play.
+    class Play_Snapshot
+    {
+    public:
+        void capture();
+
+        // Returns how many objects were patched, rebuilt or removed.
+        size_t restore();
+
+        bool empty() const { return m_buffer.empty(); }
+        size_t object_count() const { return m_scene.objects().size(); }
+
+    private:
+        std::vector<uint8_t> m_buffer;
+        Scene_View m_scene{};
+        // Geometry behind each mesh record; their blob records are left empty.
+        std::vector<std::shared_ptr<Mesh_Geometry>> m_meshes;
+        std::unordered_map<std::string_view, uint32_t> m_index;
+        std::unordered_map<std::string, std::vector<Animation_Layer>> m_animation_layers;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "registry.hpp"
+
+void MarkoEngine::Registry::initialize()
+{
+    cleanup();
+}
+
+void MarkoEngine::Registry::cleanup()
+{
+    for (auto& pool : m_pools)
+    {
+        if (pool)
+            pool->clear();
+    }
+
+    m_generations.clear();
+    m_free_indices.clear();
+    m_alive = 0;
+}
+
+MarkoEngine::Registry& MarkoEngine::Registry::get()
+{
+    static Registry instance;
+    return instance;
+}
+
+MarkoEngine::Entity MarkoEngine::Registry::create()
+{
+    ++m_alive;
+
+    if (!m_free_indices.empty())
+    {
+        const uint32_t index = m_free_indices.back();
+        m_free_indices.pop_back();
+        return { index, m_generations[index] };
+    }
+
+    m_generations.push_back(0);
+    return { static_cast<uint32_t>(m_generations.size() - 1), 0 };
+}
+
+void MarkoEngine::Registry::destroy(Entity entity)
+{
+    if (!valid(entity))
+        return;
+
+    for (auto& pool : m_pools)
+    {
+        if (pool)
+            pool->remove(entity);
+    }
+
+    ++m_generations[entity.index];
+    m_free_indices.push_back(entity.index);
+    --m_alive;
+}
+
+bool MarkoEngine::Registry::valid(Entity entity) const
+{
+    return entity.index < m_generations.size() && m_generations[entity.index] == entity.generation;
+}
+
+size_t MarkoEngine::Registry::alive() const
+{
+    return m_alive;
+}
+
+void MarkoEngine::Registry::reserve(size_t capacity)
+{
+    m_generations.reserve(capacity);
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace MarkoEngine
+{
+    struct Entity
+    {
+        uint32_t index = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        bool operator==(const Entity& other) const = default;
+    };
+
+    inline constexpr Entity null_entity{};
+
+    class I_Component_Pool
+    {
+    public:
+        virtual ~I_Component_Pool() = default;
+        virtual void remove(Entity entity) = 0;
+        virtual bool contains(Entity entity) const = 0;
+        virtual void clear() = 0;
+    };
+
+    template <typename T>
+    class Component_Pool : public I_Component_Pool
+    {
+    public:
+        template <typename... Args>
+        T& emplace(Entity entity, Args&&... args)
+        {
+            if (contains(entity))
+                return m_components[m_sparse[entity.index]] = T{ std::forward<Args>(args)... };
+
+            if (entity.index >= m_sparse.size())
+                m_sparse.resize(entity.index + 1, npos);
+
+            m_sparse[entity.index] = static_cast<uint32_t>(m_entities.size());
+            m_entities.push_back(entity);
+            return m_components.emplace_back(T{ std::forward<Args>(args)... });
+        }
+
+        void remove(Entity entity) override
+        {
+            if (!contains(entity))
+                return;
+
+            const uint32_t slot = m_sparse[entity.index];
+            const uint32_t last = static_cast<uint32_t>(m_entities.size() - 1);
+            if (slot != last)
+            {
+                m_entities[slot] = m_entities[last];
+                m_components[slot] = std::move(m_components[last]);
+                m_sparse[m_entities[slot].index] = slot;
+            }
+
+            m_entities.pop_back();
+            m_components.pop_back();
+            m_sparse[entity.index] = npos;
+        }
+
+        bool contains(Entity entity) const override
+        {
+            return entity.index < m_sparse.size() && m_sparse[entity.index] != npos && m_entities[m_sparse[entity.index]] == entity;
+        }
+
+        void clear() override
+        {
+            m_sparse.clear();
+            m_entities.clear();
+            m_components.clear();
+        }
+
+        void reserve(size_t capacity)
+        {
+            m_entities.reserve(capacity);
+            m_components.reserve(capacity);
+        }
+
+        // Reorders the dense arrays by a key per slot; the sparse map is rebuilt so handles stay valid.
+        template <typename Key>
+        void sort_by(const std::vector<Key>& keys)
+        {
+            std::vector<uint32_t> order(m_entities.size());
+            for (uint32_t i = 0; i < order.size(); ++i)
+                order[i] = i;
+
+            std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+            std::vector<Entity> entities;
+            std::vector<T> components;
+            entities.reserve(order.size());
+            components.reserve(order.size());
+            for (uint32_t slot : order)
+            {
+                m_sparse[m_entities[slot].index] = static_cast<uint32_t>(entities.size());
+                entities.push_back(m_entities[slot]);
+                components.push_back(std::move(m_components[slot]));
+            }
+
+            m_entities = std::move(entities);
+            m_components = std::move(components);
+        }
+
+        T& get(Entity entity) { return m_components[m_sparse[entity.index]]; }
+        T* try_get(Entity entity) { return contains(entity) ? &m_components[m_sparse[entity.index]] : nullptr; }
+
+        size_t size() const { return m_entities.size(); }
+        const std::vector<Entity>& entities() const { return m_entities; }
+        std::vector<T>& components() { return m_components; }
+
+    private:
+        static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+        std::vector<uint32_t> m_sparse{};
+        std::vector<Entity> m_entities{};
+        std::vector<T> m_components{};
+    };
+
+    class Registry
+    {
+    public:
+        Registry(const Registry&) = delete;
+        Registry(Registry&&) = delete;
+        Registry& operator=(const Registry&) = delete;
+        Registry& operator=(Registry&&) = delete;
+
+    private:
+        Registry() = default;
+
+    public:
+        void initialize();
+        void cleanup();
+
+        static Registry& get();
+
+        Entity create();
+        void destroy(Entity entity);
+        bool valid(Entity entity) const;
+        size_t alive() const;
+        void reserve(size_t capacity);
+
+        template <typename T, typename... Args>
+        T& emplace(Entity entity, Args&&... args)
+        {
+            return pool<T>().emplace(entity, std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        void remove(Entity entity)
+        {
+            pool<T>().remove(entity);
+        }
+
+        template <typename T>
+        bool has(Entity entity)
+        {
+            return pool<T>().contains(entity);
+        }
+
+        template <typename T>
+        T& get(Entity entity)
+        {
+            return pool<T>().get(entity);
+        }
+
+        template <typename T>
+        T* try_get(Entity entity)
+        {
+            return pool<T>().try_get(entity);
+        }
+
+        template <typename T>
+        Component_Pool<T>& pool()
+        {
+            const size_t id = component_id<T>();
+            if (id >= m_pools.size())
+                m_pools.resize(id + 1);
+            if (!m_pools[id])
+                m_pools[id] = std::make_unique<Component_Pool<T>>();
+
+            return static_cast<Component_Pool<T>&>(*m_pools[id]);
+        }
+
+        // Walks the dense array of the first component and skips entities missing any of the others.
+        template <typename T, typename... Others, typename Function>
+        void each(Function&& function)
+        {
+            auto& first = pool<T>();
+            const auto& entities = first.entities();
+            auto& components = first.components();
+
+            for (size_t i = 0; i < entities.size(); ++i)
+            {
+                if ((pool<Others>().contains(entities[i]) && ...))
+                    function(entities[i], components[i], pool<Others>().get(entities[i])...);
+            }
+        }
+
+    private:
+        template <typename T>
+        static size_t component_id()
+        {
+            static const size_t id = s_component_count++;
+            return id;
+        }
+
+    private:
+        std::vector<uint32_t> m_generations{};
+        std::vector<uint32_t> m_free_indices{};
+        std::vector<std::unique_ptr<I_Component_Pool>> m_pools{};
+        size_t m_alive = 0;
+
+        inline static size_t s_component_count = 0;
+    };
+}
\ No newline at end of file
@@ -10,17 +10,31 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <assimp/Importer.hpp>
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <stb/stb_image.h>
 
 #include "../game_objects/i_game_object.hpp"
+#include "../game_objects/components.hpp"
+#include "transforms.hpp"
 #include "../game_objects/camera_game_object.hpp"
 #include "../game_objects/model_game_object.hpp"
 #include "../game_objects/box_collider_game_object.hpp"
 #include "../game_objects/mesh_game_object.hpp"
 #include "../game_objects/animated_game_object.hpp"
+#include "../game_objects/crowd_game_object.hpp"
+#include "../entry/allocations.hpp"
+#include "cooked_mesh.hpp"
+#include "asset_loader.hpp"
+#include "texture_streaming.hpp"
+#include "file_system.hpp"
+#include "mesh_import.hpp"
+
+#include <mutex>
+#include <unordered_set>
 
 
 
@@ -77,7 +91,7 @@ static VkFormat find_depth_format(VkPhysicalDevice physical_device)
 	throw std::runtime_error("failed to find supported depth format: " + failed_candidates);
 }
 
-static VkImage create_image(VkDevice device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage_flags)
+static VkImage create_image(VkDevice device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage_flags, uint32_t mip_levels = 1)
 {
 	VkImage image{};
 
@@ -88,7 +102,7 @@ static VkImage create_image(VkDevice device, uint32_t width, uint32_t height, Vk
 	image_info.extent.width = width;
 	image_info.extent.height = height;
 	image_info.extent.depth = 1;
-	image_info.mipLevels = 1;
+	image_info.mipLevels = mip_levels;
 	image_info.arrayLayers = 1;
 	image_info.samples = VK_SAMPLE_COUNT_1_BIT;
 	image_info.tiling = tiling;
@@ -101,7 +115,7 @@ static VkImage create_image(VkDevice device, uint32_t width, uint32_t height, Vk
 	return image;
 }
 
-static VkImageView create_image_view(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags)
+static VkImageView create_image_view(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags, uint32_t mip_levels = 1)
 {
 	VkImageView image_view{};
 
@@ -119,7 +133,7 @@ static VkImageView create_image_view(VkDevice device, VkImage image, VkFormat fo
 	view_info.components = components;
 	view_info.subresourceRange.aspectMask = aspect_flags;
 	view_info.subresourceRange.baseMipLevel = 0;
-	view_info.subresourceRange.levelCount = 1;
+	view_info.subresourceRange.levelCount = mip_levels;
 	view_info.subresourceRange.baseArrayLayer = 0;
 	view_info.subresourceRange.layerCount = 1;
 
@@ -215,10 +229,8 @@ static void submit_command_buffer(VkDevice device, VkCommandPool command_pool, V
 	vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
 }
 
-static void transition_image_layout(VkDevice device, VkQueue queue, VkCommandPool command_pool, VkImage image, VkImageLayout old_layout, VkImageLayout new_layout)
+static void record_image_transition(VkCommandBuffer command_buffer, VkImage image, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels = 1)
 {
-	VkCommandBuffer command_buffer = begin_command_buffer(device, command_pool);
-
 	VkImageMemoryBarrier image_memory_barrier = {};
 	image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	image_memory_barrier.oldLayout = old_layout;
@@ -228,7 +240,7 @@ static void transition_image_layout(VkDevice device, VkQueue queue, VkCommandPoo
 	image_memory_barrier.image = image;
 	image_memory_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	image_memory_barrier.subresourceRange.baseMipLevel = 0;
-	image_memory_barrier.subresourceRange.levelCount = 1;
+	image_memory_barrier.subresourceRange.levelCount = mip_levels;
 	image_memory_barrier.subresourceRange.baseArrayLayer = 0;
 	image_memory_barrier.subresourceRange.layerCount = 1;
 
@@ -249,9 +261,28 @@ static void transition_image_layout(VkDevice device, VkQueue queue, VkCommandPoo
 		src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 	}
+	else if (old_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+	{
+		image_memory_barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		src_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	}
+	else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	{
+		image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	}
 
 	vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+}
 
+static void transition_image_layout(VkDevice device, VkQueue queue, VkCommandPool command_pool, VkImage image, VkImageLayout old_layout, VkImageLayout new_layout)
+{
+	VkCommandBuffer command_buffer = begin_command_buffer(device, command_pool);
+	record_image_transition(command_buffer, image, old_layout, new_layout);
 	submit_command_buffer(device, command_pool, queue, command_buffer);
 }
 
@@ -289,26 +320,14 @@ static VkShaderModule create_shader_module(VkDevice device, std::vector<char> co
 
 static std::vector<char> read_shader(std::string filename)
 {
-	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+	const MarkoEngine::File_Data file = MarkoEngine::File_System::get().open(filename);
 
 	if (!file.is_open())
 	{
 		throw std::runtime_error("failed to open shader file: " + filename);
 	}
 
-	size_t file_size = static_cast<size_t>(file.tellg());
-	std::vector<char> buffer(file_size);
-
-	file.seekg(0);
-	file.read(buffer.data(), file_size);
-
-	if (file.fail())
-	{
-		throw std::runtime_error("failed to read shader file: " + filename);
-	}
-
-	file.close();
-	return buffer;
+	return std::vector<char>(file.data(), file.data() + file.size());
 }
 
 static VkDeviceSize aligned_size(VkDeviceSize size, VkDeviceSize alignment = 256)
@@ -347,7 +366,8 @@ static void create_uniform_buffer(VkPhysicalDevice physical_device, VkDevice dev
 inline static int load_texture_from_file(const std::string& filename, int& width, int& height, VkDeviceSize& image_size, stbi_uc*& image)
 {
 	int channels;
-	image = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	const MarkoEngine::File_Data file = MarkoEngine::File_System::get().open(filename);
+	image = file.is_open() ? stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, STBI_rgb_alpha) : nullptr;
 	image_size = width * height * 4;
 
 	if (image == nullptr)
@@ -359,51 +379,46 @@ inline static int load_texture_from_file(const std::string& filename, int& width
 	return 1;
 }
 
-inline static void copy_buffer_to_image(VkDevice device, VkQueue queue, VkCommandPool command_pool, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+inline static void record_buffer_to_image(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset, VkImage image, uint32_t width, uint32_t height, uint32_t mip_level = 0)
 {
-	VkCommandBuffer transfer_command_buffer = begin_command_buffer(device, command_pool);
-
 	VkBufferImageCopy image_region = {};
-	image_region.bufferOffset = 0;
+	image_region.bufferOffset = offset;
 	image_region.bufferRowLength = 0;
 	image_region.bufferImageHeight = 0;
 	image_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	image_region.imageSubresource.mipLevel = 0;
+	image_region.imageSubresource.mipLevel = mip_level;
 	image_region.imageSubresource.baseArrayLayer = 0;
 	image_region.imageSubresource.layerCount = 1;
 	image_region.imageOffset = { 0, 0, 0 };
 	image_region.imageExtent = { width, height, 1 };
 
-	vkCmdCopyBufferToImage(transfer_command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_region);
-
-	submit_command_buffer(device, command_pool, queue, transfer_command_buffer);
+	vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_region);
 }
 
-inline static void create_texture(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, VkCommandPool command_pool, VkDescriptorPool descriptor_pool, VkDescriptorSetLayout descriptor_set_layout, VkSampler sampler, std::string file_name, VkDescriptorSet& descriptor_set, VkImageView& image_view, VkImage& image, VkDeviceMemory& device_memory)
+// The staging buffer holds the chain level after level from offset, as Texture_Streaming lays it out.
+inline static void record_texture_upload(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset, VkImage image, const Decoded_Texture& texture)
 {
-	int image_width, image_height;
-	VkDeviceSize image_size;
-	stbi_uc* image_data;
-	if (!load_texture_from_file(file_name, image_width, image_height, image_size, image_data)) return;
-
-	VkBuffer image_data_staging_buffer = create_buffer(device, image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-	VkDeviceMemory image_data_staging_buffer_device_memory = allocate_buffer_memory(physical_device, device, image_data_staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	void* data;
-	vkMapMemory(device, image_data_staging_buffer_device_memory, 0, image_size, 0, &data);
-	memcpy(data, image_data, static_cast<size_t>(image_size));
-	vkUnmapMemory(device, image_data_staging_buffer_device_memory);
-	stbi_image_free(image_data);
-
-	image = create_image(device, image_width, image_height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
-	device_memory = allocate_image_memory(physical_device, device, image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	transition_image_layout(device, queue, command_pool, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	copy_buffer_to_image(device, queue, command_pool, image_data_staging_buffer, image, image_width, image_height);
-	transition_image_layout(device, queue, command_pool, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	record_image_transition(command_buffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture.mip_levels);
+	for (uint32_t level = 0; level < texture.mip_levels; ++level)
+	{
+		const uint32_t width = std::max(1u, texture.width >> level);
+		const uint32_t height = std::max(1u, texture.height >> level);
+		record_buffer_to_image(command_buffer, buffer, offset, image, width, height, level);
+		offset += static_cast<VkDeviceSize>(width) * height * 4;
+	}
+	record_image_transition(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture.mip_levels);
+}
 
-	vkDestroyBuffer(device, image_data_staging_buffer, nullptr);
-	vkFreeMemory(device, image_data_staging_buffer_device_memory, nullptr);
+inline static void copy_buffer_to_image(VkDevice device, VkQueue queue, VkCommandPool command_pool, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+{
+	VkCommandBuffer transfer_command_buffer = begin_command_buffer(device, command_pool);
+	record_buffer_to_image(transfer_command_buffer, buffer, 0, image, width, height);
+	submit_command_buffer(device, command_pool, queue, transfer_command_buffer);
+}
 
-	image_view = create_image_view(device, image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+inline static VkDescriptorSet create_texture_descriptor_set(VkDevice device, VkDescriptorPool descriptor_pool, VkDescriptorSetLayout descriptor_set_layout, VkSampler sampler, VkImageView image_view)
+{
+	VkDescriptorSet descriptor_set{};
 
 	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
 	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -428,6 +443,182 @@ inline static void create_texture(VkPhysicalDevice physical_device, VkDevice dev
 	write_descriptor_set.pImageInfo = &image_info;
 
 	vkUpdateDescriptorSets(device, 1, &write_descriptor_set, 0, nullptr);
+
+	return descriptor_set;
+}
+
+static Joint_Pose sample_channel(const BoneAnimation& channel, float time, uint32_t& cursor)
+{
+	const std::vector<Keyframe>& keyframes = channel.keyframes;
+	if (keyframes.empty())
+		return Joint_Pose();
+
+	const Keyframe* from = &keyframes.front();
+	const Keyframe* to = from;
+	float factor = 0.0f;
+
+	if (keyframes.size() > 1 && time > keyframes.front().time)
+	{
+		if (cursor + 1 >= keyframes.size() || time < keyframes[cursor].time)
+			cursor = 0;
+
+		while (cursor + 2 < keyframes.size() && time >= keyframes[cursor + 1].time)
+			cursor++;
+
+		from = &keyframes[cursor];
+		to = &keyframes[cursor + 1];
+		factor = glm::clamp((time - from->time) / (to->time - from->time), 0.0f, 1.0f);
+	}
+
+	Joint_Pose pose;
+	pose.position = glm::mix(from->position, to->position, factor);
+	pose.rotation = glm::slerp(from->rotation, to->rotation, factor);
+	pose.scale = glm::mix(from->scale, to->scale, factor);
+	return pose;
+}
+
+static void advance_state(AnimationState& state, const Animation& clip, float delta_time)
+{
+	if (clip.duration <= 0.0f)
+	{
+		state.time = 0.0f;
+		return;
+	}
+
+	state.time += delta_time * clip.ticksPerSecond * state.speed;
+
+	if (state.loop)
+	{
+		state.time = fmod(state.time, clip.duration);
+		if (state.time < 0.0f)
+			state.time += clip.duration;
+	}
+	else
+	{
+		state.time = glm::clamp(state.time, 0.0f, clip.duration);
+	}
+}
+
+static void reset_pose(std::vector<Joint_Pose>& pose, const Renderer_Skeleton& skeleton)
+{
+	for (size_t n = 0; n < pose.size(); n++)
+		pose[n] = skeleton.nodes[n].bind_pose;
+}
+
+static void sample_pose(std::vector<Joint_Pose>& pose, const Renderer_Skeleton& skeleton, const Animation& clip, AnimationState& state)
+{
+	reset_pose(pose, skeleton);
+
+	for (size_t c = 0; c < clip.boneAnimations.size(); c++)
+	{
+		const BoneAnimation& channel = clip.boneAnimations[c];
+		if (channel.node_index >= 0)
+			pose[channel.node_index] = sample_channel(channel, state.time, state.cursors[c]);
+	}
+}
+
+static void blend_poses(std::vector<Joint_Pose>& target, const std::vector<Joint_Pose>& source, float weight)
+{
+	for (size_t n = 0; n < target.size(); n++)
+	{
+		target[n].position = glm::mix(target[n].position, source[n].position, weight);
+		target[n].rotation = glm::slerp(target[n].rotation, source[n].rotation, weight);
+		target[n].scale = glm::mix(target[n].scale, source[n].scale, weight);
+	}
+}
+
+static void apply_additive_pose(std::vector<Joint_Pose>& target, const Animation& clip, AnimationState& state, float weight)
+{
+	for (size_t c = 0; c < clip.boneAnimations.size(); c++)
+	{
+		const BoneAnimation& channel = clip.boneAnimations[c];
+		if (channel.node_index < 0 || channel.keyframes.empty())
+			continue;
+
+		const Keyframe& reference = channel.keyframes.front();
+		Joint_Pose sample = sample_channel(channel, state.time, state.cursors[c]);
+		Joint_Pose& joint = target[channel.node_index];
+
+		joint.position += (sample.position - reference.position) * weight;
+		joint.rotation = joint.rotation * glm::slerp(glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::inverse(reference.rotation) * sample.rotation, weight);
+		joint.scale *= glm::mix(glm::vec3(1.0f), sample.scale / reference.scale, weight);
+	}
+}
+
+// The layer's pose before its weight is applied: the current clip, faded in over the previous clip or over the
+// pose an interrupted fade had reached.
+static void sample_layer(Renderer_Animation& animation, Animation_Layer& layer)
+{
+	const std::vector<Animation>& clips = animation.asset->animations;
+	const Renderer_Skeleton& skeleton = animation.asset->skeleton;
+
+	sample_pose(animation.layer_pose, skeleton, clips[layer.current.clip], layer.current);
+	if (layer.fade_time >= layer.fade_duration)
+		return;
+
+	if (layer.fade_source.empty())
+		sample_pose(animation.fade_pose, skeleton, clips[layer.previous.clip], layer.previous);
+	else
+		animation.fade_pose = layer.fade_source;
+
+	blend_poses(animation.fade_pose, animation.layer_pose, std::min(layer.fade_time / layer.fade_duration, 1.0f));
+	std::swap(animation.fade_pose, animation.layer_pose);
+}
+
+static void compose_pose(Renderer_Animation& animation, const glm::mat4& root_transform)
+{
+	const Renderer_Skeleton& skeleton = animation.asset->skeleton;
+
+	for (size_t n = 0; n < skeleton.nodes.size(); n++)
+	{
+		const Skeleton_Node& node = skeleton.nodes[n];
+		const Joint_Pose& joint = animation.pose[n];
+		const glm::mat4& parent_transform = node.parent < 0 ? root_transform : animation.node_transforms[node.parent];
+
+		animation.node_transforms[n] = parent_transform
+			* glm::translate(glm::mat4(1.0f), joint.position)
+			* glm::toMat4(joint.rotation)
+			* glm::scale(glm::mat4(1.0f), joint.scale);
+
+		if (node.bone_index >= 0)
+		{
+			animation.final_bone_matrices[node.bone_index] = skeleton.global_inverse_transform * animation.node_transforms[n] * skeleton.bone_offset_matrices[node.bone_index];
+		}
+	}
+}
+
+static size_t animation_asset_memory(const Renderer_Animation_Asset& asset)
+{
+	size_t bytes = sizeof(Renderer_Animation_Asset)
+		+ asset.renderer_meshes.capacity() * sizeof(Renderer_Mesh)
+		+ asset.skeleton.nodes.capacity() * sizeof(Skeleton_Node)
+		+ asset.skeleton.bone_offset_matrices.capacity() * sizeof(glm::mat4)
+		+ asset.skeleton.bone_mapping.size() * (sizeof(MarkoEngine::Name) + sizeof(int));
+
+	for (const auto& clip : asset.animations)
+	{
+		bytes += sizeof(Animation) + clip.boneAnimations.capacity() * sizeof(BoneAnimation);
+		for (const auto& channel : clip.boneAnimations)
+			bytes += channel.keyframes.capacity() * sizeof(Keyframe);
+	}
+
+	return bytes;
+}
+
+static size_t animation_instance_memory(const Renderer_Animation& animation)
+{
+	size_t bytes = sizeof(Renderer_Animation)
+		+ animation.layers.capacity() * sizeof(Animation_Layer)
+		+ (animation.pose.capacity() + animation.layer_pose.capacity() + animation.fade_pose.capacity()) * sizeof(Joint_Pose)
+		+ animation.node_transforms.capacity() * sizeof(glm::mat4)
+		+ animation.final_bone_matrices.capacity() * sizeof(glm::mat4)
+		+ (animation.skinning.output_buffer_indices.capacity() + animation.skinning.bone_buffer_indices.capacity() + animation.skinning.descriptor_set_indices.capacity()) * sizeof(uint32_t);
+
+	for (const auto& layer : animation.layers)
+		bytes += (layer.current.cursors.capacity() + layer.previous.cursors.capacity()) * sizeof(uint32_t)
+			+ layer.fade_source.capacity() * sizeof(Joint_Pose);
+
+	return bytes;
 }
 
 
@@ -452,8 +643,12 @@ void Renderer::initialize()
 		create_vulkan_renderpass();
 		create_vulkan_descriptor_resources();
 		create_vulkan_pipelines();
+		create_vulkan_framebuffers();
+		create_vulkan_vertex_animation_pipeline();
+		create_vulkan_skinning_pipeline();
 		create_vulkan_command_buffers();
 		create_vulkan_synchronization();
+		create_vulkan_timestamp_queries();
 		create_imgui_instance();
 
 		projection_matrix = glm::perspective(glm::radians(45.0f), (float)extent.width / (float)extent.height, 0.1f, 1000000.0f);
@@ -468,6 +663,7 @@ void Renderer::initialize()
 void Renderer::cleanup()
 {
 	vkDeviceWaitIdle(device);
+	destroy_retired_resources(true);
 
 
 	vkDestroyDescriptorPool(device, imgui_descriptor_pool, nullptr);
@@ -494,6 +690,36 @@ void Renderer::cleanup()
 	vkDestroyPipeline(device, graphics_pipeline, nullptr);
 	vkDestroyPipelineLayout(device, graphics_pipeline_layout, nullptr);
 
+	for (size_t i = 0; i < vertex_animation_images.size(); i++)
+	{
+		vkDestroyImageView(device, vertex_animation_image_views[i], nullptr);
+		vkDestroyImage(device, vertex_animation_images[i], nullptr);
+		vkFreeMemory(device, vertex_animation_image_memories[i], nullptr);
+	}
+
+	vkDestroyPipeline(device, vertex_animation_pipeline, nullptr);
+	vkDestroyPipelineLayout(device, vertex_animation_pipeline_layout, nullptr);
+	vkDestroyDescriptorSetLayout(device, vertex_animation_descriptor_set_layout, nullptr);
+
+	for (size_t i = 0; i < skinning_output_buffers.size(); i++)
+	{
+		vkDestroyBuffer(device, skinning_output_buffers[i], nullptr);
+		vkFreeMemory(device, skinning_output_memories[i], nullptr);
+	}
+
+	for (size_t i = 0; i < skinning_bone_buffers.size(); i++)
+	{
+		vkDestroyBuffer(device, skinning_bone_buffers[i], nullptr);
+		vkFreeMemory(device, skinning_bone_memories[i], nullptr);
+	}
+
+	vkDestroyPipeline(device, skinning_pipeline, nullptr);
+	vkDestroyPipelineLayout(device, skinning_pipeline_layout, nullptr);
+	vkDestroyDescriptorPool(device, skinning_descriptor_pool, nullptr);
+	vkDestroyDescriptorSetLayout(device, skinning_descriptor_set_layout, nullptr);
+
+	vkDestroyQueryPool(device, timestamp_query_pool, nullptr);
+
 	vkDestroyRenderPass(device, renderpass, nullptr);
 
 	vkDestroyDescriptorPool(device, uniform_pool, nullptr);
@@ -508,6 +734,7 @@ void Renderer::cleanup()
 		vkFreeMemory(device, uniform_device_memories[i], nullptr);
 	}
 
+	vkDestroySampler(device, vertex_animation_sampler, nullptr);
 	vkDestroySampler(device, sampler, nullptr);
 
 	for (VkImageView imageView : swapchain_views) 
@@ -542,6 +769,8 @@ void Renderer::update()
 			VK_TRUE, std::numeric_limits<uint64_t>::max());
 		vkResetFences(Renderer::get().device, 1,
 			&Renderer::get().draw_fences[Renderer::get().current_frame]);
+		Renderer::get().destroy_retired_resources(false);
+		MarkoEngine::Texture_Streaming::get().update();
 
 
 		vkAcquireNextImageKHR(Renderer::get().device, Renderer::get().swapchain,
@@ -550,6 +779,34 @@ void Renderer::update()
 			VK_NULL_HANDLE, &Renderer::get().image_index);
 
 
+		if (Renderer::get().timestamp_query_pool != VK_NULL_HANDLE && Renderer::get().timestamps_written[Renderer::get().image_index])
+		{
+			std::array<uint64_t, 2> timestamps = {};
+			if (vkGetQueryPoolResults(Renderer::get().device, Renderer::get().timestamp_query_pool,
+				Renderer::get().image_index * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t),
+				VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+			{
+				Renderer::get().gpu_frame_time = static_cast<float>(timestamps[1] - timestamps[0]) * Renderer::get().timestamp_period / 1000000.0f;
+
+				static float accumulated_time = 0.0f;
+				static uint32_t accumulated_frames = 0;
+				accumulated_time += Renderer::get().gpu_frame_time;
+				if (++accumulated_frames == 300)
+				{
+					if (Renderer::get().benchmark_passes > 0)
+					{
+						std::cout << "gpu scene time ("
+							<< (Renderer::get().skinning_mode == Skinning_Mode::COMPUTE ? "compute" : "vertex shader") << " skinning, "
+							<< Renderer::get().benchmark_passes << " extra passes): "
+							<< accumulated_time / accumulated_frames << " ms" << std::endl;
+					}
+					accumulated_time = 0.0f;
+					accumulated_frames = 0;
+				}
+			}
+		}
+
+
 		void* data;
 		vkMapMemory(Renderer::get().device,
 			Renderer::get().uniform_device_memories[Renderer::get().image_index],
@@ -581,111 +838,155 @@ void Renderer::update()
 		vkBeginCommandBuffer(Renderer::get().command_buffers[Renderer::get().image_index], &buffer_begin_info);
 
 
-		vkCmdBeginRenderPass(Renderer::get().command_buffers[Renderer::get().image_index],
-			&render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-
-
-		vkCmdBindPipeline(Renderer::get().command_buffers[Renderer::get().image_index],
-			VK_PIPELINE_BIND_POINT_GRAPHICS, Renderer::get().graphics_pipeline);
-
-		transform t;
-		glm::mat4 model_mat;
-		for (auto& object : I_GAME_OBJECT::game_objects)
+		if (Renderer::get().timestamp_query_pool != VK_NULL_HANDLE)
 		{
-			if (!object.second->is_visible)
-				continue;
+			vkCmdResetQueryPool(Renderer::get().command_buffers[Renderer::get().image_index],
+				Renderer::get().timestamp_query_pool, Renderer::get().image_index * 2, 2);
+			vkCmdWriteTimestamp(Renderer::get().command_buffers[Renderer::get().image_index],
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, Renderer::get().timestamp_query_pool, Renderer::get().image_index * 2);
+		}
 
-			model_mat = glm::mat4(1.0f);
 
+		MarkoEngine::Registry& registry = MarkoEngine::Registry::get();
 
-			if (object.second->get_parent().empty())
+		size_t allocations = MarkoEngine::allocation_count();
+		registry.each<Animator_Component, Transform_Component>(
+			[](MarkoEngine::Entity, Animator_Component& animator, Transform_Component& transform)
 			{
-				object.second->set_world_transform(object.second->get_world_transform());
-			}
-			else
-			{
-				auto parent = I_GAME_OBJECT::game_objects.find(object.second->get_parent());
-				if (parent != I_GAME_OBJECT::game_objects.end())
-				{
-					object.second->set_world_transform(
-						parent->second->get_world_transform() + object.second->get_local_transform()
-					);
-				}
-				else
-				{
-					object.second->set_world_transform(object.second->get_local_transform());
-				}
-			}
-			t = object.second->get_world_transform();
+				if (transform.visible)
+					animator.object->Animate();
+			});
+		Renderer::get().animation_allocations = MarkoEngine::allocation_count() - allocations;
+
+		if (Renderer::get().skinning_mode == Skinning_Mode::COMPUTE && Renderer::get().skinning_pipeline != VK_NULL_HANDLE)
+		{
+			VkMemoryBarrier memory_barrier = {};
+			memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			memory_barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+			vkCmdPipelineBarrier(Renderer::get().command_buffers[Renderer::get().image_index],
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+		}
 
-			static Renderer_Mesh dummy_mesh;
-			static int c = 0;
 
-			static Vertex dummy_vertex = {
-				.position = glm::vec3(0.0f, 0.0f, 0.0f), 
-				.color = glm::vec3(1.0f, 1.0f, 1.0f),  
-				.texture = glm::vec2(0.0f, 0.0f),      
-				.bone_ids = glm::ivec4(0),              
-				.weights = glm::vec4(0.0f)          
-			};
+		vkCmdBeginRenderPass(Renderer::get().command_buffers[Renderer::get().image_index],
+			&render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
 
-			static std::vector<Vertex> dummy_vertices = { dummy_vertex };
-			static std::vector<unsigned int> dummy_indices = { 0 };             
+		vkCmdBindPipeline(Renderer::get().command_buffers[Renderer::get().image_index],
+			VK_PIPELINE_BIND_POINT_GRAPHICS, Renderer::get().graphics_pipeline);
 
+		MarkoEngine::Transforms::get().update();
+		MarkoEngine::Spatial::get().update();
 
-			if (c == 0)dummy_mesh = create_mesh("dependencies/bela.png", dummy_vertices, dummy_indices);
-			c++;
+		static Renderer_Mesh dummy_mesh;
+		static int c = 0;
 
-			vkCmdPushConstants(Renderer::get().command_buffers[Renderer::get().image_index],
-				Renderer::get().graphics_pipeline_layout,
-				VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &model_mat);
+		static Vertex dummy_vertex = {
+			.position = glm::vec3(0.0f, 0.0f, 0.0f), 
+			.color = glm::vec3(1.0f, 1.0f, 1.0f),  
+			.texture = glm::vec2(0.0f, 0.0f),      
+			.bone_ids = glm::ivec4(0),              
+			.weights = glm::vec4(0.0f)          
+		};
 
-			draw_mesh(dummy_mesh);
 
-			if (object.second.get()->get_type() == game_object_type::MESH)
-			{
-				MESH_GAME_OBJECT* model = dynamic_cast<MESH_GAME_OBJECT*>(object.second.get());
+		static std::vector<Vertex> dummy_vertices = { dummy_vertex };
+		static std::vector<unsigned int> dummy_indices = { 0 };             
 
-				model_mat = glm::translate(model_mat, t.position);
-				model_mat = glm::rotate(model_mat, glm::radians(t.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-				model_mat = glm::rotate(model_mat, glm::radians(t.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-				model_mat = glm::rotate(model_mat, glm::radians(t.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-				model_mat = glm::scale(model_mat, t.scale);
 
-				vkCmdPushConstants(Renderer::get().command_buffers[Renderer::get().image_index],
-					Renderer::get().graphics_pipeline_layout,
-					VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &model_mat);
+		if (c == 0)dummy_mesh = create_mesh("dependencies/bela.png", dummy_vertices, dummy_indices);
+		c++;
 
-				model->Draw();
-			}
+		glm::mat4 model_mat = glm::mat4(1.0f);
+		vkCmdPushConstants(Renderer::get().command_buffers[Renderer::get().image_index],
+			Renderer::get().graphics_pipeline_layout,
+			VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &model_mat);
 
-			else if (object.second.get()->get_type() == game_object_type::MODEL)
-			{
-				MODEL_GAME_OBJECT* model = dynamic_cast<MODEL_GAME_OBJECT*>(object.second.get());
+		draw_mesh(dummy_mesh);
 
+		const glm::vec3 camera_position = glm::inverse(Renderer::get().view_matrix)[3];
+		const float pixels_per_unit = std::abs(Renderer::get().projection_matrix[1][1]) * 0.5f * Renderer::get().extent.height;
+		auto draw_object = [&](MarkoEngine::Entity entity, Mesh_Renderer_Component& mesh_renderer, Transform_Component& transform)
+			{
+				if (!transform.visible)
+					return;
 
-				model_mat = glm::translate(model_mat, t.position);
-				model_mat = glm::rotate(model_mat, glm::radians(t.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-				model_mat = glm::rotate(model_mat, glm::radians(t.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-				model_mat = glm::rotate(model_mat, glm::radians(t.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-				model_mat = glm::scale(model_mat, t.scale);
+				++Renderer::get().drawn_objects;
 
+				// Projected diameter of the bounding sphere; from inside it the object can cover the whole screen.
+				if (const Bounds_Component* bounds = registry.try_get<Bounds_Component>(entity); bounds && bounds->world.valid())
+				{
+					const float radius = glm::length(bounds->world.extent()) * 0.5f;
+					const float distance = glm::distance(camera_position, bounds->world.center());
+					Renderer::get().draw_screen_size = distance > radius
+						? 2.0f * radius * pixels_per_unit / distance
+						: static_cast<float>(std::max(Renderer::get().extent.width, Renderer::get().extent.height));
+				}
 
-				vkCmdPushConstants(Renderer::get().command_buffers[Renderer::get().image_index],
-					Renderer::get().graphics_pipeline_layout,
-					VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &model_mat);
+				if (mesh_renderer.type == game_object_type::MESH || mesh_renderer.type == game_object_type::MODEL)
+				{
+					vkCmdPushConstants(Renderer::get().command_buffers[Renderer::get().image_index],
+						Renderer::get().graphics_pipeline_layout,
+						VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &transform.local_to_world);
+				}
 
+				switch (mesh_renderer.type)
+				{
+				case game_object_type::MESH:
+					static_cast<MESH_GAME_OBJECT*>(mesh_renderer.object)->Draw();
+					break;
+				case game_object_type::MODEL:
+					static_cast<MODEL_GAME_OBJECT*>(mesh_renderer.object)->Draw();
+					break;
+				case game_object_type::ANIMATED:
+					static_cast<ANIMATED_GAME_OBJECT*>(mesh_renderer.object)->Draw();
+					break;
+				case game_object_type::CROWD:
+					static_cast<CROWD_GAME_OBJECT*>(mesh_renderer.object)->Draw();
+					break;
+				default:
+					break;
+				}
+				Renderer::get().draw_screen_size = 0.0f;
+			};
 
-				model->Draw();
-			}
+		Renderer::get().drawn_objects = 0;
+		if (Renderer::get().frustum_culling)
+		{
+			MarkoEngine::Frustum frustum = MarkoEngine::Frustum::from_matrix(Renderer::get().projection_matrix * Renderer::get().view_matrix);
+			MarkoEngine::Spatial::get().query_frustum(frustum, [&](MarkoEngine::Entity entity)
+				{
+					if (Mesh_Renderer_Component* mesh_renderer = registry.try_get<Mesh_Renderer_Component>(entity))
+						draw_object(entity, *mesh_renderer, registry.get<Transform_Component>(entity));
+				});
+		}
+		else
+		{
+			registry.each<Mesh_Renderer_Component, Transform_Component>(
+				[&](MarkoEngine::Entity entity, Mesh_Renderer_Component& mesh_renderer, Transform_Component& transform)
+				{
+					draw_object(entity, mesh_renderer, transform);
+				});
+		}
 
-			else if (object.second.get()->get_type() == game_object_type::ANIMATED)
-			{
-				ANIMATED_GAME_OBJECT* animated = dynamic_cast<ANIMATED_GAME_OBJECT*>(object.second.get());
+		for (uint32_t pass = 0; pass < Renderer::get().benchmark_passes; pass++)
+		{
+			registry.each<Animator_Component, Transform_Component>(
+				[](MarkoEngine::Entity, Animator_Component& animator, Transform_Component& transform)
+				{
+					if (transform.visible)
+						animator.object->Draw();
+				});
+		}
 
-				animated->Draw();
-			}
+		if (Renderer::get().timestamp_query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(Renderer::get().command_buffers[Renderer::get().image_index],
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, Renderer::get().timestamp_query_pool, Renderer::get().image_index * 2 + 1);
+			Renderer::get().timestamps_written[Renderer::get().image_index] = true;
 		}
 
 #ifndef EXPORT
@@ -749,8 +1050,11 @@ void Renderer::update()
 
 		vkQueuePresentKHR(Renderer::get().presentation_queue, &present_info);
 
+		MarkoEngine::Window::get().frame_presented();
+
 
 		Renderer::get().current_frame = (Renderer::get().current_frame + 1) % Renderer::get().MAX_FRAMES;
+		++Renderer::get().frame_count;
 	}
 }
 
@@ -1433,7 +1737,7 @@ void Renderer::create_vulkan_descriptor_resources() {
 		"Failed to create uniform descriptor set layout");
 
 	VkDeviceSize vp_buffer_size = aligned_size(sizeof(glm::mat4) * 2);
-	VkDeviceSize anim_buffer_size = aligned_size(sizeof(glm::mat4) * 100);
+	VkDeviceSize anim_buffer_size = aligned_size(sizeof(glm::mat4) * MAX_BONES);
 
 	for (size_t i = 0; i < swapchain_image_count; ++i) {
 		create_uniform_buffer(physical_device, device, vp_buffer_size, &uniform_buffers[i], &uniform_device_memories[i]);
@@ -1517,6 +1821,22 @@ void Renderer::create_vulkan_descriptor_resources() {
 	check_vulkan_result(vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &sampler_descriptor_set_layout),
 		"Failed to create sampler descriptor layout");
 
+	VkDescriptorSetLayoutBinding vertex_animation_binding = {
+		.binding = 0,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = 1,
+		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT
+	};
+
+	layout_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 1,
+		.pBindings = &vertex_animation_binding
+	};
+
+	check_vulkan_result(vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &vertex_animation_descriptor_set_layout),
+		"Failed to create vertex animation descriptor layout");
+
 	VkSamplerCreateInfo sampler_info = {
 		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
 		.magFilter = VK_FILTER_LINEAR,
@@ -1536,6 +1856,17 @@ void Renderer::create_vulkan_descriptor_resources() {
 
 	check_vulkan_result(vkCreateSampler(device, &sampler_info, nullptr, &sampler), "Failed to create texture sampler");
 
+	sampler_info.magFilter = VK_FILTER_NEAREST;
+	sampler_info.minFilter = VK_FILTER_NEAREST;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.anisotropyEnable = VK_FALSE;
+	sampler_info.maxAnisotropy = 1.0f;
+
+	check_vulkan_result(vkCreateSampler(device, &sampler_info, nullptr, &vertex_animation_sampler), "Failed to create vertex animation sampler");
+
 	VkDescriptorPoolSize pool_size = {
 		.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 		.descriptorCount = MAX_TEXTURE_DESCRIPTORS
@@ -1543,6 +1874,8 @@ void Renderer::create_vulkan_descriptor_resources() {
 
 	pool_info = {
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		// Hot reload frees the descriptor sets of textures it replaces.
+		.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
 		.maxSets = MAX_TEXTURE_DESCRIPTORS,
 		.poolSizeCount = 1,
 		.pPoolSizes = &pool_size
@@ -1550,6 +1883,43 @@ void Renderer::create_vulkan_descriptor_resources() {
 
 	check_vulkan_result(vkCreateDescriptorPool(device, &pool_info, nullptr, &sampler_pool), "Failed to create sampler descriptor pool");
 
+	std::array<VkDescriptorSetLayoutBinding, 3> skinning_bindings{};
+	for (uint32_t i = 0; i < skinning_bindings.size(); i++)
+	{
+		skinning_bindings[i] = {
+			.binding = i,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = nullptr
+		};
+	}
+
+	layout_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = static_cast<uint32_t>(skinning_bindings.size()),
+		.pBindings = skinning_bindings.data()
+	};
+
+	check_vulkan_result(vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &skinning_descriptor_set_layout),
+		"Failed to create skinning descriptor layout");
+
+	VkDescriptorPoolSize skinning_pool_size = {
+		.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		.descriptorCount = MAX_SKINNING_DESCRIPTORS * static_cast<uint32_t>(skinning_bindings.size())
+	};
+
+	// Skinned objects give their sets back when they are reloaded, so the pool has to allow freeing single sets.
+	pool_info = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+		.maxSets = MAX_SKINNING_DESCRIPTORS,
+		.poolSizeCount = 1,
+		.pPoolSizes = &skinning_pool_size
+	};
+
+	check_vulkan_result(vkCreateDescriptorPool(device, &pool_info, nullptr, &skinning_descriptor_pool), "Failed to create skinning descriptor pool");
+
 	model_push_constant_range = {
 		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
 		.offset = 0,
@@ -1775,8 +2145,10 @@ void Renderer::create_vulkan_pipelines()
 
 	vkDestroyShaderModule(device, grid_fragment_shader_module, nullptr);
 	vkDestroyShaderModule(device, grid_vertex_shader_module, nullptr);
+}
 
-
+void Renderer::create_vulkan_framebuffers()
+{
 	VkFormat depth_format = find_depth_format(physical_device);
 	depth_image = create_image(device, extent.width, extent.height, depth_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
 	depth_device_memory = allocate_image_memory(physical_device, device, depth_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -1804,25 +2176,250 @@ void Renderer::create_vulkan_pipelines()
 	}
 }
 
-void Renderer::create_vulkan_command_buffers()
+void Renderer::create_vulkan_vertex_animation_pipeline()
 {
-	command_buffers.resize(frame_buffers.size());
+	if (!MarkoEngine::File_System::get().exists("shaders/bin/vertex_animation.vert.spv"))
+	{
+		std::cout << "vertex animation shader is not compiled, crowd rendering is disabled!" << std::endl;
+		return;
+	}
 
-	VkCommandPoolCreateInfo command_pool_create_info = {};
-	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	command_pool_create_info.queueFamilyIndex = graphics_queue_family;
+	std::vector<char> vertex_code = read_shader("shaders/bin/vertex_animation.vert.spv");
+	std::vector<char> fragment_code = read_shader("shaders/bin/normal.frag.spv");
 
-	check_vulkan_result(vkCreateCommandPool(device, &command_pool_create_info, nullptr, &command_pool), "failed to create the command pool!");
+	VkShaderModule vertex_shader_module = create_shader_module(device, vertex_code);
+	VkShaderModule fragment_shader_module = create_shader_module(device, fragment_code);
 
-	VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
-	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	command_buffer_allocate_info.commandPool = command_pool;
-	command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	command_buffer_allocate_info.commandBufferCount = (uint32_t)command_buffers.size();
+	VkPipelineShaderStageCreateInfo vertex_shader_create_info{};
+	vertex_shader_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertex_shader_create_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertex_shader_create_info.module = vertex_shader_module;
+	vertex_shader_create_info.pName = "main";
 
-	check_vulkan_result(vkAllocateCommandBuffers(device, &command_buffer_allocate_info, command_buffers.data()), "failed to create command buffer!");
-}
+	VkPipelineShaderStageCreateInfo fragment_shader_create_info{};
+	fragment_shader_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragment_shader_create_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragment_shader_create_info.module = fragment_shader_module;
+	fragment_shader_create_info.pName = "main";
+
+	std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages = { vertex_shader_create_info, fragment_shader_create_info };
+
+	std::array<VkVertexInputBindingDescription, 2> binding_descriptions{};
+	binding_descriptions[0] = { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
+	binding_descriptions[1] = { 1, sizeof(Vertex_Animation_Instance), VK_VERTEX_INPUT_RATE_INSTANCE };
+
+	std::array<VkVertexInputAttributeDescription, 8> attribute_description{};
+	attribute_description[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) };
+	attribute_description[1] = { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) };
+	attribute_description[2] = { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texture) };
+	attribute_description[3] = { 5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex_Animation_Instance, model) };
+	attribute_description[4] = { 6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex_Animation_Instance, model) + sizeof(glm::vec4) };
+	attribute_description[5] = { 7, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex_Animation_Instance, model) + sizeof(glm::vec4) * 2 };
+	attribute_description[6] = { 8, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex_Animation_Instance, model) + sizeof(glm::vec4) * 3 };
+	attribute_description[7] = { 9, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex_Animation_Instance, animation) };
+
+	VkPipelineVertexInputStateCreateInfo vertex_input_create_info{};
+	vertex_input_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input_create_info.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size());
+	vertex_input_create_info.pVertexBindingDescriptions = binding_descriptions.data();
+	vertex_input_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_description.size());
+	vertex_input_create_info.pVertexAttributeDescriptions = attribute_description.data();
+
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_create_info{};
+	input_assembly_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	input_assembly_create_info.primitiveRestartEnable = VK_FALSE;
+
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(extent.width);
+	viewport.height = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = extent;
+
+	VkPipelineViewportStateCreateInfo viewport_state_create_info{};
+	viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state_create_info.viewportCount = 1;
+	viewport_state_create_info.pViewports = &viewport;
+	viewport_state_create_info.scissorCount = 1;
+	viewport_state_create_info.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterization_create_info{};
+	rasterization_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization_create_info.depthClampEnable = VK_FALSE;
+	rasterization_create_info.rasterizerDiscardEnable = VK_FALSE;
+	rasterization_create_info.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterization_create_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization_create_info.depthBiasEnable = VK_FALSE;
+	rasterization_create_info.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisample_state_create_info{};
+	multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisample_state_create_info.sampleShadingEnable = VK_FALSE;
+
+	VkPipelineColorBlendAttachmentState color_state{};
+	color_state.blendEnable = VK_TRUE;
+	color_state.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	color_state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	color_state.colorBlendOp = VK_BLEND_OP_ADD;
+	color_state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	color_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	color_state.alphaBlendOp = VK_BLEND_OP_ADD;
+	color_state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	VkPipelineColorBlendStateCreateInfo color_blending_create_info{};
+	color_blending_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	color_blending_create_info.logicOpEnable = VK_FALSE;
+	color_blending_create_info.attachmentCount = 1;
+	color_blending_create_info.pAttachments = &color_state;
+
+	VkPipelineDepthStencilStateCreateInfo depth_stencil_create_info{};
+	depth_stencil_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depth_stencil_create_info.depthTestEnable = VK_TRUE;
+	depth_stencil_create_info.depthWriteEnable = VK_TRUE;
+	depth_stencil_create_info.depthCompareOp = VK_COMPARE_OP_LESS;
+	depth_stencil_create_info.depthBoundsTestEnable = VK_FALSE;
+	depth_stencil_create_info.stencilTestEnable = VK_FALSE;
+
+	std::array<VkDescriptorSetLayout, 3> descriptor_set_layouts = { uniform_descriptor_set_layout, sampler_descriptor_set_layout, vertex_animation_descriptor_set_layout };
+
+	VkPushConstantRange push_constant_range = {
+		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		.offset = 0,
+		.size = sizeof(glm::mat4) + sizeof(float) * 2 + sizeof(uint32_t) * 3
+	};
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.setLayoutCount = static_cast<uint32_t>(descriptor_set_layouts.size());
+	pipeline_layout_create_info.pSetLayouts = descriptor_set_layouts.data();
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	check_vulkan_result(vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &vertex_animation_pipeline_layout),
+		"failed to create the vertex animation pipeline layout!");
+
+	VkGraphicsPipelineCreateInfo pipeline_create_info{};
+	pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipeline_create_info.stageCount = static_cast<uint32_t>(shader_stages.size());
+	pipeline_create_info.pStages = shader_stages.data();
+	pipeline_create_info.pVertexInputState = &vertex_input_create_info;
+	pipeline_create_info.pInputAssemblyState = &input_assembly_create_info;
+	pipeline_create_info.pViewportState = &viewport_state_create_info;
+	pipeline_create_info.pRasterizationState = &rasterization_create_info;
+	pipeline_create_info.pMultisampleState = &multisample_state_create_info;
+	pipeline_create_info.pDepthStencilState = &depth_stencil_create_info;
+	pipeline_create_info.pColorBlendState = &color_blending_create_info;
+	pipeline_create_info.pDynamicState = nullptr;
+	pipeline_create_info.layout = vertex_animation_pipeline_layout;
+	pipeline_create_info.renderPass = renderpass;
+	pipeline_create_info.subpass = 0;
+	pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+	pipeline_create_info.basePipelineIndex = -1;
+
+	check_vulkan_result(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &vertex_animation_pipeline),
+		"failed to create the vertex animation pipeline!");
+
+	vkDestroyShaderModule(device, fragment_shader_module, nullptr);
+	vkDestroyShaderModule(device, vertex_shader_module, nullptr);
+}
+
+void Renderer::create_vulkan_skinning_pipeline()
+{
+	if (!MarkoEngine::File_System::get().exists("shaders/bin/skin.comp.spv"))
+	{
+		std::cout << "skinning compute shader is not compiled, falling back to vertex shader skinning!" << std::endl;
+		return;
+	}
+
+	VkPushConstantRange push_constant_range = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = sizeof(uint32_t) * 2
+	};
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &skinning_descriptor_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	check_vulkan_result(vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &skinning_pipeline_layout),
+		"failed to create the skinning pipeline layout!");
+
+	std::vector<char> compute_code = read_shader("shaders/bin/skin.comp.spv");
+	VkShaderModule compute_shader_module = create_shader_module(device, compute_code);
+
+	VkComputePipelineCreateInfo pipeline_create_info{};
+	pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_create_info.stage.module = compute_shader_module;
+	pipeline_create_info.stage.pName = "main";
+	pipeline_create_info.layout = skinning_pipeline_layout;
+
+	check_vulkan_result(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &skinning_pipeline),
+		"failed to create the skinning pipeline!");
+
+	vkDestroyShaderModule(device, compute_shader_module, nullptr);
+}
+
+void Renderer::create_vulkan_timestamp_queries()
+{
+	uint32_t queue_family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+	if (queue_families[graphics_queue_family].timestampValidBits == 0 || properties.limits.timestampPeriod == 0.0f)
+	{
+		std::cout << "gpu timestamps are not supported, frame timing is disabled!" << std::endl;
+		return;
+	}
+
+	timestamp_period = properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo query_pool_create_info{};
+	query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_create_info.queryCount = static_cast<uint32_t>(command_buffers.size() * 2);
+
+	check_vulkan_result(vkCreateQueryPool(device, &query_pool_create_info, nullptr, &timestamp_query_pool),
+		"failed to create the timestamp query pool!");
+
+	timestamps_written.assign(command_buffers.size(), false);
+}
+
+void Renderer::create_vulkan_command_buffers()
+{
+	command_buffers.resize(frame_buffers.size());
+
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	command_pool_create_info.queueFamilyIndex = graphics_queue_family;
+
+	check_vulkan_result(vkCreateCommandPool(device, &command_pool_create_info, nullptr, &command_pool), "failed to create the command pool!");
+
+	VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	command_buffer_allocate_info.commandPool = command_pool;
+	command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	command_buffer_allocate_info.commandBufferCount = (uint32_t)command_buffers.size();
+
+	check_vulkan_result(vkAllocateCommandBuffers(device, &command_buffer_allocate_info, command_buffers.data()), "failed to create command buffer!");
+}
 
 void Renderer::create_vulkan_synchronization()
 {
@@ -1858,8 +2455,10 @@ void Renderer::create_imgui_instance()
 		ImGui::CreateContext();
 
 
+#ifndef EXPORT
 		ImFont* font = ImGui::GetIO().Fonts->AddFontFromFileTTF("dependencies/Roboto-Medium.ttf", 18.0f);
 		ImGui::GetIO().FontDefault = font;
+#endif
 
 		std::array<VkDescriptorPoolSize, 11> pool_sizes = {};
 		pool_sizes[0] = { VK_DESCRIPTOR_TYPE_SAMPLER, 1000 };
@@ -1903,7 +2502,10 @@ unsigned long long Renderer::create_gui_texture(std::string filename)
 {
 	Renderer_Gui_Texture imgui_texture;
 	imgui_texture.channels = 4;
-	unsigned char* image_data = stbi_load(filename.c_str(), &imgui_texture.width, &imgui_texture.height, 0, imgui_texture.channels);
+	const MarkoEngine::File_Data file = MarkoEngine::File_System::get().open(filename);
+	unsigned char* image_data = file.is_open()
+		? stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &imgui_texture.width, &imgui_texture.height, 0, imgui_texture.channels)
+		: nullptr;
 
 	if (image_data == nullptr)
 	{
@@ -2097,6 +2699,16 @@ void Renderer::set_view_matrix(glm::mat4 new_view_matrix)
 	view_matrix = new_view_matrix;
 }
 
+glm::mat4 Renderer::get_view_matrix() const
+{
+	return view_matrix;
+}
+
+glm::mat4 Renderer::get_projection_matrix() const
+{
+	return projection_matrix;
+}
+
 
 	
 void Renderer::draw_mesh(Renderer_Mesh& mesh)
@@ -2119,80 +2731,178 @@ void Renderer::draw_mesh(Renderer_Mesh& mesh)
 
 	vkCmdBindDescriptorSets(command_buffers.at(image_index), VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline_layout, 0, static_cast<uint32_t>(descriptor_sets.size()), descriptor_sets.data(), 0, nullptr);
 	vkCmdDrawIndexed(command_buffers.at(image_index), mesh.index_count, 1, 0, 0, 0);
+	MarkoEngine::Texture_Streaming::get().touch(mesh.texture_index, draw_screen_size);
+}
+
+Renderer_Mesh Renderer::create_mesh(std::string texture_filename, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+	// Goes through the batched upload so the texture is shared with every mesh using it and, while the asset
+	// loader runs, decoded in the background behind a placeholder.
+	const Imported_Mesh mesh{ std::move(texture_filename), vertices, indices };
+	return upload_meshes({ &mesh }, {}).front();
+}
+
+void Renderer::draw_model(Renderer_Model& model)
+{
+	for (auto& renderer_mesh : model.renderer_meshes)
+	{
+		draw_mesh(renderer_mesh);
+	}
 }
 
-Renderer_Mesh Renderer::create_mesh(std::string texture_filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
-    Renderer_Mesh new_renderer_mesh;
-    new_renderer_mesh.vertex_count = static_cast<uint32_t>(vertices.size());
-    new_renderer_mesh.index_count = static_cast<uint32_t>(indices.size());
+Renderer_Model Renderer::create_model(std::string model_filename)
+{
+	auto cached_model = models.find(MarkoEngine::Name::find(model_filename));
+	if (cached_model != models.end())
+		return cached_model->second;
+
+	// The empty model draws nothing; the loader reloads every object using it once the upload is done.
+	if (MarkoEngine::Asset_Loader::get().running())
+	{
+		MarkoEngine::Asset_Loader::get().request(MarkoEngine::Asset_Kind::model, model_filename);
+		return Renderer_Model();
+	}
+
+	Imported_Model imported = import_model(model_filename);
+	if (!imported.triangles)
+		return Renderer_Model();
 
-    VkImage texture_image;
-    VkImageView texture_image_view;
-    VkDeviceMemory texture_image_memory;
-    VkDescriptorSet texture_descriptor_set;
+	std::vector<const Imported_Mesh*> meshes;
+	for (const Imported_Mesh& mesh : imported.meshes)
+		meshes.push_back(&mesh);
 
-    create_texture(physical_device, device, graphics_queue, command_pool, sampler_pool, sampler_descriptor_set_layout, sampler, texture_filename, texture_descriptor_set, texture_image_view, texture_image, texture_image_memory);
+	Renderer_Model model{ upload_meshes(meshes, imported.embedded_textures), imported.bounds, imported.triangles };
+	models.emplace(model_filename, model);
+	return model;
+}
 
-    texture_image_views.push_back(texture_image_view);
-    texture_images.push_back(texture_image);
-    texture_image_memories.push_back(texture_image_memory);
-    texture_descriptor_sets.push_back(texture_descriptor_set);
-    new_renderer_mesh.texture_index = static_cast<uint32_t>(texture_image_views.size() - 1);
+Imported_Model Renderer::import_model(const std::string& model_filename)
+{
+	Imported_Model model;
+	if (MarkoEngine::load_cooked_model(model_filename, model))
+		return model;
 
-    VkDeviceSize buffer_size = sizeof(Vertex) * vertices.size();
-    VkBuffer staging_buffer = create_buffer(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-    VkDeviceMemory staging_buffer_memory = allocate_buffer_memory(physical_device, device, staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	model = import_model_source(model_filename);
+	if (model.triangles)
+		MarkoEngine::cook_model(model_filename, model);
+	return model;
+}
 
-    void* data;
-    vkMapMemory(device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, vertices.data(), (size_t)buffer_size);
-    vkUnmapMemory(device, staging_buffer_memory);
+Imported_Animation Renderer::import_animation(const std::string& animation_filename)
+{
+	Imported_Animation animation;
+	if (MarkoEngine::load_cooked_animation(animation_filename, animation))
+		return animation;
+
+	animation = import_animation_source(animation_filename);
+	if (animation.asset)
+		MarkoEngine::cook_animation(animation_filename, animation);
+	return animation;
+}
 
-    VkBuffer vertex_buffer = create_buffer(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-    VkDeviceMemory vertex_buffer_memory = allocate_buffer_memory(physical_device, device, vertex_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+namespace
+{
+	// Assimp reads the model and everything it references, such as an .obj's material library, through these, so
+	// packed models resolve their neighbours inside the archive.
+	class Archive_IO_Stream : public Assimp::IOStream
+	{
+	public:
+		explicit Archive_IO_Stream(MarkoEngine::File_Data file) : file(std::move(file)) {}
 
-    copy_buffer(device, graphics_queue, command_pool, staging_buffer, vertex_buffer, buffer_size);
+		size_t Read(void* buffer, size_t size, size_t count) override
+		{
+			if (size == 0)
+				return 0;
+			count = std::min(count, (file.size() - position) / size);
+			memcpy(buffer, file.data() + position, size * count);
+			position += size * count;
+			return count;
+		}
 
-    vkDestroyBuffer(device, staging_buffer, nullptr);
-    vkFreeMemory(device, staging_buffer_memory, nullptr);
+		size_t Write(const void*, size_t, size_t) override { return 0; }
 
-    buffer_size = sizeof(uint32_t) * indices.size();
-    staging_buffer = create_buffer(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-    staging_buffer_memory = allocate_buffer_memory(physical_device, device, staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		aiReturn Seek(size_t offset, aiOrigin origin) override
+		{
+			const size_t base = origin == aiOrigin_SET ? 0 : origin == aiOrigin_CUR ? position : file.size();
+			if (base + offset > file.size())
+				return aiReturn_FAILURE;
+			position = base + offset;
+			return aiReturn_SUCCESS;
+		}
 
-    vkMapMemory(device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, indices.data(), (size_t)buffer_size);
-    vkUnmapMemory(device, staging_buffer_memory);
+		size_t Tell() const override { return position; }
+		size_t FileSize() const override { return file.size(); }
+		void Flush() override {}
 
-    VkBuffer index_buffer = create_buffer(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
-    VkDeviceMemory index_buffer_memory = allocate_buffer_memory(physical_device, device, index_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	private:
+		MarkoEngine::File_Data file;
+		size_t position = 0;
+	};
 
-    copy_buffer(device, graphics_queue, command_pool, staging_buffer, index_buffer, buffer_size);
+	class Archive_IO_System : public Assimp::IOSystem
+	{
+	public:
+		bool Exists(const char* filename) const override { return MarkoEngine::File_System::get().exists(filename); }
+		char getOsSeparator() const override { return '/'; }
 
-    vkDestroyBuffer(device, staging_buffer, nullptr);
-    vkFreeMemory(device, staging_buffer_memory, nullptr);
+		Assimp::IOStream* Open(const char* filename, const char* mode = "rb") override
+		{
+			if (strchr(mode, 'w') != nullptr || strchr(mode, 'a') != nullptr)
+				return nullptr;
 
-    new_renderer_mesh.vertex_buffer_index = static_cast<uint32_t>(vertex_buffers.size());
-    new_renderer_mesh.index_buffer_index = static_cast<uint32_t>(index_buffers.size());
-    vertex_buffers.push_back(vertex_buffer);
-    index_buffers.push_back(index_buffer);
-    vertex_buffer_memories.push_back(vertex_buffer_memory);
-    index_buffer_memories.push_back(index_buffer_memory);
+			MarkoEngine::File_Data file = MarkoEngine::File_System::get().open(filename);
+			return file.is_open() ? new Archive_IO_Stream(std::move(file)) : nullptr;
+		}
 
-    return new_renderer_mesh;
+		void Close(Assimp::IOStream* stream) override { delete stream; }
+	};
 }
 
-void Renderer::draw_model(Renderer_Model& model)
+// Textures packed into the model file (FBX, glTF binaries) are decoded from the scene in memory: compressed ones
+// through stb, uncompressed ones straight from Assimp's BGRA texels. Returns the name the meshes refer to them by.
+static std::string import_embedded_texture(const aiScene* scene, const std::string& model_filename, const char* path, std::unordered_map<std::string, Decoded_Texture>& textures)
 {
-	for (auto& renderer_mesh : model.renderer_meshes)
+	const auto [embedded, index] = scene->GetEmbeddedTextureAndIndex(path);
+	if (embedded == nullptr || index < 0)
+		return std::string();
+
+	const std::string name = MarkoEngine::embedded_texture_name(model_filename, index);
+	if (textures.contains(name))
+		return name;
+
+	Decoded_Texture texture;
+	if (embedded->mHeight == 0)
 	{
-		draw_mesh(renderer_mesh);
+		texture = Renderer::decode_texture_memory(reinterpret_cast<const uint8_t*>(embedded->pcData), embedded->mWidth);
+	}
+	else
+	{
+		const size_t texel_count = static_cast<size_t>(embedded->mWidth) * embedded->mHeight;
+		std::shared_ptr<uint8_t[]> pixels(new uint8_t[texel_count * 4]);
+		for (size_t i = 0; i < texel_count; ++i)
+		{
+			const aiTexel& texel = embedded->pcData[i];
+			pixels[i * 4 + 0] = texel.r;
+			pixels[i * 4 + 1] = texel.g;
+			pixels[i * 4 + 2] = texel.b;
+			pixels[i * 4 + 3] = texel.a;
+		}
+		texture = { embedded->mWidth, embedded->mHeight, std::shared_ptr<const uint8_t>(pixels, pixels.get()) };
+	}
+
+	if (!texture.pixels)
+	{
+		std::cerr << "Failed to decode embedded texture " << index << " of " << model_filename << "!" << std::endl;
+		return std::string();
 	}
+
+	textures.emplace(name, std::move(texture));
+	return name;
 }
 
-Renderer_Model Renderer::create_model(std::string model_filename)
+Imported_Model Renderer::import_model_source(const std::string& model_filename)
 {
 	Assimp::Importer importer;
+	importer.SetIOHandler(new Archive_IO_System());
 	const aiScene* scene = importer.ReadFile(
 		model_filename,
 		aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices
@@ -2200,13 +2910,14 @@ Renderer_Model Renderer::create_model(std::string model_filename)
 
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
 		std::cerr << "Failed to load model: " << model_filename << "!" << std::endl;
-		return Renderer_Model();
+		return Imported_Model();
 	}
 
 	std::filesystem::path file_path(model_filename);
 	std::string directory_path = file_path.parent_path().string();
 
 
+	Imported_Model model;
 	std::vector<std::string> texture_filenames(scene->mNumMaterials);
 	for (size_t i = 0; i < scene->mNumMaterials; i++) {
 		aiMaterial* material = scene->mMaterials[i];
@@ -2215,188 +2926,827 @@ Renderer_Model Renderer::create_model(std::string model_filename)
 		if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
 			aiString path;
 			if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS) {
-				int idx = std::string(path.data).rfind("\\");
-				std::string fileName = std::string(path.data).substr(idx + 1);
-				texture_filenames[i] = directory_path + "/" + fileName;
+				texture_filenames[i] = import_embedded_texture(scene, model_filename, path.C_Str(), model.embedded_textures);
+				if (texture_filenames[i].empty()) {
+					int idx = std::string(path.data).rfind("\\");
+					std::string fileName = std::string(path.data).substr(idx + 1);
+					texture_filenames[i] = directory_path + "/" + fileName;
+				}
 			}
 		}
 	}
 
 
-	std::vector<uint32_t> vertex_buffer_indices;
-	std::vector<uint32_t> index_buffer_indices;
-	std::vector<uint32_t> texture_indices;
-	std::vector<uint32_t> vertex_counts;
-	std::vector<uint32_t> index_counts;
+	// Submeshes are independent of each other, so each is converted on its own job.
+	MarkoEngine::convert_meshes(MarkoEngine::collect_meshes(*scene), texture_filenames, nullptr, model.meshes, model.bounds);
+	model.triangles = MarkoEngine::build_triangle_mesh(model.meshes);
 
 
-	std::function<void(aiNode*)> processNode = [&](aiNode* node) {
-		for (size_t i = 0; i < node->mNumMeshes; i++) {
-			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-
-			std::vector<Vertex> vertices;
-			std::vector<uint32_t> indices;
-
-
-			vertices.resize(mesh->mNumVertices);
-			for (size_t j = 0; j < mesh->mNumVertices; j++) {
-				vertices[j].position = { mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z };
-
-				if (mesh->mTextureCoords[0]) {
-					vertices[j].texture = { mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y };
-				}
-				else {
-					vertices[j].texture = { 0.0f, 0.0f };
-				}
-
-				vertices[j].color = { 1.0f, 1.0f, 1.0f }; 
-			}
+	return model;
+}
 
+Decoded_Texture Renderer::decode_texture(const std::string& texture_filename)
+{
+	Decoded_Texture texture;
+	if (MarkoEngine::load_cooked_texture(texture_filename, texture))
+		return texture;
 
-			for (size_t j = 0; j < mesh->mNumFaces; j++) {
-				aiFace face = mesh->mFaces[j];
-				for (size_t k = 0; k < face.mNumIndices; k++) {
-					indices.push_back(face.mIndices[k]);
-				}
-			}
+	texture = decode_texture_source(texture_filename);
+#ifndef EXPORT
+	// A shipped game decodes the textures packed as sources on every load rather than write cooked copies beside itself.
+	if (texture.pixels)
+		MarkoEngine::cook_texture(texture_filename, texture);
+#endif
+	return texture;
+}
 
+Decoded_Texture Renderer::decode_texture_source(const std::string& texture_filename)
+{
+	int width = 0;
+	int height = 0;
+	VkDeviceSize image_size = 0;
+	stbi_uc* image = nullptr;
+	if (!load_texture_from_file(texture_filename, width, height, image_size, image))
+		return Decoded_Texture();
+
+	return { static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::shared_ptr<const uint8_t>(image, stbi_image_free) };
+}
 
-			std::string texture_filename = texture_filenames[mesh->mMaterialIndex];
+Decoded_Texture Renderer::decode_texture_memory(const uint8_t* data, size_t size)
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* image = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, STBI_rgb_alpha);
+	if (image == nullptr)
+		return Decoded_Texture();
 
+	return { static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::shared_ptr<const uint8_t>(image, stbi_image_free) };
+}
 
-			Renderer_Mesh new_renderer_mesh = create_mesh(texture_filename, vertices, indices);
+Imported_Assets Renderer::import_assets(const std::vector<std::string>& model_filenames, const std::vector<std::string>& animation_filenames, const MarkoEngine::Load_Progress& progress)
+{
+	Imported_Assets assets;
+	std::unordered_set<MarkoEngine::Name> seen;
+	for (const std::string& filename : model_filenames)
+	{
+		if (seen.insert(filename).second)
+			assets.model_filenames.push_back(filename);
+	}
+	seen.clear();
+	for (const std::string& filename : animation_filenames)
+	{
+		if (seen.insert(filename).second)
+			assets.animation_filenames.push_back(filename);
+	}
 
+	assets.models.resize(assets.model_filenames.size());
+	assets.animations.resize(assets.animation_filenames.size());
 
-			vertex_buffer_indices.push_back(new_renderer_mesh.vertex_buffer_index);
-			index_buffer_indices.push_back(new_renderer_mesh.index_buffer_index);
-			texture_indices.push_back(new_renderer_mesh.texture_index);
-			vertex_counts.push_back(new_renderer_mesh.vertex_count);
-			index_counts.push_back(new_renderer_mesh.index_count);
-		}
+	std::mutex progress_mutex;
+	size_t done = 0;
+	auto report = [&](std::string_view stage, size_t total)
+		{
+			std::lock_guard lock(progress_mutex);
+			++done;
+			if (progress)
+				progress(stage, done, total);
+		};
 
+	const size_t asset_count = assets.models.size() + assets.animations.size();
+	MarkoEngine::Jobs::get().parallel_for(asset_count, [&](size_t i)
+		{
+			if (i < assets.models.size())
+				assets.models[i] = import_model(assets.model_filenames[i]);
+			else
+				assets.animations[i - assets.models.size()] = import_animation(assets.animation_filenames[i - assets.models.size()]);
+			report("import", asset_count);
+		});
 
-		for (size_t i = 0; i < node->mNumChildren; i++) {
-			processNode(node->mChildren[i]);
-		}
+	// Embedded textures were decoded by the import; the rest are decoded here, each file once. Both are cut down to
+	// the mips texture streaming starts them at here, off the main thread, after anything was cooked.
+	auto add_embedded_textures = [&](const std::unordered_map<std::string, Decoded_Texture>& embedded_textures)
+		{
+			for (const auto& [filename, texture] : embedded_textures)
+				assets.textures.emplace(filename, MarkoEngine::Texture_Streaming::get().prepare(filename, texture));
 		};
+	for (const Imported_Model& model : assets.models)
+		add_embedded_textures(model.embedded_textures);
+	for (const Imported_Animation& animation : assets.animations)
+		add_embedded_textures(animation.embedded_textures);
 
+	std::vector<std::string> texture_filenames;
+	auto add_textures = [&](const std::vector<Imported_Mesh>& meshes)
+		{
+			for (const Imported_Mesh& mesh : meshes)
+			{
+				if (assets.textures.emplace(mesh.texture_filename, Decoded_Texture()).second)
+					texture_filenames.push_back(mesh.texture_filename);
+			}
+		};
+	for (const Imported_Model& model : assets.models)
+		add_textures(model.meshes);
+	for (const Imported_Animation& animation : assets.animations)
+		add_textures(animation.meshes);
+
+	// Every slot exists before the jobs start, so they only write into their own texture.
+	std::vector<Decoded_Texture*> textures;
+	for (const std::string& filename : texture_filenames)
+		textures.push_back(&assets.textures[filename]);
+
+	done = 0;
+	MarkoEngine::Jobs::get().parallel_for(texture_filenames.size(), [&](size_t i)
+		{
+			*textures[i] = MarkoEngine::Texture_Streaming::get().prepare(texture_filenames[i], decode_texture(texture_filenames[i]));
+			report("decode", texture_filenames.size());
+		});
 
-	processNode(scene->mRootNode);
+	return assets;
+}
 
+void Renderer::preload_assets(const std::vector<std::string>& model_filenames, const std::vector<std::string>& animation_filenames, const MarkoEngine::Load_Progress& progress)
+{
+	// Staging memory a single submit may use; a scene larger than this is uploaded in several batches.
+	constexpr VkDeviceSize UPLOAD_BATCH_BYTES = 64ull << 20;
 
-	Renderer_Model model;
-	for (size_t i = 0; i < vertex_buffer_indices.size(); i++) {
-		Renderer_Mesh mesh;
-		mesh.vertex_buffer_index = vertex_buffer_indices[i];
-		mesh.index_buffer_index = index_buffer_indices[i];
-		mesh.texture_index = texture_indices[i];
-		mesh.vertex_count = vertex_counts[i];
-		mesh.index_count = index_counts[i];
-		model.renderer_meshes.push_back(mesh);
+	std::vector<std::string> new_models;
+	for (const std::string& filename : model_filenames)
+	{
+		if (!models.contains(MarkoEngine::Name::find(filename)))
+			new_models.push_back(filename);
+	}
+	std::vector<std::string> new_animations;
+	for (const std::string& filename : animation_filenames)
+	{
+		if (!animation_assets.contains(MarkoEngine::Name::find(filename)))
+			new_animations.push_back(filename);
 	}
 
-	return model;
+	Imported_Assets assets = import_assets(new_models, new_animations, progress);
+
+	struct Pending_Asset
+	{
+		size_t index;
+		size_t first_mesh;
+		size_t mesh_count;
+	};
+
+	std::vector<const Imported_Mesh*> batch_meshes;
+	std::vector<Pending_Asset> batch_assets;
+	std::unordered_set<std::string_view> batch_textures;
+	VkDeviceSize batch_bytes = 0;
+	const size_t asset_count = assets.models.size() + assets.animations.size();
+	size_t uploaded = 0;
+
+	auto flush = [&]()
+		{
+			if (batch_meshes.empty())
+				return;
+
+			std::vector<Renderer_Mesh> renderer_meshes = upload_meshes(batch_meshes, assets.textures);
+			for (const Pending_Asset& pending : batch_assets)
+			{
+				std::vector<Renderer_Mesh> meshes(renderer_meshes.begin() + pending.first_mesh, renderer_meshes.begin() + pending.first_mesh + pending.mesh_count);
+				if (pending.index < assets.models.size())
+				{
+					const Imported_Model& model = assets.models[pending.index];
+					models.emplace(assets.model_filenames[pending.index], Renderer_Model{ std::move(meshes), model.bounds, model.triangles });
+				}
+				else
+				{
+					const size_t index = pending.index - assets.models.size();
+					assets.animations[index].asset->renderer_meshes = std::move(meshes);
+					animation_assets.emplace(assets.animation_filenames[index], assets.animations[index].asset);
+				}
+			}
+
+			uploaded += batch_assets.size();
+			if (progress)
+				progress("upload", uploaded, asset_count);
+
+			batch_meshes.clear();
+			batch_assets.clear();
+			batch_textures.clear();
+			batch_bytes = 0;
+		};
+
+	for (size_t i = 0; i < asset_count; ++i)
+	{
+		const bool is_model = i < assets.models.size();
+		const std::vector<Imported_Mesh>& meshes = is_model ? assets.models[i].meshes : assets.animations[i - assets.models.size()].meshes;
+		const bool imported = is_model ? assets.models[i].triangles != nullptr : assets.animations[i - assets.models.size()].asset != nullptr;
+		if (!imported)
+		{
+			++uploaded;
+			continue;
+		}
+
+		VkDeviceSize asset_bytes = 0;
+		for (const Imported_Mesh& mesh : meshes)
+		{
+			asset_bytes += sizeof(Vertex) * mesh.vertices.size() + sizeof(uint32_t) * mesh.indices.size();
+			const Decoded_Texture& texture = assets.textures[mesh.texture_filename];
+			if (batch_textures.insert(mesh.texture_filename).second)
+				asset_bytes += MarkoEngine::mip_chain_size(texture.width, texture.height, texture.mip_levels);
+		}
+
+		if (batch_bytes + asset_bytes > UPLOAD_BATCH_BYTES)
+		{
+			flush();
+			for (const Imported_Mesh& mesh : meshes)
+				batch_textures.insert(mesh.texture_filename);
+		}
+
+		batch_assets.push_back({ i, batch_meshes.size(), meshes.size() });
+		for (const Imported_Mesh& mesh : meshes)
+			batch_meshes.push_back(&mesh);
+		batch_bytes += asset_bytes;
+	}
+	flush();
 }
 
-void Renderer::draw_animation(Renderer_Animation& animation)
+std::vector<Renderer_Mesh> Renderer::upload_meshes(const std::vector<const Imported_Mesh*>& meshes, const std::unordered_map<std::string, Decoded_Texture>& decoded_textures)
 {
+	// Missing textures sample white instead of leaving the mesh without a descriptor set.
+	static const uint8_t white_pixel[4] = { 255, 255, 255, 255 };
+	const Decoded_Texture placeholder{ 1, 1, std::shared_ptr<const uint8_t>(white_pixel, [](const uint8_t*) {}) };
 
-	if (!animation.animations.empty())
+	struct Pending_Texture
 	{
+		std::string filename;
+		Decoded_Texture texture;
+		VkDeviceSize offset;
+		VkImage image;
+		VkDeviceMemory memory;
+	};
 
-		Animation& anim = animation.animations[0];
-		animation.current_animation_time += MarkoEngine::Window::get().delta_time() * anim.ticksPerSecond;
-		animation.current_animation_time = fmod(animation.current_animation_time, anim.duration);
+	struct Pending_Mesh
+	{
+		VkDeviceSize vertex_offset;
+		VkDeviceSize index_offset;
+	};
 
+	auto align = [](VkDeviceSize offset) { return (offset + 15) & ~VkDeviceSize(15); };
 
-		for (size_t i = 0; i < animation.final_bone_matrices.size(); i++)
+	// Everything is laid out in one staging buffer first so the whole batch is a single map and a single submit.
+	std::vector<Renderer_Mesh> result(meshes.size());
+	std::vector<Pending_Mesh> pending_meshes(meshes.size());
+	std::vector<Pending_Texture> pending_textures;
+	std::unordered_map<MarkoEngine::Name, uint32_t> batch_textures;
+	VkDeviceSize staging_size = 0;
+
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		const Imported_Mesh& mesh = *meshes[i];
+		const MarkoEngine::Name texture_name(mesh.texture_filename);
+
+		auto resident = texture_indices.find(texture_name);
+		if (resident != texture_indices.end())
 		{
-			animation.final_bone_matrices[i] = glm::mat4(1.0f);
+			result[i].texture_index = resident->second;
 		}
+		else
+		{
+			auto [pending, inserted] = batch_textures.emplace(texture_name, static_cast<uint32_t>(texture_image_views.size() + pending_textures.size()));
+			if (inserted)
+			{
+				Decoded_Texture texture;
+				auto decoded = decoded_textures.find(mesh.texture_filename);
+				// While the loader runs a texture nobody decoded yet takes its slot with the placeholder, and the
+				// decoded one replaces it there when it lands.
+				if (decoded != decoded_textures.end())
+					texture = decoded->second;
+				else if (MarkoEngine::Asset_Loader::get().running() && !mesh.texture_filename.empty())
+					MarkoEngine::Asset_Loader::get().request(MarkoEngine::Asset_Kind::texture, mesh.texture_filename);
+				else
+					texture = decode_texture(mesh.texture_filename);
+				if (texture.pixels)
+					texture = MarkoEngine::Texture_Streaming::get().prepare(mesh.texture_filename, texture);
+				else
+					texture = placeholder;
+
+				// The placeholder is not streamed; the real texture reports its slot when it replaces it.
+				pending_textures.push_back({ texture.pixels == placeholder.pixels ? std::string() : mesh.texture_filename, texture, staging_size, VK_NULL_HANDLE, VK_NULL_HANDLE });
+				staging_size = align(staging_size + MarkoEngine::mip_chain_size(texture.width, texture.height, texture.mip_levels));
+			}
+			result[i].texture_index = pending->second;
+		}
+
+		result[i].vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+		result[i].index_count = static_cast<uint32_t>(mesh.indices.size());
+		pending_meshes[i].vertex_offset = staging_size;
+		staging_size = align(staging_size + sizeof(Vertex) * mesh.vertices.size());
+		pending_meshes[i].index_offset = staging_size;
+		staging_size = align(staging_size + sizeof(uint32_t) * mesh.indices.size());
+	}
+
+	if (staging_size == 0)
+		return result;
+
+	VkBuffer staging_buffer = create_buffer(device, staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	VkDeviceMemory staging_buffer_memory = allocate_buffer_memory(physical_device, device, staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	uint8_t* data;
+	vkMapMemory(device, staging_buffer_memory, 0, staging_size, 0, reinterpret_cast<void**>(&data));
+	for (const Pending_Texture& texture : pending_textures)
+		memcpy(data + texture.offset, texture.texture.pixels.get(), MarkoEngine::mip_chain_size(texture.texture.width, texture.texture.height, texture.texture.mip_levels));
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		memcpy(data + pending_meshes[i].vertex_offset, meshes[i]->vertices.data(), sizeof(Vertex) * meshes[i]->vertices.size());
+		memcpy(data + pending_meshes[i].index_offset, meshes[i]->indices.data(), sizeof(uint32_t) * meshes[i]->indices.size());
+	}
+	vkUnmapMemory(device, staging_buffer_memory);
+
+	VkCommandBuffer command_buffer = begin_command_buffer(device, command_pool);
+
+	for (Pending_Texture& texture : pending_textures)
+	{
+		texture.image = create_image(device, texture.texture.width, texture.texture.height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, texture.texture.mip_levels);
+		texture.memory = allocate_image_memory(physical_device, device, texture.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		record_texture_upload(command_buffer, staging_buffer, texture.offset, texture.image, texture.texture);
+	}
 
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		const VkDeviceSize vertex_size = sizeof(Vertex) * meshes[i]->vertices.size();
+		VkBuffer vertex_buffer = create_buffer(device, vertex_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		VkDeviceMemory vertex_buffer_memory = allocate_buffer_memory(physical_device, device, vertex_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VkBufferCopy vertex_copy = { pending_meshes[i].vertex_offset, 0, vertex_size };
+		vkCmdCopyBuffer(command_buffer, staging_buffer, vertex_buffer, 1, &vertex_copy);
+
+		const VkDeviceSize index_size = sizeof(uint32_t) * meshes[i]->indices.size();
+		VkBuffer index_buffer = create_buffer(device, index_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+		VkDeviceMemory index_buffer_memory = allocate_buffer_memory(physical_device, device, index_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VkBufferCopy index_copy = { pending_meshes[i].index_offset, 0, index_size };
+		vkCmdCopyBuffer(command_buffer, staging_buffer, index_buffer, 1, &index_copy);
+
+		result[i].vertex_buffer_index = static_cast<uint32_t>(vertex_buffers.size());
+		result[i].index_buffer_index = static_cast<uint32_t>(index_buffers.size());
+		vertex_buffers.push_back(vertex_buffer);
+		index_buffers.push_back(index_buffer);
+		vertex_buffer_memories.push_back(vertex_buffer_memory);
+		index_buffer_memories.push_back(index_buffer_memory);
+	}
 
-		glm::mat4 correction = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1, 0, 0));
+	submit_command_buffer(device, command_pool, graphics_queue, command_buffer);
 
+	vkDestroyBuffer(device, staging_buffer, nullptr);
+	vkFreeMemory(device, staging_buffer_memory, nullptr);
 
-		std::function<void(const aiNode*, const glm::mat4&)> traverseNode =
-			[&](const aiNode* node, const glm::mat4& parentTransform)
+	for (const Pending_Texture& texture : pending_textures)
+	{
+		if (!texture.filename.empty())
+			MarkoEngine::Texture_Streaming::get().set_resident(static_cast<uint32_t>(texture_images.size()), texture.filename, texture.texture);
+
+		VkImageView image_view = create_image_view(device, texture.image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, texture.texture.mip_levels);
+		texture_images.push_back(texture.image);
+		texture_image_memories.push_back(texture.memory);
+		texture_image_views.push_back(image_view);
+		texture_descriptor_sets.push_back(create_texture_descriptor_set(device, sampler_pool, sampler_descriptor_set_layout, sampler, image_view));
+	}
+	for (const auto& [name, index] : batch_textures)
+		texture_indices.emplace(name, index);
+
+	return result;
+}
+
+void Renderer::retire(std::function<void()> destroy)
+{
+	retired_resources.push_back({ frame_count, std::move(destroy) });
+}
+
+void Renderer::destroy_retired_resources(bool all)
+{
+	// Frames submitted before the resource was retired may still read it until their fences have signalled.
+	auto retired = retired_resources.begin();
+	for (; retired != retired_resources.end() && (all || retired->first + MAX_FRAMES <= frame_count); ++retired)
+		retired->second();
+	retired_resources.erase(retired_resources.begin(), retired);
+}
+
+void Renderer::retire_meshes(const std::vector<Renderer_Mesh>& meshes)
+{
+	for (const Renderer_Mesh& mesh : meshes)
+	{
+		const uint32_t vertex_index = mesh.vertex_buffer_index;
+		const uint32_t index_index = mesh.index_buffer_index;
+		retire([this, vertex_index, index_index]()
 			{
+				vkDestroyBuffer(device, vertex_buffers[vertex_index], nullptr);
+				vkFreeMemory(device, vertex_buffer_memories[vertex_index], nullptr);
+				vkDestroyBuffer(device, index_buffers[index_index], nullptr);
+				vkFreeMemory(device, index_buffer_memories[index_index], nullptr);
+				vertex_buffers[vertex_index] = VK_NULL_HANDLE;
+				vertex_buffer_memories[vertex_index] = VK_NULL_HANDLE;
+				index_buffers[index_index] = VK_NULL_HANDLE;
+				index_buffer_memories[index_index] = VK_NULL_HANDLE;
+			});
+	}
+}
 
-				aiMatrix4x4 aiMat = node->mTransformation;
-				glm::mat4 nodeTransform = glm::mat4(
-					aiMat.a1, aiMat.b1, aiMat.c1, aiMat.d1,
-					aiMat.a2, aiMat.b2, aiMat.c2, aiMat.d2,
-					aiMat.a3, aiMat.b3, aiMat.c3, aiMat.d3,
-					aiMat.a4, aiMat.b4, aiMat.c4, aiMat.d4
-				);
+void Renderer::replace_texture(uint32_t texture_index, const std::string& texture_filename, const Decoded_Texture& decoded)
+{
+	const Decoded_Texture texture = MarkoEngine::Texture_Streaming::get().prepare(texture_filename, decoded);
+	const VkDeviceSize size = MarkoEngine::mip_chain_size(texture.width, texture.height, texture.mip_levels);
+	VkBuffer staging_buffer = create_buffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	VkDeviceMemory staging_buffer_memory = allocate_buffer_memory(physical_device, device, staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
+	void* data;
+	vkMapMemory(device, staging_buffer_memory, 0, size, 0, &data);
+	memcpy(data, texture.pixels.get(), static_cast<size_t>(size));
+	vkUnmapMemory(device, staging_buffer_memory);
 
-				glm::mat4 animTransform = glm::mat4(1.0f);
-				for (auto& channel : anim.boneAnimations)
-				{
-					if (channel.boneName == node->mName.C_Str())
-					{
+	VkImage image = create_image(device, texture.width, texture.height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, texture.mip_levels);
+	VkDeviceMemory memory = allocate_image_memory(physical_device, device, image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-						for (size_t i = 0; i < channel.keyframes.size() - 1; i++)
-						{
-							if (animation.current_animation_time >= channel.keyframes[i].time &&
-								animation.current_animation_time < channel.keyframes[i + 1].time)
-							{
-								float factor = (animation.current_animation_time - channel.keyframes[i].time) /
-									(channel.keyframes[i + 1].time - channel.keyframes[i].time);
-								glm::vec3 interpolatedPos = glm::mix(channel.keyframes[i].position, channel.keyframes[i + 1].position, factor);
-								glm::quat interpolatedRot = glm::slerp(channel.keyframes[i].rotation, channel.keyframes[i + 1].rotation, factor);
-								glm::vec3 interpolatedScale = glm::mix(channel.keyframes[i].scale, channel.keyframes[i + 1].scale, factor);
-
-								animTransform = glm::translate(glm::mat4(1.0f), interpolatedPos)
-									* glm::toMat4(interpolatedRot)
-									* glm::scale(glm::mat4(1.0f), interpolatedScale);
-								break;
-							}
-						}
-						break;
-					}
-				}
+	VkCommandBuffer command_buffer = begin_command_buffer(device, command_pool);
+	record_texture_upload(command_buffer, staging_buffer, 0, image, texture);
+	submit_command_buffer(device, command_pool, graphics_queue, command_buffer);
 
-				glm::mat4 combinedLocalTransform = animTransform;
-				glm::mat4 globalTransform = parentTransform * combinedLocalTransform;
+	vkDestroyBuffer(device, staging_buffer, nullptr);
+	vkFreeMemory(device, staging_buffer_memory, nullptr);
 
+	VkImageView image_view = create_image_view(device, image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, texture.mip_levels);
+	VkDescriptorSet descriptor_set = create_texture_descriptor_set(device, sampler_pool, sampler_descriptor_set_layout, sampler, image_view);
+	swap_texture(texture_index, image, image_view, memory, descriptor_set);
+	MarkoEngine::Texture_Streaming::get().set_resident(texture_index, texture_filename, texture);
+}
 
-				auto it = animation.bone_mapping.find(node->mName.C_Str());
-				if (it != animation.bone_mapping.end())
-				{
-					int boneIndex = it->second;
-					animation.final_bone_matrices[boneIndex] =
-						animation.global_inverse_transform * globalTransform * animation.bone_offset_matrices[boneIndex];
-				}
+void Renderer::trim_texture(uint32_t texture_index, uint32_t width, uint32_t height, uint32_t mip_levels, uint32_t drop_levels)
+{
+	if (drop_levels == 0 || drop_levels >= mip_levels)
+		return;
 
+	const uint32_t levels = mip_levels - drop_levels;
+	VkImage image = create_image(device, std::max(1u, width >> drop_levels), std::max(1u, height >> drop_levels), VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, levels);
+	VkDeviceMemory memory = allocate_image_memory(physical_device, device, image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-				for (unsigned int i = 0; i < node->mNumChildren; i++)
-				{
-					traverseNode(node->mChildren[i], globalTransform);
-				}
-			};
+	// The old image goes back to being sampled until it is retired, so later frames in flight still read it fine.
+	VkCommandBuffer command_buffer = begin_command_buffer(device, command_pool);
+	record_image_transition(command_buffer, texture_images[texture_index], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mip_levels);
+	record_image_transition(command_buffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levels);
+	std::vector<VkImageCopy> copies(levels);
+	for (uint32_t level = 0; level < levels; ++level)
+	{
+		VkImageCopy& copy = copies[level];
+		copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level + drop_levels, 0, 1 };
+		copy.srcOffset = { 0, 0, 0 };
+		copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		copy.dstOffset = { 0, 0, 0 };
+		copy.extent = { std::max(1u, width >> (level + drop_levels)), std::max(1u, height >> (level + drop_levels)), 1 };
+	}
+	vkCmdCopyImage(command_buffer, texture_images[texture_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(copies.size()), copies.data());
+	record_image_transition(command_buffer, texture_images[texture_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mip_levels);
+	record_image_transition(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, levels);
+	submit_command_buffer(device, command_pool, graphics_queue, command_buffer);
+
+	VkImageView image_view = create_image_view(device, image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, levels);
+	VkDescriptorSet descriptor_set = create_texture_descriptor_set(device, sampler_pool, sampler_descriptor_set_layout, sampler, image_view);
+	swap_texture(texture_index, image, image_view, memory, descriptor_set);
+}
+
+void Renderer::swap_texture(uint32_t texture_index, VkImage image, VkImageView image_view, VkDeviceMemory memory, VkDescriptorSet descriptor_set)
+{
+	// Meshes refer to the slot, not the image, so every mesh using the texture switches with this swap.
+	retire([this, old_image = texture_images[texture_index], old_view = texture_image_views[texture_index],
+		old_memory = texture_image_memories[texture_index], old_set = texture_descriptor_sets[texture_index]]()
+		{
+			vkFreeDescriptorSets(device, sampler_pool, 1, &old_set);
+			vkDestroyImageView(device, old_view, nullptr);
+			vkDestroyImage(device, old_image, nullptr);
+			vkFreeMemory(device, old_memory, nullptr);
+		});
+
+	texture_images[texture_index] = image;
+	texture_image_views[texture_index] = image_view;
+	texture_image_memories[texture_index] = memory;
+	texture_descriptor_sets[texture_index] = descriptor_set;
+}
+
+std::vector<std::string> Renderer::loaded_models() const
+{
+	std::vector<std::string> filenames;
+	for (const auto& [name, model] : models)
+		filenames.push_back(name.str());
+	return filenames;
+}
+
+std::vector<std::string> Renderer::loaded_animations() const
+{
+	std::vector<std::string> filenames;
+	for (const auto& [name, asset] : animation_assets)
+		filenames.push_back(name.str());
+	return filenames;
+}
+
+std::vector<std::string> Renderer::loaded_textures() const
+{
+	std::vector<std::string> filenames;
+	for (const auto& [name, index] : texture_indices)
+		filenames.push_back(name.str());
+	return filenames;
+}
 
+void Renderer::replace_assets(const Imported_Assets& assets, const std::unordered_map<std::string, Decoded_Texture>& textures)
+{
+	auto replace_textures = [this](const std::unordered_map<std::string, Decoded_Texture>& replacements)
+		{
+			for (const auto& [filename, texture] : replacements)
+			{
+				auto resident = texture_indices.find(MarkoEngine::Name::find(filename));
+				if (resident != texture_indices.end() && texture.pixels)
+					replace_texture(resident->second, filename, texture);
+			}
+		};
+	replace_textures(textures);
+	// A re-imported model brings its embedded textures along, and they keep the slots the first import gave them.
+	for (const Imported_Model& model : assets.models)
+		replace_textures(model.embedded_textures);
+	for (const Imported_Animation& animation : assets.animations)
+		replace_textures(animation.embedded_textures);
+
+	std::vector<const Imported_Mesh*> meshes;
+	for (const Imported_Model& model : assets.models)
+	{
+		if (!model.triangles)
+			continue;
+		for (const Imported_Mesh& mesh : model.meshes)
+			meshes.push_back(&mesh);
+	}
+	for (const Imported_Animation& animation : assets.animations)
+	{
+		if (!animation.asset)
+			continue;
+		for (const Imported_Mesh& mesh : animation.meshes)
+			meshes.push_back(&mesh);
+	}
+
+	const std::vector<Renderer_Mesh> renderer_meshes = upload_meshes(meshes, assets.textures);
+	auto next_mesh = renderer_meshes.begin();
+
+	// A failed import keeps the asset that is loaded, so a half-saved file never takes a model off screen.
+	for (size_t i = 0; i < assets.models.size(); ++i)
+	{
+		const Imported_Model& imported = assets.models[i];
+		if (!imported.triangles)
+			continue;
+
+		Renderer_Model& model = models[assets.model_filenames[i]];
+		retire_meshes(model.renderer_meshes);
+		model = { std::vector<Renderer_Mesh>(next_mesh, next_mesh + imported.meshes.size()), imported.bounds, imported.triangles };
+		next_mesh += imported.meshes.size();
+	}
+	for (size_t i = 0; i < assets.animations.size(); ++i)
+	{
+		const Imported_Animation& imported = assets.animations[i];
+		if (!imported.asset)
+			continue;
+
+		imported.asset->renderer_meshes.assign(next_mesh, next_mesh + imported.meshes.size());
+		next_mesh += imported.meshes.size();
+
+		std::shared_ptr<const Renderer_Animation_Asset>& asset = animation_assets[assets.animation_filenames[i]];
+		if (asset)
+			retire_meshes(asset->renderer_meshes);
+		asset = imported.asset;
+	}
+}
+
+bool Renderer::reload_shaders()
+{
+	// Pipelines cannot be destroyed while a frame in flight uses them, and shader edits are rare enough to wait for.
+	vkDeviceWaitIdle(device);
+
+	// Descriptor set layouts and pools stay, so the sets already allocated from them remain valid.
+	const std::array<VkPipeline*, 4> pipelines = { &graphics_pipeline, &grid_pipeline, &vertex_animation_pipeline, &skinning_pipeline };
+	const std::array<VkPipelineLayout*, 4> layouts = { &graphics_pipeline_layout, &grid_pipeline_layout, &vertex_animation_pipeline_layout, &skinning_pipeline_layout };
+
+	std::array<VkPipeline, 4> old_pipelines{};
+	std::array<VkPipelineLayout, 4> old_layouts{};
+	for (size_t i = 0; i < pipelines.size(); i++)
+	{
+		old_pipelines[i] = *pipelines[i];
+		old_layouts[i] = *layouts[i];
+		*pipelines[i] = VK_NULL_HANDLE;
+		*layouts[i] = VK_NULL_HANDLE;
+	}
+
+	try
+	{
+		create_vulkan_pipelines();
+		create_vulkan_vertex_animation_pipeline();
+		create_vulkan_skinning_pipeline();
+	}
+	catch (const std::exception& e)
+	{
+		// A shader that fails to load leaves the previous pipelines in place.
+		std::cerr << "shader reload failed: " << e.what() << std::endl;
+		for (size_t i = 0; i < pipelines.size(); i++)
+		{
+			vkDestroyPipeline(device, *pipelines[i], nullptr);
+			vkDestroyPipelineLayout(device, *layouts[i], nullptr);
+			*pipelines[i] = old_pipelines[i];
+			*layouts[i] = old_layouts[i];
+		}
+		return false;
+	}
+
+	for (size_t i = 0; i < pipelines.size(); i++)
+	{
+		// The crowd and skinning shaders are optional; one that went missing keeps its previous pipeline.
+		if (*pipelines[i] == VK_NULL_HANDLE)
+		{
+			vkDestroyPipelineLayout(device, *layouts[i], nullptr);
+			*pipelines[i] = old_pipelines[i];
+			*layouts[i] = old_layouts[i];
+			continue;
+		}
+
+		vkDestroyPipeline(device, old_pipelines[i], nullptr);
+		vkDestroyPipelineLayout(device, old_layouts[i], nullptr);
+	}
+	return true;
+}
+
+void Renderer::animate(Renderer_Animation& animation)
+{
+
+	if (animation.asset && !animation.asset->animations.empty())
+	{
+
+		const std::vector<Animation>& clips = animation.asset->animations;
+		float delta_time = MarkoEngine::Window::get().delta_time();
+
+		reset_pose(animation.pose, animation.asset->skeleton);
+
+		for (auto& layer : animation.layers)
+		{
+			if (!layer.active || layer.weight <= 0.0f)
+				continue;
+
+			const Animation& clip = clips[layer.current.clip];
+			advance_state(layer.current, clip, delta_time);
+
+			if (layer.additive)
+			{
+				apply_additive_pose(animation.pose, clip, layer.current, layer.weight);
+				continue;
+			}
+
+			if (layer.fade_time < layer.fade_duration)
+			{
+				if (layer.fade_source.empty())
+					advance_state(layer.previous, clips[layer.previous.clip], delta_time);
+				layer.fade_time += delta_time;
+			}
+
+			sample_layer(animation, layer);
+			blend_poses(animation.pose, animation.layer_pose, layer.weight);
+		}
+
+
+		for (size_t i = 0; i < animation.final_bone_matrices.size(); i++)
+		{
+			animation.final_bone_matrices[i] = glm::mat4(1.0f);
+		}
+
+
+		glm::mat4 correction = animation_correction();
+
+		compose_pose(animation, correction);
+
+
+		if (is_compute_skinned(animation))
+		{
+			size_t bone_count = std::min<size_t>(animation.final_bone_matrices.size(), animation.skinning.bone_count);
+			VkDeviceMemory bone_memory = skinning_bone_memories[animation.skinning.bone_buffer_indices[image_index]];
+
+			void* data;
+			vkMapMemory(device, bone_memory, 0, sizeof(glm::mat4) * bone_count, 0, &data);
+			memcpy(data, animation.final_bone_matrices.data(), sizeof(glm::mat4) * bone_count);
+			vkUnmapMemory(device, bone_memory);
+
+			VkCommandBuffer command_buffer = command_buffers[image_index];
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinning_pipeline);
+
+			const std::vector<Renderer_Mesh>& meshes = animation.asset->renderer_meshes;
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				VkDescriptorSet descriptor_set = skinning_descriptor_sets[animation.skinning.descriptor_set_indices[image_index * meshes.size() + i]];
+				vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinning_pipeline_layout, 0, 1, &descriptor_set, 0, nullptr);
+
+				std::array<uint32_t, 2> push_constants = { meshes[i].vertex_count, animation.skinning.bone_count };
+				vkCmdPushConstants(command_buffer, skinning_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants), push_constants.data());
+
+				vkCmdDispatch(command_buffer, (meshes[i].vertex_count + 63) / 64, 1, 1);
+			}
+			return;
+		}
 
-		traverseNode(animation.root_node, correction);
 
+		size_t bone_count = std::min<size_t>(animation.final_bone_matrices.size(), MAX_BONES);
 
 		void* data;
 		vkMapMemory(Renderer::get().device,
 			Renderer::get().animation_device_memories[Renderer::get().image_index],
 			0,
-			sizeof(glm::mat4) * animation.final_bone_matrices.size(),
+			sizeof(glm::mat4) * bone_count,
 			0,
 			&data);
-		memcpy(data, animation.final_bone_matrices.data(), sizeof(glm::mat4) * animation.final_bone_matrices.size());
+		memcpy(data, animation.final_bone_matrices.data(), sizeof(glm::mat4) * bone_count);
 		vkUnmapMemory(Renderer::get().device, Renderer::get().animation_device_memories[Renderer::get().image_index]);
 	}
+}
+
+bool Renderer::play_animation(Renderer_Animation& animation, std::string_view clip_name, float fade_duration, uint32_t layer, bool loop)
+{
+	if (!animation.asset || layer >= animation.layers.size())
+		return false;
 
+	const std::vector<Animation>& clips = animation.asset->animations;
+	auto clip = std::find_if(clips.begin(), clips.end(), [&](const Animation& candidate) { return candidate.name.hash() == MarkoEngine::hash_name(clip_name); });
+	if (clip == clips.end())
+		return false;
 
-	for (size_t i = 0; i < animation.renderer_meshes.size(); i++)
+	Animation_Layer& target = animation.layers[layer];
+	if (target.active && !target.additive && fade_duration > 0.0f && target.fade_time < target.fade_duration)
 	{
-		const Renderer_Mesh& mesh = animation.renderer_meshes[i];
-		std::array<VkBuffer, 1> vertex_buffers = { Renderer::get().vertex_buffers[mesh.vertex_buffer_index] };
+		// Starting over from either clip would pop, so the new fade starts from the pose the old one has reached.
+		sample_layer(animation, target);
+		target.fade_source = animation.layer_pose;
+		target.fade_duration = fade_duration;
+	}
+	else if (target.active && !target.additive && fade_duration > 0.0f)
+	{
+		std::swap(target.previous, target.current);
+		target.fade_source.clear();
+		target.fade_duration = fade_duration;
+	}
+	else
+	{
+		target.fade_source.clear();
+		target.fade_duration = 0.0f;
+	}
+
+	target.fade_time = 0.0f;
+	target.current.clip = static_cast<uint32_t>(std::distance(clips.begin(), clip));
+	target.current.time = 0.0f;
+	target.current.speed = 1.0f;
+	target.current.loop = loop;
+	std::fill(target.current.cursors.begin(), target.current.cursors.end(), 0);
+	target.active = true;
+
+	return true;
+}
+
+void Renderer::stop_animation(Renderer_Animation& animation, uint32_t layer)
+{
+	if (layer < animation.layers.size())
+		animation.layers[layer].active = false;
+}
+
+void Renderer::set_animation_layer(Renderer_Animation& animation, uint32_t layer, float weight, bool additive)
+{
+	if (layer >= animation.layers.size())
+		return;
+
+	animation.layers[layer].weight = glm::clamp(weight, 0.0f, 1.0f);
+	animation.layers[layer].additive = additive;
+}
+
+void Renderer::set_animation_speed(Renderer_Animation& animation, float speed, uint32_t layer)
+{
+	if (layer < animation.layers.size())
+		animation.layers[layer].current.speed = speed;
+}
+
+bool Renderer::is_compute_skinned(const Renderer_Animation& animation) const
+{
+	return skinning_mode == Skinning_Mode::COMPUTE
+		&& skinning_pipeline != VK_NULL_HANDLE
+		&& animation.asset
+		&& !animation.asset->animations.empty()
+		&& !animation.skinning.descriptor_set_indices.empty();
+}
+
+void Renderer::draw_animation(Renderer_Animation& animation)
+{
+	if (!animation.asset)
+		return;
+
+	bool compute_skinned = is_compute_skinned(animation);
+	size_t mesh_count = animation.asset->renderer_meshes.size();
+
+	for (size_t i = 0; i < mesh_count; i++)
+	{
+		const Renderer_Mesh& mesh = animation.asset->renderer_meshes[i];
+		std::array<VkBuffer, 1> vertex_buffers = { compute_skinned
+			? Renderer::get().skinning_output_buffers[animation.skinning.output_buffer_indices[Renderer::get().image_index * mesh_count + i]]
+			: Renderer::get().vertex_buffers[mesh.vertex_buffer_index] };
 		std::array<VkDeviceSize, 1> offsets = { 0 };
 
 		vkCmdBindVertexBuffers(Renderer::get().command_buffers[Renderer::get().image_index],
@@ -2417,22 +3767,15 @@ void Renderer::draw_animation(Renderer_Animation& animation)
 			descriptor_sets.data(), 0, nullptr);
 
 
-		transform t = animation.t;
-		glm::mat4 model_mat = glm::translate(glm::mat4(1.0f), t.position)
-			* glm::rotate(glm::mat4(1.0f), glm::radians(t.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f))
-			* glm::rotate(glm::mat4(1.0f), glm::radians(t.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f))
-			* glm::rotate(glm::mat4(1.0f), glm::radians(t.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f))
-			* glm::scale(glm::mat4(1.0f), t.scale);
-
-		glm::mat4 correction = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-		glm::mat4 correctedModelMat = correction * model_mat;
+		glm::mat4 correction = animation_correction();
+		glm::mat4 correctedModelMat = correction * animation.model;
 
 		struct PushConstants {
 			glm::mat4 model;
 			int isAnimated;
 		} pushConstants;
 		pushConstants.model = correctedModelMat;
-		pushConstants.isAnimated = 1;
+		pushConstants.isAnimated = compute_skinned ? 0 : 1;
 
 		vkCmdPushConstants(Renderer::get().command_buffers[Renderer::get().image_index],
 			Renderer::get().graphics_pipeline_layout,
@@ -2441,14 +3784,89 @@ void Renderer::draw_animation(Renderer_Animation& animation)
 
 		vkCmdDrawIndexed(Renderer::get().command_buffers[Renderer::get().image_index],
 			mesh.index_count, 1, 0, 0, 0);
+		MarkoEngine::Texture_Streaming::get().touch(mesh.texture_index, Renderer::get().draw_screen_size);
 	}
 }
 
-Renderer_Animation Renderer::create_animation(std::string animation_filename)
+Renderer_Animation Renderer::create_animation(std::string animation_filename, std::vector<std::vector<Vertex>>* mesh_vertices)
 {
 	Renderer_Animation result;
 
+	auto cached_asset = animation_assets.find(MarkoEngine::Name::find(animation_filename));
+	if (cached_asset != animation_assets.end() && mesh_vertices == nullptr)
+	{
+		result.asset = cached_asset->second;
+	}
+	else if (mesh_vertices == nullptr && MarkoEngine::Asset_Loader::get().running())
+	{
+		// Without an asset the animation neither animates nor draws until the loader reloads its objects.
+		MarkoEngine::Asset_Loader::get().request(MarkoEngine::Asset_Kind::animation, animation_filename);
+		return result;
+	}
+	else
+	{
+		std::shared_ptr<Renderer_Animation_Asset> asset = load_animation_asset(animation_filename, mesh_vertices);
+		if (!asset)
+			return result;
+
+		// A vertex animation bake uploads its own copy of the meshes and frees them when it is re-baked, so only
+		// the shared loads are cached.
+		if (mesh_vertices == nullptr)
+			animation_assets.emplace(animation_filename, asset);
+		result.asset = asset;
+	}
+
+	size_t channel_count = 0;
+	for (const auto& clip : result.asset->animations)
+		channel_count = std::max(channel_count, clip.boneAnimations.size());
+
+	result.layers.resize(MAX_ANIMATION_LAYERS);
+	for (auto& layer : result.layers)
+	{
+		layer.current.cursors.assign(channel_count, 0);
+		layer.previous.cursors.assign(channel_count, 0);
+	}
+	result.layers[0].active = !result.asset->animations.empty();
+
+	size_t node_count = result.asset->skeleton.nodes.size();
+	result.pose.assign(node_count, Joint_Pose());
+	result.layer_pose.assign(node_count, Joint_Pose());
+	result.fade_pose.assign(node_count, Joint_Pose());
+	result.node_transforms.assign(node_count, glm::mat4(1.0f));
+	result.final_bone_matrices.assign(result.asset->skeleton.bone_offset_matrices.size(), glm::mat4(1.0f));
+
+	std::cout << "Animation " << animation_filename << ": shared asset " << animation_asset_memory(*result.asset)
+		<< " bytes, instance " << animation_instance_memory(result) << " bytes" << std::endl;
+
+	return result;
+}
+
+std::shared_ptr<Renderer_Animation_Asset> Renderer::load_animation_asset(const std::string& animation_filename, std::vector<std::vector<Vertex>>* mesh_vertices)
+{
+	Imported_Animation imported = import_animation(animation_filename);
+	if (!imported.asset)
+		return nullptr;
+
+	std::vector<const Imported_Mesh*> meshes;
+	for (const Imported_Mesh& mesh : imported.meshes)
+	{
+		meshes.push_back(&mesh);
+		if (mesh_vertices != nullptr)
+			mesh_vertices->push_back(mesh.vertices);
+	}
+
+	imported.asset->renderer_meshes = upload_meshes(meshes, imported.embedded_textures);
+	return imported.asset;
+}
+
+Imported_Animation Renderer::import_animation_source(const std::string& animation_filename)
+{
+	Imported_Animation imported;
+	std::shared_ptr<Renderer_Animation_Asset> result = std::make_shared<Renderer_Animation_Asset>();
+	Renderer_Skeleton& skeleton = result->skeleton;
+
 	Assimp::Importer importer;
+	importer.SetIOHandler(new Archive_IO_System());
 
 	const aiScene* scene = importer.ReadFile(
 		animation_filename,
@@ -2458,12 +3876,33 @@ Renderer_Animation Renderer::create_animation(std::string animation_filename)
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
 		std::cerr << "Failed to load model: " << animation_filename << "!" << std::endl;
 
-		return result;
+		return imported;
 	}
 
 
-	result.scene = importer.GetOrphanedScene();
-	result.root_node = scene->mRootNode;
+	std::unordered_map<MarkoEngine::Name, int> node_mapping;
+	std::function<void(const aiNode*, int)> flatten_node = [&](const aiNode* node, int parent) {
+		int node_index = static_cast<int>(skeleton.nodes.size());
+		MarkoEngine::Name name(std::string_view(node->mName.C_Str(), node->mName.length));
+		aiVector3D scale;
+		aiQuaternion rotation;
+		aiVector3D position;
+		node->mTransformation.Decompose(scale, rotation, position);
+
+		Joint_Pose bind_pose;
+		bind_pose.position = glm::vec3(position.x, position.y, position.z);
+		bind_pose.rotation = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+		bind_pose.scale = glm::vec3(scale.x, scale.y, scale.z);
+
+		skeleton.nodes.push_back({ name, parent, -1, bind_pose });
+		node_mapping.emplace(name, node_index);
+
+		for (unsigned int i = 0; i < node->mNumChildren; i++) {
+			flatten_node(node->mChildren[i], node_index);
+		}
+		};
+
+	flatten_node(scene->mRootNode, -1);
 
 
 	aiMatrix4x4 rootMat = scene->mRootNode->mTransformation;
@@ -2473,7 +3912,7 @@ Renderer_Animation Renderer::create_animation(std::string animation_filename)
 	rootTransform[0][2] = rootMat.c1; rootTransform[1][2] = rootMat.c2; rootTransform[2][2] = rootMat.c3; rootTransform[3][2] = rootMat.c4;
 	rootTransform[0][3] = rootMat.d1; rootTransform[1][3] = rootMat.d2; rootTransform[2][3] = rootMat.d3; rootTransform[3][3] = rootMat.d4;
 
-	result.global_inverse_transform = glm::inverse(rootTransform);
+	skeleton.global_inverse_transform = glm::inverse(rootTransform);
 
 
 	std::filesystem::path file_path(animation_filename);
@@ -2490,7 +3929,8 @@ Renderer_Animation Renderer::create_animation(std::string animation_filename)
 			if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS) {
 				std::string texturePath = path.C_Str();
 				std::replace(texturePath.begin(), texturePath.end(), '\\', '/');
-				if (texturePath[0] != '*') {
+				texture_filenames[i] = import_embedded_texture(scene, animation_filename, path.C_Str(), imported.embedded_textures);
+				if (texture_filenames[i].empty() && !texturePath.empty() && texturePath[0] != '*') {
 
 					if (texturePath.find(".fbm") != std::string::npos) {
 						std::string textureFileName = texturePath.substr(texturePath.find(".fbm") + 5);
@@ -2501,129 +3941,43 @@ Renderer_Animation Renderer::create_animation(std::string animation_filename)
 					}
 					std::cout << "Texture path: " << texture_filenames[i] << std::endl;
 				}
-				else {
-
-					int texIndex = std::atoi(texturePath.c_str() + 1);
-					if (scene->HasTextures() && texIndex < scene->mNumTextures) {
-						aiTexture* embeddedTex = scene->mTextures[texIndex];
-						std::string textureFilename = directory_path + "/embedded_texture_" + std::to_string(i) + ".png";
-						FILE* file;
-#ifdef _MSC_VER
-						errno_t err = fopen_s(&file, textureFilename.c_str(), "wb");
-						if (err != 0 || !file) {
-							std::cerr << "Failed to open file for writing embedded texture!" << std::endl;
-							throw std::runtime_error("failed to load model");
-						}
-#else
-						file = fopen(textureFilename.c_str(), "wb");
-						if (!file) {
-							std::cerr << "Failed to open file for writing embedded texture!" << std::endl;
-							throw std::runtime_error("failed to load model");
-						}
-#endif
-						fwrite(embeddedTex->pcData, 1, embeddedTex->mWidth, file);
-						fclose(file);
-						texture_filenames[i] = textureFilename;
-					}
-				}
 			}
 		}
 	}
 
 
-	std::function<void(aiNode*)> processNode = [&](aiNode* node) {
+	const std::vector<const aiMesh*> meshes = MarkoEngine::collect_meshes(*scene);
 
-		for (size_t i = 0; i < node->mNumMeshes; i++) {
-			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+	// Bone ids are handed out in the order the meshes are reached, so only the weights are converted on the jobs.
+	std::vector<std::vector<int>> bone_ids(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++) {
+		const aiMesh* mesh = meshes[i];
+		for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+			aiBone* bone = mesh->mBones[b];
+			MarkoEngine::Name boneName(std::string_view(bone->mName.C_Str(), bone->mName.length));
+			int boneID = 0;
+			if (skeleton.bone_mapping.find(boneName) == skeleton.bone_mapping.end()) {
 
+				boneID = static_cast<int>(skeleton.bone_mapping.size());
+				skeleton.bone_mapping[boneName] = boneID;
 
-			std::vector<Vertex> vertices(mesh->mNumVertices);
-			std::vector<uint32_t> indices;
 
-
-			for (size_t j = 0; j < mesh->mNumVertices; j++) {
-				vertices[j].position = {
-					mesh->mVertices[j].x,
-					mesh->mVertices[j].y,
-					mesh->mVertices[j].z
-				};
-
-				if (mesh->mTextureCoords[0]) {
-					vertices[j].texture = {
-						mesh->mTextureCoords[0][j].x,
-						mesh->mTextureCoords[0][j].y
-					};
-				}
-				else {
-					vertices[j].texture = { 0.0f, 0.0f };
-				}
-
-
-				vertices[j].color = { 1.0f, 1.0f, 1.0f };
-			}
-
-
-			for (size_t j = 0; j < mesh->mNumFaces; j++) {
-				aiFace face = mesh->mFaces[j];
-				for (size_t k = 0; k < face.mNumIndices; k++) {
-					indices.push_back(face.mIndices[k]);
-				}
+				aiMatrix4x4 boneMat = bone->mOffsetMatrix;
+				glm::mat4 offsetMat;
+				offsetMat[0][0] = boneMat.a1; offsetMat[1][0] = boneMat.a2; offsetMat[2][0] = boneMat.a3; offsetMat[3][0] = boneMat.a4;
+				offsetMat[0][1] = boneMat.b1; offsetMat[1][1] = boneMat.b2; offsetMat[2][1] = boneMat.b3; offsetMat[3][1] = boneMat.b4;
+				offsetMat[0][2] = boneMat.c1; offsetMat[1][2] = boneMat.c2; offsetMat[2][2] = boneMat.c3; offsetMat[3][2] = boneMat.c4;
+				offsetMat[0][3] = boneMat.d1; offsetMat[1][3] = boneMat.d2; offsetMat[2][3] = boneMat.d3; offsetMat[3][3] = boneMat.d4;
+				skeleton.bone_offset_matrices.push_back(offsetMat);
 			}
-
-
-			if (mesh->HasBones()) {
-				for (unsigned int b = 0; b < mesh->mNumBones; b++) {
-					aiBone* bone = mesh->mBones[b];
-					std::string boneName(bone->mName.C_Str());
-					int boneID = 0;
-					if (result.bone_mapping.find(boneName) == result.bone_mapping.end()) {
-
-						boneID = static_cast<int>(result.bone_mapping.size());
-						result.bone_mapping[boneName] = boneID;
-
-
-						aiMatrix4x4 boneMat = bone->mOffsetMatrix;
-						glm::mat4 offsetMat;
-						offsetMat[0][0] = boneMat.a1; offsetMat[1][0] = boneMat.a2; offsetMat[2][0] = boneMat.a3; offsetMat[3][0] = boneMat.a4;
-						offsetMat[0][1] = boneMat.b1; offsetMat[1][1] = boneMat.b2; offsetMat[2][1] = boneMat.b3; offsetMat[3][1] = boneMat.b4;
-						offsetMat[0][2] = boneMat.c1; offsetMat[1][2] = boneMat.c2; offsetMat[2][2] = boneMat.c3; offsetMat[3][2] = boneMat.c4;
-						offsetMat[0][3] = boneMat.d1; offsetMat[1][3] = boneMat.d2; offsetMat[2][3] = boneMat.d3; offsetMat[3][3] = boneMat.d4;
-						result.bone_offset_matrices.push_back(offsetMat);
-					}
-					else {
-						boneID = result.bone_mapping[boneName];
-					}
-
-
-					for (unsigned int w = 0; w < bone->mNumWeights; w++) {
-						unsigned int vertexID = bone->mWeights[w].mVertexId;
-						float weight = bone->mWeights[w].mWeight;
-
-				
-						for (int slot = 0; slot < 4; slot++) {
-							if (vertices[vertexID].weights[slot] == 0.0f) {
-								vertices[vertexID].bone_ids[slot] = boneID;
-								vertices[vertexID].weights[slot] = weight;
-								break;
-							}
-						}
-					}
-				}
+			else {
+				boneID = skeleton.bone_mapping[boneName];
 			}
-
-
-			std::string texture_filename = texture_filenames[mesh->mMaterialIndex];
-			Renderer_Mesh new_renderer_mesh = create_mesh(texture_filename, vertices, indices);
-			result.renderer_meshes.push_back(new_renderer_mesh);
-		}
-
-		for (size_t i = 0; i < node->mNumChildren; i++) {
-			processNode(node->mChildren[i]);
+			bone_ids[i].push_back(boneID);
 		}
-		};
-
+	}
 
-	processNode(scene->mRootNode);
+	MarkoEngine::convert_meshes(meshes, texture_filenames, &bone_ids, imported.meshes, result->bounds);
 
 	if (scene->HasAnimations()) {
 		for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
@@ -2639,7 +3993,9 @@ Renderer_Animation Renderer::create_animation(std::string animation_filename)
 			for (unsigned int j = 0; j < anim->mNumChannels; j++) {
 				aiNodeAnim* nodeAnim = anim->mChannels[j];
 				BoneAnimation boneAnim;
-				boneAnim.boneName = nodeAnim->mNodeName.C_Str();
+				boneAnim.boneName = std::string_view(nodeAnim->mNodeName.C_Str(), nodeAnim->mNodeName.length);
+				auto node = node_mapping.find(boneAnim.boneName);
+				boneAnim.node_index = node != node_mapping.end() ? node->second : -1;
 				unsigned int numKeys = nodeAnim->mNumPositionKeys;
 				for (unsigned int k = 0; k < numKeys; k++) {
 					Keyframe frame;
@@ -2660,12 +4016,396 @@ Renderer_Animation Renderer::create_animation(std::string animation_filename)
 				}
 				animation.boneAnimations.push_back(boneAnim);
 			}
-			result.animations.push_back(animation);
+			result->animations.push_back(animation);
 		}
 	}
 
 
-	result.final_bone_matrices.resize(result.bone_offset_matrices.size(), glm::mat4(1.0f));
+	for (auto& node : skeleton.nodes)
+	{
+		auto bone = skeleton.bone_mapping.find(node.name);
+		if (bone != skeleton.bone_mapping.end())
+			node.bone_index = bone->second;
+	}
+
+	imported.asset = result;
+	return imported;
+}
+
+void Renderer::draw_vertex_animation(Renderer_Vertex_Animation& animation, Renderer_Crowd& crowd, const glm::mat4& model)
+{
+	if (vertex_animation_pipeline == VK_NULL_HANDLE || animation.renderer_meshes.empty() || crowd.instance_count == 0)
+		return;
+
+	VkCommandBuffer command_buffer = command_buffers[image_index];
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vertex_animation_pipeline);
+
+	struct PushConstants {
+		glm::mat4 model;
+		float time;
+		float frames_per_second;
+		uint32_t vertex_offset;
+		uint32_t vertex_count;
+		uint32_t texture_width;
+	} push_constants;
+
+	glm::mat4 correction = animation_correction();
+	push_constants.model = correction * model;
+	push_constants.time = static_cast<float>(glfwGetTime());
+	push_constants.frames_per_second = animation.frames_per_second;
+	push_constants.vertex_count = animation.vertex_count;
+	push_constants.texture_width = animation.texture_width;
+
+	for (size_t i = 0; i < animation.renderer_meshes.size(); i++)
+	{
+		const Renderer_Mesh& mesh = animation.renderer_meshes[i];
+
+		std::array<VkBuffer, 2> buffers = { vertex_buffers[mesh.vertex_buffer_index], vertex_buffers[crowd.instance_buffer_index] };
+		std::array<VkDeviceSize, 2> offsets = { 0, 0 };
+
+		vkCmdBindVertexBuffers(command_buffer, 0, static_cast<uint32_t>(buffers.size()), buffers.data(), offsets.data());
+		vkCmdBindIndexBuffer(command_buffer, index_buffers[mesh.index_buffer_index], 0, VK_INDEX_TYPE_UINT32);
+
+		std::array<VkDescriptorSet, 3> descriptor_sets = {
+			uniform_descriptor_sets[current_frame],
+			texture_descriptor_sets[mesh.texture_index],
+			vertex_animation_descriptor_sets[animation.texture_index]
+		};
+
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vertex_animation_pipeline_layout,
+			0, static_cast<uint32_t>(descriptor_sets.size()), descriptor_sets.data(), 0, nullptr);
+
+		push_constants.vertex_offset = animation.vertex_offsets[i];
+
+		vkCmdPushConstants(command_buffer, vertex_animation_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT,
+			0, sizeof(PushConstants), &push_constants);
+
+		vkCmdDrawIndexed(command_buffer, mesh.index_count, crowd.instance_count, 0, 0, 0);
+	}
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+}
+
+Renderer_Vertex_Animation Renderer::create_vertex_animation(std::string animation_filename, float frames_per_second)
+{
+	Renderer_Vertex_Animation result;
+
+	if (vertex_animation_pipeline == VK_NULL_HANDLE)
+		return result;
+
+	std::vector<std::vector<Vertex>> mesh_vertices;
+	Renderer_Animation animation = create_animation(animation_filename, &mesh_vertices);
+	if (!animation.asset || animation.asset->renderer_meshes.empty() || animation.asset->animations.empty())
+	{
+		std::cerr << "Failed to bake vertex animation: " << animation_filename << "!" << std::endl;
+		if (animation.asset)
+			retire_meshes(animation.asset->renderer_meshes);
+		return result;
+	}
+
+	uint32_t vertex_count = 0;
+	for (auto& vertices : mesh_vertices)
+	{
+		result.vertex_offsets.push_back(vertex_count);
+		vertex_count += static_cast<uint32_t>(vertices.size());
+	}
+
+	uint32_t frame_count = 0;
+	for (auto& clip : animation.asset->animations)
+	{
+		float seconds = clip.duration / clip.ticksPerSecond;
+		uint32_t frames = std::max(1u, static_cast<uint32_t>(std::ceil(seconds * frames_per_second)));
+		result.clips.push_back({ clip.name.str(), frame_count, frames });
+		frame_count += frames;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+	uint64_t texel_count = static_cast<uint64_t>(frame_count) * vertex_count;
+	uint32_t texture_width = static_cast<uint32_t>(std::min<uint64_t>(texel_count, std::min(4096u, properties.limits.maxImageDimension2D)));
+	uint32_t texture_height = static_cast<uint32_t>((texel_count + texture_width - 1) / texture_width);
+
+	if (texture_height > properties.limits.maxImageDimension2D)
+	{
+		std::cerr << "Vertex animation is too large to bake: " << animation_filename << "!" << std::endl;
+		retire_meshes(animation.asset->renderer_meshes);
+		return Renderer_Vertex_Animation();
+	}
+
+	std::vector<glm::vec4> texels(static_cast<size_t>(texture_width) * texture_height, glm::vec4(0.0f));
+
+	glm::mat4 correction = animation_correction();
+	for (size_t c = 0; c < animation.asset->animations.size(); c++)
+	{
+		const Animation& clip = animation.asset->animations[c];
+		for (uint32_t f = 0; f < result.clips[c].frame_count; f++)
+		{
+			AnimationState& state = animation.layers[0].current;
+			state.time = std::fmod(f / frames_per_second * clip.ticksPerSecond, clip.duration);
+
+			std::fill(animation.final_bone_matrices.begin(), animation.final_bone_matrices.end(), glm::mat4(1.0f));
+			sample_pose(animation.pose, animation.asset->skeleton, clip, state);
+			compose_pose(animation, correction);
+
+			size_t frame_offset = static_cast<size_t>(result.clips[c].first_frame + f) * vertex_count;
+			for (size_t m = 0; m < mesh_vertices.size(); m++)
+			{
+				for (size_t v = 0; v < mesh_vertices[m].size(); v++)
+				{
+					const Vertex& vertex = mesh_vertices[m][v];
+					glm::vec4 position = glm::vec4(vertex.position, 1.0f);
+
+					float total_weight = vertex.weights.x + vertex.weights.y + vertex.weights.z + vertex.weights.w;
+					if (total_weight > 0.0f)
+					{
+						glm::mat4 skin_matrix = glm::mat4(0.0f);
+						for (int k = 0; k < 4; k++)
+						{
+							if (vertex.weights[k] > 0.0f)
+								skin_matrix += vertex.weights[k] * animation.final_bone_matrices[vertex.bone_ids[k]];
+						}
+						position = skin_matrix * position;
+					}
+
+					texels[frame_offset + result.vertex_offsets[m] + v] = glm::vec4(glm::vec3(position), 1.0f);
+					result.bounds.extend(glm::vec3(position));
+				}
+			}
+		}
+	}
+
+	VkDeviceSize image_size = sizeof(glm::vec4) * texels.size();
+	VkBuffer staging_buffer = create_buffer(device, image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	VkDeviceMemory staging_buffer_memory = allocate_buffer_memory(physical_device, device, staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	void* data;
+	vkMapMemory(device, staging_buffer_memory, 0, image_size, 0, &data);
+	memcpy(data, texels.data(), static_cast<size_t>(image_size));
+	vkUnmapMemory(device, staging_buffer_memory);
+
+	VkImage image = create_image(device, texture_width, texture_height, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	VkDeviceMemory image_memory = allocate_image_memory(physical_device, device, image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	transition_image_layout(device, graphics_queue, command_pool, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	copy_buffer_to_image(device, graphics_queue, command_pool, staging_buffer, image, texture_width, texture_height);
+	transition_image_layout(device, graphics_queue, command_pool, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	vkDestroyBuffer(device, staging_buffer, nullptr);
+	vkFreeMemory(device, staging_buffer_memory, nullptr);
+
+	VkImageView image_view = create_image_view(device, image, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	VkDescriptorSet descriptor_set;
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.descriptorPool = sampler_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &vertex_animation_descriptor_set_layout;
+
+	check_vulkan_result(vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &descriptor_set), "failed to create a descriptor set!");
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.sampler = vertex_animation_sampler;
+	image_info.imageView = image_view;
+	image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet write_descriptor_set = {};
+	write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_set.dstSet = descriptor_set;
+	write_descriptor_set.dstBinding = 0;
+	write_descriptor_set.dstArrayElement = 0;
+	write_descriptor_set.descriptorCount = 1;
+	write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write_descriptor_set.pImageInfo = &image_info;
+
+	vkUpdateDescriptorSets(device, 1, &write_descriptor_set, 0, nullptr);
+
+	vertex_animation_images.push_back(image);
+	vertex_animation_image_views.push_back(image_view);
+	vertex_animation_image_memories.push_back(image_memory);
+	vertex_animation_descriptor_sets.push_back(descriptor_set);
+
+	result.renderer_meshes = animation.asset->renderer_meshes;
+	result.texture_index = static_cast<uint32_t>(vertex_animation_descriptor_sets.size() - 1);
+	result.vertex_count = vertex_count;
+	result.texture_width = texture_width;
+	result.frames_per_second = frames_per_second;
+
+	return result;
+}
+
+Renderer_Crowd Renderer::create_crowd(std::vector<Vertex_Animation_Instance>& instances)
+{
+	Renderer_Crowd result{};
+	if (instances.empty())
+		return result;
+
+	VkDeviceSize buffer_size = sizeof(Vertex_Animation_Instance) * instances.size();
+	VkBuffer staging_buffer = create_buffer(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	VkDeviceMemory staging_buffer_memory = allocate_buffer_memory(physical_device, device, staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	void* data;
+	vkMapMemory(device, staging_buffer_memory, 0, buffer_size, 0, &data);
+	memcpy(data, instances.data(), static_cast<size_t>(buffer_size));
+	vkUnmapMemory(device, staging_buffer_memory);
+
+	VkBuffer instance_buffer = create_buffer(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	VkDeviceMemory instance_buffer_memory = allocate_buffer_memory(physical_device, device, instance_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	copy_buffer(device, graphics_queue, command_pool, staging_buffer, instance_buffer, buffer_size);
+
+	vkDestroyBuffer(device, staging_buffer, nullptr);
+	vkFreeMemory(device, staging_buffer_memory, nullptr);
+
+	result.instance_buffer_index = static_cast<uint32_t>(vertex_buffers.size());
+	result.instance_count = static_cast<uint32_t>(instances.size());
+	vertex_buffers.push_back(instance_buffer);
+	vertex_buffer_memories.push_back(instance_buffer_memory);
+
+	return result;
+}
+
+void Renderer::retire_vertex_animation(const Renderer_Vertex_Animation& animation)
+{
+	if (animation.renderer_meshes.empty())
+		return;
+
+	retire_meshes(animation.renderer_meshes);
+
+	const uint32_t texture_index = animation.texture_index;
+	retire([this, texture_index]()
+		{
+			vkFreeDescriptorSets(device, sampler_pool, 1, &vertex_animation_descriptor_sets[texture_index]);
+			vkDestroyImageView(device, vertex_animation_image_views[texture_index], nullptr);
+			vkDestroyImage(device, vertex_animation_images[texture_index], nullptr);
+			vkFreeMemory(device, vertex_animation_image_memories[texture_index], nullptr);
+			vertex_animation_descriptor_sets[texture_index] = VK_NULL_HANDLE;
+			vertex_animation_image_views[texture_index] = VK_NULL_HANDLE;
+			vertex_animation_images[texture_index] = VK_NULL_HANDLE;
+			vertex_animation_image_memories[texture_index] = VK_NULL_HANDLE;
+		});
+}
+
+void Renderer::retire_crowd(const Renderer_Crowd& crowd)
+{
+	if (crowd.instance_count == 0)
+		return;
+
+	const uint32_t instance_index = crowd.instance_buffer_index;
+	retire([this, instance_index]()
+		{
+			vkDestroyBuffer(device, vertex_buffers[instance_index], nullptr);
+			vkFreeMemory(device, vertex_buffer_memories[instance_index], nullptr);
+			vertex_buffers[instance_index] = VK_NULL_HANDLE;
+			vertex_buffer_memories[instance_index] = VK_NULL_HANDLE;
+		});
+}
+
+void Renderer::destroy_skinning(const Renderer_Skinning& skinning)
+{
+	for (uint32_t index : skinning.descriptor_set_indices)
+	{
+		vkFreeDescriptorSets(device, skinning_descriptor_pool, 1, &skinning_descriptor_sets[index]);
+		skinning_descriptor_sets[index] = VK_NULL_HANDLE;
+	}
+
+	for (uint32_t index : skinning.output_buffer_indices)
+	{
+		vkDestroyBuffer(device, skinning_output_buffers[index], nullptr);
+		vkFreeMemory(device, skinning_output_memories[index], nullptr);
+		skinning_output_buffers[index] = VK_NULL_HANDLE;
+		skinning_output_memories[index] = VK_NULL_HANDLE;
+	}
+
+	for (uint32_t index : skinning.bone_buffer_indices)
+	{
+		vkDestroyBuffer(device, skinning_bone_buffers[index], nullptr);
+		vkFreeMemory(device, skinning_bone_memories[index], nullptr);
+		skinning_bone_buffers[index] = VK_NULL_HANDLE;
+		skinning_bone_memories[index] = VK_NULL_HANDLE;
+	}
+}
+
+void Renderer::retire_skinning(const Renderer_Skinning& skinning)
+{
+	if (skinning.descriptor_set_indices.empty() && skinning.bone_buffer_indices.empty())
+		return;
+
+	retire([this, skinning]() { destroy_skinning(skinning); });
+}
+
+glm::mat4 Renderer::animation_correction()
+{
+	return glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+}
+
+Renderer_Skinning Renderer::create_skinning(Renderer_Animation& animation)
+{
+	Renderer_Skinning result;
+	if (skinning_pipeline == VK_NULL_HANDLE || !animation.asset || animation.asset->renderer_meshes.empty())
+		return result;
+
+	result.bone_count = std::max<uint32_t>(1, static_cast<uint32_t>(animation.asset->skeleton.bone_offset_matrices.size()));
+	VkDeviceSize bone_buffer_size = sizeof(glm::mat4) * result.bone_count;
+
+	for (size_t image = 0; image < command_buffers.size(); image++)
+	{
+		VkBuffer bone_buffer = create_buffer(device, bone_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		VkDeviceMemory bone_memory = allocate_buffer_memory(physical_device, device, bone_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		result.bone_buffer_indices.push_back(static_cast<uint32_t>(skinning_bone_buffers.size()));
+		skinning_bone_buffers.push_back(bone_buffer);
+		skinning_bone_memories.push_back(bone_memory);
+
+		for (auto& mesh : animation.asset->renderer_meshes)
+		{
+			VkDeviceSize output_buffer_size = sizeof(Vertex) * mesh.vertex_count;
+			VkBuffer output_buffer = create_buffer(device, output_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+			VkDeviceMemory output_memory = allocate_buffer_memory(physical_device, device, output_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			result.output_buffer_indices.push_back(static_cast<uint32_t>(skinning_output_buffers.size()));
+			skinning_output_buffers.push_back(output_buffer);
+			skinning_output_memories.push_back(output_memory);
+
+			VkDescriptorSet descriptor_set;
+			VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+			descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			descriptor_set_allocate_info.descriptorPool = skinning_descriptor_pool;
+			descriptor_set_allocate_info.descriptorSetCount = 1;
+			descriptor_set_allocate_info.pSetLayouts = &skinning_descriptor_set_layout;
+
+			if (vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &descriptor_set) != VK_SUCCESS)
+			{
+				std::cerr << "Out of skinning descriptor sets, falling back to vertex shader skinning!" << std::endl;
+				// Nothing has recorded these yet, so they can go right away.
+				destroy_skinning(result);
+				return Renderer_Skinning();
+			}
+
+			std::array<VkDescriptorBufferInfo, 3> buffer_infos = { {
+				{ vertex_buffers[mesh.vertex_buffer_index], 0, output_buffer_size },
+				{ bone_buffer, 0, bone_buffer_size },
+				{ output_buffer, 0, output_buffer_size }
+			} };
+
+			std::array<VkWriteDescriptorSet, 3> descriptor_writes{};
+			for (uint32_t i = 0; i < descriptor_writes.size(); i++)
+			{
+				descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptor_writes[i].dstSet = descriptor_set;
+				descriptor_writes[i].dstBinding = i;
+				descriptor_writes[i].descriptorCount = 1;
+				descriptor_writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				descriptor_writes[i].pBufferInfo = &buffer_infos[i];
+			}
+
+			vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptor_writes.size()), descriptor_writes.data(), 0, nullptr);
+
+			result.descriptor_set_indices.push_back(static_cast<uint32_t>(skinning_descriptor_sets.size()));
+			skinning_descriptor_sets.push_back(descriptor_set);
+		}
+	}
 
 	return result;
 }
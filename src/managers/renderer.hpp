@@ -5,11 +5,14 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <string>
+#include <string_view>
+#include <functional>
 #include <glm/gtc/quaternion.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "../game_objects/i_game_object.hpp"
+#include "jobs.hpp"
 
 struct Vertex
 {
@@ -31,14 +34,14 @@ struct Keyframe
 
 struct BoneAnimation
 {
-	std::string boneName;
-
+	MarkoEngine::Name boneName;
+	int node_index = -1;
 	std::vector<Keyframe> keyframes;
 };
 
 struct Animation
 {
-	std::string name;
+	MarkoEngine::Name name;
 	float duration;
 	float ticksPerSecond;
 	std::vector<BoneAnimation> boneAnimations;
@@ -60,20 +63,168 @@ struct Renderer_Mesh
 struct Renderer_Model
 {
 	std::vector<Renderer_Mesh> renderer_meshes;
+	MarkoEngine::Aabb bounds;
+	std::shared_ptr<const MarkoEngine::Triangle_Mesh> triangles;
 };
 
-struct Renderer_Animation
+// CPU side of an asset, produced on worker threads and uploaded later on the main thread.
+struct Decoded_Texture
 {
-	std::vector<Renderer_Mesh> renderer_meshes;
-	std::vector<Animation> animations;
-	std::unordered_map<std::string, int> bone_mapping;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::shared_ptr<const uint8_t> pixels;
+	// With more than one level, pixels holds the chain level after level; width and height are those of first_mip.
+	uint32_t first_mip = 0;
+	uint32_t mip_levels = 1;
+	// Size of level 0, which odd sizes do not give back from a cut chain; left 0 for a texture decoded whole.
+	uint32_t source_width = 0;
+	uint32_t source_height = 0;
+};
+
+struct Imported_Mesh
+{
+	std::string texture_filename;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+};
+
+struct Imported_Model
+{
+	std::vector<Imported_Mesh> meshes;
+	MarkoEngine::Aabb bounds;
+	// Null when the import failed.
+	std::shared_ptr<MarkoEngine::Triangle_Mesh> triangles;
+	// Textures stored inside the source file, decoded by the import under the names its meshes use.
+	std::unordered_map<std::string, Decoded_Texture> embedded_textures;
+};
+
+struct Renderer_Skinning
+{
+	std::vector<uint32_t> output_buffer_indices;
+	std::vector<uint32_t> bone_buffer_indices;
+	std::vector<uint32_t> descriptor_set_indices;
+	uint32_t bone_count = 0;
+};
+
+enum class Skinning_Mode
+{
+	VERTEX_SHADER,
+	COMPUTE
+};
+
+struct Joint_Pose
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+};
+
+struct Skeleton_Node
+{
+	MarkoEngine::Name name;
+	int parent = -1;
+	int bone_index = -1;
+	// The node's local transform in the file; joints a clip has no channel for stay here.
+	Joint_Pose bind_pose;
+};
+
+struct Renderer_Skeleton
+{
+	std::vector<Skeleton_Node> nodes;
+	std::unordered_map<MarkoEngine::Name, int> bone_mapping;
 	std::vector<glm::mat4> bone_offset_matrices;
-	const aiScene* scene;
-	aiNode* root_node;
 	glm::mat4 global_inverse_transform;
-	float current_animation_time = 0.0f;
+};
+
+struct Renderer_Animation_Asset
+{
+	std::vector<Renderer_Mesh> renderer_meshes;
+	Renderer_Skeleton skeleton;
+	std::vector<Animation> animations;
+	MarkoEngine::Aabb bounds;
+};
+
+struct Imported_Animation
+{
+	// Null when the import failed; renderer_meshes is filled by the upload.
+	std::shared_ptr<Renderer_Animation_Asset> asset;
+	std::vector<Imported_Mesh> meshes;
+	std::unordered_map<std::string, Decoded_Texture> embedded_textures;
+};
+
+struct Imported_Assets
+{
+	std::vector<std::string> model_filenames;
+	std::vector<Imported_Model> models;
+	std::vector<std::string> animation_filenames;
+	std::vector<Imported_Animation> animations;
+	std::unordered_map<std::string, Decoded_Texture> textures;
+};
+
+struct AnimationState
+{
+	uint32_t clip = 0;
+	float time = 0.0f;
+	float speed = 1.0f;
+	bool loop = true;
+	std::vector<uint32_t> cursors;
+};
+
+struct Animation_Layer
+{
+	AnimationState current;
+	AnimationState previous;
+	float fade_duration = 0.0f;
+	float fade_time = 0.0f;
+	// Set when a fade interrupts another one: the blended pose on screen at that moment, faded from instead of previous.
+	std::vector<Joint_Pose> fade_source;
+	float weight = 1.0f;
+	bool additive = false;
+	bool active = false;
+};
+
+struct Renderer_Animation
+{
+	std::shared_ptr<const Renderer_Animation_Asset> asset;
+	std::vector<Animation_Layer> layers;
+	std::vector<Joint_Pose> pose;
+	std::vector<Joint_Pose> layer_pose;
+	std::vector<Joint_Pose> fade_pose;
+	std::vector<glm::mat4> node_transforms;
 	std::vector<glm::mat4> final_bone_matrices;
-	transform t;
+	glm::mat4 model{ 1.0f };
+	Renderer_Skinning skinning;
+};
+
+struct Vertex_Animation_Clip
+{
+	std::string name;
+	uint32_t first_frame;
+	uint32_t frame_count;
+};
+
+struct Vertex_Animation_Instance
+{
+	glm::mat4 model;
+	glm::vec4 animation;
+};
+
+struct Renderer_Vertex_Animation
+{
+	std::vector<Renderer_Mesh> renderer_meshes;
+	std::vector<uint32_t> vertex_offsets;
+	std::vector<Vertex_Animation_Clip> clips;
+	uint32_t texture_index;
+	uint32_t vertex_count;
+	uint32_t texture_width;
+	float frames_per_second;
+	MarkoEngine::Aabb bounds;
+};
+
+struct Renderer_Crowd
+{
+	uint32_t instance_buffer_index;
+	uint32_t instance_count;
 };
 
 struct Renderer_Gui_Texture
@@ -113,11 +264,28 @@ private:
 	void create_vulkan_renderpass();
 	void create_vulkan_descriptor_resources();
 	void create_vulkan_pipelines();
+	void create_vulkan_framebuffers();
+	void create_vulkan_vertex_animation_pipeline();
+	void create_vulkan_skinning_pipeline();
+	void create_vulkan_timestamp_queries();
+	[[nodiscard]] bool is_compute_skinned(const Renderer_Animation& animation) const;
+	[[nodiscard]] std::shared_ptr<Renderer_Animation_Asset> load_animation_asset(const std::string& animation_filename, std::vector<std::vector<Vertex>>* mesh_vertices);
+	[[nodiscard]] std::vector<Renderer_Mesh> upload_meshes(const std::vector<const Imported_Mesh*>& meshes, const std::unordered_map<std::string, Decoded_Texture>& decoded_textures);
+	void replace_texture(uint32_t texture_index, const std::string& texture_filename, const Decoded_Texture& decoded);
+	void swap_texture(uint32_t texture_index, VkImage image, VkImageView image_view, VkDeviceMemory memory, VkDescriptorSet descriptor_set);
+	void retire_meshes(const std::vector<Renderer_Mesh>& meshes);
+	void destroy_skinning(const Renderer_Skinning& skinning);
+	// Destroys the resources once every frame that could still be reading them has finished.
+	void retire(std::function<void()> destroy);
+	void destroy_retired_resources(bool all);
 	void create_vulkan_command_buffers();
 	void create_vulkan_synchronization();
 	void create_imgui_instance();
 	const uint32_t MAX_FRAMES = 2;
 	const uint32_t MAX_TEXTURE_DESCRIPTORS = 1000;
+	const uint32_t MAX_SKINNING_DESCRIPTORS = 1000;
+	const uint32_t MAX_BONES = 100;
+	const uint32_t MAX_ANIMATION_LAYERS = 4;
 	VkInstance instance {};
 	VkDebugUtilsMessengerEXT debug_messenger {};
 	VkSurfaceKHR surface {};
@@ -157,6 +325,29 @@ private:
 	VkPipeline graphics_pipeline {};
 	VkPipelineLayout grid_pipeline_layout {};
 	VkPipeline grid_pipeline {};
+	VkDescriptorSetLayout vertex_animation_descriptor_set_layout {};
+	VkPipelineLayout vertex_animation_pipeline_layout {};
+	VkPipeline vertex_animation_pipeline {};
+	VkSampler vertex_animation_sampler {};
+	std::vector<VkImage> vertex_animation_images {};
+	std::vector<VkImageView> vertex_animation_image_views {};
+	std::vector<VkDeviceMemory> vertex_animation_image_memories {};
+	std::vector<VkDescriptorSet> vertex_animation_descriptor_sets {};
+	VkDescriptorSetLayout skinning_descriptor_set_layout {};
+	VkPipelineLayout skinning_pipeline_layout {};
+	VkPipeline skinning_pipeline {};
+	VkDescriptorPool skinning_descriptor_pool {};
+	std::vector<VkBuffer> skinning_output_buffers {};
+	std::vector<VkDeviceMemory> skinning_output_memories {};
+	std::vector<VkBuffer> skinning_bone_buffers {};
+	std::vector<VkDeviceMemory> skinning_bone_memories {};
+	std::vector<VkDescriptorSet> skinning_descriptor_sets {};
+	VkQueryPool timestamp_query_pool {};
+	float timestamp_period = 0.0f;
+	std::vector<bool> timestamps_written {};
+	std::unordered_map<MarkoEngine::Name, std::shared_ptr<const Renderer_Animation_Asset>> animation_assets {};
+	std::unordered_map<MarkoEngine::Name, Renderer_Model> models {};
+	std::unordered_map<MarkoEngine::Name, uint32_t> texture_indices {};
 	VkImage depth_image {};
 	VkImageView	depth_view {};
 	VkDeviceMemory depth_device_memory {};
@@ -169,16 +360,75 @@ private:
 	VkDescriptorPool imgui_descriptor_pool {};
 	uint32_t image_index = 0;
 	uint32_t current_frame = 0;
+	uint64_t frame_count = 0;
+	std::vector<std::pair<uint64_t, std::function<void()>>> retired_resources {};
+	// Longest side in pixels of the object being drawn, for texture streaming.
+	float draw_screen_size = 0.0f;
 
 public: 
 	void draw_mesh(Renderer_Mesh& mesh);
-	[[nodiscard]] Renderer_Mesh create_mesh(std::string texture_filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+	[[nodiscard]] Renderer_Mesh create_mesh(std::string texture_filename, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
 
 	void draw_model(Renderer_Model& model);
 	[[nodiscard]] Renderer_Model create_model(std::string model_filename);
 
+	// Thread safe; nothing here touches Vulkan. The import and decode functions read the cooked file when the asset
+	// database says it is current and otherwise go through Assimp or stb and cook the result for the next load.
+	[[nodiscard]] static Imported_Model import_model(const std::string& model_filename);
+	[[nodiscard]] static Imported_Animation import_animation(const std::string& animation_filename);
+	[[nodiscard]] static Imported_Model import_model_source(const std::string& model_filename);
+	[[nodiscard]] static Imported_Animation import_animation_source(const std::string& animation_filename);
+	[[nodiscard]] static Decoded_Texture decode_texture(const std::string& texture_filename);
+	[[nodiscard]] static Decoded_Texture decode_texture_source(const std::string& texture_filename);
+	// PNG, JPEG and the other formats stb reads, from a buffer that is already in memory.
+	[[nodiscard]] static Decoded_Texture decode_texture_memory(const uint8_t* data, size_t size);
+	// Imports every asset and decodes every texture they reference on the job pool, each file once.
+	[[nodiscard]] static Imported_Assets import_assets(const std::vector<std::string>& model_filenames, const std::vector<std::string>& animation_filenames, const MarkoEngine::Load_Progress& progress = {});
+	// Imports the assets not loaded yet and uploads them in a few batched submits, so create_model and
+	// create_animation hand out the cached results afterwards.
+	void preload_assets(const std::vector<std::string>& model_filenames, const std::vector<std::string>& animation_filenames, const MarkoEngine::Load_Progress& progress = {});
+
+	// Hot reload, called on the main thread between frames. Re-imported models and animations replace the cached
+	// ones under the names they were loaded with, so objects pick them up through create_model and create_animation;
+	// textures are replaced in their slot, so every mesh using one switches at once. Old resources are destroyed
+	// once the frames in flight are done with them.
+	[[nodiscard]] std::vector<std::string> loaded_models() const;
+	[[nodiscard]] std::vector<std::string> loaded_animations() const;
+	[[nodiscard]] std::vector<std::string> loaded_textures() const;
+	void replace_assets(const Imported_Assets& assets, const std::unordered_map<std::string, Decoded_Texture>& textures);
+	// Rebuilds the scene, grid, crowd and skinning pipelines from shaders/bin; keeps the old ones when a shader fails to load.
+	bool reload_shaders();
+	// Texture streaming, between frames: replaces the slot with a copy of the image without its drop_levels finest
+	// levels, made on the GPU, so nothing has to be decoded again.
+	void trim_texture(uint32_t texture_index, uint32_t width, uint32_t height, uint32_t mip_levels, uint32_t drop_levels);
+
+	void animate(Renderer_Animation& animation);
 	void draw_animation(Renderer_Animation& animation);
-	[[nodiscard]] Renderer_Animation create_animation(std::string animation_filename);
+	[[nodiscard]] Renderer_Skinning create_skinning(Renderer_Animation& animation);
+	// Frees the buffers and descriptor sets of a skinning that is being replaced, once no frame in flight uses them.
+	void retire_skinning(const Renderer_Skinning& skinning);
+
+	bool play_animation(Renderer_Animation& animation, std::string_view clip_name, float fade_duration = 0.0f, uint32_t layer = 0, bool loop = true);
+	void stop_animation(Renderer_Animation& animation, uint32_t layer = 0);
+	void set_animation_layer(Renderer_Animation& animation, uint32_t layer, float weight, bool additive);
+	void set_animation_speed(Renderer_Animation& animation, float speed, uint32_t layer = 0);
+	[[nodiscard]] Renderer_Animation create_animation(std::string animation_filename, std::vector<std::vector<Vertex>>* mesh_vertices = nullptr);
+
+	void draw_vertex_animation(Renderer_Vertex_Animation& animation, Renderer_Crowd& crowd, const glm::mat4& model);
+	[[nodiscard]] Renderer_Vertex_Animation create_vertex_animation(std::string animation_filename, float frames_per_second = 30.0f);
+	[[nodiscard]] Renderer_Crowd create_crowd(std::vector<Vertex_Animation_Instance>& instances);
+	// Free what a re-bake or a new instance layout replaces, once no frame in flight uses it.
+	void retire_vertex_animation(const Renderer_Vertex_Animation& animation);
+	void retire_crowd(const Renderer_Crowd& crowd);
+	[[nodiscard]] static glm::mat4 animation_correction();
+
+public: 
+	Skinning_Mode skinning_mode = Skinning_Mode::COMPUTE;
+	uint32_t benchmark_passes = 0;
+	float gpu_frame_time = 0.0f;
+	size_t animation_allocations = 0;
+	bool frustum_culling = true;
+	size_t drawn_objects = 0;
 
 public: 
 	[[nodiscard]] unsigned long long create_gui_texture(std::string filename);
@@ -187,6 +437,8 @@ private:
 
 public: 
 	void set_view_matrix(glm::mat4 new_view_matrix);
+	[[nodiscard]] glm::mat4 get_view_matrix() const;
+	[[nodiscard]] glm::mat4 get_projection_matrix() const;
 private:
 	glm::mat4 view_matrix {};
 	glm::mat4 projection_matrix {};
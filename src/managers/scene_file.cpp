@@ -0,0 +1,486 @@
+#include "pch.h"
+#include "scene_file.hpp"
+#include "mapped_file.hpp"
+
+#include <cstring>
+
+namespace
+{
+    // "MKSCENE1"; the first string-table format, before chunks.
+    constexpr uint64_t LEGACY_SCENE_MAGIC = 0x31454E4543534B4Dull;
+
+    size_t align_up(size_t value)
+    {
+        return (value + MarkoEngine::SCENE_CHUNK_ALIGNMENT - 1) & ~(MarkoEngine::SCENE_CHUNK_ALIGNMENT - 1);
+    }
+
+    template <typename T>
+    void append(std::vector<uint8_t>& buffer, const T* data, size_t count)
+    {
+        const size_t bytes = sizeof(T) * count;
+        if (bytes == 0)
+            return;
+
+        const size_t offset = buffer.size();
+        buffer.resize(offset + bytes);
+        std::memcpy(buffer.data() + offset, data, bytes);
+    }
+}
+
+uint32_t MarkoEngine::Scene_Data::add_string(std::string_view string)
+{
+    if (string.empty())
+        return 0;
+
+    auto [it, inserted] = m_string_indices.try_emplace(std::string(string), static_cast<uint32_t>(strings.size()));
+    if (inserted)
+        strings.emplace_back(string);
+    return it->second;
+}
+
+std::vector<uint8_t> MarkoEngine::serialize_scene(const Scene_Data& scene)
+{
+    std::vector<uint8_t> strings;
+    {
+        std::vector<uint32_t> offsets;
+        offsets.reserve(scene.strings.size() + 1);
+
+        uint32_t offset = 0;
+        for (const std::string& string : scene.strings)
+        {
+            offsets.push_back(offset);
+            offset += static_cast<uint32_t>(string.size() + 1);
+        }
+        offsets.push_back(offset);
+
+        const uint32_t count = static_cast<uint32_t>(scene.strings.size());
+        append(strings, &count, 1);
+        append(strings, offsets.data(), offsets.size());
+        for (const std::string& string : scene.strings)
+            append(strings, string.c_str(), string.size() + 1);
+    }
+
+    struct Chunk_Source
+    {
+        uint32_t id;
+        uint32_t stride;
+        size_t count;
+        const void* data;
+        size_t size;
+    };
+
+    const std::array<Chunk_Source, 7> sources = { {
+        { SCENE_CHUNK_STRINGS, 1, strings.size(), strings.data(), strings.size() },
+        { SCENE_CHUNK_OBJECTS, sizeof(Scene_Object_Record), scene.objects.size(), scene.objects.data(), scene.objects.size() * sizeof(Scene_Object_Record) },
+        { SCENE_CHUNK_CHILDREN, sizeof(uint32_t), scene.children.size(), scene.children.data(), scene.children.size() * sizeof(uint32_t) },
+        { SCENE_CHUNK_MESHES, sizeof(Scene_Mesh_Record), scene.meshes.size(), scene.meshes.data(), scene.meshes.size() * sizeof(Scene_Mesh_Record) },
+        { SCENE_CHUNK_VERTICES, sizeof(Vertex), scene.vertices.size(), scene.vertices.data(), scene.vertices.size() * sizeof(Vertex) },
+        { SCENE_CHUNK_INDICES, sizeof(uint32_t), scene.indices.size(), scene.indices.data(), scene.indices.size() * sizeof(uint32_t) },
+        { SCENE_CHUNK_MESH_BLOBS, sizeof(Scene_Mesh_Blob_Record), scene.mesh_blobs.size(), scene.mesh_blobs.data(), scene.mesh_blobs.size() * sizeof(Scene_Mesh_Blob_Record) }
+    } };
+
+    Scene_File_Header header{ SCENE_FILE_MAGIC, SCENE_FILE_VERSION, static_cast<uint32_t>(sources.size()) };
+    std::vector<Scene_Chunk_Entry> entries(sources.size());
+
+    size_t offset = align_up(sizeof(Scene_File_Header) + sizeof(Scene_Chunk_Entry) * entries.size());
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        entries[i] = { sources[i].id, 1, sources[i].stride, static_cast<uint32_t>(sources[i].count), offset, sources[i].size };
+        offset = align_up(offset + sources[i].size);
+    }
+
+    std::vector<uint8_t> buffer;
+    buffer.reserve(offset);
+    append(buffer, &header, 1);
+    append(buffer, entries.data(), entries.size());
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        buffer.resize(entries[i].offset, 0);
+        append(buffer, static_cast<const uint8_t*>(sources[i].data), sources[i].size);
+    }
+    buffer.resize(offset, 0);
+
+    return buffer;
+}
+
+bool MarkoEngine::write_scene(const std::string& filename, const Scene_Data& scene)
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs) {
+        std::cerr << "Failed to open file for saving: " << filename << std::endl;
+        return false;
+    }
+
+    const std::vector<uint8_t> buffer = serialize_scene(scene);
+    ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    return static_cast<bool>(ofs);
+}
+
+bool MarkoEngine::is_scene_file(const uint8_t* data, size_t size)
+{
+    uint64_t magic = 0;
+    if (size < sizeof(Scene_File_Header))
+        return false;
+
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == SCENE_FILE_MAGIC;
+}
+
+bool MarkoEngine::Scene_View::open(const uint8_t* data, size_t size)
+{
+    *this = Scene_View();
+    if (!is_scene_file(data, size))
+        return false;
+
+    const Scene_File_Header* header = reinterpret_cast<const Scene_File_Header*>(data);
+    if (size < sizeof(Scene_File_Header) + sizeof(Scene_Chunk_Entry) * static_cast<size_t>(header->chunk_count))
+        return false;
+
+    m_data = data;
+    m_size = size;
+    m_chunks = reinterpret_cast<const Scene_Chunk_Entry*>(data + sizeof(Scene_File_Header));
+    m_chunk_count = header->chunk_count;
+
+    for (uint32_t i = 0; i < m_chunk_count; ++i)
+    {
+        const Scene_Chunk_Entry& chunk = m_chunks[i];
+        if (chunk.offset > size || chunk.size > size - chunk.offset || chunk.offset % SCENE_CHUNK_ALIGNMENT != 0)
+            return false;
+    }
+
+    const Scene_Chunk_Entry* strings = find_chunk(SCENE_CHUNK_STRINGS);
+    if (strings == nullptr || strings->size < sizeof(uint32_t))
+        return false;
+
+    const uint8_t* string_chunk = m_data + strings->offset;
+    std::memcpy(&m_string_count, string_chunk, sizeof(uint32_t));
+    const size_t table_size = sizeof(uint32_t) * (static_cast<size_t>(m_string_count) + 2);
+    if (table_size > strings->size)
+        return false;
+
+    m_string_offsets = reinterpret_cast<const uint32_t*>(string_chunk + sizeof(uint32_t));
+    m_string_data = reinterpret_cast<const char*>(string_chunk + table_size);
+    if (m_string_offsets[m_string_count] > strings->size - table_size)
+        return false;
+
+    if (!array(SCENE_CHUNK_OBJECTS, m_objects) || !array(SCENE_CHUNK_CHILDREN, m_children) || !array(SCENE_CHUNK_MESHES, m_meshes) ||
+        !array(SCENE_CHUNK_VERTICES, m_vertices) || !array(SCENE_CHUNK_INDICES, m_indices) || !array(SCENE_CHUNK_MESH_BLOBS, m_mesh_blobs))
+        return false;
+
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        const Scene_Mesh_Record& mesh = m_meshes[i];
+        if (mesh.first_vertex + mesh.vertex_count > m_vertices.size() || mesh.first_index + mesh.index_count > m_indices.size())
+            return false;
+    }
+
+    return true;
+}
+
+std::string_view MarkoEngine::Scene_View::string(uint32_t index) const
+{
+    if (index >= m_string_count)
+        return {};
+
+    const uint32_t begin = m_string_offsets[index];
+    const uint32_t end = m_string_offsets[index + 1];
+    return end > begin ? std::string_view(m_string_data + begin, end - begin - 1) : std::string_view();
+}
+
+template <typename T>
+bool MarkoEngine::Scene_View::array(uint32_t id, Scene_Array<T>& result) const
+{
+    const Scene_Chunk_Entry* chunk = find_chunk(id);
+    if (chunk == nullptr)
+    {
+        result = Scene_Array<T>();
+        return true;
+    }
+
+    if (chunk->stride < sizeof(T) || static_cast<uint64_t>(chunk->stride) * chunk->count > chunk->size)
+        return false;
+
+    result = Scene_Array<T>(m_data + chunk->offset, chunk->count, chunk->stride);
+    return true;
+}
+
+const MarkoEngine::Scene_Chunk_Entry* MarkoEngine::Scene_View::find_chunk(uint32_t id) const
+{
+    for (uint32_t i = 0; i < m_chunk_count; ++i)
+    {
+        if (m_chunks[i].id == id)
+            return &m_chunks[i];
+    }
+    return nullptr;
+}
+
+bool MarkoEngine::read_legacy_scene(const std::string& filename, Scene_Data& scene)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "Failed to open file for loading: " << filename << std::endl;
+        return false;
+    }
+
+    scene = Scene_Data();
+
+    uint64_t magic = 0;
+    ifs.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+
+    std::vector<uint32_t> string_indices;
+    size_t game_objects_size = static_cast<size_t>(magic);
+    if (magic == LEGACY_SCENE_MAGIC) {
+        uint32_t string_count = 0;
+        ifs.read(reinterpret_cast<char*>(&string_count), sizeof(string_count));
+        string_indices.reserve(string_count);
+        for (uint32_t i = 0; i < string_count && ifs; ++i) {
+            uint32_t string_size = 0;
+            ifs.read(reinterpret_cast<char*>(&string_size), sizeof(string_size));
+            std::string string(string_size, '\0');
+            ifs.read(string.data(), string_size);
+            string_indices.push_back(scene.add_string(string));
+        }
+
+        ifs.read(reinterpret_cast<char*>(&game_objects_size), sizeof(game_objects_size));
+    }
+
+    auto read_name = [&]() -> uint32_t {
+        if (magic != LEGACY_SCENE_MAGIC) {
+            size_t string_size = 0;
+            ifs.read(reinterpret_cast<char*>(&string_size), sizeof(string_size));
+            std::string string(string_size, '\0');
+            ifs.read(string.data(), string_size);
+            return scene.add_string(string);
+        }
+
+        uint32_t index = 0;
+        ifs.read(reinterpret_cast<char*>(&index), sizeof(index));
+        return index < string_indices.size() ? string_indices[index] : 0;
+    };
+
+    for (size_t i = 0; i < game_objects_size && ifs; ++i) {
+        Scene_Object_Record record{};
+        record.flags = SCENE_OBJECT_VISIBLE;
+        record.mesh = SCENE_NO_INDEX;
+
+        game_object_type type;
+        ifs.read(reinterpret_cast<char*>(&type), sizeof(type));
+        record.type = static_cast<uint32_t>(type);
+
+        record.id = read_name();
+        record.script = read_name();
+        record.parent = read_name();
+
+        size_t children_size = 0;
+        ifs.read(reinterpret_cast<char*>(&children_size), sizeof(children_size));
+        record.first_child = static_cast<uint32_t>(scene.children.size());
+        record.child_count = static_cast<uint32_t>(children_size);
+        for (size_t j = 0; j < children_size && ifs; ++j) {
+            scene.children.push_back(read_name());
+        }
+
+        transform world_transform;
+        ifs.read(reinterpret_cast<char*>(&record.local), sizeof(transform));
+        ifs.read(reinterpret_cast<char*>(&world_transform), sizeof(transform));
+
+        switch (type) {
+        case MESH: {
+            record.asset = read_name();
+
+            Scene_Mesh_Record mesh{};
+            ifs.read(reinterpret_cast<char*>(&mesh.vertex_count), sizeof(size_t));
+            mesh.first_vertex = scene.vertices.size();
+            scene.vertices.resize(mesh.first_vertex + mesh.vertex_count);
+            ifs.read(reinterpret_cast<char*>(scene.vertices.data() + mesh.first_vertex), mesh.vertex_count * sizeof(Vertex));
+
+            ifs.read(reinterpret_cast<char*>(&mesh.index_count), sizeof(size_t));
+            mesh.first_index = scene.indices.size();
+            scene.indices.resize(mesh.first_index + mesh.index_count);
+            ifs.read(reinterpret_cast<char*>(scene.indices.data() + mesh.first_index), mesh.index_count * sizeof(uint32_t));
+
+            record.mesh = static_cast<uint32_t>(scene.meshes.size());
+            scene.meshes.push_back(mesh);
+            break;
+        }
+        case MODEL:
+        case ANIMATED: {
+            record.asset = read_name();
+            break;
+        }
+        case CROWD: {
+            record.asset = read_name();
+            size_t instance_count = 0;
+            ifs.read(reinterpret_cast<char*>(&instance_count), sizeof(instance_count));
+            ifs.read(reinterpret_cast<char*>(&record.spacing), sizeof(record.spacing));
+            record.instance_count = static_cast<uint32_t>(instance_count);
+            break;
+        }
+        case CAMERA: {
+            ifs.read(reinterpret_cast<char*>(&record.vector_a), sizeof(glm::vec3));
+            break;
+        }
+        case BOX_COLLIDER: {
+            ifs.read(reinterpret_cast<char*>(&record.vector_a), sizeof(glm::vec3));
+            ifs.read(reinterpret_cast<char*>(&record.vector_b), sizeof(glm::vec3));
+            break;
+        }
+        default:
+            break;
+        }
+
+        if (ifs)
+            scene.objects.push_back(record);
+    }
+
+    return true;
+}
+
+void MarkoEngine::move_meshes_to_blobs(Scene_Data& scene)
+{
+    for (Scene_Object_Record& record : scene.objects)
+    {
+        if (record.mesh == SCENE_NO_INDEX || (record.flags & SCENE_OBJECT_MESH_BLOB) != 0)
+            continue;
+
+        const Scene_Mesh_Record& mesh = scene.meshes[record.mesh];
+        const std::vector<Vertex> vertices(scene.vertices.begin() + mesh.first_vertex, scene.vertices.begin() + mesh.first_vertex + mesh.vertex_count);
+        const std::vector<uint32_t> indices(scene.indices.begin() + mesh.first_index, scene.indices.begin() + mesh.first_index + mesh.index_count);
+
+        record.mesh = static_cast<uint32_t>(scene.mesh_blobs.size());
+        record.flags |= SCENE_OBJECT_MESH_BLOB;
+        scene.mesh_blobs.push_back(store_mesh_blob(vertices, indices));
+    }
+
+    scene.meshes.clear();
+    scene.vertices.clear();
+    scene.indices.clear();
+}
+
+bool MarkoEngine::move_meshes_inline(Scene_Data& scene)
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (Scene_Object_Record& record : scene.objects)
+    {
+        if (record.mesh == SCENE_NO_INDEX || (record.flags & SCENE_OBJECT_MESH_BLOB) == 0)
+            continue;
+
+        if (!load_mesh_blob(scene.mesh_blobs[record.mesh], vertices, indices))
+            return false;
+
+        record.mesh = static_cast<uint32_t>(scene.meshes.size());
+        record.flags &= ~SCENE_OBJECT_MESH_BLOB;
+        scene.meshes.push_back({ scene.vertices.size(), vertices.size(), scene.indices.size(), indices.size() });
+        scene.vertices.insert(scene.vertices.end(), vertices.begin(), vertices.end());
+        scene.indices.insert(scene.indices.end(), indices.begin(), indices.end());
+    }
+
+    scene.mesh_blobs.clear();
+    return true;
+}
+
+bool MarkoEngine::convert_scene(const std::string& filename, const std::string& output)
+{
+    Scene_Data scene;
+    if (!read_legacy_scene(filename, scene))
+        return false;
+
+    move_meshes_to_blobs(scene);
+    return write_scene(output, scene);
+}
+
+size_t MarkoEngine::convert_scenes(const std::string& directory)
+{
+    if (!std::filesystem::exists(directory))
+        return 0;
+
+    std::vector<std::filesystem::path> legacy_files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (!entry.is_regular_file() || entry.path().filename() != "game_objects.bin")
+            continue;
+
+        Mapped_File file(entry.path().string());
+        if (file.is_open() && !is_scene_file(file.data(), file.size()))
+            legacy_files.push_back(entry.path());
+    }
+
+    size_t converted = 0;
+    for (const auto& path : legacy_files)
+    {
+        const std::string legacy = path.string() + ".legacy";
+        std::filesystem::rename(path, legacy);
+        if (convert_scene(legacy, path.string()))
+        {
+            std::cout << "converted " << path.string() << std::endl;
+            ++converted;
+        }
+        else
+        {
+            std::filesystem::rename(legacy, path);
+        }
+    }
+    return converted;
+}
+
+MarkoEngine::Scene_Mesh_Blob_Record MarkoEngine::store_mesh_blob(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    std::vector<uint8_t> payload;
+    payload.reserve(vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t));
+    append(payload, vertices.data(), vertices.size());
+    append(payload, indices.data(), indices.size());
+
+    return { Blob_Store::get().put(payload.data(), payload.size()), vertices.size(), indices.size() };
+}
+
+MarkoEngine::Scene_Mesh_Blob_Record MarkoEngine::Mesh_Geometry::blob()
+{
+    std::lock_guard lock(m_mutex);
+    if (m_blob.hash.empty())
+        m_blob = store_mesh_blob(vertices, indices);
+    return m_blob;
+}
+
+void MarkoEngine::Mesh_Geometry::set_blob(const Scene_Mesh_Blob_Record& record)
+{
+    std::lock_guard lock(m_mutex);
+    m_blob = record;
+}
+
+bool MarkoEngine::load_mesh_blob(const Scene_Mesh_Blob_Record& record, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint8_t> payload;
+    if (!Blob_Store::get().get(record.hash, payload))
+        return false;
+
+    const size_t vertex_bytes = record.vertex_count * sizeof(Vertex);
+    const size_t index_bytes = record.index_count * sizeof(uint32_t);
+    if (payload.size() != vertex_bytes + index_bytes)
+        return false;
+
+    vertices.resize(record.vertex_count);
+    indices.resize(record.index_count);
+    std::memcpy(vertices.data(), payload.data(), vertex_bytes);
+    std::memcpy(indices.data(), payload.data() + vertex_bytes, index_bytes);
+    return true;
+}
+
+void MarkoEngine::collect_scene_blobs(const std::string& directory, std::unordered_set<Blob_Hash>& live)
+{
+    if (!std::filesystem::exists(directory))
+        return;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".bin")
+            continue;
+
+        Mapped_File file(entry.path().string());
+        Scene_View view;
+        if (!file.is_open() || !view.open(file.data(), file.size()))
+            continue;
+
+        for (size_t i = 0; i < view.mesh_blobs().size(); ++i)
+            live.insert(view.mesh_blobs()[i].hash);
+    }
+}
\ No newline at end of file
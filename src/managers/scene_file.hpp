@@ -0,0 +1,217 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../game_objects/i_game_object.hpp"
+#include "blob_store.hpp"
+#include "renderer.hpp"
+
+namespace MarkoEngine
+{
+    constexpr uint32_t make_chunk_id(const char (&tag)[5])
+    {
+        return static_cast<uint32_t>(tag[0]) | static_cast<uint32_t>(tag[1]) << 8 | static_cast<uint32_t>(tag[2]) << 16 | static_cast<uint32_t>(tag[3]) << 24;
+    }
+
+    // "MKSCENE2"
+    inline constexpr uint64_t SCENE_FILE_MAGIC = 0x32454E4543534B4Dull;
+    inline constexpr uint32_t SCENE_FILE_VERSION = 1;
+    inline constexpr uint32_t SCENE_NO_INDEX = 0xFFFFFFFFu;
+    inline constexpr size_t SCENE_CHUNK_ALIGNMENT = 16;
+
+    inline constexpr uint32_t SCENE_CHUNK_STRINGS = make_chunk_id("STRS");
+    inline constexpr uint32_t SCENE_CHUNK_OBJECTS = make_chunk_id("OBJS");
+    inline constexpr uint32_t SCENE_CHUNK_CHILDREN = make_chunk_id("CHLD");
+    inline constexpr uint32_t SCENE_CHUNK_MESHES = make_chunk_id("MESH");
+    inline constexpr uint32_t SCENE_CHUNK_VERTICES = make_chunk_id("VERT");
+    inline constexpr uint32_t SCENE_CHUNK_INDICES = make_chunk_id("INDX");
+    inline constexpr uint32_t SCENE_CHUNK_MESH_BLOBS = make_chunk_id("MBLB");
+
+    enum Scene_Object_Flags : uint32_t
+    {
+        SCENE_OBJECT_VISIBLE = 1u << 0,
+        // The mesh index refers to the blob table instead of the inline mesh table.
+        SCENE_OBJECT_MESH_BLOB = 1u << 1,
+        // Only written in backup journal deltas; the record carries nothing but the id of an object that was deleted.
+        SCENE_OBJECT_REMOVED = 1u << 2
+    };
+
+    struct Scene_File_Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t chunk_count;
+    };
+
+    // Readers skip chunk ids they do not know, and a stride larger than the record they expect means a newer
+    // writer appended fields, so older builds keep loading newer files.
+    struct Scene_Chunk_Entry
+    {
+        uint32_t id;
+        uint32_t version;
+        uint32_t stride;
+        uint32_t count;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // Strings are indices into the string table; mesh is an index into the mesh records.
+    struct Scene_Object_Record
+    {
+        uint32_t type;
+        uint32_t id;
+        uint32_t script;
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t child_count;
+        uint32_t asset;
+        uint32_t flags;
+        transform local;
+        glm::vec3 vector_a;
+        glm::vec3 vector_b;
+        uint32_t mesh;
+        uint32_t instance_count;
+        float spacing;
+        uint32_t reserved;
+    };
+
+    struct Scene_Mesh_Record
+    {
+        uint64_t first_vertex;
+        uint64_t vertex_count;
+        uint64_t first_index;
+        uint64_t index_count;
+    };
+
+    // Vertices followed by indices, stored once in the blob store.
+    struct Scene_Mesh_Blob_Record
+    {
+        Blob_Hash hash;
+        uint64_t vertex_count;
+        uint64_t index_count;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Scene_Mesh_Blob_Record> && sizeof(Scene_Mesh_Blob_Record) == 32);
+    static_assert(std::is_trivially_copyable_v<Scene_Object_Record> && sizeof(Scene_Object_Record) == 108);
+    static_assert(std::is_trivially_copyable_v<Scene_Mesh_Record> && sizeof(Scene_Mesh_Record) == 32);
+    static_assert(std::is_trivially_copyable_v<Vertex> && sizeof(Vertex) == 64);
+
+    // Fixed-size records read in place; the stride comes from the file so appended fields are stepped over.
+    template <typename T>
+    class Scene_Array
+    {
+    public:
+        Scene_Array() = default;
+        Scene_Array(const uint8_t* data, size_t count, size_t stride) : m_data(data), m_count(count), m_stride(stride) {}
+
+        size_t size() const { return m_count; }
+        bool empty() const { return m_count == 0; }
+        const T& operator[](size_t index) const { return *reinterpret_cast<const T*>(m_data + index * m_stride); }
+
+        // Only valid when the file was written with this build's record layout.
+        const T* contiguous() const { return m_stride == sizeof(T) ? reinterpret_cast<const T*>(m_data) : nullptr; }
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_count = 0;
+        size_t m_stride = sizeof(T);
+    };
+
+    // Builds a scene in memory; used when saving and when converting older files.
+    struct Scene_Data
+    {
+        std::vector<std::string> strings{ "" };
+        std::vector<Scene_Object_Record> objects;
+        std::vector<uint32_t> children;
+        std::vector<Scene_Mesh_Record> meshes;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<Scene_Mesh_Blob_Record> mesh_blobs;
+
+        uint32_t add_string(std::string_view string);
+
+    private:
+        std::unordered_map<std::string, uint32_t> m_string_indices{};
+    };
+
+    // Validates a serialized scene and hands out views into it without copying.
+    class Scene_View
+    {
+    public:
+        bool open(const uint8_t* data, size_t size);
+
+        std::string_view string(uint32_t index) const;
+        const Scene_Array<Scene_Object_Record>& objects() const { return m_objects; }
+        const Scene_Array<uint32_t>& children() const { return m_children; }
+        const Scene_Array<Scene_Mesh_Record>& meshes() const { return m_meshes; }
+        const Scene_Array<Vertex>& vertices() const { return m_vertices; }
+        const Scene_Array<uint32_t>& indices() const { return m_indices; }
+        const Scene_Array<Scene_Mesh_Blob_Record>& mesh_blobs() const { return m_mesh_blobs; }
+
+    private:
+        template <typename T>
+        bool array(uint32_t id, Scene_Array<T>& result) const;
+        const Scene_Chunk_Entry* find_chunk(uint32_t id) const;
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        const Scene_Chunk_Entry* m_chunks = nullptr;
+        uint32_t m_chunk_count = 0;
+
+        const uint32_t* m_string_offsets = nullptr;
+        const char* m_string_data = nullptr;
+        uint32_t m_string_count = 0;
+
+        Scene_Array<Scene_Object_Record> m_objects{};
+        Scene_Array<uint32_t> m_children{};
+        Scene_Array<Scene_Mesh_Record> m_meshes{};
+        Scene_Array<Vertex> m_vertices{};
+        Scene_Array<uint32_t> m_indices{};
+        Scene_Array<Scene_Mesh_Blob_Record> m_mesh_blobs{};
+    };
+
+    std::vector<uint8_t> serialize_scene(const Scene_Data& scene);
+    bool write_scene(const std::string& filename, const Scene_Data& scene);
+    bool is_scene_file(const uint8_t* data, size_t size);
+
+    // Reads the unversioned stream format and the first string-table format written before the chunked layout.
+    bool read_legacy_scene(const std::string& filename, Scene_Data& scene);
+    bool convert_scene(const std::string& filename, const std::string& output);
+    size_t convert_scenes(const std::string& directory);
+
+    Scene_Mesh_Blob_Record store_mesh_blob(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    // Geometry of a MESH object, shared with the backup thread so a save never copies or hashes it on the frame.
+    // It never changes after construction, so its blob is written once, by whichever save needs it first.
+    class Mesh_Geometry
+    {
+    public:
+        Mesh_Geometry() = default;
+        Mesh_Geometry(std::vector<Vertex> vertices, std::vector<uint32_t> indices) : vertices(std::move(vertices)), indices(std::move(indices)) {}
+
+        // Safe from any thread; the hash is empty when the blob could not be written.
+        Scene_Mesh_Blob_Record blob();
+        void set_blob(const Scene_Mesh_Blob_Record& record);
+
+        const std::vector<Vertex> vertices;
+        const std::vector<uint32_t> indices;
+
+    private:
+        std::mutex m_mutex;
+        Scene_Mesh_Blob_Record m_blob{};
+    };
+
+    bool load_mesh_blob(const Scene_Mesh_Blob_Record& record, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+    void move_meshes_to_blobs(Scene_Data& scene);
+    // The other way round, for a scene that is shipped without the blob store. False if a blob is missing.
+    bool move_meshes_inline(Scene_Data& scene);
+
+    // Adds every blob referenced by the scene files under a directory to the live set.
+    void collect_scene_blobs(const std::string& directory, std::unordered_set<Blob_Hash>& live);
+}
\ No newline at end of file
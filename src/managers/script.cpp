@@ -1,100 +1,78 @@
 #include "pch.h"
 #include "script.hpp"
 #include "window.hpp"
+#include "spatial.hpp"
+#include "file_system.hpp"
 
 #include "../game_objects/camera_game_object.hpp"
 #include "../game_objects/i_game_object.hpp"
+#include "../game_objects/animated_game_object.hpp"
 
-static int transform_proxy_index(lua_State* lua_state)
+#include <unordered_set>
+
+enum transform_property
 {
-    lua_getfield(lua_state, 1, "id");
-    std::string id = lua_tostring(lua_state, -1);
+    POSITION,
+    ROTATION,
+    SCALE
+};
+
+// Proxies carry the interned object name and property as integers so field access does no string building.
+static I_GAME_OBJECT* transform_proxy_object(lua_State* lua_state, transform_property& property)
+{
+    lua_getfield(lua_state, 1, "name");
+    MarkoEngine::Name name = MarkoEngine::Name::from_hash(static_cast<uint64_t>(lua_tointeger(lua_state, -1)));
     lua_pop(lua_state, 1);
     lua_getfield(lua_state, 1, "prop");
-    std::string prop = lua_tostring(lua_state, -1);
+    property = static_cast<transform_property>(lua_tointeger(lua_state, -1));
     lua_pop(lua_state, 1);
-    auto it = I_GAME_OBJECT::game_objects.find(id);
-    if (it == I_GAME_OBJECT::game_objects.end())
-    {
-        lua_pushnil(lua_state);
-        return 1;
-    }
-    transform t = it->second->get_local_transform();
-    std::string key = lua_tostring(lua_state, 2);
-    float value = 0.0f;
-    if (prop == "position")
-    {
-        if (key == "x")
-            value = t.position.x;
-        else if (key == "y")
-            value = t.position.y;
-        else if (key == "z")
-            value = t.position.z;
-    }
-    else if (prop == "rotation")
+
+    auto it = I_GAME_OBJECT::game_objects.find(name);
+    return it != I_GAME_OBJECT::game_objects.end() ? it->second.get() : nullptr;
+}
+
+static float* transform_field(transform& t, transform_property property, const char* key)
+{
+    glm::vec3& value = property == POSITION ? t.position : property == ROTATION ? t.rotation : t.scale;
+    if (key == nullptr || key[0] == '\0' || key[1] != '\0')
+        return nullptr;
+
+    switch (key[0])
     {
-        if (key == "x")
-            value = t.rotation.x;
-        else if (key == "y")
-            value = t.rotation.y;
-        else if (key == "z")
-            value = t.rotation.z;
+    case 'x': return &value.x;
+    case 'y': return &value.y;
+    case 'z': return &value.z;
+    default: return nullptr;
     }
-    else if (prop == "scale")
+}
+
+static int transform_proxy_index(lua_State* lua_state)
+{
+    transform_property property;
+    I_GAME_OBJECT* object = transform_proxy_object(lua_state, property);
+    if (object == nullptr)
     {
-        if (key == "x")
-            value = t.scale.x;
-        else if (key == "y")
-            value = t.scale.y;
-        else if (key == "z")
-            value = t.scale.z;
+        lua_pushnil(lua_state);
+        return 1;
     }
-    lua_pushnumber(lua_state, value);
+    transform t = object->get_local_transform();
+    float* field = transform_field(t, property, lua_tostring(lua_state, 2));
+    lua_pushnumber(lua_state, field ? *field : 0.0f);
     return 1;
 }
 
 static int transform_proxy_new_index(lua_State* lua_state)
 {
-    lua_getfield(lua_state, 1, "id");
-    std::string id = lua_tostring(lua_state, -1);
-    lua_pop(lua_state, 1);
-    lua_getfield(lua_state, 1, "prop");
-    std::string prop = lua_tostring(lua_state, -1);
-    lua_pop(lua_state, 1);
-    std::string key = lua_tostring(lua_state, 2);
-    float newValue = static_cast<float> (lua_tonumber(lua_state, 3));
-    auto it = I_GAME_OBJECT::game_objects.find(id);
-    if (it == I_GAME_OBJECT::game_objects.end())
+    transform_property property;
+    I_GAME_OBJECT* object = transform_proxy_object(lua_state, property);
+    if (object == nullptr)
         return 0;
-    transform t = it->second->get_local_transform();
-    if (prop == "position")
-    {
-        if (key == "x")
-            t.position.x = newValue;
-        else if (key == "y")
-            t.position.y = newValue;
-        else if (key == "z")
-            t.position.z = newValue;
-    }
-    else if (prop == "rotation")
-    {
-        if (key == "x")
-            t.rotation.x = newValue;
-        else if (key == "y")
-            t.rotation.y = newValue;
-        else if (key == "z")
-            t.rotation.z = newValue;
-    }
-    else if (prop == "scale")
-    {
-        if (key == "x")
-            t.scale.x = newValue;
-        else if (key == "y")
-            t.scale.y = newValue;
-        else if (key == "z")
-            t.scale.z = newValue;
-    }
-    it->second->set_local_transform(t);
+    transform t = object->get_local_transform();
+    float* field = transform_field(t, property, lua_tostring(lua_state, 2));
+    if (field == nullptr)
+        return 0;
+    *field = static_cast<float>(lua_tonumber(lua_state, 3));
+    object->set_local_transform(t);
     return 0;
 }
 
@@ -102,30 +80,33 @@ static int transform_value(lua_State* lua_state)
 {
     if (!lua_istable(lua_state, 1) || !lua_isstring(lua_state, 2))
         return 0;
-    std::string key = lua_tostring(lua_state, 2);
-    if (key == "position" || key == "rotation" || key == "scale")
-    {
-        lua_newtable(lua_state);
-        lua_pushstring(lua_state, "id");
-        lua_getfield(lua_state, 1, "id");
-        lua_settable(lua_state, -3);
-        lua_pushstring(lua_state, "prop");
-        lua_pushstring(lua_state, key.c_str());
-        lua_settable(lua_state, -3);
-        lua_newtable(lua_state);
-        lua_pushstring(lua_state, "__index");
-        lua_pushcfunction(lua_state, transform_proxy_index);
-        lua_settable(lua_state, -3);
-        lua_pushstring(lua_state, "__newindex");
-        lua_pushcfunction(lua_state, transform_proxy_new_index);
-        lua_settable(lua_state, -3);
-        lua_setmetatable(lua_state, -2);
-        return 1;
-    }
+    const char* key = lua_tostring(lua_state, 2);
+    transform_property property;
+    if (std::strcmp(key, "position") == 0)
+        property = POSITION;
+    else if (std::strcmp(key, "rotation") == 0)
+        property = ROTATION;
+    else if (std::strcmp(key, "scale") == 0)
+        property = SCALE;
     else
-    {
         return 0;
-    }
+
+    lua_newtable(lua_state);
+    lua_pushstring(lua_state, "name");
+    lua_getfield(lua_state, 1, "name");
+    lua_settable(lua_state, -3);
+    lua_pushstring(lua_state, "prop");
+    lua_pushinteger(lua_state, property);
+    lua_settable(lua_state, -3);
+    lua_newtable(lua_state);
+    lua_pushstring(lua_state, "__index");
+    lua_pushcfunction(lua_state, transform_proxy_index);
+    lua_settable(lua_state, -3);
+    lua_pushstring(lua_state, "__newindex");
+    lua_pushcfunction(lua_state, transform_proxy_new_index);
+    lua_settable(lua_state, -3);
+    lua_setmetatable(lua_state, -2);
+    return 1;
 }
 
 static int is_key_pressed(lua_State* lua_state)
@@ -150,6 +131,32 @@ static int is_key_held(lua_State* lua_state)
     return 1;
 }
 
+static int poll_input_events(lua_State* lua_state)
+{
+    const auto& events = MarkoEngine::Window::get().input_events();
+
+    lua_createtable(lua_state, static_cast<int>(events.size()), 0);
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const auto& event = events[i];
+
+        lua_createtable(lua_state, 0, 5);
+        lua_pushstring(lua_state, event.type == MarkoEngine::Input_Event_Type::KEY ? "key" : "mouse");
+        lua_setfield(lua_state, -2, "type");
+        lua_pushinteger(lua_state, event.code);
+        lua_setfield(lua_state, -2, "code");
+        lua_pushstring(lua_state, event.action == GLFW_PRESS ? "press" : event.action == GLFW_RELEASE ? "release" : "repeat");
+        lua_setfield(lua_state, -2, "action");
+        lua_pushinteger(lua_state, event.mods);
+        lua_setfield(lua_state, -2, "mods");
+        lua_pushnumber(lua_state, std::chrono::duration<double>(event.timestamp.time_since_epoch()).count());
+        lua_setfield(lua_state, -2, "time");
+
+        lua_rawseti(lua_state, -2, static_cast<lua_Integer>(i + 1));
+    }
+    return 1;
+}
+
 static int get_position(lua_State* lua_state)
 {
 
@@ -163,7 +170,7 @@ static int get_position(lua_State* lua_state)
     std::string id = lua_tostring(lua_state, 1);
 
 
-    auto it = I_GAME_OBJECT::game_objects.find(id);
+    auto it = I_GAME_OBJECT::game_objects.find(MarkoEngine::Name::find(id));
     if (it == I_GAME_OBJECT::game_objects.end())
     {
         std::cout << "Game object with ID '" << id << "' not found!" << std::endl;
@@ -181,6 +188,166 @@ static int get_position(lua_State* lua_state)
     return 3; 
 }
 
+static int get_world_position(lua_State* lua_state)
+{
+    if (lua_gettop(lua_state) != 1 || !lua_isstring(lua_state, 1))
+    {
+        std::cout << "Failed to call get_world_position (Expected ID : string)!" << std::endl;
+        return 0;
+    }
+
+    auto it = I_GAME_OBJECT::game_objects.find(MarkoEngine::Name::find(lua_tostring(lua_state, 1)));
+    if (it == I_GAME_OBJECT::game_objects.end())
+    {
+        std::cout << "Game object with ID '" << lua_tostring(lua_state, 1) << "' not found!" << std::endl;
+        return 0;
+    }
+
+    glm::vec3 position = glm::vec3(it->second->get_local_to_world()[3]);
+
+    lua_pushnumber(lua_state, position.x);
+    lua_pushnumber(lua_state, position.y);
+    lua_pushnumber(lua_state, -position.z);
+
+    return 3;
+}
+
+static int query_sphere(lua_State* lua_state)
+{
+    if (lua_gettop(lua_state) != 4 || !lua_isnumber(lua_state, 1) || !lua_isnumber(lua_state, 2) || !lua_isnumber(lua_state, 3) || !lua_isnumber(lua_state, 4))
+    {
+        std::cout << "Failed to call query_sphere (Expected x : number, y : number, z : number, radius : number)!" << std::endl;
+        return 0;
+    }
+
+    glm::vec3 center(lua_tonumber(lua_state, 1), lua_tonumber(lua_state, 2), -lua_tonumber(lua_state, 3));
+    float radius = static_cast<float>(lua_tonumber(lua_state, 4));
+
+    std::vector<MarkoEngine::Entity> entities;
+    MarkoEngine::Spatial::get().overlap_sphere(center, radius, entities);
+
+    // Tree leaves only carry the entity and ids only live in the object map, so the hits are hashed and the map is
+    // walked once, stopping when every hit has its id.
+    std::unordered_set<uint64_t> hits;
+    hits.reserve(entities.size());
+    for (const MarkoEngine::Entity& entity : entities)
+        hits.insert(static_cast<uint64_t>(entity.generation) << 32 | entity.index);
+
+    lua_createtable(lua_state, static_cast<int>(entities.size()), 0);
+    int index = 1;
+    for (const auto& [id, object] : I_GAME_OBJECT::game_objects)
+    {
+        if (static_cast<size_t>(index) > hits.size())
+            break;
+
+        const MarkoEngine::Entity entity = object->get_entity();
+        if (!hits.contains(static_cast<uint64_t>(entity.generation) << 32 | entity.index))
+            continue;
+
+        lua_pushstring(lua_state, id.c_str());
+        lua_rawseti(lua_state, -2, index++);
+    }
+    return 1;
+}
+
+static int raycast(lua_State* lua_state)
+{
+    if (lua_gettop(lua_state) < 6)
+    {
+        std::cout << "Failed to call raycast (Expected origin x, y, z : number, direction x, y, z : number, max distance : number)!" << std::endl;
+        return 0;
+    }
+
+    MarkoEngine::Ray ray;
+    ray.origin = glm::vec3(lua_tonumber(lua_state, 1), lua_tonumber(lua_state, 2), -lua_tonumber(lua_state, 3));
+    ray.direction = glm::vec3(lua_tonumber(lua_state, 4), lua_tonumber(lua_state, 5), -lua_tonumber(lua_state, 6));
+    ray.max_distance = static_cast<float>(luaL_optnumber(lua_state, 7, FLT_MAX));
+
+    if (glm::length(ray.direction) == 0.0f)
+        return 0;
+    ray.direction = glm::normalize(ray.direction);
+
+    float distance = 0.0f;
+    MarkoEngine::Entity hit = MarkoEngine::Spatial::get().raycast(ray, &distance);
+    if (hit == MarkoEngine::null_entity)
+        return 0;
+
+    lua_pushstring(lua_state, I_GAME_OBJECT::find_id(hit).c_str());
+    lua_pushnumber(lua_state, distance);
+    return 2;
+}
+
+static ANIMATED_GAME_OBJECT* find_animated(lua_State* lua_state, const char* function)
+{
+    if (lua_gettop(lua_state) < 1 || !lua_isstring(lua_state, 1))
+    {
+        std::cout << "Failed to call " << function << " (Expected ID : string)!" << std::endl;
+        return nullptr;
+    }
+
+    auto it = I_GAME_OBJECT::game_objects.find(MarkoEngine::Name::find(lua_tostring(lua_state, 1)));
+    if (it == I_GAME_OBJECT::game_objects.end() || it->second->get_type() != game_object_type::ANIMATED)
+    {
+        std::cout << "Animated game object with ID '" << lua_tostring(lua_state, 1) << "' not found!" << std::endl;
+        return nullptr;
+    }
+
+    return static_cast<ANIMATED_GAME_OBJECT*>(it->second.get());
+}
+
+static int play_animation(lua_State* lua_state)
+{
+    ANIMATED_GAME_OBJECT* animated = find_animated(lua_state, "play_animation");
+    if (animated == nullptr || !lua_isstring(lua_state, 2))
+    {
+        std::cout << "Failed to call play_animation (ID : string, clip : string, fade : number, layer : number, loop : boolean)!" << std::endl;
+        return 0;
+    }
+
+    float fade_duration = static_cast<float>(luaL_optnumber(lua_state, 3, 0.0));
+    uint32_t layer = static_cast<uint32_t>(luaL_optinteger(lua_state, 4, 0));
+    bool loop = lua_isnoneornil(lua_state, 5) ? true : lua_toboolean(lua_state, 5);
+
+    lua_pushboolean(lua_state, animated->play(lua_tostring(lua_state, 2), fade_duration, layer, loop));
+    return 1;
+}
+
+static int stop_animation(lua_State* lua_state)
+{
+    ANIMATED_GAME_OBJECT* animated = find_animated(lua_state, "stop_animation");
+    if (animated == nullptr)
+        return 0;
+
+    animated->stop(static_cast<uint32_t>(luaL_optinteger(lua_state, 2, 0)));
+    return 0;
+}
+
+static int set_animation_layer(lua_State* lua_state)
+{
+    ANIMATED_GAME_OBJECT* animated = find_animated(lua_state, "set_animation_layer");
+    if (animated == nullptr || !lua_isnumber(lua_state, 2) || !lua_isnumber(lua_state, 3))
+    {
+        std::cout << "Failed to call set_animation_layer (ID : string, layer : number, weight : number, additive : boolean)!" << std::endl;
+        return 0;
+    }
+
+    animated->set_layer(static_cast<uint32_t>(lua_tointeger(lua_state, 2)), static_cast<float>(lua_tonumber(lua_state, 3)), lua_toboolean(lua_state, 4));
+    return 0;
+}
+
+static int set_animation_speed(lua_State* lua_state)
+{
+    ANIMATED_GAME_OBJECT* animated = find_animated(lua_state, "set_animation_speed");
+    if (animated == nullptr || !lua_isnumber(lua_state, 2))
+    {
+        std::cout << "Failed to call set_animation_speed (ID : string, speed : number, layer : number)!" << std::endl;
+        return 0;
+    }
+
+    animated->set_speed(static_cast<float>(lua_tonumber(lua_state, 2)), static_cast<uint32_t>(luaL_optinteger(lua_state, 3, 0)));
+    return 0;
+}
+
 void MarkoEngine::Script::initialize()
 {
     m_script.reset(luaL_newstate());
@@ -195,6 +362,14 @@ void MarkoEngine::Script::initialize()
     lua_register(m_script.get(), "is_key_pressed", is_key_pressed);
     lua_register(m_script.get(), "is_key_held", is_key_held);
     lua_register(m_script.get(), "get_position", get_position);
+    lua_register(m_script.get(), "get_world_position", get_world_position);
+    lua_register(m_script.get(), "poll_input_events", poll_input_events);
+    lua_register(m_script.get(), "query_sphere", query_sphere);
+    lua_register(m_script.get(), "raycast", raycast);
+    lua_register(m_script.get(), "play_animation", play_animation);
+    lua_register(m_script.get(), "stop_animation", stop_animation);
+    lua_register(m_script.get(), "set_animation_layer", set_animation_layer);
+    lua_register(m_script.get(), "set_animation_speed", set_animation_speed);
 
     lua_newtable(m_script.get());
     lua_setglobal(m_script.get(), "Time");
@@ -261,6 +436,9 @@ void MarkoEngine::Script::call_function(const std::string& func)
         lua_pushstring(m_script.get(), "id");
         lua_pushstring(m_script.get(), object.first.c_str());
         lua_settable(m_script.get(), -3);
+        lua_pushstring(m_script.get(), "name");
+        lua_pushinteger(m_script.get(), static_cast<lua_Integer>(object.first.hash()));
+        lua_settable(m_script.get(), -3);
         lua_newtable(m_script.get());
         lua_pushstring(m_script.get(), "__index");
         lua_pushcfunction(m_script.get(), transform_value);
@@ -513,10 +691,15 @@ void MarkoEngine::Script::call_function(const std::string& func)
         lua_pushnumber(m_script.get(), GLFW_KEY_F12);
         lua_settable(m_script.get(), -3);
 
-        const std::string& script_string = object.second->get_script();
-        if (script_string.empty() || !std::filesystem::exists(script_string))
+        const std::string& script_string = object.second->get_script().str();
+        if (script_string.empty())
+            continue;
+        const MarkoEngine::File_Data script_file = MarkoEngine::File_System::get().open(script_string);
+        if (!script_file.is_open())
             continue;
-        if (luaL_dofile(m_script.get(), script_string.c_str()) != LUA_OK)
+        const std::string chunk_name = "@" + script_string;
+        if (luaL_loadbuffer(m_script.get(), reinterpret_cast<const char*>(script_file.data()), script_file.size(), chunk_name.c_str()) != LUA_OK ||
+            lua_pcall(m_script.get(), 0, LUA_MULTRET, 0) != LUA_OK)
         {
             std::cerr << "Failed to run lua script: " << script_string
                 << " error: " << lua_tostring(m_script.get(), -1)
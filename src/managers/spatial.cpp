@@ -0,0 +1,550 @@
+#include "pch.h"
+#include "spatial.hpp"
+#include "transforms.hpp"
+#include "../game_objects/components.hpp"
+
+namespace
+{
+    constexpr float FAT_MARGIN = 0.1f;
+    constexpr int SAH_BINS = 12;
+
+    MarkoEngine::Aabb fatten(const MarkoEngine::Aabb& bounds)
+    {
+        return { bounds.min - glm::vec3(FAT_MARGIN), bounds.max + glm::vec3(FAT_MARGIN) };
+    }
+}
+
+MarkoEngine::Aabb MarkoEngine::Aabb::transformed(const glm::mat4& matrix) const
+{
+    if (!valid())
+        return *this;
+
+    const glm::vec3 center_point = glm::vec3(matrix * glm::vec4(center(), 1.0f));
+    const glm::vec3 half = extent() * 0.5f;
+    const glm::vec3 new_half = glm::abs(glm::vec3(matrix[0])) * half.x
+        + glm::abs(glm::vec3(matrix[1])) * half.y
+        + glm::abs(glm::vec3(matrix[2])) * half.z;
+
+    return { center_point - new_half, center_point + new_half };
+}
+
+MarkoEngine::Frustum MarkoEngine::Frustum::from_matrix(const glm::mat4& view_projection)
+{
+    const glm::vec4 row0(view_projection[0][0], view_projection[1][0], view_projection[2][0], view_projection[3][0]);
+    const glm::vec4 row1(view_projection[0][1], view_projection[1][1], view_projection[2][1], view_projection[3][1]);
+    const glm::vec4 row2(view_projection[0][2], view_projection[1][2], view_projection[2][2], view_projection[3][2]);
+    const glm::vec4 row3(view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3]);
+
+    Frustum frustum;
+    frustum.planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+    for (glm::vec4& plane : frustum.planes)
+    {
+        const float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            plane /= length;
+    }
+    return frustum;
+}
+
+bool MarkoEngine::Frustum::overlaps(const Aabb& bounds) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        const glm::vec3 positive(
+            plane.x >= 0.0f ? bounds.max.x : bounds.min.x,
+            plane.y >= 0.0f ? bounds.max.y : bounds.min.y,
+            plane.z >= 0.0f ? bounds.max.z : bounds.min.z);
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+float MarkoEngine::Ray::intersect(const Aabb& bounds) const
+{
+    const glm::vec3 inverse = 1.0f / direction;
+    const glm::vec3 t0 = (bounds.min - origin) * inverse;
+    const glm::vec3 t1 = (bounds.max - origin) * inverse;
+    const glm::vec3 near_t = glm::min(t0, t1);
+    const glm::vec3 far_t = glm::max(t0, t1);
+
+    const float enter = std::max(std::max(near_t.x, near_t.y), std::max(near_t.z, 0.0f));
+    const float exit = std::min(std::min(far_t.x, far_t.y), far_t.z);
+
+    return enter <= exit && enter <= max_distance ? enter : -1.0f;
+}
+
+float MarkoEngine::Triangle_Mesh::intersect(const Ray& ray) const
+{
+    float closest = -1.0f;
+    float max_distance = ray.max_distance;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const glm::vec3& a = positions[indices[i]];
+        const glm::vec3 edge1 = positions[indices[i + 1]] - a;
+        const glm::vec3 edge2 = positions[indices[i + 2]] - a;
+
+        const glm::vec3 p = glm::cross(ray.direction, edge2);
+        const float determinant = glm::dot(edge1, p);
+        if (std::abs(determinant) < 1e-8f)
+            continue;
+
+        const float inverse = 1.0f / determinant;
+        const glm::vec3 offset = ray.origin - a;
+        const float u = glm::dot(offset, p) * inverse;
+        if (u < 0.0f || u > 1.0f)
+            continue;
+
+        const glm::vec3 q = glm::cross(offset, edge1);
+        const float v = glm::dot(ray.direction, q) * inverse;
+        if (v < 0.0f || u + v > 1.0f)
+            continue;
+
+        const float t = glm::dot(edge2, q) * inverse;
+        if (t >= 0.0f && t <= max_distance)
+        {
+            closest = t;
+            max_distance = t;
+        }
+    }
+    return closest;
+}
+
+int32_t MarkoEngine::Aabb_Tree::insert(const Aabb& bounds, Entity entity)
+{
+    const int32_t leaf = allocate_node();
+    m_nodes[leaf].bounds = fatten(bounds);
+    m_nodes[leaf].entity = entity;
+    m_nodes[leaf].height = 0;
+
+    insert_leaf(leaf);
+    ++m_leaf_count;
+    return leaf;
+}
+
+void MarkoEngine::Aabb_Tree::remove(int32_t proxy)
+{
+    remove_leaf(proxy);
+    free_node(proxy);
+    --m_leaf_count;
+}
+
+bool MarkoEngine::Aabb_Tree::move(int32_t proxy, const Aabb& bounds)
+{
+    if (m_nodes[proxy].bounds.contains(bounds))
+        return false;
+
+    remove_leaf(proxy);
+    m_nodes[proxy].bounds = fatten(bounds);
+    insert_leaf(proxy);
+    return true;
+}
+
+void MarkoEngine::Aabb_Tree::clear()
+{
+    m_nodes.clear();
+    m_root = null_node;
+    m_free_list = null_node;
+    m_leaf_count = 0;
+}
+
+// Top-down binned SAH build over the existing leaves; leaf indices are kept so proxies stay valid.
+void MarkoEngine::Aabb_Tree::rebuild()
+{
+    std::vector<int32_t> leaves;
+    leaves.reserve(m_leaf_count);
+    for (int32_t i = 0; i < static_cast<int32_t>(m_nodes.size()); ++i)
+    {
+        if (m_nodes[i].height < 0)
+            continue;
+
+        if (m_nodes[i].is_leaf())
+            leaves.push_back(i);
+        else
+            free_node(i);
+    }
+
+    m_root = leaves.empty() ? null_node : build(leaves, 0, leaves.size());
+    if (m_root != null_node)
+        m_nodes[m_root].parent = null_node;
+}
+
+int32_t MarkoEngine::Aabb_Tree::build(std::vector<int32_t>& leaves, size_t begin, size_t end)
+{
+    if (end - begin == 1)
+        return leaves[begin];
+
+    Aabb centroids;
+    for (size_t i = begin; i < end; ++i)
+        centroids.extend(m_nodes[leaves[i]].bounds.center());
+
+    const glm::vec3 extent = centroids.extent();
+    const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    size_t middle = begin + (end - begin) / 2;
+    if (extent[axis] > 0.0f)
+    {
+        struct Bin
+        {
+            Aabb bounds;
+            size_t count = 0;
+        };
+        std::array<Bin, SAH_BINS> bins{};
+
+        const float scale = SAH_BINS / extent[axis];
+        auto bin_of = [&](int32_t leaf)
+            {
+                const int bin = static_cast<int>((m_nodes[leaf].bounds.center()[axis] - centroids.min[axis]) * scale);
+                return std::min(bin, SAH_BINS - 1);
+            };
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            Bin& bin = bins[bin_of(leaves[i])];
+            bin.bounds = Aabb::merge(bin.bounds, m_nodes[leaves[i]].bounds);
+            ++bin.count;
+        }
+
+        std::array<float, SAH_BINS - 1> left_cost{};
+        Aabb running;
+        size_t count = 0;
+        for (int i = 0; i < SAH_BINS - 1; ++i)
+        {
+            running = Aabb::merge(running, bins[i].bounds);
+            count += bins[i].count;
+            left_cost[i] = count ? running.surface_area() * count : 0.0f;
+        }
+
+        int best_split = -1;
+        float best_cost = FLT_MAX;
+        running = Aabb();
+        count = 0;
+        for (int i = SAH_BINS - 1; i > 0; --i)
+        {
+            running = Aabb::merge(running, bins[i].bounds);
+            count += bins[i].count;
+            const float cost = left_cost[i - 1] + (count ? running.surface_area() * count : 0.0f);
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_split = i;
+            }
+        }
+
+        auto split = std::partition(leaves.begin() + begin, leaves.begin() + end,
+            [&](int32_t leaf) { return bin_of(leaf) < best_split; });
+        const size_t partitioned = static_cast<size_t>(split - leaves.begin());
+        if (partitioned > begin && partitioned < end)
+            middle = partitioned;
+    }
+
+    const int32_t left = build(leaves, begin, middle);
+    const int32_t right = build(leaves, middle, end);
+
+    const int32_t node = allocate_node();
+    m_nodes[node].left = left;
+    m_nodes[node].right = right;
+    m_nodes[node].bounds = Aabb::merge(m_nodes[left].bounds, m_nodes[right].bounds);
+    m_nodes[node].height = 1 + std::max(m_nodes[left].height, m_nodes[right].height);
+    m_nodes[left].parent = node;
+    m_nodes[right].parent = node;
+    return node;
+}
+
+int32_t MarkoEngine::Aabb_Tree::allocate_node()
+{
+    if (m_free_list == null_node)
+    {
+        m_nodes.emplace_back();
+        return static_cast<int32_t>(m_nodes.size() - 1);
+    }
+
+    const int32_t node = m_free_list;
+    m_free_list = m_nodes[node].parent;
+    m_nodes[node] = Node{};
+    return node;
+}
+
+void MarkoEngine::Aabb_Tree::free_node(int32_t node)
+{
+    m_nodes[node].parent = m_free_list;
+    m_nodes[node].height = -1;
+    m_free_list = node;
+}
+
+void MarkoEngine::Aabb_Tree::insert_leaf(int32_t leaf)
+{
+    if (m_root == null_node)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = null_node;
+        return;
+    }
+
+    // Descend towards the sibling that minimises the added surface area, including what ancestors inherit.
+    const Aabb leaf_bounds = m_nodes[leaf].bounds;
+    int32_t index = m_root;
+    while (!m_nodes[index].is_leaf())
+    {
+        const Node& node = m_nodes[index];
+        const float area = node.bounds.surface_area();
+        const float combined_area = Aabb::merge(node.bounds, leaf_bounds).surface_area();
+
+        const float cost = 2.0f * combined_area;
+        const float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto child_cost = [&](int32_t child)
+            {
+                const float merged = Aabb::merge(leaf_bounds, m_nodes[child].bounds).surface_area();
+                return (m_nodes[child].is_leaf() ? merged : merged - m_nodes[child].bounds.surface_area()) + inheritance_cost;
+            };
+
+        const float left_cost = child_cost(node.left);
+        const float right_cost = child_cost(node.right);
+        if (cost < left_cost && cost < right_cost)
+            break;
+
+        index = left_cost < right_cost ? node.left : node.right;
+    }
+
+    const int32_t sibling = index;
+    const int32_t old_parent = m_nodes[sibling].parent;
+    const int32_t new_parent = allocate_node();
+    m_nodes[new_parent].parent = old_parent;
+    m_nodes[new_parent].bounds = Aabb::merge(leaf_bounds, m_nodes[sibling].bounds);
+    m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+    m_nodes[new_parent].left = sibling;
+    m_nodes[new_parent].right = leaf;
+
+    if (old_parent != null_node)
+    {
+        if (m_nodes[old_parent].left == sibling)
+            m_nodes[old_parent].left = new_parent;
+        else
+            m_nodes[old_parent].right = new_parent;
+    }
+    else
+    {
+        m_root = new_parent;
+    }
+
+    m_nodes[sibling].parent = new_parent;
+    m_nodes[leaf].parent = new_parent;
+
+    refit(new_parent);
+}
+
+void MarkoEngine::Aabb_Tree::remove_leaf(int32_t leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = null_node;
+        return;
+    }
+
+    const int32_t parent = m_nodes[leaf].parent;
+    const int32_t grand_parent = m_nodes[parent].parent;
+    const int32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+    if (grand_parent != null_node)
+    {
+        if (m_nodes[grand_parent].left == parent)
+            m_nodes[grand_parent].left = sibling;
+        else
+            m_nodes[grand_parent].right = sibling;
+
+        m_nodes[sibling].parent = grand_parent;
+        free_node(parent);
+        refit(grand_parent);
+    }
+    else
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = null_node;
+        free_node(parent);
+    }
+}
+
+void MarkoEngine::Aabb_Tree::refit(int32_t index)
+{
+    while (index != null_node)
+    {
+        index = balance(index);
+
+        Node& node = m_nodes[index];
+        node.height = 1 + std::max(m_nodes[node.left].height, m_nodes[node.right].height);
+        node.bounds = Aabb::merge(m_nodes[node.left].bounds, m_nodes[node.right].bounds);
+
+        index = node.parent;
+    }
+}
+
+// Rotates the taller grandchild up when the subtree heights differ by more than one.
+int32_t MarkoEngine::Aabb_Tree::balance(int32_t a)
+{
+    if (m_nodes[a].is_leaf() || m_nodes[a].height < 2)
+        return a;
+
+    const int32_t b = m_nodes[a].left;
+    const int32_t c = m_nodes[a].right;
+    const int32_t difference = m_nodes[c].height - m_nodes[b].height;
+
+    if (difference > -2 && difference < 2)
+        return a;
+
+    const bool rotate_right_child = difference > 1;
+    const int32_t up = rotate_right_child ? c : b;
+    const int32_t stay = rotate_right_child ? b : c;
+    const int32_t f = m_nodes[up].left;
+    const int32_t g = m_nodes[up].right;
+
+    m_nodes[up].left = a;
+    m_nodes[up].parent = m_nodes[a].parent;
+    m_nodes[a].parent = up;
+
+    if (m_nodes[up].parent != null_node)
+    {
+        Node& parent = m_nodes[m_nodes[up].parent];
+        if (parent.left == a)
+            parent.left = up;
+        else
+            parent.right = up;
+    }
+    else
+    {
+        m_root = up;
+    }
+
+    const bool keep_f = m_nodes[f].height > m_nodes[g].height;
+    const int32_t kept = keep_f ? f : g;
+    const int32_t moved = keep_f ? g : f;
+
+    m_nodes[up].right = kept;
+    if (rotate_right_child)
+        m_nodes[a].right = moved;
+    else
+        m_nodes[a].left = moved;
+    m_nodes[moved].parent = a;
+
+    m_nodes[a].bounds = Aabb::merge(m_nodes[stay].bounds, m_nodes[moved].bounds);
+    m_nodes[a].height = 1 + std::max(m_nodes[stay].height, m_nodes[moved].height);
+    m_nodes[up].bounds = Aabb::merge(m_nodes[a].bounds, m_nodes[kept].bounds);
+    m_nodes[up].height = 1 + std::max(m_nodes[a].height, m_nodes[kept].height);
+
+    return up;
+}
+
+MarkoEngine::Spatial& MarkoEngine::Spatial::get()
+{
+    static Spatial instance;
+    return instance;
+}
+
+void MarkoEngine::Spatial::update()
+{
+    m_moved_count = 0;
+
+    const bool transforms_changed = Transforms::get().updated_count() > 0;
+    Registry::get().each<Bounds_Component, Transform_Component>(
+        [&](Entity entity, Bounds_Component& bounds, Transform_Component& transform)
+        {
+            if (!bounds.dirty && !(transforms_changed && transform.changed))
+                return;
+
+            bounds.dirty = false;
+            bounds.world = bounds.local.transformed(bounds.world_correction * transform.local_to_world);
+
+            if (!bounds.world.valid())
+            {
+                if (bounds.proxy != Aabb_Tree::null_node)
+                    m_tree.remove(bounds.proxy);
+                bounds.proxy = Aabb_Tree::null_node;
+                return;
+            }
+
+            if (bounds.proxy == Aabb_Tree::null_node)
+                bounds.proxy = m_tree.insert(bounds.world, entity);
+            else if (m_tree.move(bounds.proxy, bounds.world))
+                ++m_moved_count;
+        });
+}
+
+void MarkoEngine::Spatial::remove(Entity entity)
+{
+    Bounds_Component* bounds = Registry::get().try_get<Bounds_Component>(entity);
+    if (bounds == nullptr || bounds->proxy == Aabb_Tree::null_node)
+        return;
+
+    m_tree.remove(bounds->proxy);
+    bounds->proxy = Aabb_Tree::null_node;
+}
+
+void MarkoEngine::Spatial::rebuild()
+{
+    m_tree.rebuild();
+}
+
+void MarkoEngine::Spatial::cleanup()
+{
+    m_tree.clear();
+    for (Bounds_Component& bounds : Registry::get().pool<Bounds_Component>().components())
+    {
+        bounds.proxy = Aabb_Tree::null_node;
+        bounds.dirty = true;
+    }
+}
+
+MarkoEngine::Entity MarkoEngine::Spatial::raycast(const Ray& ray, float* distance) const
+{
+    Registry& registry = Registry::get();
+
+    Entity hit = null_entity;
+    const float closest = m_tree.raycast(ray, [&](Entity entity, const Ray& clipped)
+        {
+            Bounds_Component* bounds = registry.try_get<Bounds_Component>(entity);
+            const float t = bounds ? clipped.intersect(bounds->world) : -1.0f;
+            if (t >= 0.0f)
+                hit = entity;
+            return t;
+        });
+
+    if (distance)
+        *distance = closest;
+    return hit;
+}
+
+void MarkoEngine::Spatial::overlap_sphere(const glm::vec3& center, float radius, std::vector<Entity>& entities) const
+{
+    Registry& registry = Registry::get();
+    query_sphere(center, radius, [&](Entity entity)
+        {
+            Bounds_Component* bounds = registry.try_get<Bounds_Component>(entity);
+            if (bounds && bounds->world.overlaps_sphere(center, radius))
+                entities.push_back(entity);
+        });
+}
+
+void MarkoEngine::Spatial::query_pairs(const std::function<void(Entity, Entity)>& function) const
+{
+    Registry& registry = Registry::get();
+    Component_Pool<Bounds_Component>& pool = registry.pool<Bounds_Component>();
+
+    for (size_t i = 0; i < pool.size(); ++i)
+    {
+        const Entity entity = pool.entities()[i];
+        const Aabb bounds = pool.components()[i].world;
+        if (pool.components()[i].proxy == Aabb_Tree::null_node)
+            continue;
+
+        query_box(bounds, [&](Entity other)
+            {
+                if (other.index <= entity.index)
+                    return;
+
+                Bounds_Component* other_bounds = registry.try_get<Bounds_Component>(other);
+                if (other_bounds && other_bounds->world.overlaps(bounds))
+                    function(entity, other);
+            });
+    }
+}
\ No newline at end of file
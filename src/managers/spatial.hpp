@@ -0,0 +1,292 @@
+#pragma once
+#include "registry.hpp"
+
+#include <array>
+#include <cfloat>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace MarkoEngine
+{
+    struct Aabb
+    {
+        glm::vec3 min{ FLT_MAX };
+        glm::vec3 max{ -FLT_MAX };
+
+        bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        glm::vec3 extent() const { return max - min; }
+
+        float surface_area() const
+        {
+            const glm::vec3 e = extent();
+            return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+
+        void extend(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        bool contains(const Aabb& other) const
+        {
+            return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+        }
+
+        bool overlaps(const Aabb& other) const
+        {
+            return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+        }
+
+        bool overlaps_sphere(const glm::vec3& center, float radius) const
+        {
+            const glm::vec3 offset = glm::clamp(center, min, max) - center;
+            return glm::dot(offset, offset) <= radius * radius;
+        }
+
+        static Aabb merge(const Aabb& a, const Aabb& b)
+        {
+            return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+        }
+
+        Aabb transformed(const glm::mat4& matrix) const;
+    };
+
+    struct Frustum
+    {
+        std::array<glm::vec4, 6> planes;
+
+        static Frustum from_matrix(const glm::mat4& view_projection);
+        bool overlaps(const Aabb& bounds) const;
+    };
+
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        float max_distance = FLT_MAX;
+
+        // Slab test; returns the entry distance or a negative value on a miss.
+        float intersect(const Aabb& bounds) const;
+    };
+
+    // CPU copy of render geometry kept for exact picking.
+    struct Triangle_Mesh
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+
+        // Closest triangle hit along the ray in the mesh's space, or a negative value on a miss.
+        float intersect(const Ray& ray) const;
+    };
+
+    // Depth-first work list that stays on the stack for balanced trees and spills to the heap beyond that.
+    class Traversal_Stack
+    {
+    public:
+        void push(int32_t node)
+        {
+            if (m_size < m_local.size())
+                m_local[m_size] = node;
+            else
+                m_overflow.push_back(node);
+            ++m_size;
+        }
+
+        int32_t pop()
+        {
+            --m_size;
+            if (m_size < m_local.size())
+                return m_local[m_size];
+
+            const int32_t node = m_overflow.back();
+            m_overflow.pop_back();
+            return node;
+        }
+
+        bool empty() const { return m_size == 0; }
+
+    private:
+        std::array<int32_t, 64> m_local;
+        std::vector<int32_t> m_overflow{};
+        size_t m_size = 0;
+    };
+
+    // Incrementally updated bounding volume tree in the style of Box2D's dynamic tree: leaves hold fattened
+    // bounds so small movements need no tree changes, and insertion refits with AVL rotations on the way up.
+    class Aabb_Tree
+    {
+    public:
+        static constexpr int32_t null_node = -1;
+
+        int32_t insert(const Aabb& bounds, Entity entity);
+        void remove(int32_t proxy);
+        bool move(int32_t proxy, const Aabb& bounds);
+        void rebuild();
+        void clear();
+
+        const Aabb& fat_bounds(int32_t proxy) const { return m_nodes[proxy].bounds; }
+        Entity entity(int32_t proxy) const { return m_nodes[proxy].entity; }
+        size_t leaf_count() const { return m_leaf_count; }
+        int32_t height() const { return m_root == null_node ? 0 : m_nodes[m_root].height; }
+
+        template <typename Overlaps, typename Function>
+        void query(Overlaps&& overlaps, Function&& function) const
+        {
+            if (m_root == null_node)
+                return;
+
+            Traversal_Stack stack;
+            stack.push(m_root);
+            while (!stack.empty())
+            {
+                const Node& node = m_nodes[stack.pop()];
+
+                if (!overlaps(node.bounds))
+                    continue;
+
+                if (node.is_leaf())
+                {
+                    function(node.entity);
+                }
+                else
+                {
+                    stack.push(node.left);
+                    stack.push(node.right);
+                }
+            }
+        }
+
+        // Visits leaves in roughly front-to-back order; the callback returns the hit distance or a negative
+        // value, and hits shrink the search range so subtrees behind the closest hit are skipped.
+        template <typename Function>
+        float raycast(Ray ray, Function&& function) const
+        {
+            if (m_root == null_node)
+                return -1.0f;
+
+            float closest = -1.0f;
+            Traversal_Stack stack;
+            stack.push(m_root);
+            while (!stack.empty())
+            {
+                const Node& node = m_nodes[stack.pop()];
+
+                if (ray.intersect(node.bounds) < 0.0f)
+                    continue;
+
+                if (node.is_leaf())
+                {
+                    const float distance = function(node.entity, ray);
+                    if (distance >= 0.0f && distance <= ray.max_distance)
+                    {
+                        ray.max_distance = distance;
+                        closest = distance;
+                    }
+                    continue;
+                }
+
+                const float left = ray.intersect(m_nodes[node.left].bounds);
+                const float right = ray.intersect(m_nodes[node.right].bounds);
+                if (left >= 0.0f && right >= 0.0f && left < right)
+                {
+                    stack.push(node.right);
+                    stack.push(node.left);
+                }
+                else
+                {
+                    if (left >= 0.0f)
+                        stack.push(node.left);
+                    if (right >= 0.0f)
+                        stack.push(node.right);
+                }
+            }
+            return closest;
+        }
+
+    private:
+        struct Node
+        {
+            Aabb bounds;
+            Entity entity;
+            int32_t parent = null_node;
+            int32_t left = null_node;
+            int32_t right = null_node;
+            int32_t height = 0;
+
+            bool is_leaf() const { return left == null_node; }
+        };
+
+        int32_t allocate_node();
+        void free_node(int32_t node);
+        void insert_leaf(int32_t leaf);
+        void remove_leaf(int32_t leaf);
+        void refit(int32_t node);
+        int32_t balance(int32_t node);
+        int32_t build(std::vector<int32_t>& leaves, size_t begin, size_t end);
+
+    private:
+        std::vector<Node> m_nodes{};
+        int32_t m_root = null_node;
+        int32_t m_free_list = null_node;
+        size_t m_leaf_count = 0;
+    };
+
+    class Spatial
+    {
+    public:
+        Spatial(const Spatial&) = delete;
+        Spatial(Spatial&&) = delete;
+        Spatial& operator=(const Spatial&) = delete;
+        Spatial& operator=(Spatial&&) = delete;
+
+    private:
+        Spatial() = default;
+
+    public:
+        static Spatial& get();
+
+        void update();
+        void remove(Entity entity);
+        void rebuild();
+        void cleanup();
+
+        template <typename Function>
+        void query_box(const Aabb& bounds, Function&& function) const
+        {
+            m_tree.query([&bounds](const Aabb& node) { return node.overlaps(bounds); }, function);
+        }
+
+        template <typename Function>
+        void query_sphere(const glm::vec3& center, float radius, Function&& function) const
+        {
+            m_tree.query([&center, radius](const Aabb& node) { return node.overlaps_sphere(center, radius); }, function);
+        }
+
+        // Entities whose tight world bounds touch the sphere; query_sphere only tests the fattened tree bounds.
+        void overlap_sphere(const glm::vec3& center, float radius, std::vector<Entity>& entities) const;
+
+        template <typename Function>
+        void query_frustum(const Frustum& frustum, Function&& function) const
+        {
+            m_tree.query([&frustum](const Aabb& node) { return frustum.overlaps(node); }, function);
+        }
+
+        // Closest entity whose tight world bounds the ray enters; returns null_entity on a miss.
+        Entity raycast(const Ray& ray, float* distance = nullptr) const;
+
+        // Broadphase: reports every pair of entities whose tight bounds overlap, each pair once.
+        void query_pairs(const std::function<void(Entity, Entity)>& function) const;
+
+        const Aabb_Tree& tree() const { return m_tree; }
+        size_t moved_count() const { return m_moved_count; }
+
+    private:
+        Aabb_Tree m_tree{};
+        size_t m_moved_count = 0;
+    };
+}
\ No newline at end of file
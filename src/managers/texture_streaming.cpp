@@ -0,0 +1,328 @@
+#include "pch.h"
+#include "texture_streaming.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Textures come in with their levels up to this size, which is enough for anything small on screen.
+    constexpr uint32_t START_SIZE = 128;
+    // Streams in flight at once; each is a decode on the loader thread and an upload on the main thread.
+    constexpr size_t MAX_STREAMS = 4;
+    // A texture nothing drew for this many frames goes back to its start levels when memory is needed.
+    constexpr uint64_t UNUSED_FRAMES = 300;
+
+    uint32_t mip_count(uint32_t width, uint32_t height)
+    {
+        uint32_t levels = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+            ++levels;
+        return levels;
+    }
+
+    size_t level_size(uint32_t width, uint32_t height, uint32_t level)
+    {
+        return static_cast<size_t>(std::max(1u, width >> level)) * std::max(1u, height >> level) * 4;
+    }
+
+    // 2x2 box filter; odd edges repeat their last row or column.
+    void downsample(const uint8_t* source, uint32_t source_width, uint32_t source_height, uint8_t* target, uint32_t width, uint32_t height)
+    {
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint32_t y0 = std::min(y * 2, source_height - 1);
+            const uint32_t y1 = std::min(y * 2 + 1, source_height - 1);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint32_t x0 = std::min(x * 2, source_width - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, source_width - 1);
+                const uint8_t* p00 = source + (static_cast<size_t>(y0) * source_width + x0) * 4;
+                const uint8_t* p01 = source + (static_cast<size_t>(y0) * source_width + x1) * 4;
+                const uint8_t* p10 = source + (static_cast<size_t>(y1) * source_width + x0) * 4;
+                const uint8_t* p11 = source + (static_cast<size_t>(y1) * source_width + x1) * 4;
+                uint8_t* out = target + (static_cast<size_t>(y) * width + x) * 4;
+                for (int c = 0; c < 4; ++c)
+                    out[c] = static_cast<uint8_t>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+            }
+        }
+    }
+}
+
+size_t MarkoEngine::mip_chain_size(uint32_t width, uint32_t height, uint32_t levels)
+{
+    size_t size = 0;
+    for (uint32_t level = 0; level < levels; ++level)
+        size += level_size(width, height, level);
+    return size;
+}
+
+Decoded_Texture MarkoEngine::build_mip_chain(const Decoded_Texture& texture, uint32_t first_mip)
+{
+    if (!texture.pixels || texture.width == 0 || texture.height == 0)
+        return texture;
+
+    const uint32_t levels = mip_count(texture.width, texture.height);
+    first_mip = std::min(first_mip, levels - 1);
+
+    Decoded_Texture result;
+    result.width = std::max(1u, texture.width >> first_mip);
+    result.height = std::max(1u, texture.height >> first_mip);
+    result.first_mip = first_mip;
+    result.mip_levels = levels - first_mip;
+    result.source_width = texture.width;
+    result.source_height = texture.height;
+    std::shared_ptr<uint8_t[]> chain(new uint8_t[mip_chain_size(result.width, result.height, result.mip_levels)]);
+
+    size_t offset = 0;
+    if (first_mip == 0)
+    {
+        offset = level_size(texture.width, texture.height, 0);
+        std::memcpy(chain.get(), texture.pixels.get(), offset);
+    }
+
+    // Levels above the first one kept are only filtered through, alternating between two scratch buffers.
+    std::vector<uint8_t> scratch[2];
+    const uint8_t* source = texture.pixels.get();
+    uint32_t source_width = texture.width;
+    uint32_t source_height = texture.height;
+    for (uint32_t level = 1; level < levels; ++level)
+    {
+        const uint32_t width = std::max(1u, source_width / 2);
+        const uint32_t height = std::max(1u, source_height / 2);
+        const size_t size = level_size(width, height, 0);
+
+        uint8_t* target = nullptr;
+        if (level >= first_mip)
+        {
+            target = chain.get() + offset;
+            offset += size;
+        }
+        else
+        {
+            scratch[level % 2].resize(size);
+            target = scratch[level % 2].data();
+        }
+
+        downsample(source, source_width, source_height, target, width, height);
+        source = target;
+        source_width = width;
+        source_height = height;
+    }
+
+    result.pixels = std::shared_ptr<const uint8_t>(chain, chain.get());
+    return result;
+}
+
+MarkoEngine::Texture_Streaming& MarkoEngine::Texture_Streaming::get()
+{
+    static Texture_Streaming instance;
+    return instance;
+}
+
+void MarkoEngine::Texture_Streaming::initialize(size_t budget)
+{
+    cleanup();
+    m_budget = budget;
+    m_enabled = true;
+}
+
+void MarkoEngine::Texture_Streaming::cleanup()
+{
+    m_enabled = false;
+    m_resident_bytes = 0;
+    m_frame = 0;
+    m_slots.clear();
+
+    std::lock_guard lock(m_mutex);
+    m_target_mips.clear();
+}
+
+Decoded_Texture MarkoEngine::Texture_Streaming::prepare(const std::string& filename, const Decoded_Texture& texture) const
+{
+    // A chain that was cut already, or a texture too small to have more than one level, goes up as it is.
+    if (!m_enabled || !texture.pixels || texture.first_mip != 0 || texture.mip_levels != 1 || std::max(texture.width, texture.height) <= 1)
+        return texture;
+
+    uint32_t first_mip = start_mip(texture.width, texture.height);
+    {
+        std::lock_guard lock(m_mutex);
+        auto target = m_target_mips.find(filename);
+        if (target != m_target_mips.end())
+            first_mip = target->second;
+    }
+    return build_mip_chain(texture, first_mip);
+}
+
+void MarkoEngine::Texture_Streaming::set_resident(uint32_t texture_index, const std::string& filename, const Decoded_Texture& texture)
+{
+    if (!m_enabled)
+        return;
+
+    if (texture_index >= m_slots.size())
+        m_slots.resize(texture_index + 1);
+
+    Slot& slot = m_slots[texture_index];
+    const bool first_upload = slot.mip_levels == 0;
+    m_resident_bytes -= slot.bytes;
+
+    slot.filename = filename;
+    slot.full_width = texture.source_width != 0 ? texture.source_width : texture.width;
+    slot.full_height = texture.source_height != 0 ? texture.source_height : texture.height;
+    slot.first_mip = texture.first_mip;
+    slot.mip_levels = texture.mip_levels;
+    slot.bytes = mip_chain_size(texture.width, texture.height, texture.mip_levels);
+    slot.stream_failed = false;
+    m_resident_bytes += slot.bytes;
+
+    if (first_upload)
+    {
+        slot.needed_mip = slot.first_mip;
+        slot.last_used = m_frame;
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_target_mips[filename] = slot.first_mip;
+}
+
+void MarkoEngine::Texture_Streaming::touch(uint32_t texture_index, float screen_size)
+{
+    if (!m_enabled || texture_index >= m_slots.size() || m_slots[texture_index].mip_levels == 0)
+        return;
+
+    // Assumes the texture is mapped once across the object, so one texel per pixel at the level chosen. Nothing is
+    // trimmed below the start levels; they cost little and keep a texture from turning to mush on its way back.
+    Slot& slot = m_slots[texture_index];
+    const uint32_t coarsest = std::min(slot.first_mip + slot.mip_levels - 1, start_mip(slot.full_width, slot.full_height));
+    const float texels = static_cast<float>(std::max(slot.full_width, slot.full_height));
+    uint32_t mip = coarsest;
+    if (screen_size >= texels)
+        mip = 0;
+    else if (screen_size >= 1.0f)
+        mip = std::min(coarsest, static_cast<uint32_t>(std::log2(texels / screen_size)));
+
+    slot.frame_mip = std::min(slot.frame_mip, mip);
+    slot.last_used = m_frame;
+}
+
+void MarkoEngine::Texture_Streaming::update()
+{
+    if (!m_enabled)
+        return;
+
+    size_t streaming = 0;
+    size_t streaming_bytes = 0;
+    for (Slot& slot : m_slots)
+    {
+        if (slot.mip_levels == 0)
+            continue;
+
+        if (slot.last_used == m_frame && slot.frame_mip != UINT32_MAX)
+            slot.needed_mip = slot.frame_mip;
+        else if (m_frame - slot.last_used > UNUSED_FRAMES)
+            slot.needed_mip = std::max(slot.needed_mip, start_mip(slot.full_width, slot.full_height));
+        slot.frame_mip = UINT32_MAX;
+
+        if (slot.streaming.valid() && slot.streaming.state() != Asset_State::loading)
+        {
+            slot.stream_failed = slot.streaming.failed();
+            slot.streaming = Asset_Handle();
+        }
+        if (slot.streaming.valid())
+        {
+            ++streaming;
+            const size_t size = mip_chain_size(std::max(1u, slot.full_width >> slot.needed_mip), std::max(1u, slot.full_height >> slot.needed_mip),
+                slot.first_mip + slot.mip_levels - slot.needed_mip);
+            streaming_bytes += size > slot.bytes ? size - slot.bytes : 0;
+        }
+    }
+    ++m_frame;
+
+    if (m_resident_bytes > m_budget)
+        evict(m_resident_bytes - m_budget, UINT32_MAX);
+
+    if (!Asset_Loader::get().running())
+        return;
+
+    // The most blurred textures on screen go first.
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < m_slots.size(); ++i)
+    {
+        const Slot& slot = m_slots[i];
+        if (slot.mip_levels != 0 && !slot.streaming.valid() && !slot.stream_failed && slot.needed_mip < slot.first_mip)
+            candidates.push_back(i);
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+        {
+            const uint32_t blur_a = m_slots[a].first_mip - m_slots[a].needed_mip;
+            const uint32_t blur_b = m_slots[b].first_mip - m_slots[b].needed_mip;
+            return blur_a != blur_b ? blur_a > blur_b : m_slots[a].last_used > m_slots[b].last_used;
+        });
+
+    for (uint32_t index : candidates)
+    {
+        if (streaming >= MAX_STREAMS)
+            break;
+
+        Slot& slot = m_slots[index];
+        const uint32_t levels = slot.first_mip + slot.mip_levels - slot.needed_mip;
+        const size_t size = mip_chain_size(std::max(1u, slot.full_width >> slot.needed_mip), std::max(1u, slot.full_height >> slot.needed_mip), levels);
+        const size_t growth = size - slot.bytes;
+        if (m_resident_bytes + streaming_bytes + growth > m_budget && !evict(m_resident_bytes + streaming_bytes + growth - m_budget, index))
+            continue;
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_target_mips[slot.filename] = slot.needed_mip;
+        }
+        slot.streaming = Asset_Loader::get().request(Asset_Kind::texture, slot.filename);
+        ++streaming;
+        streaming_bytes += growth;
+    }
+}
+
+uint32_t MarkoEngine::Texture_Streaming::start_mip(uint32_t width, uint32_t height) const
+{
+    uint32_t mip = 0;
+    while (std::max(width >> mip, height >> mip) > START_SIZE)
+        ++mip;
+    return mip;
+}
+
+bool MarkoEngine::Texture_Streaming::evict(size_t needed, uint32_t keep)
+{
+    // Levels finer than what is on screen go first, from the texture drawn longest ago.
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < m_slots.size(); ++i)
+    {
+        const Slot& slot = m_slots[i];
+        if (i != keep && slot.mip_levels > 1 && !slot.streaming.valid() && slot.first_mip < slot.needed_mip)
+            candidates.push_back(i);
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) { return m_slots[a].last_used < m_slots[b].last_used; });
+
+    size_t freed = 0;
+    for (uint32_t index : candidates)
+    {
+        Slot& slot = m_slots[index];
+        const uint32_t drop = std::min(slot.needed_mip - slot.first_mip, slot.mip_levels - 1);
+        const size_t before = slot.bytes;
+        const uint32_t width = std::max(1u, slot.full_width >> slot.first_mip);
+        const uint32_t height = std::max(1u, slot.full_height >> slot.first_mip);
+        Renderer::get().trim_texture(index, width, height, slot.mip_levels, drop);
+
+        Decoded_Texture trimmed;
+        trimmed.width = std::max(1u, width >> drop);
+        trimmed.height = std::max(1u, height >> drop);
+        trimmed.first_mip = slot.first_mip + drop;
+        trimmed.mip_levels = slot.mip_levels - drop;
+        trimmed.source_width = slot.full_width;
+        trimmed.source_height = slot.full_height;
+        set_resident(index, slot.filename, trimmed);
+
+        freed += before - slot.bytes;
+        if (freed >= needed)
+            return true;
+    }
+    return false;
+}
\ No newline at end of file
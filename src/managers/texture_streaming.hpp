@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "asset_loader.hpp"
+#include "renderer.hpp"
+
+namespace MarkoEngine
+{
+    inline constexpr size_t DEFAULT_TEXTURE_BUDGET = 256ull << 20;
+
+    // Bytes of an RGBA8 mip chain of the given number of levels, starting at width x height.
+    size_t mip_chain_size(uint32_t width, uint32_t height, uint32_t levels);
+    // The full chain of a texture down to 1x1, box filtered, dropping the levels finer than first_mip.
+    Decoded_Texture build_mip_chain(const Decoded_Texture& texture, uint32_t first_mip);
+
+    // Keeps each texture slot resident only down to the mip level its on-screen size needs. Textures are uploaded
+    // with their low mips first; while drawing, the renderer reports the projected size of the object behind every
+    // textured mesh, and update() streams finer levels in through the Asset_Loader and drops levels that nothing
+    // needs any more to stay under the budget. Nothing is asked of game objects.
+    class Texture_Streaming
+    {
+    public:
+        Texture_Streaming(const Texture_Streaming&) = delete;
+        Texture_Streaming(Texture_Streaming&&) = delete;
+        Texture_Streaming& operator=(const Texture_Streaming&) = delete;
+        Texture_Streaming& operator=(Texture_Streaming&&) = delete;
+
+    private:
+        Texture_Streaming() = default;
+        ~Texture_Streaming() = default;
+
+    public:
+        static Texture_Streaming& get();
+
+        // Without it every texture stays fully resident, as before.
+        void initialize(size_t budget = DEFAULT_TEXTURE_BUDGET);
+        void cleanup();
+
+        bool enabled() const { return m_enabled; }
+        size_t budget() const { return m_budget; }
+        void set_budget(size_t budget) { m_budget = budget; }
+        size_t resident_bytes() const { return m_resident_bytes; }
+
+        // Thread safe. Cuts a decoded texture down to the chain worth uploading: from the level its slot streams
+        // at, or the first level no larger than the start size for a texture not resident yet.
+        Decoded_Texture prepare(const std::string& filename, const Decoded_Texture& texture) const;
+
+        // Main thread, from the renderer. A slot is reported whenever its image changes and touched for every mesh
+        // drawn with it, with the longest side in pixels of what it covers on screen.
+        void set_resident(uint32_t texture_index, const std::string& filename, const Decoded_Texture& texture);
+        void touch(uint32_t texture_index, float screen_size);
+
+        // Called once per frame before anything is drawn.
+        void update();
+
+    private:
+        struct Slot
+        {
+            std::string filename;
+            uint32_t full_width = 0;
+            uint32_t full_height = 0;
+            uint32_t first_mip = 0;
+            uint32_t mip_levels = 0;
+            size_t bytes = 0;
+            // Finest level a draw asked for this frame, and the last level decided on.
+            uint32_t frame_mip = UINT32_MAX;
+            uint32_t needed_mip = 0;
+            uint64_t last_used = 0;
+            Asset_Handle streaming;
+            // Not tried again until the slot gets a new image, e.g. from hot reload.
+            bool stream_failed = false;
+        };
+
+        uint32_t start_mip(uint32_t width, uint32_t height) const;
+        bool evict(size_t needed, uint32_t keep);
+
+    private:
+        bool m_enabled = false;
+        size_t m_budget = DEFAULT_TEXTURE_BUDGET;
+        size_t m_resident_bytes = 0;
+        uint64_t m_frame = 0;
+        std::vector<Slot> m_slots;
+        // Level each texture streams at, read by prepare() on the loader thread.
+        mutable std::mutex m_mutex;
+        std::unordered_map<std::string, uint32_t> m_target_mips;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "pch.h"
+#include "transforms.hpp"
+#include "../game_objects/components.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+
+MarkoEngine::Transforms& MarkoEngine::Transforms::get()
+{
+    static Transforms instance;
+    return instance;
+}
+
+void MarkoEngine::Transforms::update()
+{
+    m_updated_count = 0;
+    if (!m_dirty && !m_hierarchy_dirty)
+        return;
+
+    if (m_hierarchy_dirty)
+        sort_hierarchy();
+
+    Registry& registry = Registry::get();
+    for (Transform_Component& component : registry.pool<Transform_Component>().components())
+    {
+        Transform_Component* parent = registry.try_get<Transform_Component>(component.parent);
+
+        component.changed = component.dirty || (parent && parent->changed);
+        component.dirty = false;
+        if (!component.changed)
+            continue;
+
+        component.local_to_world = parent ? parent->local_to_world * local_matrix(component.local) : local_matrix(component.local);
+        component.world = decompose(component.local_to_world);
+        ++m_updated_count;
+    }
+
+    m_dirty = false;
+}
+
+void MarkoEngine::Transforms::mark_dirty(Entity entity)
+{
+    if (Transform_Component* component = Registry::get().try_get<Transform_Component>(entity))
+    {
+        component->dirty = true;
+        m_dirty = true;
+    }
+}
+
+void MarkoEngine::Transforms::mark_hierarchy_dirty()
+{
+    m_hierarchy_dirty = true;
+}
+
+size_t MarkoEngine::Transforms::updated_count() const
+{
+    return m_updated_count;
+}
+
+glm::mat4 MarkoEngine::Transforms::local_matrix(const transform& local)
+{
+    return glm::translate(glm::mat4(1.0f), local.position)
+        * glm::eulerAngleXYZ(glm::radians(local.rotation.x), glm::radians(local.rotation.y), glm::radians(local.rotation.z))
+        * glm::scale(glm::mat4(1.0f), local.scale);
+}
+
+transform MarkoEngine::Transforms::decompose(const glm::mat4& matrix)
+{
+    transform result;
+    result.position = glm::vec3(matrix[3]);
+    result.scale = glm::vec3(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])));
+
+    glm::mat4 rotation(1.0f);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (result.scale[axis] > 0.0f)
+            rotation[axis] = glm::vec4(glm::vec3(matrix[axis]) / result.scale[axis], 0.0f);
+    }
+
+    glm::extractEulerAngleXYZ(rotation, result.rotation.x, result.rotation.y, result.rotation.z);
+    result.rotation = glm::degrees(result.rotation);
+    return result;
+}
+
+// Orders the dense transform array by depth so every parent is computed before its children,
+// then recomputes everything once since slots and parent links may have changed.
+void MarkoEngine::Transforms::sort_hierarchy()
+{
+    Registry& registry = Registry::get();
+    Component_Pool<Transform_Component>& pool = registry.pool<Transform_Component>();
+
+    std::vector<uint32_t> depths(pool.size(), 0);
+    for (size_t i = 0; i < pool.size(); ++i)
+    {
+        Entity parent = pool.components()[i].parent;
+        while (depths[i] <= pool.size())
+        {
+            Transform_Component* component = registry.try_get<Transform_Component>(parent);
+            if (!component)
+                break;
+
+            parent = component->parent;
+            ++depths[i];
+        }
+    }
+
+    pool.sort_by(depths);
+    for (Transform_Component& component : pool.components())
+    {
+        component.dirty = true;
+    }
+
+    m_hierarchy_dirty = false;
+    m_dirty = true;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include "registry.hpp"
+
+#include <glm/glm.hpp>
+
+struct transform;
+
+namespace MarkoEngine
+{
+    class Transforms
+    {
+    public:
+        Transforms(const Transforms&) = delete;
+        Transforms(Transforms&&) = delete;
+        Transforms& operator=(const Transforms&) = delete;
+        Transforms& operator=(Transforms&&) = delete;
+
+    private:
+        Transforms() = default;
+
+    public:
+        static Transforms& get();
+
+        void update();
+
+        void mark_dirty(Entity entity);
+        void mark_hierarchy_dirty();
+
+        size_t updated_count() const;
+
+        static glm::mat4 local_matrix(const transform& local);
+        static transform decompose(const glm::mat4& matrix);
+
+    private:
+        void sort_hierarchy();
+
+    private:
+        bool m_dirty = true;
+        bool m_hierarchy_dirty = true;
+        size_t m_updated_count = 0;
+    };
+}
\ No newline at end of file
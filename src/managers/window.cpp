@@ -31,14 +31,33 @@ void MarkoEngine::Window::initialize()
 
     m_start_time = m_last_time = m_current_time = m_last_interval = std::chrono::steady_clock::now();
 
-    m_previous_keys.reset();
     m_current_keys.reset();
-    m_previous_buttons.reset();
+    m_pressed_keys.reset();
     m_current_buttons.reset();
+    m_pressed_buttons.reset();
+    m_frame_events.reserve(1024);
+
+    glfwSetKeyCallback(m_window.get(), key_callback);
+    glfwSetMouseButtonCallback(m_window.get(), mouse_button_callback);
+}
+
+void MarkoEngine::Window::key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_UNKNOWN)
+        return;
+
+    get().m_frame_events.push_back({ Input_Event_Type::KEY, key, action, mods, std::chrono::steady_clock::now() });
+}
+
+void MarkoEngine::Window::mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    get().m_frame_events.push_back({ Input_Event_Type::MOUSE_BUTTON, button, action, mods, std::chrono::steady_clock::now() });
 }
 
 void MarkoEngine::Window::update()
 {
+    // The callbacks run inside glfwPollEvents on this thread and append the frame's events in order.
+    m_frame_events.clear();
     glfwPollEvents();
 
     glfwGetWindowSize(m_window.get(), &m_window_size.x, &m_window_size.y);
@@ -47,16 +66,24 @@ void MarkoEngine::Window::update()
     m_delta_time = std::chrono::duration<double>(now - m_last_time).count();
     m_last_time = m_current_time = now;
 
-    m_previous_keys = m_current_keys;
-    for (int key = GLFW_KEY_SPACE; key < GLFW_KEY_LAST; ++key)
-    {
-        m_current_keys.set(key, glfwGetKey(m_window.get(), key) == GLFW_PRESS);
-    }
+    m_pressed_keys.reset();
+    m_pressed_buttons.reset();
 
-    m_previous_buttons = m_current_buttons;
-    for (int btn = GLFW_MOUSE_BUTTON_1; btn < GLFW_MOUSE_BUTTON_LAST; ++btn)
+    for (const Input_Event& event : m_frame_events)
     {
-        m_current_buttons.set(btn, glfwGetMouseButton(m_window.get(), btn));
+        if (event.type == Input_Event_Type::KEY && event.code >= 0 && event.code <= GLFW_KEY_LAST)
+        {
+            if (event.action == GLFW_PRESS)
+                m_pressed_keys.set(event.code);
+            if (event.action != GLFW_REPEAT)
+                m_current_keys.set(event.code, event.action == GLFW_PRESS);
+        }
+        else if (event.type == Input_Event_Type::MOUSE_BUTTON && event.code >= 0 && event.code <= GLFW_MOUSE_BUTTON_LAST)
+        {
+            if (event.action == GLFW_PRESS)
+                m_pressed_buttons.set(event.code);
+            m_current_buttons.set(event.code, event.action == GLFW_PRESS);
+        }
     }
 
     glm::dvec2 new_pos;
@@ -130,7 +157,7 @@ bool MarkoEngine::Window::interval_elapsed(double seconds)
 
 bool MarkoEngine::Window::key_pressed(int key)
 {
-    return m_current_keys.test(key) && !m_previous_keys.test(key);
+    return m_pressed_keys.test(key);
 }
 
 bool MarkoEngine::Window::key_held(int key)
@@ -140,7 +167,7 @@ bool MarkoEngine::Window::key_held(int key)
 
 bool MarkoEngine::Window::mouse_pressed(int button)
 {
-    return m_current_buttons.test(button) && !m_previous_buttons.test(button);
+    return m_pressed_buttons.test(button);
 }
 
 bool MarkoEngine::Window::mouse_held(int button)
@@ -158,6 +185,25 @@ glm::dvec2 MarkoEngine::Window::mouse_delta()
     return m_mouse_delta;
 }
 
+const std::vector<MarkoEngine::Input_Event>& MarkoEngine::Window::input_events()
+{
+    return m_frame_events;
+}
+
+void MarkoEngine::Window::frame_presented()
+{
+    if (m_frame_events.empty())
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+    m_poll_to_present_latency = std::chrono::duration<double, std::milli>(now - m_frame_events.front().timestamp).count();
+}
+
+double MarkoEngine::Window::poll_to_present_latency()
+{
+    return m_poll_to_present_latency;
+}
+
 void MarkoEngine::Window::close()
 {
     glfwSetWindowShouldClose(m_window.get(), GLFW_TRUE);
@@ -4,9 +4,26 @@
 #include <bitset>
 #include <chrono>
 #include <memory>
+#include <vector>
 
 namespace MarkoEngine
 {
+    enum class Input_Event_Type : uint8_t
+    {
+        KEY,
+        MOUSE_BUTTON
+    };
+
+    struct Input_Event
+    {
+        Input_Event_Type type;
+        int code;
+        int action;
+        int mods;
+        // When glfwPollEvents delivered the event; GLFW does not pass on the time the OS received it.
+        std::chrono::steady_clock::time_point timestamp;
+    };
+
     class Window final
     {
     public:
@@ -44,24 +61,36 @@ namespace MarkoEngine
         glm::dvec2 mouse_position();
         glm::dvec2 mouse_delta();
 
+        const std::vector<Input_Event>& input_events();
+        void frame_presented();
+        // From the poll that delivered the frame's first event to the present that showed it, in milliseconds.
+        double poll_to_present_latency();
+
         bool should_close();
         void close();
 
         void set_mouse_position(const glm::dvec2& position);
         void set_mouse_mode(int mode);
 
+    private:
+        static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+        static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+
     private:
         std::unique_ptr<GLFWwindow, decltype(&glfwDestroyWindow)> m_window{nullptr, &glfwDestroyWindow};
         glm::ivec2 m_window_size{1920, 1080};
         glm::ivec2 m_window_position{0, 0};
 
-        std::bitset<GLFW_KEY_LAST> m_previous_keys{};
-        std::bitset<GLFW_KEY_LAST> m_current_keys{};
+        std::bitset<GLFW_KEY_LAST + 1> m_current_keys{};
+        std::bitset<GLFW_KEY_LAST + 1> m_pressed_keys{};
 
         glm::dvec2 m_mouse_position{0.0f, 0.0f};
         glm::dvec2 m_mouse_delta{0.0f, 0.0f};
-        std::bitset<GLFW_MOUSE_BUTTON_LAST> m_previous_buttons{};
-        std::bitset<GLFW_MOUSE_BUTTON_LAST> m_current_buttons{};
+        std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> m_current_buttons{};
+        std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> m_pressed_buttons{};
+
+        std::vector<Input_Event> m_frame_events{};
+        double m_poll_to_present_latency = 0.0;
 
         std::chrono::steady_clock::time_point m_start_time{};
         std::chrono::steady_clock::time_point m_last_time{};